@@ -11,6 +11,12 @@ const bool g_EnableValidationlayers{ false };
 const int g_MaxFramePerFlight{ 2 };
 const int g_NumberOfMeshes{ 2 };
 
+// Coarsest lod whose simplification error stays below this many pixels on screen gets drawn
+const float g_LodPixelError{ 1.0f };
+
+// Meshes whose bounding sphere covers a smaller radius than this many pixels get drawn as an impostor
+const float g_ImpostorScreenRadius{ 24.0f };
+
 #include <glfw3.h>
 #include <stdexcept>
 #include <iostream>
@@ -22,13 +28,34 @@ const int g_NumberOfMeshes{ 2 };
 #include <gtc/matrix_transform.hpp>
 #include <chrono>
 #include <functional>
+#include <string>
+#include <limits>
+#include <array>
 
 #include "Application.h"
 #include "HelperFunctions.h"
 #include "Mesh.h"
+#include "VertexLayout.h"
+#include "Benchmarks.h"
+#include "Impostor.h"
+#include "GeometryArena.h"
+#include "StagingRing.h"
+#include "Defragmenter.h"
+#include "AttachmentPool.h"
+#include "HostAllocator.h"
+#include "GpuCulling.h"
 #include "Texture.h"
 #include "Camera.h"
 
+// The gpu driven path draws all objects sharing an index type with one indirect draw, the position is their draw group
+const std::array<VkIndexType, 2> g_GpuDrawGroupIndexTypes{ VK_INDEX_TYPE_UINT16, VK_INDEX_TYPE_UINT32 };
+
+// Base color, normal, glossiness and specular
+constexpr uint32_t g_TexturesPerMesh{ 4 };
+
+// Culled meshlets of at most this many triangles between two visible ones get drawn anyway, a few triangles cost less than another draw
+constexpr uint32_t g_MeshletDrawGapTriangles{ 32 };
+
 void GlobalKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
 	static_cast<Application*>(glfwGetWindowUserPointer(window))->KeyCallback(window, key, scancode, action, mods);
@@ -38,6 +65,7 @@ Application::Application(int width, int height) :
 	m_Width{ width },
 	m_Height{ height },
 	m_Window{ nullptr },
+	m_HostAllocator{},
 	m_Instance{},
 	m_DebugMessenger{},
 	m_Surface{},
@@ -46,8 +74,13 @@ Application::Application(int width, int height) :
 	m_PhysicalDeviceExtensionNames{ VK_KHR_SWAPCHAIN_EXTENSION_NAME },
 	m_PhysicalDevice{ VK_NULL_HANDLE },
 	m_Device{ VK_NULL_HANDLE },
+	m_MemoryBudgetSupported{ false },
+	m_HostImageCopySupported{ false },
+	m_MemoryBudget{},
+	m_DeviceAllocator{},
 	m_GrahicsQueue{ VK_NULL_HANDLE },
 	m_PresentQueue{ VK_NULL_HANDLE },
+	m_TransferQueue{ VK_NULL_HANDLE },
 	m_SwapChainImages{},
 	m_SwapChainImageViews{},
 	m_VertexShader{},
@@ -57,12 +90,15 @@ Application::Application(int width, int height) :
 	m_PipeLine{},
 	m_SwapChainFrameBuffers{},
 	m_CommandPool{},
+	m_StagingRing{},
+	m_Defragmenter{},
 	m_CommandBuffers{},
 	m_ImageAvailable{},
 	m_RenderFinished{},
 	m_InFlight{},
 	m_CurrentFrame{},
 	m_FrameBufferResized{ false },
+	m_GeometryArena{},
 	m_Meshes{},
 	m_UniformBuffers{},
 	m_UniformBufferMemories{},
@@ -77,25 +113,66 @@ Application::Application(int width, int height) :
 	m_GlossTextures{},
 	m_SpecularTextures{},
 	m_TextureSampler{},
+	m_AttachmentPool{},
 	m_DepthImage{},
-	m_DepthMemory{},
 	m_DepthImageView{},
 	m_ColorImage{},
-	m_ColorMemory{},
 	m_ColorImageView{},
 	m_Camera{},
 	m_MSAASamples{ VK_SAMPLE_COUNT_1_BIT },
-	m_PushConstants{ 0 }
+	m_PushConstants{ 0 },
+	m_MeshletCulling{ true },
+	m_LodSelection{ true },
+	m_SubmittedTriangles{},
+	m_ForceImpostors{ false },
+	m_ImpostorVertexShader{},
+	m_ImpostorFragmentShader{},
+	m_ImpostorPipeLineLayout{},
+	m_ImpostorPipeLine{},
+	m_ImpostorDescriptorSetLayout{},
+	m_ImpostorDescriptorSets{},
+	m_ImpostorBaker{},
+	m_Impostors{},
+	m_ImpostorEvictables{},
+	m_TextureEvictables{},
+	m_AttachmentEvictables{},
+	m_ResidencyChangePending{ false },
+	m_ObjectBounds{},
+	m_VisibleObjects{},
+	m_GpuCullingSupported{ false },
+	m_GpuDriven{ false },
+	m_GpuCulling{},
+	m_GpuDrivenVertexShader{},
+	m_GpuDrivenFragmentShader{},
+	m_GpuDrivenPipeLineLayout{},
+	m_GpuDrivenPipeLine{},
+	m_TextureTableDescriptorSetLayout{},
+	m_TextureTableDescriptorSet{}
 {
+	const auto startTime{ std::chrono::high_resolution_clock::now() };
+
 	InitializeWindow();
 	InitializeVulkan();
+	if (g_RunBenchmarks) RunDeviceBenchmarks(m_PhysicalDevice, *m_DeviceAllocator, m_Device, m_CommandPool, m_GrahicsQueue, *m_StagingRing, m_HostImageCopySupported);
 	InitializeMeshes();
+	InitializeImpostors();
+	m_DeviceAllocator->PrintStatistics();
+	m_MemoryBudget->PrintStatistics();
+
+	const std::chrono::duration<float, std::milli> startupTime{ std::chrono::high_resolution_clock::now() - startTime };
+	std::cout << "Started in " << startupTime.count() << " ms, " << m_StagingRing->GetSubmissionCount() << " staging submissions" << std::endl << std::endl;
 
 	m_Camera = new Camera{ glm::radians(45.0f), (float(m_ImageExtend.width) / float(m_ImageExtend.height)), 0.1f, 10.0f, 2.5f };
 	m_Camera->SetStartPosition(glm::vec3{ 2.83f, 2.09f, 1.41f }, 0.63f, -0.39f);
 
 	std::cout << "--- Mesh Controls ---" << std::endl;
-	std::cout << "Stop rotating mesh with R" << std::endl << std::endl;	
+	std::cout << "Stop rotating mesh with R" << std::endl;
+	std::cout << "Toggle meshlet culling with C" << std::endl;
+	std::cout << "Toggle lod selection with L" << std::endl;
+	std::cout << "Toggle forced impostors with I" << std::endl;
+	if (m_GpuCulling != nullptr) std::cout << "Toggle gpu driven culling with G" << std::endl;
+	std::cout << "Print host allocations with H" << std::endl;
+	std::cout << std::endl;
 
 	std::cout << "--- Render Controls ---" << std::endl;
 	std::cout << "Combined render mode with 1" << std::endl;
@@ -108,7 +185,7 @@ Application::Application(int width, int height) :
 Application::~Application()
 {
 	delete m_Camera;
-	vkDestroySampler(m_Device, m_TextureSampler, nullptr);
+	vkDestroySampler(m_Device, m_TextureSampler, m_HostAllocator->GetCallbacks());
 	for (int i{}; i < g_NumberOfMeshes; ++i)
 	{
 		delete m_BaseColorTextures.at(i);
@@ -116,38 +193,75 @@ Application::~Application()
 		delete m_GlossTextures.at(i);
 		delete m_SpecularTextures.at(i);
 	}
+	for (auto evictable : m_ImpostorEvictables)
+	{
+		m_MemoryBudget->UnregisterEvictable(evictable);
+	}
+	for (auto evictable : m_TextureEvictables)
+	{
+		m_MemoryBudget->UnregisterEvictable(evictable);
+	}
+	for (auto evictable : m_AttachmentEvictables)
+	{
+		m_MemoryBudget->UnregisterEvictable(evictable);
+	}
+	for (auto impostor : m_Impostors)
+	{
+		delete impostor;
+	}
+	delete m_ImpostorBaker;
 	for (auto mesh : m_Meshes)
 	{
 		delete mesh;
 	}
+	delete m_GeometryArena;
+	delete m_GpuCulling;
 	for (int i{}; i < g_MaxFramePerFlight; ++i)
 	{
 		for (size_t j{}; j < m_Meshes.size(); ++j)
 		{
 			vkDestroyBuffer(m_Device, m_UniformBuffers.at(i).at(j), nullptr);
-			vkFreeMemory(m_Device, m_UniformBufferMemories.at(i).at(j), nullptr);
+			m_DeviceAllocator->Free(m_UniformBufferMemories.at(i).at(j));
 		}
 	}
 	for (int i{}; i < g_MaxFramePerFlight; ++i)
 	{
-		vkDestroySemaphore(m_Device, m_ImageAvailable[i], nullptr);
-		vkDestroySemaphore(m_Device, m_RenderFinished[i], nullptr);
-		vkDestroyFence(m_Device, m_InFlight[i], nullptr);
+		vkDestroySemaphore(m_Device, m_ImageAvailable[i], m_HostAllocator->GetCallbacks());
+		vkDestroySemaphore(m_Device, m_RenderFinished[i], m_HostAllocator->GetCallbacks());
+		vkDestroyFence(m_Device, m_InFlight[i], m_HostAllocator->GetCallbacks());
 	}
-	vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
+	delete m_StagingRing;
+	m_Defragmenter->PrintStatistics();
+	delete m_Defragmenter;
+	vkDestroyCommandPool(m_Device, m_CommandPool, m_HostAllocator->GetCallbacks());
 	CleanupSwapChain();
-	vkDestroyPipeline(m_Device, m_PipeLine, nullptr);
-	vkDestroyPipelineLayout(m_Device, m_PipeLineLayout, nullptr);
-	vkDestroyDescriptorPool(m_Device, m_DescriptorPool, nullptr);
-	vkDestroyDescriptorSetLayout(m_Device, m_TexturesDescriptorSetLayout, nullptr);
-	vkDestroyDescriptorSetLayout(m_Device, m_TransformsDescriptorSetLayout, nullptr);
-	vkDestroyRenderPass(m_Device, m_RenderPass, nullptr);
+	delete m_AttachmentPool;
+	vkDestroyPipeline(m_Device, m_PipeLine, m_HostAllocator->GetCallbacks());
+	vkDestroyPipelineLayout(m_Device, m_PipeLineLayout, m_HostAllocator->GetCallbacks());
+	vkDestroyPipeline(m_Device, m_ImpostorPipeLine, m_HostAllocator->GetCallbacks());
+	vkDestroyPipelineLayout(m_Device, m_ImpostorPipeLineLayout, m_HostAllocator->GetCallbacks());
+	vkDestroyPipeline(m_Device, m_GpuDrivenPipeLine, m_HostAllocator->GetCallbacks());
+	vkDestroyPipelineLayout(m_Device, m_GpuDrivenPipeLineLayout, m_HostAllocator->GetCallbacks());
+	vkDestroyDescriptorPool(m_Device, m_DescriptorPool, m_HostAllocator->GetCallbacks());
+	vkDestroyDescriptorSetLayout(m_Device, m_TexturesDescriptorSetLayout, m_HostAllocator->GetCallbacks());
+	vkDestroyDescriptorSetLayout(m_Device, m_TransformsDescriptorSetLayout, m_HostAllocator->GetCallbacks());
+	vkDestroyDescriptorSetLayout(m_Device, m_ImpostorDescriptorSetLayout, m_HostAllocator->GetCallbacks());
+	vkDestroyDescriptorSetLayout(m_Device, m_TextureTableDescriptorSetLayout, m_HostAllocator->GetCallbacks());
+	vkDestroyRenderPass(m_Device, m_RenderPass, m_HostAllocator->GetCallbacks());
 	vkDestroyShaderModule(m_Device, m_VertexShader, nullptr);
 	vkDestroyShaderModule(m_Device, m_FragmentShader, nullptr);
-	vkDestroyDevice(m_Device, nullptr);
-	vkDestroySurfaceKHR(m_Instance, m_Surface, nullptr);
-	if (g_EnableValidationlayers) DestroyDebugUtilsMessengerEXT(m_Instance, m_DebugMessenger, nullptr);
-	vkDestroyInstance(m_Instance, nullptr);
+	vkDestroyShaderModule(m_Device, m_ImpostorVertexShader, nullptr);
+	vkDestroyShaderModule(m_Device, m_ImpostorFragmentShader, nullptr);
+	vkDestroyShaderModule(m_Device, m_GpuDrivenVertexShader, nullptr);
+	vkDestroyShaderModule(m_Device, m_GpuDrivenFragmentShader, nullptr);
+	delete m_DeviceAllocator;
+	delete m_MemoryBudget;
+	vkDestroyDevice(m_Device, m_HostAllocator->GetCallbacks());
+	vkDestroySurfaceKHR(m_Instance, m_Surface, m_HostAllocator->GetCallbacks());
+	if (g_EnableValidationlayers) DestroyDebugUtilsMessengerEXT(m_Instance, m_DebugMessenger, m_HostAllocator->GetCallbacks());
+	vkDestroyInstance(m_Instance, m_HostAllocator->GetCallbacks());
+	m_HostAllocator->PrintStatistics();
+	delete m_HostAllocator;
 	glfwDestroyWindow(m_Window);
 	glfwTerminate();
 }
@@ -166,7 +280,10 @@ void Application::Run()
 
 		glfwPollEvents();
 		m_Camera->Update(m_Window, time);
-		for (int i{}; i < g_NumberOfMeshes; ++i) m_Meshes.at(i)->Update(time);
+		for (int i{}; i < g_NumberOfMeshes; ++i)
+		{
+			if (m_Meshes.at(i)->Update(time)) UpdateGpuObject(i);
+		}
 		DrawFrame();
 
 		lastTime = currentTime;
@@ -177,12 +294,21 @@ void Application::Run()
 
 void Application::InitializeMeshes()
 {
+	m_GeometryArena = new GeometryArena{ *m_DeviceAllocator, m_Device, *m_StagingRing };
+	m_GeometryArena->RegisterMovable(*m_Defragmenter);
+
+	const auto startTime{ std::chrono::high_resolution_clock::now() };
+	const uint32_t submissionCount{ m_StagingRing->GetSubmissionCount() };
+
+	// The vertices and indices of every mesh go up in one submission
+	m_StagingRing->BeginBatch();
+
 	// Vehicle
-	m_Meshes.push_back(new Mesh{ m_PhysicalDevice, m_Device, m_CommandPool, m_GrahicsQueue, "Models/vehicle.obj" });
+	m_Meshes.push_back(new Mesh{ *m_GeometryArena, "Models/vehicle.obj" });
 	m_Meshes.at(0)->SetModelMatrix(glm::scale(glm::rotate(glm::mat4{ 1.0f }, glm::radians(-90.0f), g_WorldForward), glm::vec3{ 0.1f, 0.1f, 0.1f }));
 
 	// Mixer
-	m_Meshes.push_back(new Mesh{ m_PhysicalDevice, m_Device, m_CommandPool, m_GrahicsQueue, "Models/mixer.obj" });
+	m_Meshes.push_back(new Mesh{ *m_GeometryArena, "Models/mixer.obj" });
 	m_Meshes.at(1)->SetModelMatrix
 	(
 		glm::translate
@@ -198,6 +324,16 @@ void Application::InitializeMeshes()
 			glm::vec3{ 0.0f, 20.0, 0.0f }
 		)
 	);
+
+	m_StagingRing->EndBatch();
+
+	// The gpu driven objects stay in the culling buffers, after this only moved objects get written again
+	for (int i{}; i < g_NumberOfMeshes; ++i) UpdateGpuObject(i);
+
+	const std::chrono::duration<float, std::milli> loadTime{ std::chrono::high_resolution_clock::now() - startTime };
+	std::cout << "Loaded " << m_Meshes.size() << " meshes in " << loadTime.count() << " ms, " << m_StagingRing->GetSubmissionCount() - submissionCount << " staging submissions" << std::endl;
+	std::cout << "Geometry arena holds " << m_Meshes.size() << " meshes, " << m_GeometryArena->GetVertexCount() << " vertices, " << m_GeometryArena->GetIndexCount(VK_INDEX_TYPE_UINT16)
+		<< " 16 bit and " << m_GeometryArena->GetIndexCount(VK_INDEX_TYPE_UINT32) << " 32 bit indices" << std::endl;
 }
 
 void Application::InitializeWindow()
@@ -221,6 +357,9 @@ void Application::InitializeVulkan()
 		throw std::runtime_error("vulkan doesn't have the required extensions for glfw!");
 	}
 
+	// Everything the application creates itself passes these, objects made by the helper functions still use the default allocator
+	m_HostAllocator = new HostAllocator{};
+
 	if (g_EnableValidationlayers)
 	{
 		if (!ValidationLayersPresent())
@@ -235,16 +374,32 @@ void Application::InitializeVulkan()
 	if (!PickPhysicalDevice()) throw std::runtime_error("Failed to find suitable gpu!");
 	if (CreateLogicalDevice() != VK_SUCCESS) throw std::runtime_error("failed to create logical device!");
 	RetrieveQueueHandles();
+	m_MemoryBudget = new MemoryBudget{ m_PhysicalDevice, m_MemoryBudgetSupported };
+	m_DeviceAllocator = new DeviceAllocator{ m_PhysicalDevice, m_Device, *m_MemoryBudget };
 	if (CreateSwapChain() != VK_SUCCESS) throw std::runtime_error("failed to create swap chain!");
 	RetrieveSwapChainImages();
 	if (CreateSwapChainImageViews() != VK_SUCCESS) throw std::runtime_error("failed to create swap chain image views!");
 	if (CreateRenderPass() != VK_SUCCESS) throw std::runtime_error("failed to create render pass!");
 	if (CreateTexturesDescriptorSetLayout() != VK_SUCCESS) throw std::runtime_error("failed to create textures descriptor set layout!");
 	if (CreateTransformsDescriptorSetLayout() != VK_SUCCESS) throw std::runtime_error("failed to create transforms descriptor set layout!");
+	if (CreateImpostorDescriptorSetLayout() != VK_SUCCESS) throw std::runtime_error("failed to create impostor descriptor set layout!");
+	if (m_GpuCullingSupported)
+	{
+		if (CreateTextureTableDescriptorSetLayout() != VK_SUCCESS) throw std::runtime_error("failed to create texture table descriptor set layout!");
+		m_GpuCulling = new GpuCulling{ m_PhysicalDevice, m_Device, *m_DeviceAllocator, g_MaxFramePerFlight, static_cast<uint32_t>(g_GpuDrawGroupIndexTypes.size()) };
+	}
 	if (CreateGraphicsPipeline() != VK_SUCCESS) throw std::runtime_error("failed to create grahpics pipeline!");
+	if (CreateImpostorPipeline() != VK_SUCCESS) throw std::runtime_error("failed to create impostor pipeline!");
 	if (CreateCommandPool() != VK_SUCCESS) throw std::runtime_error("failed to create command pool!");
+	const QueueFamilyIndices queueFamilyIndices{ FindQueueFamilies(m_PhysicalDevice, m_Surface) };
+	const uint32_t graphicsFamily{ queueFamilyIndices.GraphicsFamily.value() };
+	m_StagingRing = new StagingRing{ m_Device, *m_DeviceAllocator, graphicsFamily, m_GrahicsQueue, queueFamilyIndices.TransferFamily.value_or(graphicsFamily), m_TransferQueue };
+	std::cout << "Uploads run on the " << (m_StagingRing->UsesTransferQueue() ? "dedicated transfer" : "graphics") << " queue" << std::endl;
+	m_Defragmenter = new Defragmenter{ *m_DeviceAllocator, graphicsFamily, m_GrahicsQueue };
+	m_AttachmentPool = new AttachmentPool{ *m_DeviceAllocator };
 	CreateColorResources();
 	CreateDepthResources();
+	BindAttachmentResources();
 	if (CreateSwapChainFrameBuffers() != VK_SUCCESS) throw std::runtime_error("failed to create swap chain frame buffers!");
 	if (CreateCommandBuffers() != VK_SUCCESS) throw std::runtime_error("failed to create command buffer!");
 	if (CreateSyncObjects() != VK_SUCCESS) throw std::runtime_error("failed to create sync objects!");
@@ -363,7 +518,7 @@ VkResult Application::CreateVulkanInstance()
 		m_InstanceExtensionNames.data()																		// pEnabledExtensionNames
 	};
 
-	return vkCreateInstance(&instanceCreateInfo, nullptr, &m_Instance);
+	return vkCreateInstance(&instanceCreateInfo, m_HostAllocator->GetCallbacks(), &m_Instance);
 }
 
 VkResult Application::SetupDebugMessenger()
@@ -373,7 +528,7 @@ VkResult Application::SetupDebugMessenger()
 	VkDebugUtilsMessengerCreateInfoEXT createInformation{};
 	FillDebugMessengerCreateInfo(createInformation);
 
-	if (CreateDebugUtilsMessengerEXT(m_Instance, &createInformation, nullptr, &m_DebugMessenger) != VK_SUCCESS)
+	if (CreateDebugUtilsMessengerEXT(m_Instance, &createInformation, m_HostAllocator->GetCallbacks(), &m_DebugMessenger) != VK_SUCCESS)
 	{
 		throw std::runtime_error("failed to set up debug messenger!");
 	}
@@ -383,7 +538,7 @@ VkResult Application::SetupDebugMessenger()
 
 VkResult Application::CreateSurface()
 {
-	return glfwCreateWindowSurface(m_Instance, m_Window, nullptr, &m_Surface);
+	return glfwCreateWindowSurface(m_Instance, m_Window, m_HostAllocator->GetCallbacks(), &m_Surface);
 }
 
 bool Application::PickPhysicalDevice()
@@ -414,6 +569,7 @@ VkResult Application::CreateLogicalDevice()
 	QueueFamilyIndices queueFamilyIndices{ FindQueueFamilies(m_PhysicalDevice, m_Surface) };
 	std::vector<VkDeviceQueueCreateInfo> queueFamailyCreateInfos{};
 	std::set<uint32_t> queueFamilieIndexes{ queueFamilyIndices.GraphicsFamily.value(), queueFamilyIndices.PresentFamily.value() };
+	if (queueFamilyIndices.TransferFamily.has_value()) queueFamilieIndexes.insert(queueFamilyIndices.TransferFamily.value());
 
 	const float queuePriority{ 1.0f };
 
@@ -434,9 +590,67 @@ VkResult Application::CreateLogicalDevice()
 	physicalDeviceFeatures.samplerAnisotropy = VK_TRUE;
 	physicalDeviceFeatures.sampleRateShading = VK_TRUE;
 
+	// The gpu driven path needs indirect draws with a count buffer, core since vulkan 1.2 and supported by lavapipe
+	VkPhysicalDeviceProperties physicalDeviceProperties{};
+	vkGetPhysicalDeviceProperties(m_PhysicalDevice, &physicalDeviceProperties);
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPhysicalDeviceVulkan12Features.html
+	VkPhysicalDeviceVulkan12Features vulkan12Features{};
+	vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPhysicalDeviceFeatures2.html
+	VkPhysicalDeviceFeatures2 supportedFeatures{};
+	supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	supportedFeatures.pNext = &vulkan12Features;
+
+	if (physicalDeviceProperties.apiVersion >= VK_API_VERSION_1_2) vkGetPhysicalDeviceFeatures2(m_PhysicalDevice, &supportedFeatures);
+
+	// The culling dispatch gets recorded in the graphics command buffer
+	uint32_t queueFamilyCount{};
+	vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &queueFamilyCount, queueFamilyProperties.data());
+
+	m_GpuCullingSupported =
+		vulkan12Features.drawIndirectCount == VK_TRUE and
+		supportedFeatures.features.multiDrawIndirect == VK_TRUE and
+		supportedFeatures.features.drawIndirectFirstInstance == VK_TRUE and
+		supportedFeatures.features.shaderSampledImageArrayDynamicIndexing == VK_TRUE and
+		(queueFamilyProperties.at(queueFamilyIndices.GraphicsFamily.value()).queueFlags & VK_QUEUE_COMPUTE_BIT) != 0;
+
+	// Without the budget extension the memory budget falls back on a part of the heap sizes
+	m_MemoryBudgetSupported = DeviceExtensionSupported(m_PhysicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	if (m_MemoryBudgetSupported) m_PhysicalDeviceExtensionNames.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+	// Without host image copies the textures go through the staging ring
+	m_HostImageCopySupported = HostImageCopySupported(m_PhysicalDevice);
+	if (m_HostImageCopySupported) m_PhysicalDeviceExtensionNames.push_back(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME);
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPhysicalDeviceHostImageCopyFeaturesEXT.html
+	VkPhysicalDeviceHostImageCopyFeaturesEXT enabledHostImageCopyFeatures{};
+	enabledHostImageCopyFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT;
+	enabledHostImageCopyFeatures.hostImageCopy = VK_TRUE;
+
+	// The staging ring hands its uploads from the transfer queue to the graphics queue with timeline semaphores
+	if (vulkan12Features.timelineSemaphore != VK_TRUE) throw std::runtime_error("timeline semaphores are not supported!");
+
+	// Only the features we use get chained, the rest of the struct stays zero
+	VkPhysicalDeviceVulkan12Features enabledVulkan12Features{};
+	enabledVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	enabledVulkan12Features.timelineSemaphore = VK_TRUE;
+	if (m_HostImageCopySupported) enabledVulkan12Features.pNext = &enabledHostImageCopyFeatures;
+	if (m_GpuCullingSupported)
+	{
+		physicalDeviceFeatures.multiDrawIndirect = VK_TRUE;
+		physicalDeviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+		physicalDeviceFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+		enabledVulkan12Features.drawIndirectCount = VK_TRUE;
+	}
+
 	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDeviceCreateInfo.html
 	VkDeviceCreateInfo deviceCreateInfo{};
 	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	deviceCreateInfo.pNext = &enabledVulkan12Features;
 	deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueFamailyCreateInfos.size());
 	deviceCreateInfo.pQueueCreateInfos = queueFamailyCreateInfos.data();
 	deviceCreateInfo.pEnabledFeatures = &physicalDeviceFeatures;
@@ -452,7 +666,7 @@ VkResult Application::CreateLogicalDevice()
 		deviceCreateInfo.enabledLayerCount = 0;
 	}
 
-	return vkCreateDevice(m_PhysicalDevice, &deviceCreateInfo, nullptr, &m_Device);
+	return vkCreateDevice(m_PhysicalDevice, &deviceCreateInfo, m_HostAllocator->GetCallbacks(), &m_Device);
 }
 
 VkResult Application::CreateSwapChain()
@@ -506,7 +720,7 @@ VkResult Application::CreateSwapChain()
 	swapChaincreateInfo.clipped = VK_TRUE;
 	swapChaincreateInfo.oldSwapchain = VK_NULL_HANDLE;
 
-	return vkCreateSwapchainKHR(m_Device, &swapChaincreateInfo, nullptr, &m_SwapChain);
+	return vkCreateSwapchainKHR(m_Device, &swapChaincreateInfo, m_HostAllocator->GetCallbacks(), &m_SwapChain);
 }
 
 void Application::RetrieveQueueHandles()
@@ -515,6 +729,10 @@ void Application::RetrieveQueueHandles()
 
 	vkGetDeviceQueue(m_Device, queueFamilyIndices.GraphicsFamily.value(), 0, &m_GrahicsQueue);
 	vkGetDeviceQueue(m_Device, queueFamilyIndices.PresentFamily.value(), 0, &m_PresentQueue);
+
+	// Without a transfer only family the uploads share the graphics queue
+	if (queueFamilyIndices.TransferFamily.has_value()) vkGetDeviceQueue(m_Device, queueFamilyIndices.TransferFamily.value(), 0, &m_TransferQueue);
+	else m_TransferQueue = m_GrahicsQueue;
 }
 
 void Application::RetrieveSwapChainImages()
@@ -539,7 +757,7 @@ VkResult Application::CreateSwapChainImageViews()
 VkResult Application::CreateGraphicsPipeline()
 {
 
-	m_VertexShader = CreateShaderModule(LoadSPIRV("shaders/vert.spv"), m_Device);
+	m_VertexShader = CreateShaderModule(LoadSPIRV(VertexFormat<g_VertexLayout>::ShaderPath), m_Device);
 	m_FragmentShader = CreateShaderModule(LoadSPIRV("shaders/frag.spv"), m_Device);
 
 	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineShaderStageCreateInfo.html
@@ -557,8 +775,8 @@ VkResult Application::CreateGraphicsPipeline()
 
 	VkPipelineShaderStageCreateInfo shaderStages[2]{ vertShaderStageInfo, fragShaderStageInfo };
 
-	const auto vertexBindingDescription{ Vertex::GetBindingDescription() };
-	const auto vertexAttributeDescriptions{ Vertex::GetAttributeDescriptions() };
+	const auto vertexBindingDescription{ VertexFormat<g_VertexLayout>::GetBindingDescription() };
+	const auto vertexAttributeDescriptions{ VertexFormat<g_VertexLayout>::GetAttributeDescriptions() };
 
 	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineVertexInputStateCreateInfo.html
 	const VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo
@@ -681,7 +899,7 @@ VkResult Application::CreateGraphicsPipeline()
 		&pushConstantRange											// pPushConstantRanges
 	};
 
-	if (vkCreatePipelineLayout(m_Device, &pipelineLayoutCreateInfo, nullptr, &m_PipeLineLayout) != VK_SUCCESS) throw std::runtime_error("failed to create pipeline layout!");
+	if (vkCreatePipelineLayout(m_Device, &pipelineLayoutCreateInfo, m_HostAllocator->GetCallbacks(), &m_PipeLineLayout) != VK_SUCCESS) throw std::runtime_error("failed to create pipeline layout!");
 
 	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkGraphicsPipelineCreateInfo.html
 	const VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo
@@ -707,7 +925,201 @@ VkResult Application::CreateGraphicsPipeline()
 		0														// basePipelineIndex
 	};
 
-	return vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, nullptr, &m_PipeLine);
+	const VkResult result{ vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, m_HostAllocator->GetCallbacks(), &m_PipeLine) };
+	if (result != VK_SUCCESS or m_GpuCulling == nullptr) return result;
+
+	// Same state for the gpu driven path, its vertex shader reads the model matrix and material out of the culled objects
+	m_GpuDrivenVertexShader = CreateShaderModule(LoadSPIRV(VertexFormat<g_VertexLayout>::GpuDrivenShaderPath), m_Device);
+	m_GpuDrivenFragmentShader = CreateShaderModule(LoadSPIRV("shaders/frag_gpu.spv"), m_Device);
+	shaderStages[0].module = m_GpuDrivenVertexShader;
+	shaderStages[1].module = m_GpuDrivenFragmentShader;
+
+	// The texture table of the fragment shader gets sized with a specialization constant
+	const uint32_t materialCount{ static_cast<uint32_t>(g_NumberOfMeshes) };
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkSpecializationMapEntry.html
+	const VkSpecializationMapEntry specializationMapEntry
+	{
+		0,								// constantID
+		0,								// offset
+		sizeof(materialCount)			// size
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkSpecializationInfo.html
+	const VkSpecializationInfo specializationInfo
+	{
+		1,								// mapEntryCount
+		&specializationMapEntry,		// pMapEntries
+		sizeof(materialCount),			// dataSize
+		&materialCount					// pData
+	};
+	shaderStages[1].pSpecializationInfo = &specializationInfo;
+
+	const std::array<VkDescriptorSetLayout, 3> gpuDrivenDescriptorSetLayouts{ m_TransformsDescriptorSetLayout, m_TextureTableDescriptorSetLayout, m_GpuCulling->GetDescriptorSetLayout() };
+
+	VkPipelineLayoutCreateInfo gpuDrivenPipelineLayoutCreateInfo{ pipelineLayoutCreateInfo };
+	gpuDrivenPipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(gpuDrivenDescriptorSetLayouts.size());
+	gpuDrivenPipelineLayoutCreateInfo.pSetLayouts = gpuDrivenDescriptorSetLayouts.data();
+
+	if (vkCreatePipelineLayout(m_Device, &gpuDrivenPipelineLayoutCreateInfo, m_HostAllocator->GetCallbacks(), &m_GpuDrivenPipeLineLayout) != VK_SUCCESS) throw std::runtime_error("failed to create gpu driven pipeline layout!");
+
+	VkGraphicsPipelineCreateInfo gpuDrivenPipelineCreateInfo{ graphicsPipelineCreateInfo };
+	gpuDrivenPipelineCreateInfo.layout = m_GpuDrivenPipeLineLayout;
+
+	return vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &gpuDrivenPipelineCreateInfo, m_HostAllocator->GetCallbacks(), &m_GpuDrivenPipeLine);
+}
+
+VkResult Application::CreateImpostorPipeline()
+{
+	m_ImpostorVertexShader = CreateShaderModule(LoadSPIRV("shaders/impostor_vert.spv"), m_Device);
+	m_ImpostorFragmentShader = CreateShaderModule(LoadSPIRV("shaders/impostor_frag.spv"), m_Device);
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineShaderStageCreateInfo.html
+	VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
+	vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+	vertShaderStageInfo.module = m_ImpostorVertexShader;
+	vertShaderStageInfo.pName = "main";
+
+	VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
+	fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	fragShaderStageInfo.module = m_ImpostorFragmentShader;
+	fragShaderStageInfo.pName = "main";
+
+	VkPipelineShaderStageCreateInfo shaderStages[2]{ vertShaderStageInfo, fragShaderStageInfo };
+
+	// The quad gets built from the vertex index, so there is no vertex input
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineVertexInputStateCreateInfo.html
+	const VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,		// sType
+		nullptr,														// pNext
+		0,																// flags
+		0,																// vertexBindingDescriptionCount
+		nullptr,														// pVertexBindingDescriptions
+		0,																// vertexAttributeDescriptionCount
+		nullptr															// pVertexAttributeDescriptions
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineInputAssemblyStateCreateInfo.html
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDynamicState.html
+	std::vector<VkDynamicState> dynamicStates{ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineDynamicStateCreateInfo.html
+	VkPipelineDynamicStateCreateInfo dynamicState{};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+	dynamicState.pDynamicStates = dynamicStates.data();
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineViewportStateCreateInfo.html
+	VkPipelineViewportStateCreateInfo viewportState{};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportState.viewportCount = 1;
+	viewportState.scissorCount = 1;
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineDepthStencilStateCreateInfo.html
+	const VkPipelineDepthStencilStateCreateInfo pipelineDepthStencilCreateInfo
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,				// sType
+		nullptr,																// pNext
+		0,																		// flags
+		VK_TRUE,																// depthTestEnable
+		VK_TRUE,																// depthWriteEnable
+		VK_COMPARE_OP_LESS,														// depthCompareOp
+		VK_FALSE,																// depthBoundsTestEnable
+		VK_FALSE,																// stencilTestEnable
+		VkStencilOpState{},														// front
+		VkStencilOpState{},														// back
+		0.0f,																	// minDepthBounds
+		1.0f																	// maxDepthBounds
+	};
+
+	// The quad always faces the camera, no need to care about its winding
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineRasterizationStateCreateInfo.html
+	VkPipelineRasterizationStateCreateInfo rasterizer{};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizer.depthClampEnable = VK_FALSE;
+	rasterizer.rasterizerDiscardEnable = VK_FALSE;
+	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizer.lineWidth = 1.0f;
+	rasterizer.cullMode = VK_CULL_MODE_NONE;
+	rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	rasterizer.depthBiasEnable = VK_FALSE;
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineMultisampleStateCreateInfo.html
+	VkPipelineMultisampleStateCreateInfo multisampling{};
+	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisampling.sampleShadingEnable = VK_FALSE;
+	multisampling.rasterizationSamples = m_MSAASamples;
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineColorBlendAttachmentState.html
+	VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	colorBlendAttachment.blendEnable = VK_FALSE;
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineColorBlendStateCreateInfo.html
+	VkPipelineColorBlendStateCreateInfo colorBlending{};
+	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlending.logicOpEnable = VK_FALSE;
+	colorBlending.logicOp = VK_LOGIC_OP_COPY;
+	colorBlending.attachmentCount = 1;
+	colorBlending.pAttachments = &colorBlendAttachment;
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPushConstantRange.html
+	const VkPushConstantRange pushConstantRange
+	{
+		VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+		0,
+		sizeof(ImpostorPushConstants)
+	};
+
+	const std::array<VkDescriptorSetLayout, 2> descriptorSetLayouts{ m_TransformsDescriptorSetLayout, m_ImpostorDescriptorSetLayout };
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineLayoutCreateInfo.html
+	const VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,				// sType
+		nullptr,													// pNext
+		0,															// flags
+		static_cast<uint32_t>(descriptorSetLayouts.size()),			// setLayoutCount
+		descriptorSetLayouts.data(),								// pSetLayouts
+		1,															// pushConstantRangeCount
+		&pushConstantRange											// pPushConstantRanges
+	};
+
+	if (vkCreatePipelineLayout(m_Device, &pipelineLayoutCreateInfo, m_HostAllocator->GetCallbacks(), &m_ImpostorPipeLineLayout) != VK_SUCCESS) throw std::runtime_error("failed to create impostor pipeline layout!");
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkGraphicsPipelineCreateInfo.html
+	const VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo
+	{
+		VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,		// sType
+		nullptr,												// pNext
+		0,														// flags
+		2,														// stageCount
+		shaderStages,											// pStages
+		&vertexInputStateCreateInfo,							// pVertexInputState
+		&inputAssembly,											// pInputAssemblyState
+		nullptr,												// pTessellationState
+		&viewportState,											// pViewportState
+		&rasterizer,											// pRasterizationState
+		&multisampling,											// pMultisampleState
+		&pipelineDepthStencilCreateInfo,						// pDepthStencilState
+		&colorBlending,											// pColorBlendState
+		&dynamicState,											// pDynamicState
+		m_ImpostorPipeLineLayout,								// layout
+		m_RenderPass,											// renderPass
+		0,														// subpass
+		nullptr,												// basePipelineHandle
+		0														// basePipelineIndex
+	};
+
+	return vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, m_HostAllocator->GetCallbacks(), &m_ImpostorPipeLine);
 }
 
 VkResult Application::CreateRenderPass()
@@ -715,14 +1127,14 @@ VkResult Application::CreateRenderPass()
 	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkAttachmentDescription.html
 	std::array<VkAttachmentDescription, 3> attachmentDescriptions
 	{
-		// color attachment
+		// color attachment, resolved inside the pass so it never has to be stored
 		VkAttachmentDescription
 		{
 			0,													// flags
 			m_ImageFormat,										// format
 			m_MSAASamples,										// samples
 			VK_ATTACHMENT_LOAD_OP_CLEAR,						// loadOp
-			VK_ATTACHMENT_STORE_OP_STORE,						// storeOp
+			VK_ATTACHMENT_STORE_OP_DONT_CARE,					// storeOp
 			VK_ATTACHMENT_LOAD_OP_DONT_CARE,					// stencilLoadOp
 			VK_ATTACHMENT_STORE_OP_DONT_CARE,					// stencilStoreOp
 			VK_IMAGE_LAYOUT_UNDEFINED,							// initialLayout
@@ -816,7 +1228,7 @@ VkResult Application::CreateRenderPass()
 		&subpassDependency									// pDependencies
 	};
 
-	return vkCreateRenderPass(m_Device, &renderPassCreateInfo, nullptr, &m_RenderPass);
+	return vkCreateRenderPass(m_Device, &renderPassCreateInfo, m_HostAllocator->GetCallbacks(), &m_RenderPass);
 }
 
 VkResult Application::CreateSwapChainFrameBuffers()
@@ -843,7 +1255,7 @@ VkResult Application::CreateSwapChainFrameBuffers()
 			1														// layers
 		};
 
-		result = vkCreateFramebuffer(m_Device, &frameBufferCreateInfo, nullptr, &m_SwapChainFrameBuffers.at(i));
+		result = vkCreateFramebuffer(m_Device, &frameBufferCreateInfo, m_HostAllocator->GetCallbacks(), &m_SwapChainFrameBuffers.at(i));
 		if (result != VK_SUCCESS) return result;
 	}
 
@@ -863,7 +1275,7 @@ VkResult Application::CreateCommandPool()
 		queueFamilyIndices.GraphicsFamily.value()				// queueFamilyIndex
 	};
 
-	return vkCreateCommandPool(m_Device, &commandPoolCreateInfo, nullptr, &m_CommandPool);
+	return vkCreateCommandPool(m_Device, &commandPoolCreateInfo, m_HostAllocator->GetCallbacks(), &m_CommandPool);
 }
 
 VkResult Application::CreateCommandBuffers()
@@ -923,6 +1335,15 @@ void Application::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t im
 		clearColors.data()																			// pClearValues
 	};
 
+	// Only meshes whose world space bounds touch the view frustum get drawn
+	glm::mat4 projectionMatrix{ m_Camera->GetProjectionMatrix() };
+	projectionMatrix[1][1] *= -1;
+	const Frustum frustum{ ExtractFrustum(projectionMatrix * m_Camera->GetViewMatrx()) };
+
+	// The compute pass has to be recorded before the render pass starts
+	const bool gpuDriven{ m_GpuDriven and m_GpuCulling != nullptr };
+	if (gpuDriven) RecordGpuCulling(commandBuffer, frustum);
+
 	vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipeLine);
@@ -943,28 +1364,220 @@ void Application::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t im
 
 	vkCmdPushConstants(commandBuffer, m_PipeLineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstants), &m_PushConstants);
 
-	for (int i{}; i < g_NumberOfMeshes; ++i)
+	uint32_t submittedIndices{};
+	std::array<bool, g_NumberOfMeshes> drawImpostors{};
+
+	// Every mesh lives in the geometry arena, the vertex buffer gets bound once and the index buffer once per index type
+	const VkBuffer vertexBuffers[]{ m_GeometryArena->GetVertexBuffer() };
+	const VkDeviceSize offsets[]{ 0 };
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+
+	VkIndexType boundIndexType{ VK_INDEX_TYPE_MAX_ENUM };
+
+	if (gpuDriven)
+	{
+		// The compute pass already culled, nothing is left for the cpu path below. Any object might get drawn, so all textures count as used
+		m_VisibleObjects.clear();
+		submittedIndices += RecordGpuDrivenDraws(commandBuffer);
+		for (uint32_t evictable : m_TextureEvictables) m_MemoryBudget->Touch(evictable);
+	}
+	else
+	{
+		ClearObjectBounds(m_ObjectBounds);
+		for (const Mesh* mesh : m_Meshes) AddObjectBounds(m_ObjectBounds, mesh->GetBoundingBox(), mesh->GetModelMatrix());
+		CullObjects(frustum, m_ObjectBounds, m_VisibleObjects);
+	}
+
+	for (uint32_t i : m_VisibleObjects)
 	{
-		const VkBuffer vertexBuffers[]{ m_Meshes.at(i)->GetVertexBuffer() };
-		const VkDeviceSize offsets[]{ 0 };
+		// Meshes covering only a few pixels go through the impostor pipeline afterwards
+		const float pixelsPerUnit{ CalculatePixelsPerUnit(*m_Meshes.at(i)) };
+		drawImpostors.at(i) = m_ForceImpostors or m_Meshes.at(i)->GetBoundingSphere().Radius * pixelsPerUnit < g_ImpostorScreenRadius;
+		drawImpostors.at(i) = drawImpostors.at(i) and m_Impostors.at(i)->IsBaked();
+		if (drawImpostors.at(i)) continue;
 
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-		vkCmdBindIndexBuffer(commandBuffer, m_Meshes.at(i)->GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+		for (uint32_t j{}; j < g_TexturesPerMesh; ++j) m_MemoryBudget->Touch(m_TextureEvictables.at(i * g_TexturesPerMesh + j));
+
+		if (m_Meshes.at(i)->GetIndexType() != boundIndexType)
+		{
+			boundIndexType = m_Meshes.at(i)->GetIndexType();
+			vkCmdBindIndexBuffer(commandBuffer, m_GeometryArena->GetIndexBuffer(boundIndexType), 0, boundIndexType);
+		}
 
 		const std::array<VkDescriptorSet, 2> descriptorSets { m_TransformsDescriptorSets.at(m_CurrentFrame).at(i), m_TexturesDescriptorSets.at(i) };
 		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipeLineLayout, 0, static_cast<uint32_t>(descriptorSets.size()), descriptorSets.data(), 0, nullptr);
 
-		vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(m_Meshes.at(i)->GetIndices().size()), 1, 0, 0, 0);
+		// The meshlets only cover the full detail level
+		const uint32_t lod{ (m_LodSelection) ? SelectLod(*m_Meshes.at(i), pixelsPerUnit) : 0 };
+		if (lod == 0 and m_MeshletCulling and !m_Meshes.at(i)->GetMeshlets().empty())
+		{
+			submittedIndices += RecordVisibleMeshlets(commandBuffer, *m_Meshes.at(i));
+		}
+		else
+		{
+			const MeshLod& meshLod{ m_Meshes.at(i)->GetLods().at(lod) };
+			vkCmdDrawIndexed(commandBuffer, meshLod.IndexCount, 1, m_Meshes.at(i)->GetFirstIndex() + meshLod.FirstIndex, m_Meshes.at(i)->GetVertexOffset(), 0);
+			submittedIndices += meshLod.IndexCount;
+		}
+	}
+
+	if (std::find(drawImpostors.begin(), drawImpostors.end(), true) != drawImpostors.end())
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_ImpostorPipeLine);
+
+		for (int i{}; i < g_NumberOfMeshes; ++i)
+		{
+			if (!drawImpostors.at(i)) continue;
+			m_MemoryBudget->Touch(m_ImpostorEvictables.at(i));
+
+			const std::array<VkDescriptorSet, 2> descriptorSets{ m_TransformsDescriptorSets.at(m_CurrentFrame).at(i), m_ImpostorDescriptorSets.at(i) };
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_ImpostorPipeLineLayout, 0, static_cast<uint32_t>(descriptorSets.size()), descriptorSets.data(), 0, nullptr);
+
+			const BoundingSphere& boundingSphere{ m_Impostors.at(i)->GetBoundingSphere() };
+			const ImpostorPushConstants pushConstants
+			{
+				glm::vec4{ boundingSphere.Center, boundingSphere.Radius },		// BoundingSphere
+				static_cast<int>(g_ImpostorFrameCount),							// FrameCount
+				m_PushConstants.RenderType										// RenderType
+			};
+			vkCmdPushConstants(commandBuffer, m_ImpostorPipeLineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(ImpostorPushConstants), &pushConstants);
+
+			// The quad its corners come from the vertex index
+			vkCmdDraw(commandBuffer, 6, 1, 0, 0);
+			submittedIndices += 6;
+		}
 	}
 
 	vkCmdEndRenderPass(commandBuffer);
 
+	if (submittedIndices / 3 != m_SubmittedTriangles)
+	{
+		m_SubmittedTriangles = submittedIndices / 3;
+
+		const std::string title{ "Vulkan - " + std::to_string(m_SubmittedTriangles) + " triangles" };
+		glfwSetWindowTitle(m_Window, title.c_str());
+	}
+
 	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
 	{
 		throw std::runtime_error("failed to record command buffer");
 	}
 }
 
+float Application::CalculatePixelsPerUnit(const Mesh& mesh) const
+{
+	// Mesh space units get scaled like the bounding sphere, so the model matrix should have a uniform scale
+	const glm::mat4 modelMatrix{ mesh.GetModelMatrix() };
+	const float scale{ glm::length(glm::vec3{ modelMatrix[0] }) };
+	const glm::vec3 center{ modelMatrix * glm::vec4{ mesh.GetBoundingSphere().Center, 1.0f } };
+
+	// Distance to the closest point of the bounding sphere, from inside it a unit can cover any number of pixels
+	const float distance{ glm::length(center - m_Camera->GetPosition()) - mesh.GetBoundingSphere().Radius * scale };
+	if (distance <= 0.0f) return std::numeric_limits<float>::max();
+
+	// Element [1][1] of the projection is the cotangent of half the vertical field of view
+	return m_Camera->GetProjectionMatrix()[1][1] * 0.5f * static_cast<float>(m_ImageExtend.height) * scale / distance;
+}
+
+uint32_t Application::SelectLod(const Mesh& mesh, float pixelsPerUnit) const
+{
+	const std::vector<MeshLod>& lods{ mesh.GetLods() };
+
+	uint32_t lod{};
+	for (uint32_t i{ 1 }; i < static_cast<uint32_t>(lods.size()); ++i)
+	{
+		if (lods.at(i).Error * pixelsPerUnit <= g_LodPixelError) lod = i;
+	}
+
+	return lod;
+}
+
+uint32_t Application::RecordVisibleMeshlets(VkCommandBuffer commandBuffer, const Mesh& mesh)
+{
+	glm::mat4 projectionMatrix{ m_Camera->GetProjectionMatrix() };
+	projectionMatrix[1][1] *= -1;
+
+	// Culling happens in mesh space, the cone test assumes the model matrix has a uniform scale
+	const Frustum frustum{ ExtractFrustum(projectionMatrix * m_Camera->GetViewMatrx() * mesh.GetModelMatrix()) };
+	const glm::vec3 cameraPosition{ glm::inverse(mesh.GetModelMatrix()) * glm::vec4{ m_Camera->GetPosition(), 1.0f } };
+
+	// Visible meshlets next to each other in the index buffer share one draw, so do ones with a short gap of culled meshlets in between
+	uint32_t firstIndex{};
+	uint32_t indexCount{};
+	uint32_t submittedIndices{};
+
+	for (const Meshlet& meshlet : mesh.GetMeshlets())
+	{
+		if (!IsMeshletVisible(meshlet, frustum, cameraPosition)) continue;
+
+		if (indexCount != 0 and meshlet.FirstIndex - (firstIndex + indexCount) <= g_MeshletDrawGapTriangles * 3)
+		{
+			indexCount = meshlet.FirstIndex + meshlet.IndexCount - firstIndex;
+			continue;
+		}
+
+		if (indexCount != 0) vkCmdDrawIndexed(commandBuffer, indexCount, 1, mesh.GetFirstIndex() + firstIndex, mesh.GetVertexOffset(), 0);
+		submittedIndices += indexCount;
+		firstIndex = meshlet.FirstIndex;
+		indexCount = meshlet.IndexCount;
+	}
+
+	if (indexCount != 0) vkCmdDrawIndexed(commandBuffer, indexCount, 1, mesh.GetFirstIndex() + firstIndex, mesh.GetVertexOffset(), 0);
+	submittedIndices += indexCount;
+
+	return submittedIndices;
+}
+
+void Application::RecordGpuCulling(VkCommandBuffer commandBuffer, const Frustum& frustum)
+{
+	// The objects live in the culling buffers, only the ones UpdateGpuObject changed get copied in
+	m_GpuCulling->RecordCulling(commandBuffer, m_CurrentFrame, frustum);
+}
+
+uint32_t Application::RecordGpuDrivenDraws(VkCommandBuffer commandBuffer)
+{
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_GpuDrivenPipeLine);
+	vkCmdPushConstants(commandBuffer, m_GpuDrivenPipeLineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstants), &m_PushConstants);
+
+	// Every mesh its uniform buffer holds the same view and projection, the model matrices come from the objects
+	const std::array<VkDescriptorSet, 3> descriptorSets{ m_TransformsDescriptorSets.at(m_CurrentFrame).at(0), m_TextureTableDescriptorSet, m_GpuCulling->GetDescriptorSet(m_CurrentFrame) };
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_GpuDrivenPipeLineLayout, 0, static_cast<uint32_t>(descriptorSets.size()), descriptorSets.data(), 0, nullptr);
+
+	// One indirect draw per index type, no matter how many objects there are or how many survived the culling
+	for (uint32_t i{}; i < static_cast<uint32_t>(g_GpuDrawGroupIndexTypes.size()); ++i)
+	{
+		const VkIndexType indexType{ g_GpuDrawGroupIndexTypes.at(i) };
+		vkCmdBindIndexBuffer(commandBuffer, m_GeometryArena->GetIndexBuffer(indexType), 0, indexType);
+
+		m_GpuCulling->RecordDraws(commandBuffer, m_CurrentFrame, i);
+	}
+
+	// The fence of this frame got waited on, so the counts are the ones of its previous submission
+	return m_GpuCulling->GetSubmittedIndexCount(m_CurrentFrame);
+}
+
+void Application::UpdateGpuObject(uint32_t mesh)
+{
+	if (m_GpuCulling == nullptr) return;
+
+	// The gpu path always draws the full detail level
+	const Mesh& gpuMesh{ *m_Meshes.at(mesh) };
+	const MeshLod& meshLod{ gpuMesh.GetLods().at(0) };
+	const uint32_t drawGroup{ static_cast<uint32_t>(std::find(g_GpuDrawGroupIndexTypes.begin(), g_GpuDrawGroupIndexTypes.end(), gpuMesh.GetIndexType()) - g_GpuDrawGroupIndexTypes.begin()) };
+
+	m_GpuCulling->SetObject(mesh, GpuObject
+	{
+		gpuMesh.GetModelMatrix(),																	// ModelMatrix
+		glm::vec4{ gpuMesh.GetBoundingSphere().Center, gpuMesh.GetBoundingSphere().Radius },		// BoundingSphere
+		meshLod.IndexCount,																			// IndexCount
+		gpuMesh.GetFirstIndex() + meshLod.FirstIndex,												// FirstIndex
+		gpuMesh.GetVertexOffset(),																	// VertexOffset
+		drawGroup,																					// DrawGroup
+		mesh,																						// MaterialIndex
+		{}																							// Padding
+	});
+}
+
 void Application::UpdateUniformBuffers(uint32_t currentImage)
 {
 	for (size_t i{}; i < m_Meshes.size(); ++i)
@@ -986,6 +1599,43 @@ void Application::DrawFrame()
 {
 	vkWaitForFences(m_Device, 1, &m_InFlight[m_CurrentFrame], VK_TRUE, UINT64_MAX);
 
+	// Uploads the transfer queue finished get handed to the graphics queue ahead of this frame, unfinished ones are left running.
+	// Evictions and restores whose uploads finished get committed from here
+	m_StagingRing->Update();
+
+	// Textures get replaced without waiting on the copies, until they are committed nothing else gets evicted or restored.
+	// Impostor atlases and attachments are released right away, only the other frame in flight has to be done with them
+	m_MemoryBudget->Update();
+	if (!m_ResidencyChangePending and m_MemoryBudget->CanEvict())
+	{
+		vkWaitForFences(m_Device, static_cast<uint32_t>(m_InFlight.size()), m_InFlight.data(), VK_TRUE, UINT64_MAX);
+
+		m_StagingRing->BeginBatch();
+		const uint32_t evictedCount{ m_MemoryBudget->Evict() };
+		m_StagingRing->EndBatch();
+
+		m_ResidencyChangePending = true;
+		m_StagingRing->CallWhenFinished([this]() { CommitResidencyChanges(); });
+
+		std::cout << "Near the memory budget, evicted " << evictedCount << " resources" << std::endl;
+	}
+	else if (!m_ResidencyChangePending and m_MemoryBudget->CanRestore())
+	{
+		RestoreResources();
+	}
+
+	// Both frames in flight share the texture descriptor sets, so moved resources only get swapped in once neither frame runs
+	if (m_Defragmenter->IsCommitPending())
+	{
+		vkWaitForFences(m_Device, static_cast<uint32_t>(m_InFlight.size()), m_InFlight.data(), VK_TRUE, UINT64_MAX);
+		m_Defragmenter->Commit();
+		UpdateTexturesDescriptorSets();
+
+		// Moved geometry changes the first index and vertex offset of the objects
+		for (int i{}; i < g_NumberOfMeshes; ++i) UpdateGpuObject(i);
+	}
+	m_Defragmenter->Update();
+
 	uint32_t imageIndex;
 	VkResult result{ vkAcquireNextImageKHR(m_Device, m_SwapChain, UINT64_MAX, m_ImageAvailable[m_CurrentFrame], VK_NULL_HANDLE, &imageIndex) };
 	if (result == VK_ERROR_OUT_OF_DATE_KHR)
@@ -1043,6 +1693,7 @@ void Application::DrawFrame()
 	}
 
 	m_CurrentFrame = (m_CurrentFrame + 1) % g_MaxFramePerFlight;
+	m_HostAllocator->EndFrame();
 }
 
 VkResult Application::CreateSyncObjects()
@@ -1071,13 +1722,13 @@ VkResult Application::CreateSyncObjects()
 
 	for (int i{}; i < g_MaxFramePerFlight; ++i)
 	{
-		result = vkCreateSemaphore(m_Device, &semaphoreCreateInfo, nullptr, &m_ImageAvailable[i]);
+		result = vkCreateSemaphore(m_Device, &semaphoreCreateInfo, m_HostAllocator->GetCallbacks(), &m_ImageAvailable[i]);
 		if (result != VK_SUCCESS) return result;
 
-		result = vkCreateSemaphore(m_Device, &semaphoreCreateInfo, nullptr, &m_RenderFinished[i]);
+		result = vkCreateSemaphore(m_Device, &semaphoreCreateInfo, m_HostAllocator->GetCallbacks(), &m_RenderFinished[i]);
 		if (result != VK_SUCCESS) return result;
 
-		result = vkCreateFence(m_Device, &fenceCreateInfo, nullptr, &m_InFlight[i]);
+		result = vkCreateFence(m_Device, &fenceCreateInfo, m_HostAllocator->GetCallbacks(), &m_InFlight[i]);
 		if (result != VK_SUCCESS) return result;
 	}
 
@@ -1096,6 +1747,8 @@ void Application::RecreateSwapChain()
 
 	vkDeviceWaitIdle(m_Device);
 
+	const DeviceMemoryStatistics statisticsBefore{ m_DeviceAllocator->GetStatistics() };
+
 	CleanupSwapChain();
 
 	if (CreateSwapChain() != VK_SUCCESS) throw std::runtime_error("Failed to recreate swap chain");
@@ -1103,29 +1756,92 @@ void Application::RecreateSwapChain()
 	if (CreateSwapChainImageViews() != VK_SUCCESS) throw std::runtime_error("Failed to recreate swap chain image views");
 	CreateColorResources();
 	CreateDepthResources();
+	BindAttachmentResources();
 	if (CreateSwapChainFrameBuffers() != VK_SUCCESS) throw std::runtime_error("Failed to recreate swap chain frame buffers");
+
+	const DeviceMemoryStatistics statisticsAfter{ m_DeviceAllocator->GetStatistics() };
+	std::cout << "Swap chain recreated at " << m_ImageExtend.width << "x" << m_ImageExtend.height << std::fixed << std::setprecision(1)
+		<< ", device memory " << double(statisticsBefore.BlockBytes + statisticsBefore.DedicatedBytes) / 1048576.0
+		<< " MiB before " << double(statisticsAfter.BlockBytes + statisticsAfter.DedicatedBytes) / 1048576.0
+		<< " MiB after, attachments " << double(m_AttachmentPool->GetBoundSize()) / 1048576.0
+		<< " MiB of the " << double(m_AttachmentPool->GetSize()) / 1048576.0 << " MiB pool, "
+		<< m_AttachmentPool->GetAllocationCount() << " pool allocations" << std::endl;
+	std::cout << std::defaultfloat;
 }
 
 void Application::CleanupSwapChain()
+{
+	CleanupAttachments();
+
+	for (auto imageView : m_SwapChainImageViews)
+	{
+		vkDestroyImageView(m_Device, imageView, nullptr);
+	}
+
+	vkDestroySwapchainKHR(m_Device, m_SwapChain, m_HostAllocator->GetCallbacks());
+}
+
+void Application::CleanupAttachments()
 {
 	vkDestroyImageView(m_Device, m_DepthImageView, nullptr);
 	vkDestroyImage(m_Device, m_DepthImage, nullptr);
-	vkFreeMemory(m_Device, m_DepthMemory, nullptr);
 	vkDestroyImageView(m_Device, m_ColorImageView, nullptr);
 	vkDestroyImage(m_Device, m_ColorImage, nullptr);
-	vkFreeMemory(m_Device, m_ColorMemory, nullptr);
 
 	for (auto frameBuffer : m_SwapChainFrameBuffers)
 	{
-		vkDestroyFramebuffer(m_Device, frameBuffer, nullptr);
+		vkDestroyFramebuffer(m_Device, frameBuffer, m_HostAllocator->GetCallbacks());
 	}
+}
 
-	for (auto imageView : m_SwapChainImageViews)
+void Application::TrimAttachments()
+{
+	// Same attachments again, this time in a pool that holds nothing but them
+	CleanupAttachments();
+	m_AttachmentPool->Release();
+
+	CreateColorResources();
+	CreateDepthResources();
+	BindAttachmentResources();
+	if (CreateSwapChainFrameBuffers() != VK_SUCCESS) throw std::runtime_error("Failed to recreate swap chain frame buffers");
+}
+
+void Application::RestoreResources()
+{
+	// The textures load into new images in one submission, frames keep sampling the evicted ones until the uploads finished
+	m_StagingRing->BeginBatch();
+	const uint32_t restoredCount{ m_MemoryBudget->Restore() };
+	m_StagingRing->EndBatch();
+
+	m_ResidencyChangePending = true;
+	m_StagingRing->CallWhenFinished([this]() { CommitResidencyChanges(); });
+
+	std::cout << "Memory budget has room again, restoring " << restoredCount << " resources" << std::endl;
+}
+
+void Application::CommitResidencyChanges()
+{
+	// Both frames in flight share the texture descriptor sets, the replaced images only go once neither frame runs
+	vkWaitForFences(m_Device, static_cast<uint32_t>(m_InFlight.size()), m_InFlight.data(), VK_TRUE, UINT64_MAX);
+
+	for (int i{}; i < g_NumberOfMeshes; ++i)
 	{
-		vkDestroyImageView(m_Device, imageView, nullptr);
+		const std::array<Texture*, g_TexturesPerMesh> textures{ m_BaseColorTextures.at(i), m_NormalTextures.at(i), m_GlossTextures.at(i), m_SpecularTextures.at(i) };
+		for (Texture* texture : textures) texture->ReleaseRetired();
 	}
+	UpdateTexturesDescriptorSets();
 
-	vkDestroySwapchainKHR(m_Device, m_SwapChain, nullptr);
+	// The bakes draw with the textures that are in the descriptor sets now, the restored impostors get drawn once they are recorded
+	for (int i{}; i < g_NumberOfMeshes; ++i)
+	{
+		if (!m_Impostors.at(i)->IsResident() or m_Impostors.at(i)->IsBaked()) continue;
+		m_Impostors.at(i)->Bake(*m_ImpostorBaker, *m_Meshes.at(i), m_TexturesDescriptorSets.at(i));
+	}
+	const uint32_t bakeCount{ m_ImpostorBaker->Submit() };
+	if (bakeCount > 0) UpdateImpostorDescriptorSets();
+
+	m_ResidencyChangePending = false;
+	std::cout << "Uploads of the evicted and restored textures finished, baked " << bakeCount << " impostors again" << std::endl;
 }
 
 void Application::FrameBufferResizedCallback(GLFWwindow* window, int width, int height)
@@ -1169,6 +1885,30 @@ void Application::KeyCallback(GLFWwindow* window, int key, int scancode, int act
 	{
 		m_PushConstants.RenderType = static_cast<int>(RenderType::Specular);
 	}
+	else if (key == GLFW_KEY_C && action == GLFW_RELEASE)
+	{
+		m_MeshletCulling = !m_MeshletCulling;
+		std::cout << "Meshlet culling " << ((m_MeshletCulling) ? "on" : "off") << std::endl;
+	}
+	else if (key == GLFW_KEY_L && action == GLFW_RELEASE)
+	{
+		m_LodSelection = !m_LodSelection;
+		std::cout << "Lod selection " << ((m_LodSelection) ? "on" : "off") << std::endl;
+	}
+	else if (key == GLFW_KEY_I && action == GLFW_RELEASE)
+	{
+		m_ForceImpostors = !m_ForceImpostors;
+		std::cout << "Forced impostors " << ((m_ForceImpostors) ? "on" : "off") << std::endl;
+	}
+	else if (key == GLFW_KEY_G && action == GLFW_RELEASE and m_GpuCulling != nullptr)
+	{
+		m_GpuDriven = !m_GpuDriven;
+		std::cout << "Gpu driven culling " << ((m_GpuDriven) ? "on" : "off") << std::endl;
+	}
+	else if (key == GLFW_KEY_H && action == GLFW_RELEASE)
+	{
+		m_HostAllocator->PrintStatistics();
+	}
 }
 
 VkResult Application::CreateUniformBuffers()
@@ -1198,17 +1938,16 @@ VkResult Application::CreateUniformBuffers()
 		{
 			CreateBuffer
 			(
-				m_PhysicalDevice,
-				m_Device,
+				*m_DeviceAllocator,
 				bufferSize,
 				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				MemoryCategory::Uniforms,
 				m_UniformBuffers.at(i).at(j),
 				m_UniformBufferMemories.at(i).at(j)
 			);
 
-			result = vkMapMemory(m_Device, m_UniformBufferMemories.at(i).at(j), 0, bufferSize, 0, &m_UniformBufferMaps.at(i).at(j));
-			if (result != VK_SUCCESS) return result;
+			m_UniformBufferMaps.at(i).at(j) = m_UniformBufferMemories.at(i).at(j).Map;
 		}
 	}
 
@@ -1268,7 +2007,33 @@ VkResult Application::CreateTexturesDescriptorSetLayout()
 		descriptorSetLayoutBindings.data()							// pBindings
 	};
 
-	return vkCreateDescriptorSetLayout(m_Device, &descriptorSetLayoutCreateInfo, nullptr, &m_TexturesDescriptorSetLayout);
+	return vkCreateDescriptorSetLayout(m_Device, &descriptorSetLayoutCreateInfo, m_HostAllocator->GetCallbacks(), &m_TexturesDescriptorSetLayout);
+}
+
+VkResult Application::CreateTextureTableDescriptorSetLayout()
+{
+	// Base color, normal, glossiness and specular of every mesh, indexed with the material of the object
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDescriptorSetLayoutBinding.html
+	const VkDescriptorSetLayoutBinding descriptorSetLayoutBinding
+	{
+		0,													// binding
+		VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,			// descriptorType
+		g_NumberOfMeshes * g_TexturesPerMesh,				// descriptorCount
+		VK_SHADER_STAGE_FRAGMENT_BIT,						// stageFlags
+		nullptr												// pImmutableSamplers
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDescriptorSetLayoutCreateInfo.html
+	const VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo
+	{
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,		// sType
+		nullptr,													// pNext
+		0,															// flags
+		1,															// bindingCount
+		&descriptorSetLayoutBinding									// pBindings
+	};
+
+	return vkCreateDescriptorSetLayout(m_Device, &descriptorSetLayoutCreateInfo, m_HostAllocator->GetCallbacks(), &m_TextureTableDescriptorSetLayout);
 }
 
 VkResult Application::CreateTransformsDescriptorSetLayout()
@@ -1297,7 +2062,45 @@ VkResult Application::CreateTransformsDescriptorSetLayout()
 		descriptorSetLayoutBindings.data()							// pBindings
 	};
 
-	return vkCreateDescriptorSetLayout(m_Device, &descriptorSetLayoutCreateInfo, nullptr, &m_TransformsDescriptorSetLayout);
+	return vkCreateDescriptorSetLayout(m_Device, &descriptorSetLayoutCreateInfo, m_HostAllocator->GetCallbacks(), &m_TransformsDescriptorSetLayout);
+}
+
+VkResult Application::CreateImpostorDescriptorSetLayout()
+{
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDescriptorSetLayoutBinding.html
+	const std::array<VkDescriptorSetLayoutBinding, 2> descriptorSetLayoutBindings
+	{
+		// Base color atlas
+		VkDescriptorSetLayoutBinding
+		{
+			0,													// binding
+			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,			// descriptorType	
+			1,													// descriptorCount
+			VK_SHADER_STAGE_FRAGMENT_BIT,						// stageFlags
+			nullptr												// pImmutableSamplers
+		},
+		// Surface atlas
+		VkDescriptorSetLayoutBinding
+		{
+			1,
+			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			1,
+			VK_SHADER_STAGE_FRAGMENT_BIT,
+			nullptr
+		}
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDescriptorSetLayoutCreateInfo.html
+	const VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo
+	{
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,		// sType
+		nullptr,													// pNext
+		0,															// flags
+		uint32_t(descriptorSetLayoutBindings.size()),				// bindingCount
+		descriptorSetLayoutBindings.data()							// pBindings
+	};
+
+	return vkCreateDescriptorSetLayout(m_Device, &descriptorSetLayoutCreateInfo, m_HostAllocator->GetCallbacks(), &m_ImpostorDescriptorSetLayout);
 }
 
 VkResult Application::CreateTexturesDescriptorSets()
@@ -1320,6 +2123,29 @@ VkResult Application::CreateTexturesDescriptorSets()
 	result = vkAllocateDescriptorSets(m_Device, &descriptorSetAllocateInfo, m_TexturesDescriptorSets.data());
 	if (result != VK_SUCCESS) return result;
 
+	// Only the gpu driven path draws with the texture table
+	if (m_TextureTableDescriptorSetLayout != VK_NULL_HANDLE)
+	{
+		const VkDescriptorSetAllocateInfo textureTableAllocateInfo
+		{
+			VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,			// sType
+			nullptr,												// pNext
+			m_DescriptorPool,										// descriptorPool
+			1,														// descriptorSetCount
+			&m_TextureTableDescriptorSetLayout						// pSetLayouts
+		};
+
+		result = vkAllocateDescriptorSets(m_Device, &textureTableAllocateInfo, &m_TextureTableDescriptorSet);
+		if (result != VK_SUCCESS) return result;
+	}
+
+	UpdateTexturesDescriptorSets();
+
+	return result;
+}
+
+void Application::UpdateTexturesDescriptorSets()
+{
 	for (int i{}; i < g_NumberOfMeshes; i++)
 	{
 		// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDescriptorImageInfo.html
@@ -1413,9 +2239,28 @@ VkResult Application::CreateTexturesDescriptorSets()
 		};
 
 		vkUpdateDescriptorSets(m_Device, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
-	}
 
-	return result;
+		if (m_TextureTableDescriptorSet == VK_NULL_HANDLE) continue;
+
+		// The four textures of the mesh are its material in the texture table
+		const std::array<VkDescriptorImageInfo, 4> materialInfos{ descriptorBaseColorInfo, descriptorNormalInfo, descriptorGlossInfo, descriptorSpecularInfo };
+
+		const VkWriteDescriptorSet writeMaterial
+		{
+			VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,					// sType
+			nullptr,												// pNext
+			m_TextureTableDescriptorSet,							// dstSet
+			0,														// dstBinding
+			static_cast<uint32_t>(i * materialInfos.size()),		// dstArrayElement
+			static_cast<uint32_t>(materialInfos.size()),			// descriptorCount
+			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,				// descriptorType
+			materialInfos.data(),									// pImageInfo
+			nullptr,												// pBufferInfo
+			nullptr													// pTexelBufferView
+		};
+
+		vkUpdateDescriptorSets(m_Device, 1, &writeMaterial, 0, nullptr);
+	}
 }
 
 VkResult Application::CreateTransformsDescriptorSets()
@@ -1486,6 +2331,90 @@ VkResult Application::CreateTransformsDescriptorSets()
 	return result;
 }
 
+VkResult Application::CreateImpostorDescriptorSets()
+{
+	VkResult result{ VK_SUCCESS };
+
+	m_ImpostorDescriptorSets.resize(g_NumberOfMeshes);
+	std::vector<VkDescriptorSetLayout> descriptorSetlayouts{ g_NumberOfMeshes, m_ImpostorDescriptorSetLayout };
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDescriptorSetAllocateInfo.html
+	const VkDescriptorSetAllocateInfo descriptorSetAllocateInfo
+	{
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,			// sType
+		nullptr,												// pNext
+		m_DescriptorPool,										// descriptorPool
+		static_cast<uint32_t>(g_NumberOfMeshes),				// descriptorSetCount
+		descriptorSetlayouts.data()								// pSetLayouts
+	};
+
+	result = vkAllocateDescriptorSets(m_Device, &descriptorSetAllocateInfo, m_ImpostorDescriptorSets.data());
+	if (result != VK_SUCCESS) return result;
+
+	UpdateImpostorDescriptorSets();
+
+	return result;
+}
+
+void Application::UpdateImpostorDescriptorSets()
+{
+	for (int i{}; i < g_NumberOfMeshes; i++)
+	{
+		// Evicted atlases have no views, their sets don't get bound until they are baked again
+		if (!m_Impostors.at(i)->IsResident()) continue;
+
+		// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDescriptorImageInfo.html
+		const VkDescriptorImageInfo descriptorBaseColorInfo
+		{
+			m_TextureSampler,								// sampler	
+			m_Impostors.at(i)->GetBaseColorImageView(),		// imageView
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL		// imageLayout
+		};
+
+		const VkDescriptorImageInfo descriptorSurfaceInfo
+		{
+			m_TextureSampler,
+			m_Impostors.at(i)->GetSurfaceImageView(),
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		};
+
+		// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkWriteDescriptorSet.html
+		std::array<VkWriteDescriptorSet, 2> writeDescriptorSets
+		{
+			// Base color atlas
+			VkWriteDescriptorSet
+			{
+				VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,			// sType
+				nullptr,										// pNext
+				m_ImpostorDescriptorSets.at(i),					// dstSet	
+				0,												// dstBinding
+				0,												// dstArrayElement
+				1,												// descriptorCount
+				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,		// descriptorType
+				&descriptorBaseColorInfo,						// pImageInfo
+				nullptr,										// pBufferInfo
+				nullptr											// pTexelBufferView
+			},
+			// Surface atlas
+			VkWriteDescriptorSet
+			{
+				VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+				nullptr,
+				m_ImpostorDescriptorSets.at(i),
+				1,
+				0,
+				1,
+				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+				&descriptorSurfaceInfo,
+				nullptr,
+				nullptr
+			}
+		};
+
+		vkUpdateDescriptorSets(m_Device, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
+	}
+}
+
 VkResult Application::CreateDescriptorPool()
 {
 	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDescriptorPoolSize.html
@@ -1499,7 +2428,7 @@ VkResult Application::CreateDescriptorPool()
 		VkDescriptorPoolSize
 		{
 			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-			static_cast<uint32_t>(g_NumberOfMeshes * 4)
+			static_cast<uint32_t>(g_NumberOfMeshes * (g_TexturesPerMesh + 2 + g_TexturesPerMesh))
 		}
 	};
 
@@ -1509,12 +2438,12 @@ VkResult Application::CreateDescriptorPool()
 		VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,														// sType
 		nullptr,																							// pNext
 		0,																									// flags
-		static_cast<uint32_t>((g_MaxFramePerFlight * g_NumberOfMeshes) + (g_NumberOfMeshes)),				// maxSets
+		static_cast<uint32_t>((g_MaxFramePerFlight * g_NumberOfMeshes) + (g_NumberOfMeshes * 2) + 1),		// maxSets
 		static_cast<uint32_t>(descriptorPoolSizes.size()),													// poolSizeCount
 		descriptorPoolSizes.data()																			// pPoolSizes
 	};
 
-	return vkCreateDescriptorPool(m_Device, &descriptorPoolCreateInfo, nullptr, &m_DescriptorPool);
+	return vkCreateDescriptorPool(m_Device, &descriptorPoolCreateInfo, m_HostAllocator->GetCallbacks(), &m_DescriptorPool);
 }
 
 void Application::CreateTextureSampler()
@@ -1545,7 +2474,7 @@ void Application::CreateTextureSampler()
 		VK_FALSE														// unnormalizedCoordinates
 	};
 
-	if (vkCreateSampler(m_Device, &samplerCreateInfo, nullptr, &m_TextureSampler) != VK_SUCCESS)
+	if (vkCreateSampler(m_Device, &samplerCreateInfo, m_HostAllocator->GetCallbacks(), &m_TextureSampler) != VK_SUCCESS)
 	{
 		throw std::runtime_error("Failed to create texture sampler!");
 	}
@@ -1553,57 +2482,117 @@ void Application::CreateTextureSampler()
 
 void Application::CreateDepthResources()
 {
-	VkFormat depthFormat{ FindDepthFormat(m_PhysicalDevice) };
-
+	// Transient, the depth never leaves the render pass
 	CreateImage
 	(
-		m_PhysicalDevice,
 		m_Device,
 		m_ImageExtend,
-		depthFormat,
+		FindDepthFormat(m_PhysicalDevice),
 		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
 		m_DepthImage,
-		m_DepthMemory,
 		1,
 		m_MSAASamples
 	);
-
-	m_DepthImageView = CreateImageView(m_Device, m_DepthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
-
-	TransitionImageLayout(m_Device, m_CommandPool, m_GrahicsQueue, m_DepthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, 1);
 }
 
 void Application::CreateColorResources()
 {
+	// Transient, only the resolved image gets stored
 	CreateImage
 	(
-		m_PhysicalDevice,
 		m_Device,
 		m_ImageExtend,
 		m_ImageFormat,
 		VK_IMAGE_TILING_OPTIMAL,
 		VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 		m_ColorImage,
-		m_ColorMemory,
 		1,
 		m_MSAASamples
 	);
+}
 
+void Application::BindAttachmentResources()
+{
+	m_AttachmentPool->Bind({ m_ColorImage, m_DepthImage });
+
+	const VkFormat depthFormat{ FindDepthFormat(m_PhysicalDevice) };
 	m_ColorImageView = CreateImageView(m_Device, m_ColorImage, m_ImageFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+	m_DepthImageView = CreateImageView(m_Device, m_DepthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
+
+	TransitionImageLayout(m_Device, m_CommandPool, m_GrahicsQueue, m_DepthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, 1);
+
+	for (auto evictable : m_AttachmentEvictables) m_MemoryBudget->UnregisterEvictable(evictable);
+	m_AttachmentEvictables.clear();
+
+	// The pool only grows, after the swap chain shrank the part the attachments don't use can be evicted.
+	// It comes back on its own once the swap chain grows again, lazily allocated memory costs nothing to keep
+	const VkDeviceSize unusedSize{ m_AttachmentPool->GetSize() - m_AttachmentPool->GetBoundSize() };
+	if (unusedSize == 0 or m_AttachmentPool->IsLazilyAllocated()) return;
+
+	m_AttachmentEvictables.push_back(m_MemoryBudget->RegisterEvictable(m_AttachmentPool->GetHeap(), 0, [this]() { TrimAttachments(); }));
 }
 
 void Application::InitializeTextures()
 {
-	m_BaseColorTextures.push_back(new Texture{ m_PhysicalDevice, m_Device, m_CommandPool, m_GrahicsQueue, "Textures/vehicle_base.png", VK_FORMAT_R8G8B8A8_SRGB });
-	m_NormalTextures.push_back(new Texture{ m_PhysicalDevice, m_Device, m_CommandPool, m_GrahicsQueue, "Textures/vehicle_normal.png", VK_FORMAT_R8G8B8A8_UNORM });
-	m_GlossTextures.push_back(new Texture{ m_PhysicalDevice, m_Device, m_CommandPool, m_GrahicsQueue, "Textures/vehicle_gloss.png", VK_FORMAT_R8G8B8A8_UNORM });
-	m_SpecularTextures.push_back(new Texture{ m_PhysicalDevice, m_Device, m_CommandPool, m_GrahicsQueue, "Textures/vehicle_specular.png", VK_FORMAT_R8G8B8A8_UNORM });
-
-	m_BaseColorTextures.push_back(new Texture{ m_PhysicalDevice, m_Device, m_CommandPool, m_GrahicsQueue, "Textures/mixer_base.png", VK_FORMAT_R8G8B8A8_SRGB });
-	m_NormalTextures.push_back(new Texture{ m_PhysicalDevice, m_Device, m_CommandPool, m_GrahicsQueue, "Textures/mixer_normal.png", VK_FORMAT_R8G8B8A8_UNORM });
-	m_GlossTextures.push_back(new Texture{ m_PhysicalDevice, m_Device, m_CommandPool, m_GrahicsQueue, "Textures/mixer_gloss.png", VK_FORMAT_R8G8B8A8_UNORM });
-	m_SpecularTextures.push_back(new Texture{ m_PhysicalDevice, m_Device, m_CommandPool, m_GrahicsQueue, "Textures/mixer_specular.png", VK_FORMAT_R8G8B8A8_UNORM });
+	const auto startTime{ std::chrono::high_resolution_clock::now() };
+	const uint32_t submissionCount{ m_StagingRing->GetSubmissionCount() };
+
+	// The uploads, transitions and mip blits of every texture share one submission, host image copies skip it altogether
+	m_StagingRing->BeginBatch();
+
+	m_BaseColorTextures.push_back(new Texture{ m_PhysicalDevice, m_Device, *m_DeviceAllocator, *m_StagingRing, "Textures/vehicle_base.png", VK_FORMAT_R8G8B8A8_SRGB, m_HostImageCopySupported });
+	m_NormalTextures.push_back(new Texture{ m_PhysicalDevice, m_Device, *m_DeviceAllocator, *m_StagingRing, "Textures/vehicle_normal.png", VK_FORMAT_R8G8B8A8_UNORM, m_HostImageCopySupported });
+	m_GlossTextures.push_back(new Texture{ m_PhysicalDevice, m_Device, *m_DeviceAllocator, *m_StagingRing, "Textures/vehicle_gloss.png", VK_FORMAT_R8G8B8A8_UNORM, m_HostImageCopySupported });
+	m_SpecularTextures.push_back(new Texture{ m_PhysicalDevice, m_Device, *m_DeviceAllocator, *m_StagingRing, "Textures/vehicle_specular.png", VK_FORMAT_R8G8B8A8_UNORM, m_HostImageCopySupported });
+
+	m_BaseColorTextures.push_back(new Texture{ m_PhysicalDevice, m_Device, *m_DeviceAllocator, *m_StagingRing, "Textures/mixer_base.png", VK_FORMAT_R8G8B8A8_SRGB, m_HostImageCopySupported });
+	m_NormalTextures.push_back(new Texture{ m_PhysicalDevice, m_Device, *m_DeviceAllocator, *m_StagingRing, "Textures/mixer_normal.png", VK_FORMAT_R8G8B8A8_UNORM, m_HostImageCopySupported });
+	m_GlossTextures.push_back(new Texture{ m_PhysicalDevice, m_Device, *m_DeviceAllocator, *m_StagingRing, "Textures/mixer_gloss.png", VK_FORMAT_R8G8B8A8_UNORM, m_HostImageCopySupported });
+	m_SpecularTextures.push_back(new Texture{ m_PhysicalDevice, m_Device, *m_DeviceAllocator, *m_StagingRing, "Textures/mixer_specular.png", VK_FORMAT_R8G8B8A8_UNORM, m_HostImageCopySupported });
+
+	m_StagingRing->EndBatch();
+
+	const std::chrono::duration<float, std::milli> loadTime{ std::chrono::high_resolution_clock::now() - startTime };
+	std::cout << "Loaded " << m_BaseColorTextures.size() * 4 << " textures in " << loadTime.count() << " ms, " << m_StagingRing->GetSubmissionCount() - submissionCount << " staging submissions"
+		<< (m_BaseColorTextures.at(0)->UsesHostImageCopy() ? ", copied from the host" : "") << std::endl;
+
+	// Evicted textures keep their smaller mip levels, restoring them loads the file again through the staging ring
+	for (int i{}; i < g_NumberOfMeshes; ++i)
+	{
+		const std::array<Texture*, g_TexturesPerMesh> textures{ m_BaseColorTextures.at(i), m_NormalTextures.at(i), m_GlossTextures.at(i), m_SpecularTextures.at(i) };
+		for (Texture* texture : textures)
+		{
+			texture->RegisterMovable(*m_Defragmenter);
+			m_TextureEvictables.push_back(m_MemoryBudget->RegisterEvictable(texture->GetHeap(), texture->GetResidentSize(), [texture]() { texture->Evict(); }, [texture]() { texture->Restore(); }));
+		}
+	}
+}
+
+void Application::InitializeImpostors()
+{
+	const auto startTime{ std::chrono::high_resolution_clock::now() };
+
+	// Baking draws the meshes with their textures, the graphics queue has to own all of them first
+	m_StagingRing->Flush();
+
+	// One pipeline for every bake, the bakes get recorded back to back and go to the queue in one submission
+	m_ImpostorBaker = new ImpostorBaker{ m_PhysicalDevice, m_Device, *m_DeviceAllocator, m_CommandPool, m_GrahicsQueue, m_TexturesDescriptorSetLayout };
+
+	for (int i{}; i < g_NumberOfMeshes; ++i)
+	{
+		m_Impostors.push_back(new Impostor{ m_Device, *m_DeviceAllocator, *m_ImpostorBaker, *m_Meshes.at(i), m_TexturesDescriptorSets.at(i) });
+	}
+	m_ImpostorBaker->Submit();
+
+	if (CreateImpostorDescriptorSets() != VK_SUCCESS) throw std::runtime_error("failed to create impostor descriptor sets!");
+
+	// An evicted impostor gets drawn as the full mesh, once its heap has room again the atlas comes back and gets baked again
+	for (Impostor* impostor : m_Impostors)
+	{
+		m_ImpostorEvictables.push_back(m_MemoryBudget->RegisterEvictable(impostor->GetHeap(), impostor->GetSize(), [impostor]() { impostor->Evict(); }, [impostor]() { impostor->Restore(); }));
+	}
+
+	const std::chrono::duration<float, std::milli> bakeTime{ std::chrono::high_resolution_clock::now() - startTime };
+	std::cout << "Baked " << m_Impostors.size() << " impostors in " << bakeTime.count() << " ms" << std::endl;
 }
\ No newline at end of file
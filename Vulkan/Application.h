@@ -5,9 +5,19 @@
 #include <vector>
 
 #include "HelperStructs.h"
+#include "FrustumCulling.h"
+#include "DeviceAllocator.h"
 
 class Mesh;
 class Texture;
+class Impostor;
+class ImpostorBaker;
+class GeometryArena;
+class StagingRing;
+class Defragmenter;
+class HostAllocator;
+class AttachmentPool;
+class GpuCulling;
 struct GLFWwindow;
 class Camera;
 
@@ -47,29 +57,51 @@ private:
     VkResult CreateSwapChainImageViews();
     VkResult CreateRenderPass();
     VkResult CreateGraphicsPipeline();
+    VkResult CreateImpostorPipeline();
     VkResult CreateSwapChainFrameBuffers();
     VkResult CreateCommandPool();
     VkResult CreateCommandBuffers();
     void RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+    float CalculatePixelsPerUnit(const Mesh& mesh) const;
+    uint32_t SelectLod(const Mesh& mesh, float pixelsPerUnit) const;
+    uint32_t RecordVisibleMeshlets(VkCommandBuffer commandBuffer, const Mesh& mesh);
+    void RecordGpuCulling(VkCommandBuffer commandBuffer, const Frustum& frustum);
+    uint32_t RecordGpuDrivenDraws(VkCommandBuffer commandBuffer);
+    void UpdateGpuObject(uint32_t mesh);
     void UpdateUniformBuffers(uint32_t currentImage);
     void DrawFrame();
     VkResult CreateSyncObjects();
     void RecreateSwapChain();
     void CleanupSwapChain();
+    void CleanupAttachments();
+    // Evicts what the attachment pool holds beyond the attachments of the current swap chain
+    void TrimAttachments();
+    // Restores what fits in the memory budget again, the uploads go out without waiting on them
+    void RestoreResources();
+    // Called by the staging ring once the copies and uploads of an eviction or restore finished, swaps the textures in and bakes the restored impostors
+    void CommitResidencyChanges();
     VkResult CreateUniformBuffers();
     VkResult CreateDescriptorPool();
     VkResult CreateTexturesDescriptorSetLayout();
+    VkResult CreateTextureTableDescriptorSetLayout();
     VkResult CreateTransformsDescriptorSetLayout();
+    VkResult CreateImpostorDescriptorSetLayout();
     VkResult CreateTexturesDescriptorSets();
+    void UpdateTexturesDescriptorSets();
     VkResult CreateTransformsDescriptorSets();
+    VkResult CreateImpostorDescriptorSets();
+    void UpdateImpostorDescriptorSets();
     void CreateTextureSampler();
     void CreateDepthResources();
     void CreateColorResources();
+    void BindAttachmentResources();
     void InitializeTextures();
+    void InitializeImpostors();
 
     int m_Width;
     int m_Height;
     GLFWwindow* m_Window;
+    HostAllocator* m_HostAllocator;
     VkInstance m_Instance;
     VkDebugUtilsMessengerEXT m_DebugMessenger;
     VkSurfaceKHR m_Surface;
@@ -78,8 +110,13 @@ private:
     std::vector<const char*> m_PhysicalDeviceExtensionNames;
     VkPhysicalDevice m_PhysicalDevice;
     VkDevice m_Device;
+    bool m_MemoryBudgetSupported;
+    bool m_HostImageCopySupported;
+    MemoryBudget* m_MemoryBudget;
+    DeviceAllocator* m_DeviceAllocator;
     VkQueue m_GrahicsQueue;
     VkQueue m_PresentQueue;
+    VkQueue m_TransferQueue;
     VkSwapchainKHR m_SwapChain;
     std::vector<VkImage> m_SwapChainImages;
     VkFormat m_ImageFormat;
@@ -92,15 +129,18 @@ private:
     VkPipeline m_PipeLine;
     std::vector<VkFramebuffer> m_SwapChainFrameBuffers;
     VkCommandPool m_CommandPool;
+    StagingRing* m_StagingRing;
+    Defragmenter* m_Defragmenter;
     std::vector<VkCommandBuffer> m_CommandBuffers;
     std::vector<VkSemaphore> m_ImageAvailable;
     std::vector<VkSemaphore> m_RenderFinished;
     std::vector<VkFence> m_InFlight;
     uint32_t m_CurrentFrame;
     bool m_FrameBufferResized;
+    GeometryArena* m_GeometryArena;
     std::vector<Mesh*> m_Meshes;
     std::vector< std::vector<VkBuffer>> m_UniformBuffers;
-    std::vector< std::vector<VkDeviceMemory>> m_UniformBufferMemories;
+    std::vector< std::vector<DeviceAllocation>> m_UniformBufferMemories;
     std::vector< std::vector<void*>> m_UniformBufferMaps;
     VkDescriptorSetLayout m_TexturesDescriptorSetLayout;
     VkDescriptorSetLayout m_TransformsDescriptorSetLayout;
@@ -112,15 +152,41 @@ private:
     std::vector<Texture*> m_GlossTextures;
     std::vector<Texture*> m_SpecularTextures;
     VkSampler m_TextureSampler;
+    AttachmentPool* m_AttachmentPool;
     VkImage m_DepthImage;
-    VkDeviceMemory m_DepthMemory;
     VkImageView m_DepthImageView;
     VkImage m_ColorImage;
-    VkDeviceMemory m_ColorMemory;
     VkImageView m_ColorImageView;
     Camera* m_Camera;
     VkSampleCountFlagBits m_MSAASamples;
     PushConstants m_PushConstants;                                 
+    bool m_MeshletCulling;
+    bool m_LodSelection;
+    uint32_t m_SubmittedTriangles;
+    bool m_ForceImpostors;
+    VkShaderModule m_ImpostorVertexShader;
+    VkShaderModule m_ImpostorFragmentShader;
+    VkPipelineLayout m_ImpostorPipeLineLayout;
+    VkPipeline m_ImpostorPipeLine;
+    VkDescriptorSetLayout m_ImpostorDescriptorSetLayout;
+    std::vector<VkDescriptorSet> m_ImpostorDescriptorSets;
+    ImpostorBaker* m_ImpostorBaker;
+    std::vector<Impostor*> m_Impostors;
+    std::vector<uint32_t> m_ImpostorEvictables;
+    std::vector<uint32_t> m_TextureEvictables;              // g_TexturesPerMesh per mesh, in the order of its descriptor set
+    std::vector<uint32_t> m_AttachmentEvictables;           // The unused part of the attachment pool, when there is one
+    bool m_ResidencyChangePending;                          // Evicted or restored textures wait on their uploads, nothing else gets evicted or restored
+    ObjectBounds m_ObjectBounds;
+    std::vector<uint32_t> m_VisibleObjects;
+    bool m_GpuCullingSupported;
+    bool m_GpuDriven;
+    GpuCulling* m_GpuCulling;
+    VkShaderModule m_GpuDrivenVertexShader;
+    VkShaderModule m_GpuDrivenFragmentShader;
+    VkPipelineLayout m_GpuDrivenPipeLineLayout;
+    VkPipeline m_GpuDrivenPipeLine;
+    VkDescriptorSetLayout m_TextureTableDescriptorSetLayout;
+    VkDescriptorSet m_TextureTableDescriptorSet;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "AttachmentPool.h"
+
+AttachmentPool::AttachmentPool(DeviceAllocator& deviceAllocator) :
+	m_DeviceAllocator{ deviceAllocator },
+	m_Memory{},
+	m_Properties{},
+	m_BoundSize{},
+	m_AllocationCount{}
+{
+
+}
+
+AttachmentPool::~AttachmentPool()
+{
+	m_DeviceAllocator.Free(m_Memory);
+}
+
+void AttachmentPool::Bind(const std::vector<VkImage>& images)
+{
+	const VkDevice device{ m_DeviceAllocator.GetDevice() };
+
+	// The images go back to back, every offset aligned to the image placed there
+	std::vector<VkDeviceSize> offsets{};
+	VkMemoryRequirements requirements{ 0, 1, UINT32_MAX };
+
+	for (VkImage image : images)
+	{
+		VkMemoryRequirements imageRequirements{};
+		vkGetImageMemoryRequirements(device, image, &imageRequirements);
+
+		const VkDeviceSize offset{ (requirements.size + imageRequirements.alignment - 1) / imageRequirements.alignment * imageRequirements.alignment };
+		offsets.push_back(offset);
+
+		requirements.size = offset + imageRequirements.size;
+		requirements.alignment = std::max(requirements.alignment, imageRequirements.alignment);
+		requirements.memoryTypeBits &= imageRequirements.memoryTypeBits;
+	}
+
+	if (requirements.memoryTypeBits == 0) throw std::runtime_error("Transient attachments don't share a memory type!");
+
+	const VkMemoryPropertyFlags lazyProperties{ VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT };
+	const VkMemoryPropertyFlags properties{ (m_DeviceAllocator.HasMemoryType(requirements.memoryTypeBits, lazyProperties)) ? lazyProperties : VkMemoryPropertyFlags{ VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT } };
+
+	const bool fits
+	{
+		m_Memory.Memory != VK_NULL_HANDLE and
+		m_Memory.Size >= requirements.size and
+		m_Memory.Offset % requirements.alignment == 0 and
+		(requirements.memoryTypeBits & (1u << m_DeviceAllocator.GetMemoryType(m_Memory))) != 0 and
+		properties == m_Properties
+	};
+
+	if (!fits)
+	{
+		m_DeviceAllocator.Free(m_Memory);
+		m_Memory = m_DeviceAllocator.AllocateMemory(requirements, properties, MemoryCategory::Attachments, true);
+		m_Properties = properties;
+		++m_AllocationCount;
+	}
+
+	for (size_t i{}; i < images.size(); ++i)
+	{
+		if (vkBindImageMemory(device, images.at(i), m_Memory.Memory, m_Memory.Offset + offsets.at(i)) != VK_SUCCESS) throw std::runtime_error("Failed to bind transient attachment memory!");
+	}
+
+	m_BoundSize = requirements.size;
+}
+
+void AttachmentPool::Release()
+{
+	m_DeviceAllocator.Free(m_Memory);
+	m_Memory = DeviceAllocation{};
+	m_BoundSize = 0;
+}
+
+bool AttachmentPool::IsLazilyAllocated() const
+{
+	return (m_Properties & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+}
+
+uint32_t AttachmentPool::GetHeap() const
+{
+	return m_DeviceAllocator.GetHeap(m_Memory);
+}
+
+VkDeviceSize AttachmentPool::GetSize() const
+{
+	return m_Memory.Size;
+}
+
+VkDeviceSize AttachmentPool::GetBoundSize() const
+{
+	return m_BoundSize;
+}
+
+uint32_t AttachmentPool::GetAllocationCount() const
+{
+	return m_AllocationCount;
+}
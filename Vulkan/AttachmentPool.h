@@ -0,0 +1,45 @@
+#ifndef ATTACHMENT_POOL
+#define ATTACHMENT_POOL
+
+#include <vulkan.hpp>
+#include <vector>
+
+#include "DeviceAllocator.h"
+
+// One allocation the transient attachments of the swap chain get bound into back to back. It only grows, so recreating
+// the swap chain at the same size or smaller reuses it. Lazily allocated memory gets used when the device has it,
+// tiled gpus then never back the attachments with real memory as long as they stay on chip.
+class AttachmentPool final
+{
+public:
+	AttachmentPool(DeviceAllocator& deviceAllocator);
+	~AttachmentPool();
+
+	AttachmentPool(const AttachmentPool&) = delete;
+	AttachmentPool& operator=(const AttachmentPool&) = delete;
+	AttachmentPool(AttachmentPool&&) = delete;
+	AttachmentPool& operator=(AttachmentPool&&) = delete;
+
+	// Binds the images into the pool, the images bound before have to be destroyed already since their memory gets aliased
+	void Bind(const std::vector<VkImage>& images);
+	// Frees the pool so the next bind allocates exactly what it needs, the images bound before have to be destroyed already
+	void Release();
+
+	bool IsLazilyAllocated() const;
+	uint32_t GetHeap() const;
+	// Bytes of the pool allocation
+	VkDeviceSize GetSize() const;
+	// Bytes the images of the last bind take up
+	VkDeviceSize GetBoundSize() const;
+	// Times the pool had to allocate memory
+	uint32_t GetAllocationCount() const;
+
+private:
+	DeviceAllocator& m_DeviceAllocator;
+	DeviceAllocation m_Memory;
+	VkMemoryPropertyFlags m_Properties;
+	VkDeviceSize m_BoundSize;
+	uint32_t m_AllocationCount;
+};
+
+#endif
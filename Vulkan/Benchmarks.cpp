@@ -0,0 +1,429 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <unordered_map>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <random>
+#include <thread>
+#include <string>
+#include <gtc/matrix_transform.hpp>
+#include <stb_image.h>
+
+#include "Benchmarks.h"
+#include "Mesh.h"
+#include "VertexWeldTable.h"
+#include "VertexLayout.h"
+#include "MeshOptimizer.h"
+#include "MeshCodec.h"
+#include "FrustumCulling.h"
+#include "HelperFunctions.h"
+#include "DeviceAllocator.h"
+#include "PngDecoder.h"
+#include "StagingRing.h"
+#include "Texture.h"
+
+namespace
+{
+	constexpr int g_BenchmarkIterations{ 20 };
+
+	// Runs the function a couple of times and returns the fastest run in milliseconds
+	template <typename Function>
+	double MeasureBest(Function function)
+	{
+		double best{ std::numeric_limits<double>::max() };
+
+		for (int i{}; i < g_BenchmarkIterations; ++i)
+		{
+			const auto startTime{ std::chrono::high_resolution_clock::now() };
+			function();
+			const std::chrono::duration<double, std::milli> time{ std::chrono::high_resolution_clock::now() - startTime };
+
+			best = std::min(best, time.count());
+		}
+
+		return best;
+	}
+
+	template <VertexLayout Layout>
+	void MeasureVertexLayout
+	(
+		const char* name,
+		DeviceAllocator& deviceAllocator,
+		VkDevice device,
+		VkCommandPool commandPool,
+		VkQueue queue,
+		const std::vector<Vertex>& vertices
+	)
+	{
+		const VkDeviceSize bufferSize{ sizeof(typename VertexFormat<Layout>::Type) * vertices.size() };
+
+		VkBuffer stagingBuffer{};
+		DeviceAllocation stagingBufferMemory{};
+		CreateBuffer
+		(
+			deviceAllocator,
+			bufferSize,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			MemoryCategory::Staging,
+			stagingBuffer,
+			stagingBufferMemory
+		);
+
+		VkBuffer vertexBuffer{};
+		DeviceAllocation vertexBufferMemory{};
+		CreateBuffer
+		(
+			deviceAllocator,
+			bufferSize,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			MemoryCategory::Geometry,
+			vertexBuffer,
+			vertexBufferMemory
+		);
+
+		void* data{ stagingBufferMemory.Map };
+
+		const double packTime{ MeasureBest([&]() { PackVertices<Layout>(vertices.data(), vertices.size(), data); }) };
+		const double uploadTime{ MeasureBest([&]()
+		{
+			PackVertices<Layout>(vertices.data(), vertices.size(), data);
+			CopyBuffer(device, stagingBuffer, vertexBuffer, bufferSize, commandPool, queue);
+		}) };
+
+		vkDestroyBuffer(device, vertexBuffer, nullptr);
+		deviceAllocator.Free(vertexBufferMemory);
+		vkDestroyBuffer(device, stagingBuffer, nullptr);
+		deviceAllocator.Free(stagingBufferMemory);
+
+		std::cout << std::setw(40) << std::left << name << sizeof(typename VertexFormat<Layout>::Type) << " bytes per vertex, " << std::fixed << std::setprecision(1)
+			<< double(bufferSize) / 1024.0 << " KiB, pack " << std::setprecision(3) << packTime << " ms, upload " << uploadTime << " ms" << std::endl;
+		std::cout << std::defaultfloat;
+	}
+
+	// Prints the size of one encoded stream against its raw size and the decode throughput in raw bytes per second
+	void PrintCodecResult(const char* name, size_t rawSize, size_t encodedSize, double decodeTime)
+	{
+		std::cout << std::setw(40) << std::left << name << std::fixed << std::setprecision(1) << double(rawSize) / 1024.0 << " KiB -> " << double(encodedSize) / 1024.0
+			<< " KiB (" << std::setprecision(3) << double(encodedSize) / double(rawSize) << "), decode " << decodeTime << " ms, "
+			<< std::setprecision(2) << double(rawSize) / (decodeTime * 1.0e6) << " GB/s" << std::endl;
+	}
+}
+
+void RunVertexWeldBenchmark
+(
+	const std::vector<std::filesystem::path>& paths
+)
+{
+	std::cout << "-----Vertex Weld Benchmark-----" << std::endl;
+
+	for (const auto& path : paths)
+	{
+		std::vector<Vertex> corners{};
+		ExpandObj(path, corners);
+
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		indices.reserve(corners.size());
+
+		// The way Mesh used to weld, a count followed by one or two operator[] lookups
+		const double mapTime{ MeasureBest([&]()
+		{
+			std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+			vertices.clear();
+			indices.clear();
+
+			for (const Vertex& vertex : corners)
+			{
+				if (uniqueVertices.count(vertex) == 0)
+				{
+					uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
+					vertices.push_back(vertex);
+				}
+
+				indices.push_back(uniqueVertices[vertex]);
+			}
+		}) };
+		const size_t mapVertexCount{ vertices.size() };
+
+		const double tableTime{ MeasureBest([&]()
+		{
+			VertexWeldTable uniqueVertices{ corners.size() };
+			vertices.clear();
+			indices.clear();
+
+			for (const Vertex& vertex : corners)
+			{
+				indices.push_back(uniqueVertices.Insert(vertex, vertices));
+			}
+		}) };
+		const size_t tableVertexCount{ vertices.size() };
+
+		std::cout << path.string() << ": " << corners.size() << " corners" << std::endl;
+		std::cout << std::setw(40) << std::left << "std::unordered_map" << std::fixed << std::setprecision(3) << mapTime << " ms, " << mapVertexCount << " vertices" << std::endl;
+		std::cout << std::setw(40) << std::left << (std::string("VertexWeldTable, ") + GetVertexHashName() + " hash") << std::fixed << std::setprecision(3) << tableTime << " ms, " << tableVertexCount << " vertices" << std::endl;
+		std::cout << std::setw(40) << std::left << "Speedup" << std::fixed << std::setprecision(2) << mapTime / tableTime << "x" << std::endl;
+		std::cout << std::defaultfloat << std::endl;
+	}
+}
+
+void RunObjIngestBenchmark
+(
+	const std::vector<std::filesystem::path>& paths,
+	const std::vector<uint32_t>& threadCounts
+)
+{
+	std::cout << "-----Obj Ingest Benchmark-----" << std::endl;
+	std::cout << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+
+	for (const auto& path : paths)
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+
+		const double serialTime{ MeasureBest([&]() { LoadObj(path, 1, vertices, indices); }) };
+		std::cout << path.string() << ": " << indices.size() / 3 << " triangles, " << vertices.size() << " vertices" << std::endl;
+
+		for (const uint32_t threadCount : threadCounts)
+		{
+			const double time{ MeasureBest([&]() { LoadObj(path, threadCount, vertices, indices); }) };
+
+			std::cout << std::setw(40) << std::left << (std::to_string(threadCount) + " threads") << std::fixed << std::setprecision(3) << time << " ms, "
+				<< std::setprecision(2) << serialTime / time << "x" << std::endl;
+		}
+		std::cout << std::defaultfloat << std::endl;
+	}
+}
+
+void RunMeshCodecBenchmark
+(
+	const std::vector<std::filesystem::path>& paths
+)
+{
+	std::cout << "-----Mesh Codec Benchmark-----" << std::endl;
+
+	for (const auto& path : paths)
+	{
+		// The streams as the mesh cache stores them
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		LoadObj(path, 1, vertices, indices);
+		OptimizeVertexCache(indices, vertices.size());
+		OptimizeVertexFetch(indices, vertices);
+
+		std::vector<HalfVertex> halfVertices(vertices.size());
+		PackVertices<VertexLayout::Half>(vertices.data(), vertices.size(), halfVertices.data());
+
+		const std::vector<uint8_t> vertexData{ EncodeVertexBuffer(vertices.data(), vertices.size(), sizeof(Vertex)) };
+		const std::vector<uint8_t> halfVertexData{ EncodeVertexBuffer(halfVertices.data(), halfVertices.size(), sizeof(HalfVertex)) };
+		const std::vector<uint8_t> indexData{ EncodeIndexBuffer(indices.data(), indices.size()) };
+
+		std::vector<Vertex> decodedVertices(vertices.size());
+		std::vector<HalfVertex> decodedHalfVertices(halfVertices.size());
+		std::vector<uint32_t> decodedIndices(indices.size());
+
+		const double vertexTime{ MeasureBest([&]()
+		{
+			if (!DecodeVertexBuffer(decodedVertices.data(), decodedVertices.size(), sizeof(Vertex), vertexData.data(), vertexData.size())) throw std::runtime_error("Failed to decode vertices!");
+		}) };
+		const double halfVertexTime{ MeasureBest([&]()
+		{
+			if (!DecodeVertexBuffer(decodedHalfVertices.data(), decodedHalfVertices.size(), sizeof(HalfVertex), halfVertexData.data(), halfVertexData.size())) throw std::runtime_error("Failed to decode vertices!");
+		}) };
+		const double indexTime{ MeasureBest([&]()
+		{
+			if (!DecodeIndexBuffer(decodedIndices.data(), decodedIndices.size(), indexData.data(), indexData.size())) throw std::runtime_error("Failed to decode indices!");
+		}) };
+
+		if (!(decodedVertices == vertices) or !(decodedIndices == indices)) throw std::runtime_error("Mesh codec round trip is not lossless!");
+
+		const size_t rawSize{ vertices.size() * sizeof(Vertex) + indices.size() * sizeof(uint32_t) };
+		const size_t encodedSize{ vertexData.size() + indexData.size() };
+
+		std::cout << path.string() << ": " << std::filesystem::file_size(path) / 1024 << " KiB obj, " << vertices.size() << " vertices, " << indices.size() << " indices" << std::endl;
+		PrintCodecResult("Vertex", vertices.size() * sizeof(Vertex), vertexData.size(), vertexTime);
+		PrintCodecResult("HalfVertex", halfVertices.size() * sizeof(HalfVertex), halfVertexData.size(), halfVertexTime);
+		PrintCodecResult("Indices", indices.size() * sizeof(uint32_t), indexData.size(), indexTime);
+		std::cout << std::setw(40) << std::left << "Cache streams" << std::fixed << std::setprecision(1) << double(rawSize) / 1024.0 << " KiB -> " << double(encodedSize) / 1024.0 << " KiB" << std::endl;
+		std::cout << std::defaultfloat << std::endl;
+	}
+}
+
+void RunFrustumCullingBenchmark
+(
+	const std::vector<size_t>& objectCounts
+)
+{
+	std::cout << "-----Frustum Culling Benchmark-----" << std::endl;
+
+	// Looking down a field of objects, about a sixth of them end up inside the frustum
+	const glm::mat4 viewMatrix{ glm::lookAt(glm::vec3{ 0.0f, 0.0f, 0.0f }, glm::vec3{ 1.0f, 0.0f, 1.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f }) };
+	const glm::mat4 projectionMatrix{ glm::perspectiveRH_ZO(glm::radians(90.0f), 16.0f / 9.0f, 0.1f, 500.0f) };
+	const Frustum frustum{ ExtractFrustum(projectionMatrix * viewMatrix) };
+
+	for (size_t objectCount : objectCounts)
+	{
+		std::mt19937 generator{ 42 };
+		std::uniform_real_distribution<float> position{ -500.0f, 500.0f };
+		std::uniform_real_distribution<float> size{ 0.5f, 5.0f };
+		std::uniform_real_distribution<float> angle{ 0.0f, 6.2831853f };
+
+		std::vector<BoundingBox> boxes(objectCount);
+		std::vector<glm::mat4> modelMatrices(objectCount);
+		for (size_t i{}; i < objectCount; ++i)
+		{
+			const glm::vec3 extent{ size(generator), size(generator), size(generator) };
+			boxes[i] = BoundingBox{ -extent, extent };
+			modelMatrices[i] = glm::rotate(glm::translate(glm::mat4{ 1.0f }, glm::vec3{ position(generator), position(generator), position(generator) }), angle(generator), glm::vec3{ 0.0f, 1.0f, 0.0f });
+		}
+
+		ObjectBounds bounds{};
+		const double boundsTime{ MeasureBest([&]()
+		{
+			ClearObjectBounds(bounds);
+			for (size_t i{}; i < objectCount; ++i) AddObjectBounds(bounds, boxes[i], modelMatrices[i]);
+		}) };
+
+		std::vector<uint32_t> scalarVisible{};
+		std::vector<uint32_t> batchedVisible{};
+		const double scalarTime{ MeasureBest([&]() { CullObjectsScalar(frustum, bounds, scalarVisible); }) };
+		const double batchedTime{ MeasureBest([&]() { CullObjects(frustum, bounds, batchedVisible); }) };
+
+		if (scalarVisible != batchedVisible) throw std::runtime_error("Batched frustum culling does not match the scalar version!");
+
+		std::cout << objectCount << " objects, " << batchedVisible.size() << " visible" << std::endl;
+		std::cout << std::setw(40) << std::left << "World space bounds" << std::fixed << std::setprecision(3) << boundsTime << " ms" << std::endl;
+		std::cout << std::setw(40) << std::left << "Scalar" << std::fixed << std::setprecision(3) << scalarTime << " ms" << std::endl;
+		std::cout << std::setw(40) << std::left << "Batches of " + std::to_string(g_CullingBatchSize) << std::fixed << std::setprecision(3) << batchedTime << " ms, "
+			<< std::setprecision(2) << double(objectCount) / (batchedTime * 1.0e3) << " million objects per second" << std::endl;
+		std::cout << std::setw(40) << std::left << "Speedup" << std::fixed << std::setprecision(2) << scalarTime / batchedTime << "x" << std::endl;
+		std::cout << std::defaultfloat << std::endl;
+	}
+}
+
+void RunBenchmarks()
+{
+	const std::vector<std::filesystem::path> models{ "Models/vehicle.obj", "Models/mixer.obj" };
+
+	RunVertexWeldBenchmark(models);
+	RunObjIngestBenchmark(models, { 1, 2, 4, 8, 16, 32, 64 });
+	RunMeshCodecBenchmark(models);
+	RunFrustumCullingBenchmark({ 10000, 100000, 1000000 });
+}
+
+void RunVertexLayoutBenchmark
+(
+	DeviceAllocator& deviceAllocator,
+	VkDevice device,
+	VkCommandPool commandPool,
+	VkQueue queue,
+	const std::vector<std::filesystem::path>& paths
+)
+{
+	std::cout << "-----Vertex Layout Benchmark-----" << std::endl;
+
+	for (const auto& path : paths)
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		LoadObj(path, 0, vertices, indices);
+
+		std::cout << path.string() << ": " << vertices.size() << " vertices" << std::endl;
+		MeasureVertexLayout<VertexLayout::Float>("Float", deviceAllocator, device, commandPool, queue, vertices);
+		MeasureVertexLayout<VertexLayout::Half>("Half", deviceAllocator, device, commandPool, queue, vertices);
+		MeasureVertexLayout<VertexLayout::Compact>("Compact", deviceAllocator, device, commandPool, queue, vertices);
+		std::cout << std::endl;
+	}
+}
+
+void RunTextureUploadBenchmark
+(
+	VkPhysicalDevice physicalDevice,
+	DeviceAllocator& deviceAllocator,
+	VkDevice device,
+	StagingRing& stagingRing,
+	bool hostImageCopy,
+	const std::vector<std::filesystem::path>& paths
+)
+{
+	std::cout << "-----Texture Upload Benchmark-----" << std::endl;
+
+	// Software rasterizers like lavapipe copy on the cpu either way, the device name tells the runs apart
+	VkPhysicalDeviceProperties physicalDeviceProperties{};
+	vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+	std::cout << physicalDeviceProperties.deviceName << ", host image copy " << (hostImageCopy ? "supported" : "not supported") << std::endl;
+
+	for (const auto& path : paths)
+	{
+		int width{}, height{}, channels{};
+		const double decodeTime{ MeasureBest([&]()
+		{
+			stbi_image_free(stbi_load(path.string().c_str(), &width, &height, &channels, STBI_rgb_alpha));
+		}) };
+
+		// The streaming decoder only ever needs a few rows of memory, it gets the same small buffer over and over
+		bool decodedInRows{ false };
+		const double rowDecodeTime{ MeasureBest([&]()
+		{
+			PngDecoder decoder{ path };
+			decodedInRows = decoder.IsSupported();
+			if (!decodedInRows) return;
+
+			constexpr uint32_t rowsPerCall{ 16 };
+			std::vector<uint8_t> rows(size_t(decoder.GetWidth()) * 4 * rowsPerCall);
+			for (uint32_t row{}; row < decoder.GetHeight(); row += rowsPerCall)
+			{
+				decoder.DecodeRows(std::min(rowsPerCall, decoder.GetHeight() - row), rows.data());
+			}
+		}) };
+
+		// The staging path is done once its copies and blits finished, the host path once the constructor returns
+		const double stagingTime{ MeasureBest([&]()
+		{
+			const Texture texture{ physicalDevice, device, deviceAllocator, stagingRing, path, VK_FORMAT_R8G8B8A8_UNORM, false };
+			stagingRing.WaitIdle();
+		}) };
+
+		bool copiedFromHost{ false };
+		const double hostTime{ hostImageCopy ? MeasureBest([&]()
+		{
+			const Texture texture{ physicalDevice, device, deviceAllocator, stagingRing, path, VK_FORMAT_R8G8B8A8_UNORM, true };
+			copiedFromHost = texture.UsesHostImageCopy();
+		}) : 0.0 };
+
+		std::cout << path.string() << ": " << width << "x" << height << ", decode " << std::fixed << std::setprecision(3) << decodeTime << " ms";
+		if (decodedInRows) std::cout << ", in rows " << rowDecodeTime << " ms";
+		std::cout << std::endl;
+		std::cout << std::setw(40) << std::left << "Staging ring" << stagingTime << " ms" << std::endl;
+		if (copiedFromHost)
+		{
+			std::cout << std::setw(40) << std::left << "Host image copy" << hostTime << " ms" << std::endl;
+		}
+		else
+		{
+			std::cout << std::setw(40) << std::left << "Host image copy" << "not available for this texture" << std::endl;
+		}
+		std::cout << std::defaultfloat << std::endl;
+	}
+}
+
+void RunDeviceBenchmarks
+(
+	VkPhysicalDevice physicalDevice,
+	DeviceAllocator& deviceAllocator,
+	VkDevice device,
+	VkCommandPool commandPool,
+	VkQueue queue,
+	StagingRing& stagingRing,
+	bool hostImageCopy
+)
+{
+	const std::vector<std::filesystem::path> models{ "Models/vehicle.obj", "Models/mixer.obj" };
+	const std::vector<std::filesystem::path> textures{ "Textures/vehicle_base.png", "Textures/mixer_base.png" };
+
+	RunVertexLayoutBenchmark(deviceAllocator, device, commandPool, queue, models);
+	RunTextureUploadBenchmark(physicalDevice, deviceAllocator, device, stagingRing, hostImageCopy, textures);
+}
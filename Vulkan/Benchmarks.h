@@ -0,0 +1,75 @@
+#ifndef BENCHMARKS
+#define BENCHMARKS
+
+#include <vulkan.hpp>
+#include <filesystem>
+#include <vector>
+
+class DeviceAllocator;
+class StagingRing;
+
+// Runs the benchmarks before the application starts rendering
+constexpr bool g_RunBenchmarks{ false };
+
+// Compares welding the corners of the given models with std::unordered_map against the VertexWeldTable
+void RunVertexWeldBenchmark
+(
+	const std::vector<std::filesystem::path>& paths
+);
+
+// Times LoadObj of the given models for every thread count against the serial path, an explicit thread count is used even for small models
+void RunObjIngestBenchmark
+(
+	const std::vector<std::filesystem::path>& paths,
+	const std::vector<uint32_t>& threadCounts
+);
+
+// Measures the encoded size and decode throughput of the vertex and index streams of the given models after the cache optimizations
+void RunMeshCodecBenchmark
+(
+	const std::vector<std::filesystem::path>& paths
+);
+
+// Compares the batched frustum culling against testing one object at a time for every object count, on random boxes around the camera
+void RunFrustumCullingBenchmark
+(
+	const std::vector<size_t>& objectCounts
+);
+
+// Compares the vertex layouts on bytes per vertex, packing time and staging plus copy time of the given models
+void RunVertexLayoutBenchmark
+(
+	DeviceAllocator& deviceAllocator,
+	VkDevice device,
+	VkCommandPool commandPool,
+	VkQueue queue,
+	const std::vector<std::filesystem::path>& paths
+);
+
+// Compares the time until a texture can be sampled through the staging ring against host image copy, decoding included
+void RunTextureUploadBenchmark
+(
+	VkPhysicalDevice physicalDevice,
+	DeviceAllocator& deviceAllocator,
+	VkDevice device,
+	StagingRing& stagingRing,
+	bool hostImageCopy,
+	const std::vector<std::filesystem::path>& paths
+);
+
+// Runs every benchmark that does not need a vulkan device
+void RunBenchmarks();
+
+// Runs every benchmark that needs a vulkan device, the queue must support transfers
+void RunDeviceBenchmarks
+(
+	VkPhysicalDevice physicalDevice,
+	DeviceAllocator& deviceAllocator,
+	VkDevice device,
+	VkCommandPool commandPool,
+	VkQueue queue,
+	StagingRing& stagingRing,
+	bool hostImageCopy
+);
+
+#endif
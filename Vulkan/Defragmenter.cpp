@@ -0,0 +1,432 @@
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+#include <iomanip>
+
+#include "Defragmenter.h"
+#include "HelperFunctions.h"
+
+namespace
+{
+	VkImageMemoryBarrier CreateImageBarrier(VkImage image, uint32_t mipLevels, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask)
+	{
+		// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkImageMemoryBarrier.html
+		return VkImageMemoryBarrier
+		{
+			VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,			// sType
+			nullptr,										// pNext
+			srcAccessMask,									// srcAccessMask
+			dstAccessMask,									// dstAccessMask
+			oldLayout,										// oldLayout
+			newLayout,										// newLayout
+			VK_QUEUE_FAMILY_IGNORED,						// srcQueueFamilyIndex
+			VK_QUEUE_FAMILY_IGNORED,						// dstQueueFamilyIndex
+			image,											// image
+			// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkImageSubresourceRange.html
+			VkImageSubresourceRange							// subresourceRange
+			{
+				VK_IMAGE_ASPECT_COLOR_BIT,			// aspectMask
+				0,									// baseMipLevel
+				mipLevels,							// levelCount
+				0,									// baseArrayLayer
+				1									// layerCount
+			}
+		};
+	}
+}
+
+Defragmenter::Defragmenter(DeviceAllocator& deviceAllocator, uint32_t queueFamily, VkQueue queue) :
+	m_DeviceAllocator{ deviceAllocator },
+	m_Device{ deviceAllocator.GetDevice() },
+	m_Queue{ queue },
+	m_CommandPool{},
+	m_CommandBuffer{},
+	m_Fence{},
+	m_Resources{},
+	m_UnusedResources{},
+	m_PendingResources{},
+	m_Moves{},
+	m_Submitted{ false },
+	m_PassRunning{ false },
+	m_FrameCount{},
+	m_PassCount{},
+	m_MoveCount{},
+	m_MovedBytes{},
+	m_PassMoveCount{},
+	m_PassMovedBytes{},
+	m_PassBlockCount{}
+{
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkCommandPoolCreateInfo.html
+	const VkCommandPoolCreateInfo commandPoolCreateInfo
+	{
+		VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,				// sType
+		nullptr,												// pNext
+		VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,		// flags
+		queueFamily												// queueFamilyIndex
+	};
+
+	if (vkCreateCommandPool(m_Device, &commandPoolCreateInfo, nullptr, &m_CommandPool) != VK_SUCCESS) throw std::runtime_error("Failed to create defragmentation command pool!");
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkCommandBufferAllocateInfo.html
+	const VkCommandBufferAllocateInfo commandBufferAllocateInfo
+	{
+		VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,			// sType
+		nullptr,												// pNext
+		m_CommandPool,											// commandPool
+		VK_COMMAND_BUFFER_LEVEL_PRIMARY,						// level
+		1														// commandBufferCount
+	};
+
+	if (vkAllocateCommandBuffers(m_Device, &commandBufferAllocateInfo, &m_CommandBuffer) != VK_SUCCESS) throw std::runtime_error("Failed to allocate defragmentation command buffer!");
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkFenceCreateInfo.html
+	const VkFenceCreateInfo fenceCreateInfo
+	{
+		VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,					// sType
+		nullptr,												// pNext
+		0														// flags
+	};
+
+	if (vkCreateFence(m_Device, &fenceCreateInfo, nullptr, &m_Fence) != VK_SUCCESS) throw std::runtime_error("Failed to create defragmentation fence!");
+}
+
+Defragmenter::~Defragmenter()
+{
+	// Copies that never got committed are thrown away, the owners keep their old resources
+	if (m_Submitted) vkWaitForFences(m_Device, 1, &m_Fence, VK_TRUE, UINT64_MAX);
+	for (const DefragmentationMove& move : m_Moves) DestroyMove(move);
+	m_DeviceAllocator.EndDefragmentation();
+
+	vkDestroyFence(m_Device, m_Fence, nullptr);
+	vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
+}
+
+uint32_t Defragmenter::RegisterBuffer(VkBuffer& buffer, DeviceAllocation& memory, VkDeviceSize size, VkBufferUsageFlags usage, MovedCallback moved)
+{
+	return Register(MovableResource{ &buffer, nullptr, &memory, size, usage, VkExtent2D{}, VK_FORMAT_UNDEFINED, 0, 0, VK_IMAGE_LAYOUT_UNDEFINED, std::move(moved) });
+}
+
+uint32_t Defragmenter::RegisterImage
+(
+	VkImage& image,
+	DeviceAllocation& memory,
+	VkExtent2D extent,
+	VkFormat format,
+	VkImageUsageFlags usage,
+	uint32_t mipLevels,
+	VkImageLayout layout,
+	MovedCallback moved
+)
+{
+	return Register(MovableResource{ nullptr, &image, &memory, 0, 0, extent, format, usage, mipLevels, layout, std::move(moved) });
+}
+
+void Defragmenter::Unregister(uint32_t resource)
+{
+	CancelMove(resource);
+	m_Resources.at(resource) = MovableResource{};
+	m_UnusedResources.push_back(resource);
+}
+
+void Defragmenter::CancelMove(uint32_t resource)
+{
+	m_PendingResources.erase(std::remove(m_PendingResources.begin(), m_PendingResources.end(), resource), m_PendingResources.end());
+
+	const auto move{ std::find_if(m_Moves.begin(), m_Moves.end(), [resource](const DefragmentationMove& pendingMove) { return pendingMove.Resource == resource; }) };
+	if (move == m_Moves.end()) return;
+
+	if (m_Submitted) vkWaitForFences(m_Device, 1, &m_Fence, VK_TRUE, UINT64_MAX);
+	DestroyMove(*move);
+	m_Moves.erase(move);
+}
+
+void Defragmenter::Update()
+{
+	++m_FrameCount;
+
+	// One submission at a time, the next moves wait until the last ones got committed
+	if (m_Submitted) return;
+
+	if (m_PendingResources.empty())
+	{
+		// Every move of the pass got cancelled
+		if (m_PassRunning) EndPass();
+
+		if (m_FrameCount % g_DefragmentationInterval != 0) return;
+		if (!BeginPass()) return;
+	}
+
+	SubmitMoves();
+}
+
+bool Defragmenter::IsCommitPending() const
+{
+	return m_Submitted and vkGetFenceStatus(m_Device, m_Fence) == VK_SUCCESS;
+}
+
+void Defragmenter::Commit()
+{
+	if (!m_Submitted) return;
+
+	vkWaitForFences(m_Device, 1, &m_Fence, VK_TRUE, UINT64_MAX);
+	m_Submitted = false;
+
+	for (const DefragmentationMove& move : m_Moves)
+	{
+		MovableResource& resource{ m_Resources.at(move.Resource) };
+		const DeviceAllocation oldMemory{ *resource.Memory };
+		*resource.Memory = move.Memory;
+
+		if (resource.Buffer != nullptr)
+		{
+			const VkBuffer oldBuffer{ *resource.Buffer };
+			*resource.Buffer = move.Buffer;
+			if (resource.Moved) resource.Moved();
+			vkDestroyBuffer(m_Device, oldBuffer, nullptr);
+		}
+		else
+		{
+			const VkImage oldImage{ *resource.Image };
+			*resource.Image = move.Image;
+			if (resource.Moved) resource.Moved();
+			vkDestroyImage(m_Device, oldImage, nullptr);
+		}
+
+		// Freeing the last allocation of an excluded block releases the block
+		m_DeviceAllocator.Free(oldMemory);
+
+		++m_PassMoveCount;
+		m_PassMovedBytes += oldMemory.Size;
+	}
+
+	m_Moves.clear();
+
+	if (m_PendingResources.empty()) EndPass();
+}
+
+void Defragmenter::PrintStatistics() const
+{
+	const auto registeredCount{ std::count_if(m_Resources.begin(), m_Resources.end(), [](const MovableResource& resource) { return resource.Memory != nullptr; }) };
+
+	std::cout << "-----Defragmentation-----" << std::endl;
+	std::cout << registeredCount << " movable resources, " << m_PassCount << " passes, " << m_MoveCount << " moves "
+		<< std::fixed << std::setprecision(1) << double(m_MovedBytes) / 1048576.0 << " MiB" << std::defaultfloat << std::endl << std::endl;
+}
+
+uint32_t Defragmenter::Register(const MovableResource& resource)
+{
+	if (m_UnusedResources.empty())
+	{
+		m_Resources.push_back(resource);
+		return static_cast<uint32_t>(m_Resources.size() - 1);
+	}
+
+	const uint32_t slot{ m_UnusedResources.back() };
+	m_UnusedResources.pop_back();
+	m_Resources.at(slot) = resource;
+	return slot;
+}
+
+bool Defragmenter::BeginPass()
+{
+	for (uint32_t i{}; i < static_cast<uint32_t>(m_Resources.size()); ++i)
+	{
+		const MovableResource& resource{ m_Resources.at(i) };
+		if (resource.Memory != nullptr and m_DeviceAllocator.IsDefragmentationCandidate(*resource.Memory, g_DefragmentationThreshold)) m_PendingResources.push_back(i);
+	}
+
+	if (m_PendingResources.empty()) return false;
+
+	// Excluded only now, excluding while looking would change which block counts as the fullest
+	for (uint32_t resource : m_PendingResources) m_DeviceAllocator.ExcludeFromAllocation(*m_Resources.at(resource).Memory);
+
+	m_PassMoveCount = 0;
+	m_PassMovedBytes = 0;
+	m_PassBlockCount = m_DeviceAllocator.GetStatistics().BlockCount;
+	m_PassRunning = true;
+	return true;
+}
+
+void Defragmenter::SubmitMoves()
+{
+	// At least one move per frame, even when that one resource is bigger than the bytes per frame
+	VkDeviceSize bytes{};
+	while (!m_PendingResources.empty() and (m_Moves.empty() or bytes < g_DefragmentationBytesPerFrame))
+	{
+		const uint32_t resourceIndex{ m_PendingResources.back() };
+		m_PendingResources.pop_back();
+
+		const MovableResource& resource{ m_Resources.at(resourceIndex) };
+		DefragmentationMove move{ resourceIndex, VK_NULL_HANDLE, VK_NULL_HANDLE, DeviceAllocation{} };
+
+		if (resource.Buffer != nullptr)
+		{
+			CreateBuffer(m_DeviceAllocator, resource.Size, resource.BufferUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, resource.Memory->Category, move.Buffer, move.Memory);
+		}
+		else
+		{
+			CreateImage
+			(
+				m_DeviceAllocator,
+				resource.Extent,
+				resource.Format,
+				VK_IMAGE_TILING_OPTIMAL,
+				resource.ImageUsage,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				resource.Memory->Category,
+				move.Image,
+				move.Memory,
+				resource.MipLevels,
+				VK_SAMPLE_COUNT_1_BIT
+			);
+		}
+
+		bytes += resource.Memory->Size;
+		m_Moves.push_back(move);
+	}
+
+	if (m_Moves.empty()) return;
+
+	RecordMoves();
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkSubmitInfo.html
+	const VkSubmitInfo submitInfo
+	{
+		VK_STRUCTURE_TYPE_SUBMIT_INFO,			// sType
+		nullptr,								// pNext
+		0,										// waitSemaphoreCount
+		nullptr,								// pWaitSemaphores
+		nullptr,								// pWaitDstStageMask
+		1,										// commandBufferCount
+		&m_CommandBuffer,						// pCommandBuffers
+		0,										// signalSemaphoreCount
+		nullptr									// pSignalSemaphores
+	};
+
+	if (vkResetFences(m_Device, 1, &m_Fence) != VK_SUCCESS) throw std::runtime_error("Failed to reset defragmentation fence!");
+	if (vkQueueSubmit(m_Queue, 1, &submitInfo, m_Fence) != VK_SUCCESS) throw std::runtime_error("Failed to submit defragmentation copies!");
+	m_Submitted = true;
+}
+
+void Defragmenter::RecordMoves() const
+{
+	if (vkResetCommandBuffer(m_CommandBuffer, 0) != VK_SUCCESS) throw std::runtime_error("Failed to reset defragmentation command buffer!");
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkCommandBufferBeginInfo.html
+	const VkCommandBufferBeginInfo commandBufferBeginInfo
+	{
+		VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,			// sType
+		nullptr,												// pNext
+		VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,			// flags
+		nullptr													// pInheritanceInfo
+	};
+
+	if (vkBeginCommandBuffer(m_CommandBuffer, &commandBufferBeginInfo) != VK_SUCCESS) throw std::runtime_error("Failed to begin defragmentation command buffer!");
+
+	// Frames submitted before keep sampling the old images, the layout changes wait for them and get undone after the copy
+	std::vector<VkImageMemoryBarrier> copyBarriers{};
+	std::vector<VkImageMemoryBarrier> readBarriers{};
+	for (const DefragmentationMove& move : m_Moves)
+	{
+		const MovableResource& resource{ m_Resources.at(move.Resource) };
+		if (resource.Image == nullptr) continue;
+
+		copyBarriers.push_back(CreateImageBarrier(*resource.Image, resource.MipLevels, resource.Layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_MEMORY_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT));
+		copyBarriers.push_back(CreateImageBarrier(move.Image, resource.MipLevels, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT));
+		readBarriers.push_back(CreateImageBarrier(*resource.Image, resource.MipLevels, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, resource.Layout, 0, VK_ACCESS_MEMORY_READ_BIT));
+		readBarriers.push_back(CreateImageBarrier(move.Image, resource.MipLevels, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, resource.Layout, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_MEMORY_READ_BIT));
+	}
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkMemoryBarrier.html
+	const VkMemoryBarrier copyBarrier
+	{
+		VK_STRUCTURE_TYPE_MEMORY_BARRIER,						// sType
+		nullptr,												// pNext
+		VK_ACCESS_MEMORY_WRITE_BIT,								// srcAccessMask
+		VK_ACCESS_TRANSFER_READ_BIT								// dstAccessMask
+	};
+	vkCmdPipelineBarrier(m_CommandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &copyBarrier, 0, nullptr, static_cast<uint32_t>(copyBarriers.size()), copyBarriers.data());
+
+	for (const DefragmentationMove& move : m_Moves)
+	{
+		const MovableResource& resource{ m_Resources.at(move.Resource) };
+
+		if (resource.Buffer != nullptr)
+		{
+			// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkBufferCopy.html
+			const VkBufferCopy bufferCopy
+			{
+				0,						// srcOffset
+				0,						// dstOffset
+				resource.Size			// size
+			};
+			vkCmdCopyBuffer(m_CommandBuffer, *resource.Buffer, move.Buffer, 1, &bufferCopy);
+			continue;
+		}
+
+		std::vector<VkImageCopy> imageCopies{};
+		for (uint32_t mipLevel{}; mipLevel < resource.MipLevels; ++mipLevel)
+		{
+			// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkImageSubresourceLayers.html
+			const VkImageSubresourceLayers subresource
+			{
+				VK_IMAGE_ASPECT_COLOR_BIT,			// aspectMask
+				mipLevel,							// mipLevel
+				0,									// baseArrayLayer
+				1									// layerCount
+			};
+
+			// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkImageCopy.html
+			imageCopies.push_back(VkImageCopy
+			{
+				subresource,																				// srcSubresource
+				VkOffset3D{ 0, 0, 0 },																		// srcOffset
+				subresource,																				// dstSubresource
+				VkOffset3D{ 0, 0, 0 },																		// dstOffset
+				VkExtent3D{ std::max(resource.Extent.width >> mipLevel, 1u), std::max(resource.Extent.height >> mipLevel, 1u), 1 }	// extent
+			});
+		}
+
+		vkCmdCopyImage
+		(
+			m_CommandBuffer,
+			*resource.Image,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			move.Image,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(imageCopies.size()),
+			imageCopies.data()
+		);
+	}
+
+	const VkMemoryBarrier readBarrier
+	{
+		VK_STRUCTURE_TYPE_MEMORY_BARRIER,						// sType
+		nullptr,												// pNext
+		VK_ACCESS_TRANSFER_WRITE_BIT,							// srcAccessMask
+		VK_ACCESS_MEMORY_READ_BIT								// dstAccessMask
+	};
+	vkCmdPipelineBarrier(m_CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &readBarrier, 0, nullptr, static_cast<uint32_t>(readBarriers.size()), readBarriers.data());
+
+	if (vkEndCommandBuffer(m_CommandBuffer) != VK_SUCCESS) throw std::runtime_error("Failed to record defragmentation command buffer!");
+}
+
+void Defragmenter::DestroyMove(const DefragmentationMove& move)
+{
+	if (move.Buffer != VK_NULL_HANDLE) vkDestroyBuffer(m_Device, move.Buffer, nullptr);
+	if (move.Image != VK_NULL_HANDLE) vkDestroyImage(m_Device, move.Image, nullptr);
+	m_DeviceAllocator.Free(move.Memory);
+}
+
+void Defragmenter::EndPass()
+{
+	m_DeviceAllocator.EndDefragmentation();
+	m_PassRunning = false;
+
+	++m_PassCount;
+	m_MoveCount += m_PassMoveCount;
+	m_MovedBytes += m_PassMovedBytes;
+
+	std::cout << "Defragmentation moved " << m_PassMoveCount << " resources " << std::fixed << std::setprecision(1) << double(m_PassMovedBytes) / 1048576.0
+		<< " MiB, device memory blocks " << m_PassBlockCount << " before " << m_DeviceAllocator.GetStatistics().BlockCount << " after" << std::defaultfloat << std::endl;
+}
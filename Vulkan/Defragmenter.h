@@ -0,0 +1,118 @@
+#ifndef DEFRAGMENTER
+#define DEFRAGMENTER
+
+#include <vulkan.hpp>
+#include <functional>
+#include <vector>
+
+#include "DeviceAllocator.h"
+
+// Blocks used less than this get emptied by a defragmentation pass
+constexpr double g_DefragmentationThreshold{ 0.5 };
+
+// Bytes copied per frame, a pass over several sparse blocks gets spread over as many frames as it needs
+constexpr VkDeviceSize g_DefragmentationBytesPerFrame{ VkDeviceSize(16) << 20 };
+
+// Frames between two looks for sparse blocks
+constexpr uint32_t g_DefragmentationInterval{ 600 };
+
+// Called once the handle and allocation of the owner got replaced, the old resource still exists during the call
+using MovedCallback = std::function<void()>;
+
+// Buffer or image the defragmenter may move, it writes the new handle and allocation straight into the owner
+struct MovableResource final
+{
+	VkBuffer* Buffer;					// nullptr for images
+	VkImage* Image;						// nullptr for buffers
+	DeviceAllocation* Memory;			// nullptr once unregistered
+	VkDeviceSize Size;
+	VkBufferUsageFlags BufferUsage;
+	VkExtent2D Extent;
+	VkFormat Format;
+	VkImageUsageFlags ImageUsage;
+	uint32_t MipLevels;
+	VkImageLayout Layout;				// The image is in this layout whenever the copy could start
+	MovedCallback Moved;
+};
+
+// Copy of one resource in flight, the new handle and memory replace the old ones on commit
+struct DefragmentationMove final
+{
+	uint32_t Resource;
+	VkBuffer Buffer;
+	VkImage Image;
+	DeviceAllocation Memory;
+};
+
+// Moves the resources out of sparsely used device memory blocks into fuller ones, so the emptied blocks get released and
+// large allocations find room again. Every frame a few megabytes get copied on the queue, rendering keeps reading the old
+// resources until the copies finished and the owner of the frames commits them.
+// Registered resources are read only to everyone else while they get moved, uploads have to cancel the move first.
+class Defragmenter final
+{
+public:
+	Defragmenter(DeviceAllocator& deviceAllocator, uint32_t queueFamily, VkQueue queue);
+	~Defragmenter();
+
+	Defragmenter(const Defragmenter&) = delete;
+	Defragmenter& operator=(const Defragmenter&) = delete;
+	Defragmenter(Defragmenter&&) = delete;
+	Defragmenter& operator=(Defragmenter&&) = delete;
+
+	// Device local buffers only, the usage has to include transfer source and destination
+	uint32_t RegisterBuffer(VkBuffer& buffer, DeviceAllocation& memory, VkDeviceSize size, VkBufferUsageFlags usage, MovedCallback moved = nullptr);
+	// Device local color images with optimal tiling, the usage has to include transfer source and destination
+	uint32_t RegisterImage
+	(
+		VkImage& image,
+		DeviceAllocation& memory,
+		VkExtent2D extent,
+		VkFormat format,
+		VkImageUsageFlags usage,
+		uint32_t mipLevels,
+		VkImageLayout layout,
+		MovedCallback moved = nullptr
+	);
+	void Unregister(uint32_t resource);
+	// Drops the resource from the running pass, waits when its copy is in flight
+	void CancelMove(uint32_t resource);
+
+	// Call once per frame, looks for sparse blocks every interval and submits the copies of the next moves
+	void Update();
+	// True when copies finished and wait to be committed
+	bool IsCommitPending() const;
+	// Swaps the moved resources in and destroys the old ones, the gpu can't be using the old ones anymore
+	void Commit();
+
+	void PrintStatistics() const;
+
+private:
+	DeviceAllocator& m_DeviceAllocator;
+	VkDevice m_Device;
+	VkQueue m_Queue;
+	VkCommandPool m_CommandPool;
+	VkCommandBuffer m_CommandBuffer;
+	VkFence m_Fence;
+	std::vector<MovableResource> m_Resources;
+	std::vector<uint32_t> m_UnusedResources;
+	std::vector<uint32_t> m_PendingResources;		// Still to move in the running pass
+	std::vector<DefragmentationMove> m_Moves;		// Copies of the last submission
+	bool m_Submitted;
+	bool m_PassRunning;
+	uint32_t m_FrameCount;
+	uint32_t m_PassCount;
+	uint32_t m_MoveCount;
+	VkDeviceSize m_MovedBytes;
+	uint32_t m_PassMoveCount;
+	VkDeviceSize m_PassMovedBytes;
+	uint32_t m_PassBlockCount;						// Blocks when the pass started
+
+	uint32_t Register(const MovableResource& resource);
+	bool BeginPass();
+	void SubmitMoves();
+	void RecordMoves() const;
+	void DestroyMove(const DefragmentationMove& move);
+	void EndPass();
+};
+
+#endif
@@ -0,0 +1,624 @@
+#include <bit>
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+#include "DeviceAllocator.h"
+#include "HelperFunctions.h"
+
+namespace
+{
+	VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	void PrintStatisticsRow(const char* name, const DeviceMemoryStatistics& statistics)
+	{
+		const VkDeviceSize freeBytes{ statistics.BlockBytes - statistics.UsedBytes };
+		const double fragmentation{ (freeBytes == 0) ? 0.0 : 1.0 - double(statistics.LargestFreeRegion) / double(freeBytes) };
+
+		std::cout << std::setw(16) << std::left << name << std::fixed << std::setprecision(1)
+			<< statistics.BlockCount << " blocks " << double(statistics.BlockBytes) / 1048576.0 << " MiB, "
+			<< statistics.AllocationCount << " allocations " << double(statistics.UsedBytes) / 1048576.0 << " MiB, "
+			<< statistics.DedicatedCount << " dedicated " << double(statistics.DedicatedBytes) / 1048576.0 << " MiB, "
+			<< statistics.FreeRegionCount << " free regions, fragmentation " << std::setprecision(3) << fragmentation << std::endl;
+		std::cout << std::defaultfloat;
+	}
+}
+
+TlsfAllocator::TlsfAllocator(VkDeviceSize size) :
+	m_Regions{},
+	m_UnusedRegions{},
+	m_FreeLists{},
+	m_FirstLevelMap{},
+	m_SecondLevelMaps{},
+	m_Size{ size & ~(s_MinimumSize - 1) },
+	m_UsedSize{},
+	m_AllocationCount{},
+	m_FreeRegionCount{}
+{
+	for (auto& freeLists : m_FreeLists) freeLists.fill(g_InvalidRegion);
+
+	InsertFreeRegion(CreateRegion(0, m_Size));
+}
+
+bool TlsfAllocator::Allocate(VkDeviceSize size, VkDeviceSize alignment, uint32_t& region, VkDeviceSize& offset)
+{
+	size = AlignUp(std::max(size, VkDeviceSize(1)), s_MinimumSize);
+	alignment = std::max(alignment, s_MinimumSize);
+
+	// Offsets are multiples of the minimum size, so aligning never skips more than this
+	const uint32_t freeRegion{ FindFreeRegion(size + alignment - s_MinimumSize) };
+	if (freeRegion == g_InvalidRegion) return false;
+
+	RemoveFreeRegion(freeRegion);
+
+	// The physical neighbours of a free region are always in use, so the split off parts can't be merged
+	const VkDeviceSize alignedOffset{ AlignUp(m_Regions.at(freeRegion).Offset, alignment) };
+	const VkDeviceSize padding{ alignedOffset - m_Regions.at(freeRegion).Offset };
+	if (padding != 0)
+	{
+		const uint32_t front{ CreateRegion(m_Regions.at(freeRegion).Offset, padding) };
+		m_Regions.at(front).PreviousPhysical = m_Regions.at(freeRegion).PreviousPhysical;
+		m_Regions.at(front).NextPhysical = freeRegion;
+		if (m_Regions.at(front).PreviousPhysical != g_InvalidRegion) m_Regions.at(m_Regions.at(front).PreviousPhysical).NextPhysical = front;
+
+		m_Regions.at(freeRegion).PreviousPhysical = front;
+		m_Regions.at(freeRegion).Offset = alignedOffset;
+		m_Regions.at(freeRegion).Size -= padding;
+		InsertFreeRegion(front);
+	}
+
+	if (m_Regions.at(freeRegion).Size > size)
+	{
+		const uint32_t back{ CreateRegion(alignedOffset + size, m_Regions.at(freeRegion).Size - size) };
+		m_Regions.at(back).PreviousPhysical = freeRegion;
+		m_Regions.at(back).NextPhysical = m_Regions.at(freeRegion).NextPhysical;
+		if (m_Regions.at(back).NextPhysical != g_InvalidRegion) m_Regions.at(m_Regions.at(back).NextPhysical).PreviousPhysical = back;
+
+		m_Regions.at(freeRegion).NextPhysical = back;
+		m_Regions.at(freeRegion).Size = size;
+		InsertFreeRegion(back);
+	}
+
+	m_UsedSize += size;
+	++m_AllocationCount;
+
+	region = freeRegion;
+	offset = alignedOffset;
+	return true;
+}
+
+void TlsfAllocator::Free(uint32_t region)
+{
+	m_UsedSize -= m_Regions.at(region).Size;
+	--m_AllocationCount;
+
+	// Merge with the following region first, the previous one then absorbs both
+	const uint32_t next{ m_Regions.at(region).NextPhysical };
+	if (next != g_InvalidRegion and m_Regions.at(next).Free)
+	{
+		RemoveFreeRegion(next);
+		m_Regions.at(region).Size += m_Regions.at(next).Size;
+		m_Regions.at(region).NextPhysical = m_Regions.at(next).NextPhysical;
+		if (m_Regions.at(region).NextPhysical != g_InvalidRegion) m_Regions.at(m_Regions.at(region).NextPhysical).PreviousPhysical = region;
+		DestroyRegion(next);
+	}
+
+	const uint32_t previous{ m_Regions.at(region).PreviousPhysical };
+	if (previous != g_InvalidRegion and m_Regions.at(previous).Free)
+	{
+		RemoveFreeRegion(previous);
+		m_Regions.at(previous).Size += m_Regions.at(region).Size;
+		m_Regions.at(previous).NextPhysical = m_Regions.at(region).NextPhysical;
+		if (m_Regions.at(previous).NextPhysical != g_InvalidRegion) m_Regions.at(m_Regions.at(previous).NextPhysical).PreviousPhysical = previous;
+		DestroyRegion(region);
+		region = previous;
+	}
+
+	InsertFreeRegion(region);
+}
+
+bool TlsfAllocator::IsEmpty() const
+{
+	return m_AllocationCount == 0;
+}
+
+VkDeviceSize TlsfAllocator::GetSize() const
+{
+	return m_Size;
+}
+
+VkDeviceSize TlsfAllocator::GetUsedSize() const
+{
+	return m_UsedSize;
+}
+
+uint32_t TlsfAllocator::GetAllocationCount() const
+{
+	return m_AllocationCount;
+}
+
+uint32_t TlsfAllocator::GetFreeRegionCount() const
+{
+	return m_FreeRegionCount;
+}
+
+VkDeviceSize TlsfAllocator::GetLargestFreeRegion() const
+{
+	if (m_FirstLevelMap == 0) return 0;
+
+	// The largest region sits in the highest size class, only that list has to be walked
+	const uint32_t firstLevel{ static_cast<uint32_t>(std::bit_width(m_FirstLevelMap) - 1) };
+	const uint32_t secondLevel{ static_cast<uint32_t>(std::bit_width(m_SecondLevelMaps.at(firstLevel)) - 1) };
+
+	VkDeviceSize largest{};
+	for (uint32_t region{ m_FreeLists.at(firstLevel).at(secondLevel) }; region != g_InvalidRegion; region = m_Regions.at(region).NextFree)
+	{
+		largest = std::max(largest, m_Regions.at(region).Size);
+	}
+
+	return largest;
+}
+
+void TlsfAllocator::MapSize(VkDeviceSize size, uint32_t& firstLevel, uint32_t& secondLevel)
+{
+	if (size < s_SmallSize)
+	{
+		firstLevel = 0;
+		secondLevel = static_cast<uint32_t>(size / s_MinimumSize);
+		return;
+	}
+
+	// The small sizes take the first level 0, so the power of two of the small size maps to the first level 1
+	const uint32_t powerOfTwo{ static_cast<uint32_t>(std::bit_width(size) - 1) };
+	firstLevel = powerOfTwo - static_cast<uint32_t>(std::bit_width(s_SmallSize) - 1) + 1;
+	secondLevel = static_cast<uint32_t>(size >> (powerOfTwo - s_SecondLevelLog2)) - s_SecondLevelCount;
+}
+
+uint32_t TlsfAllocator::FindFreeRegion(VkDeviceSize size) const
+{
+	// Rounding up to the next size class makes every region of the class large enough, no list has to be searched
+	if (size >= s_SmallSize) size += (VkDeviceSize(1) << (std::bit_width(size) - 1 - s_SecondLevelLog2)) - 1;
+
+	uint32_t firstLevel{}, secondLevel{};
+	MapSize(size, firstLevel, secondLevel);
+	if (firstLevel >= s_FirstLevelCount) return g_InvalidRegion;
+
+	uint32_t secondLevelMap{ m_SecondLevelMaps.at(firstLevel) & (~0u << secondLevel) };
+	if (secondLevelMap == 0)
+	{
+		const uint64_t firstLevelMap{ (firstLevel + 1 < s_FirstLevelCount) ? m_FirstLevelMap & (~uint64_t(0) << (firstLevel + 1)) : 0 };
+		if (firstLevelMap == 0) return g_InvalidRegion;
+
+		firstLevel = static_cast<uint32_t>(std::countr_zero(firstLevelMap));
+		secondLevelMap = m_SecondLevelMaps.at(firstLevel);
+	}
+
+	secondLevel = static_cast<uint32_t>(std::countr_zero(secondLevelMap));
+	return m_FreeLists.at(firstLevel).at(secondLevel);
+}
+
+void TlsfAllocator::InsertFreeRegion(uint32_t region)
+{
+	uint32_t firstLevel{}, secondLevel{};
+	MapSize(m_Regions.at(region).Size, firstLevel, secondLevel);
+
+	uint32_t& head{ m_FreeLists.at(firstLevel).at(secondLevel) };
+	m_Regions.at(region).Free = true;
+	m_Regions.at(region).PreviousFree = g_InvalidRegion;
+	m_Regions.at(region).NextFree = head;
+	if (head != g_InvalidRegion) m_Regions.at(head).PreviousFree = region;
+	head = region;
+
+	m_FirstLevelMap |= uint64_t(1) << firstLevel;
+	m_SecondLevelMaps.at(firstLevel) |= 1u << secondLevel;
+	++m_FreeRegionCount;
+}
+
+void TlsfAllocator::RemoveFreeRegion(uint32_t region)
+{
+	uint32_t firstLevel{}, secondLevel{};
+	MapSize(m_Regions.at(region).Size, firstLevel, secondLevel);
+
+	const Region& freeRegion{ m_Regions.at(region) };
+	if (freeRegion.PreviousFree != g_InvalidRegion) m_Regions.at(freeRegion.PreviousFree).NextFree = freeRegion.NextFree;
+	else m_FreeLists.at(firstLevel).at(secondLevel) = freeRegion.NextFree;
+	if (freeRegion.NextFree != g_InvalidRegion) m_Regions.at(freeRegion.NextFree).PreviousFree = freeRegion.PreviousFree;
+
+	if (m_FreeLists.at(firstLevel).at(secondLevel) == g_InvalidRegion)
+	{
+		m_SecondLevelMaps.at(firstLevel) &= ~(1u << secondLevel);
+		if (m_SecondLevelMaps.at(firstLevel) == 0) m_FirstLevelMap &= ~(uint64_t(1) << firstLevel);
+	}
+
+	m_Regions.at(region).Free = false;
+	--m_FreeRegionCount;
+}
+
+uint32_t TlsfAllocator::CreateRegion(VkDeviceSize offset, VkDeviceSize size)
+{
+	const Region newRegion{ offset, size, g_InvalidRegion, g_InvalidRegion, g_InvalidRegion, g_InvalidRegion, false };
+
+	if (m_UnusedRegions.empty())
+	{
+		m_Regions.push_back(newRegion);
+		return static_cast<uint32_t>(m_Regions.size() - 1);
+	}
+
+	const uint32_t region{ m_UnusedRegions.back() };
+	m_UnusedRegions.pop_back();
+	m_Regions.at(region) = newRegion;
+	return region;
+}
+
+void TlsfAllocator::DestroyRegion(uint32_t region)
+{
+	m_UnusedRegions.push_back(region);
+}
+
+DeviceAllocator::DeviceAllocator(VkPhysicalDevice physicalDevice, VkDevice device, MemoryBudget& memoryBudget, VkDeviceSize blockSize) :
+	m_PhysicalDevice{ physicalDevice },
+	m_Device{ device },
+	m_MemoryBudget{ memoryBudget },
+	m_MemoryProperties{},
+	m_BufferImageGranularity{},
+	m_MaxAllocationCount{},
+	m_DeviceMemoryCount{},
+	m_BlockSizes{},
+	m_Pools{},
+	m_DedicatedCounts{},
+	m_DedicatedBytes{}
+{
+	vkGetPhysicalDeviceMemoryProperties(m_PhysicalDevice, &m_MemoryProperties);
+
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(m_PhysicalDevice, &properties);
+	m_BufferImageGranularity = properties.limits.bufferImageGranularity;
+	m_MaxAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+	// Small heaps, like the device local host visible heap of 256 MiB on a lot of desktop gpus, get smaller blocks
+	for (uint32_t i{}; i < m_MemoryProperties.memoryHeapCount; ++i)
+	{
+		const VkDeviceSize heapSize{ m_MemoryProperties.memoryHeaps[i].size };
+		m_BlockSizes.at(i) = (heapSize <= (VkDeviceSize(1) << 30)) ? std::min(blockSize, AlignUp(heapSize / 8, 1 << 20)) : blockSize;
+	}
+
+	m_Pools.resize(size_t(m_MemoryProperties.memoryTypeCount) * 2);
+	for (uint32_t i{}; i < static_cast<uint32_t>(m_Pools.size()); ++i) m_Pools.at(i).MemoryType = i / 2;
+}
+
+DeviceAllocator::~DeviceAllocator()
+{
+	for (DeviceMemoryPool& pool : m_Pools)
+	{
+		for (DeviceMemoryBlock& block : pool.Blocks)
+		{
+			if (block.Memory == VK_NULL_HANDLE) continue;
+			if (!block.Allocator.IsEmpty()) std::cout << "Device memory block freed with " << block.Allocator.GetAllocationCount() << " allocations left!" << std::endl;
+
+			vkFreeMemory(m_Device, block.Memory, nullptr);
+			m_MemoryBudget.RemoveDeviceMemory(m_MemoryProperties.memoryTypes[pool.MemoryType].heapIndex, block.Allocator.GetSize());
+		}
+	}
+}
+
+DeviceAllocation DeviceAllocator::AllocateBufferMemory(VkBuffer buffer, VkMemoryPropertyFlags properties, MemoryCategory category)
+{
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkMemoryDedicatedRequirements.html
+	VkMemoryDedicatedRequirements dedicatedRequirements{};
+	dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkMemoryRequirements2.html
+	VkMemoryRequirements2 memoryRequirements{};
+	memoryRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+	memoryRequirements.pNext = &dedicatedRequirements;
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkBufferMemoryRequirementsInfo2.html
+	const VkBufferMemoryRequirementsInfo2 requirementsInfo
+	{
+		VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2,		// sType
+		nullptr,													// pNext
+		buffer														// buffer
+	};
+
+	vkGetBufferMemoryRequirements2(m_Device, &requirementsInfo, &memoryRequirements);
+
+	const bool dedicated{ dedicatedRequirements.prefersDedicatedAllocation == VK_TRUE or dedicatedRequirements.requiresDedicatedAllocation == VK_TRUE };
+	const DeviceAllocation allocation{ Allocate(memoryRequirements.memoryRequirements, properties, category, false, dedicated, buffer, VK_NULL_HANDLE) };
+
+	if (vkBindBufferMemory(m_Device, buffer, allocation.Memory, allocation.Offset) != VK_SUCCESS) throw std::runtime_error("Failed to bind buffer memory!");
+
+	return allocation;
+}
+
+DeviceAllocation DeviceAllocator::AllocateImageMemory(VkImage image, VkImageTiling tiling, VkMemoryPropertyFlags properties, MemoryCategory category)
+{
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkMemoryDedicatedRequirements.html
+	VkMemoryDedicatedRequirements dedicatedRequirements{};
+	dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkMemoryRequirements2.html
+	VkMemoryRequirements2 memoryRequirements{};
+	memoryRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+	memoryRequirements.pNext = &dedicatedRequirements;
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkImageMemoryRequirementsInfo2.html
+	const VkImageMemoryRequirementsInfo2 requirementsInfo
+	{
+		VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2,			// sType
+		nullptr,													// pNext
+		image														// image
+	};
+
+	vkGetImageMemoryRequirements2(m_Device, &requirementsInfo, &memoryRequirements);
+
+	const bool dedicated{ dedicatedRequirements.prefersDedicatedAllocation == VK_TRUE or dedicatedRequirements.requiresDedicatedAllocation == VK_TRUE };
+	const DeviceAllocation allocation{ Allocate(memoryRequirements.memoryRequirements, properties, category, tiling == VK_IMAGE_TILING_OPTIMAL, dedicated, VK_NULL_HANDLE, image) };
+
+	if (vkBindImageMemory(m_Device, image, allocation.Memory, allocation.Offset) != VK_SUCCESS) throw std::runtime_error("Failed to bind image memory!");
+
+	return allocation;
+}
+
+DeviceAllocation DeviceAllocator::AllocateMemory(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, MemoryCategory category, bool optimal)
+{
+	return Allocate(requirements, properties, category, optimal, false, VK_NULL_HANDLE, VK_NULL_HANDLE);
+}
+
+void DeviceAllocator::Free(const DeviceAllocation& allocation)
+{
+	if (allocation.Memory == VK_NULL_HANDLE) return;
+
+	const uint32_t memoryType{ m_Pools.at(allocation.Pool).MemoryType };
+	const uint32_t heap{ m_MemoryProperties.memoryTypes[memoryType].heapIndex };
+	m_MemoryBudget.RemoveAllocation(allocation.Category, heap, allocation.Size);
+
+	if (allocation.Block == g_DedicatedAllocation)
+	{
+		vkFreeMemory(m_Device, allocation.Memory, nullptr);
+		m_MemoryBudget.RemoveDeviceMemory(heap, allocation.Size);
+		--m_DeviceMemoryCount;
+		--m_DedicatedCounts.at(memoryType);
+		m_DedicatedBytes.at(memoryType) -= allocation.Size;
+		return;
+	}
+
+	DeviceMemoryPool& pool{ m_Pools.at(allocation.Pool) };
+	DeviceMemoryBlock& block{ pool.Blocks.at(allocation.Block) };
+	block.Allocator.Free(allocation.Region);
+	if (!block.Allocator.IsEmpty()) return;
+
+	// One empty block stays around, so resources that get created and destroyed over and over don't hit the driver every time
+	const auto liveBlocks{ std::count_if(pool.Blocks.begin(), pool.Blocks.end(), [](const DeviceMemoryBlock& poolBlock) { return poolBlock.Memory != VK_NULL_HANDLE; }) };
+	if (liveBlocks <= 1) return;
+
+	vkFreeMemory(m_Device, block.Memory, nullptr);
+	m_MemoryBudget.RemoveDeviceMemory(heap, block.Allocator.GetSize());
+	block.Memory = VK_NULL_HANDLE;
+	block.Map = nullptr;
+	block.Defragmenting = false;
+	--m_DeviceMemoryCount;
+}
+
+DeviceMemoryStatistics DeviceAllocator::GetStatistics() const
+{
+	DeviceMemoryStatistics total{};
+
+	for (uint32_t i{}; i < m_MemoryProperties.memoryTypeCount; ++i)
+	{
+		const DeviceMemoryStatistics statistics{ GetStatistics(i) };
+		total.BlockCount += statistics.BlockCount;
+		total.DedicatedCount += statistics.DedicatedCount;
+		total.AllocationCount += statistics.AllocationCount;
+		total.FreeRegionCount += statistics.FreeRegionCount;
+		total.BlockBytes += statistics.BlockBytes;
+		total.DedicatedBytes += statistics.DedicatedBytes;
+		total.UsedBytes += statistics.UsedBytes;
+		total.LargestFreeRegion = std::max(total.LargestFreeRegion, statistics.LargestFreeRegion);
+	}
+
+	return total;
+}
+
+void DeviceAllocator::PrintStatistics() const
+{
+	std::cout << "-----Device Memory-----" << std::endl;
+
+	for (uint32_t i{}; i < m_MemoryProperties.memoryTypeCount; ++i)
+	{
+		const DeviceMemoryStatistics statistics{ GetStatistics(i) };
+		if (statistics.BlockCount == 0 and statistics.DedicatedCount == 0) continue;
+
+		const std::string name{ "Memory type " + std::to_string(i) };
+		PrintStatisticsRow(name.c_str(), statistics);
+	}
+
+	PrintStatisticsRow("Total", GetStatistics());
+	std::cout << m_DeviceMemoryCount << " of " << m_MaxAllocationCount << " device memory allocations in use" << std::endl << std::endl;
+}
+
+bool DeviceAllocator::HasMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const
+{
+	for (uint32_t i{}; i < m_MemoryProperties.memoryTypeCount; ++i)
+	{
+		if ((typeBits & (1u << i)) and (m_MemoryProperties.memoryTypes[i].propertyFlags & properties) == properties) return true;
+	}
+
+	return false;
+}
+
+uint32_t DeviceAllocator::GetMemoryType(const DeviceAllocation& allocation) const
+{
+	return m_Pools.at(allocation.Pool).MemoryType;
+}
+
+uint32_t DeviceAllocator::GetHeap(const DeviceAllocation& allocation) const
+{
+	return m_MemoryProperties.memoryTypes[m_Pools.at(allocation.Pool).MemoryType].heapIndex;
+}
+
+bool DeviceAllocator::IsDefragmentationCandidate(const DeviceAllocation& allocation, double threshold) const
+{
+	if (allocation.Memory == VK_NULL_HANDLE or allocation.Block == g_DedicatedAllocation) return false;
+
+	const DeviceMemoryPool& pool{ m_Pools.at(allocation.Pool) };
+	const TlsfAllocator& allocator{ pool.Blocks.at(allocation.Block).Allocator };
+	if (double(allocator.GetUsedSize()) >= double(allocator.GetSize()) * threshold) return false;
+
+	// The fullest block is where the others get compacted into, it never gets emptied itself
+	for (uint32_t i{}; i < static_cast<uint32_t>(pool.Blocks.size()); ++i)
+	{
+		const DeviceMemoryBlock& block{ pool.Blocks.at(i) };
+		if (block.Memory == VK_NULL_HANDLE or i == allocation.Block) continue;
+
+		// Equally full blocks keep the one with the lowest index
+		const VkDeviceSize usedSize{ block.Allocator.GetUsedSize() };
+		if (usedSize > allocator.GetUsedSize() or (usedSize == allocator.GetUsedSize() and i < allocation.Block)) return true;
+	}
+
+	return false;
+}
+
+void DeviceAllocator::ExcludeFromAllocation(const DeviceAllocation& allocation)
+{
+	if (allocation.Block == g_DedicatedAllocation) return;
+
+	m_Pools.at(allocation.Pool).Blocks.at(allocation.Block).Defragmenting = true;
+}
+
+void DeviceAllocator::EndDefragmentation()
+{
+	for (DeviceMemoryPool& pool : m_Pools)
+	{
+		for (DeviceMemoryBlock& block : pool.Blocks) block.Defragmenting = false;
+	}
+}
+
+VkPhysicalDevice DeviceAllocator::GetPhysicalDevice() const
+{
+	return m_PhysicalDevice;
+}
+
+VkDevice DeviceAllocator::GetDevice() const
+{
+	return m_Device;
+}
+
+DeviceAllocation DeviceAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, MemoryCategory category, bool optimal, bool dedicated, VkBuffer buffer, VkImage image)
+{
+	const uint32_t memoryType{ FindMemoryTypeIndex(m_PhysicalDevice, requirements.memoryTypeBits, properties) };
+	const uint32_t heap{ m_MemoryProperties.memoryTypes[memoryType].heapIndex };
+	const VkDeviceSize blockSize{ m_BlockSizes.at(heap) };
+
+	if (dedicated or requirements.size > blockSize / 2) return AllocateDedicated(memoryType, requirements.size, category, buffer, image);
+
+	// Linear and optimal resources sharing a page of bufferImageGranularity alias on some gpus, separate pools keep them apart
+	const uint32_t poolIndex{ memoryType * 2 + ((optimal and m_BufferImageGranularity > 1) ? 1 : 0) };
+	DeviceMemoryPool& pool{ m_Pools.at(poolIndex) };
+
+	DeviceAllocation allocation{ VK_NULL_HANDLE, 0, requirements.size, nullptr, poolIndex, 0, g_InvalidRegion, category };
+	m_MemoryBudget.AddAllocation(category, heap, requirements.size);
+
+	for (uint32_t i{}; i < static_cast<uint32_t>(pool.Blocks.size()); ++i)
+	{
+		DeviceMemoryBlock& block{ pool.Blocks.at(i) };
+		if (block.Memory == VK_NULL_HANDLE or block.Defragmenting) continue;
+		if (!block.Allocator.Allocate(requirements.size, requirements.alignment, allocation.Region, allocation.Offset)) continue;
+
+		allocation.Memory = block.Memory;
+		allocation.Map = (block.Map != nullptr) ? static_cast<char*>(block.Map) + allocation.Offset : nullptr;
+		allocation.Block = i;
+		return allocation;
+	}
+
+	// Every block is full, a new one goes into the first released slot
+	auto slot{ std::find_if(pool.Blocks.begin(), pool.Blocks.end(), [](const DeviceMemoryBlock& block) { return block.Memory == VK_NULL_HANDLE; }) };
+	if (slot == pool.Blocks.end()) slot = pool.Blocks.insert(pool.Blocks.end(), DeviceMemoryBlock{ VK_NULL_HANDLE, nullptr, TlsfAllocator{ blockSize }, false });
+	else slot->Allocator = TlsfAllocator{ blockSize };
+	slot->Defragmenting = false;
+
+	slot->Memory = AllocateDeviceMemory(memoryType, blockSize, nullptr, slot->Map);
+	if (!slot->Allocator.Allocate(requirements.size, requirements.alignment, allocation.Region, allocation.Offset)) throw std::runtime_error("Failed to suballocate device memory!");
+
+	allocation.Memory = slot->Memory;
+	allocation.Map = (slot->Map != nullptr) ? static_cast<char*>(slot->Map) + allocation.Offset : nullptr;
+	allocation.Block = static_cast<uint32_t>(slot - pool.Blocks.begin());
+	return allocation;
+}
+
+DeviceAllocation DeviceAllocator::AllocateDedicated(uint32_t memoryType, VkDeviceSize size, MemoryCategory category, VkBuffer buffer, VkImage image)
+{
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkMemoryDedicatedAllocateInfo.html
+	const VkMemoryDedicatedAllocateInfo dedicatedAllocateInfo
+	{
+		VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,		// sType
+		nullptr,												// pNext
+		image,													// image
+		buffer													// buffer
+	};
+
+	DeviceAllocation allocation{ VK_NULL_HANDLE, 0, size, nullptr, memoryType * 2, g_DedicatedAllocation, g_InvalidRegion, category };
+	allocation.Memory = AllocateDeviceMemory(memoryType, size, &dedicatedAllocateInfo, allocation.Map);
+	m_MemoryBudget.AddAllocation(category, m_MemoryProperties.memoryTypes[memoryType].heapIndex, size);
+
+	++m_DedicatedCounts.at(memoryType);
+	m_DedicatedBytes.at(memoryType) += size;
+
+	return allocation;
+}
+
+VkDeviceMemory DeviceAllocator::AllocateDeviceMemory(uint32_t memoryType, VkDeviceSize size, const void* next, void*& map)
+{
+	if (m_DeviceMemoryCount >= m_MaxAllocationCount) throw std::runtime_error("Ran out of device memory allocations!");
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkMemoryAllocateInfo.html
+	const VkMemoryAllocateInfo memoryAllocateInfo
+	{
+		VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,			// sType
+		next,											// pNext
+		size,											// allocationSize
+		memoryType										// memoryTypeIndex
+	};
+
+	VkDeviceMemory memory{};
+	if (vkAllocateMemory(m_Device, &memoryAllocateInfo, nullptr, &memory) != VK_SUCCESS) throw std::runtime_error("Failed to allocate device memory!");
+	++m_DeviceMemoryCount;
+	m_MemoryBudget.AddDeviceMemory(m_MemoryProperties.memoryTypes[memoryType].heapIndex, size);
+
+	// Host visible memory gets mapped once for its whole lifetime, a memory object can't be mapped twice
+	map = nullptr;
+	if (m_MemoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+	{
+		if (vkMapMemory(m_Device, memory, 0, VK_WHOLE_SIZE, 0, &map) != VK_SUCCESS) throw std::runtime_error("Failed to map device memory!");
+	}
+
+	return memory;
+}
+
+DeviceMemoryStatistics DeviceAllocator::GetStatistics(uint32_t memoryType) const
+{
+	DeviceMemoryStatistics statistics{};
+	statistics.DedicatedCount = m_DedicatedCounts.at(memoryType);
+	statistics.DedicatedBytes = m_DedicatedBytes.at(memoryType);
+
+	for (uint32_t pool{ memoryType * 2 }; pool < memoryType * 2 + 2; ++pool)
+	{
+		for (const DeviceMemoryBlock& block : m_Pools.at(pool).Blocks)
+		{
+			if (block.Memory == VK_NULL_HANDLE) continue;
+
+			++statistics.BlockCount;
+			statistics.AllocationCount += block.Allocator.GetAllocationCount();
+			statistics.FreeRegionCount += block.Allocator.GetFreeRegionCount();
+			statistics.BlockBytes += block.Allocator.GetSize();
+			statistics.UsedBytes += block.Allocator.GetUsedSize();
+			statistics.LargestFreeRegion = std::max(statistics.LargestFreeRegion, block.Allocator.GetLargestFreeRegion());
+		}
+	}
+
+	return statistics;
+}
@@ -0,0 +1,175 @@
+#ifndef DEVICE_ALLOCATOR
+#define DEVICE_ALLOCATOR
+
+#include <vulkan.hpp>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+#include "MemoryBudget.h"
+
+// Size of the device memory blocks allocations get carved out of, heaps of a gigabyte or less use an eighth of the heap
+constexpr VkDeviceSize g_DeviceMemoryBlockSize{ VkDeviceSize(64) << 20 };
+
+// Block index of allocations that own their device memory
+constexpr uint32_t g_DedicatedAllocation{ UINT32_MAX };
+
+// Region handle that doesn't point to a region
+constexpr uint32_t g_InvalidRegion{ UINT32_MAX };
+
+// Two level segregated fit over the bytes of one block (Masmano et al.), allocating and freeing take constant time.
+// The first level splits the sizes on powers of two, the second level splits every power of two in 16 linear steps.
+class TlsfAllocator final
+{
+public:
+	TlsfAllocator(VkDeviceSize size);
+
+	// Returns false when no free region is large enough, the alignment has to be a power of two
+	bool Allocate(VkDeviceSize size, VkDeviceSize alignment, uint32_t& region, VkDeviceSize& offset);
+	void Free(uint32_t region);
+
+	bool IsEmpty() const;
+	VkDeviceSize GetSize() const;
+	VkDeviceSize GetUsedSize() const;
+	uint32_t GetAllocationCount() const;
+	uint32_t GetFreeRegionCount() const;
+	VkDeviceSize GetLargestFreeRegion() const;
+
+private:
+	static constexpr uint32_t s_SecondLevelLog2{ 4 };
+	static constexpr uint32_t s_SecondLevelCount{ 1 << s_SecondLevelLog2 };
+	static constexpr uint32_t s_FirstLevelCount{ 64 };
+	static constexpr VkDeviceSize s_MinimumSize{ 16 };									// Every offset and size is a multiple of this
+	static constexpr VkDeviceSize s_SmallSize{ s_MinimumSize * s_SecondLevelCount };	// Sizes below go linearly into the first level 0
+
+	struct Region final
+	{
+		VkDeviceSize Offset;
+		VkDeviceSize Size;
+		uint32_t PreviousPhysical;			// Neighbours inside the block, sorted on offset
+		uint32_t NextPhysical;
+		uint32_t PreviousFree;				// Neighbours inside the free list of the size class
+		uint32_t NextFree;
+		bool Free;
+	};
+
+	std::vector<Region> m_Regions;
+	std::vector<uint32_t> m_UnusedRegions;
+	std::array<std::array<uint32_t, s_SecondLevelCount>, s_FirstLevelCount> m_FreeLists;
+	uint64_t m_FirstLevelMap;												// Bit per first level that has a free region
+	std::array<uint32_t, s_FirstLevelCount> m_SecondLevelMaps;				// Bit per size class that has a free region
+	VkDeviceSize m_Size;
+	VkDeviceSize m_UsedSize;
+	uint32_t m_AllocationCount;
+	uint32_t m_FreeRegionCount;
+
+	static void MapSize(VkDeviceSize size, uint32_t& firstLevel, uint32_t& secondLevel);
+	uint32_t FindFreeRegion(VkDeviceSize size) const;
+	void InsertFreeRegion(uint32_t region);
+	void RemoveFreeRegion(uint32_t region);
+	uint32_t CreateRegion(VkDeviceSize offset, VkDeviceSize size);
+	void DestroyRegion(uint32_t region);
+};
+
+// Part of a device memory block, what CreateBuffer and CreateImage hand out instead of a VkDeviceMemory of their own
+struct DeviceAllocation final
+{
+	VkDeviceMemory Memory;
+	VkDeviceSize Offset;
+	VkDeviceSize Size;
+	void* Map;							// Host address of Offset when the memory type is host visible, nullptr otherwise
+	uint32_t Pool;
+	uint32_t Block;						// g_DedicatedAllocation when the allocation owns Memory
+	uint32_t Region;
+	MemoryCategory Category;
+};
+
+struct DeviceMemoryStatistics final
+{
+	uint32_t BlockCount;
+	uint32_t DedicatedCount;
+	uint32_t AllocationCount;			// Suballocations, the dedicated allocations not included
+	uint32_t FreeRegionCount;
+	VkDeviceSize BlockBytes;
+	VkDeviceSize DedicatedBytes;
+	VkDeviceSize UsedBytes;				// Of the blocks
+	VkDeviceSize LargestFreeRegion;
+};
+
+// Block of device memory and the allocator handing out its bytes, host visible blocks stay mapped
+struct DeviceMemoryBlock final
+{
+	VkDeviceMemory Memory;				// VK_NULL_HANDLE once the block got released, its slot gets reused
+	void* Map;
+	TlsfAllocator Allocator;
+	bool Defragmenting;					// Gets emptied by the defragmenter, new allocations skip it
+};
+
+// Blocks of one memory type, linear and optimal resources get their own pool when bufferImageGranularity asks for it
+struct DeviceMemoryPool final
+{
+	uint32_t MemoryType;
+	std::vector<DeviceMemoryBlock> Blocks;
+};
+
+// Suballocates buffers and images out of large device memory blocks instead of calling vkAllocateMemory for every resource,
+// resources the driver prefers to own their memory and resources bigger than half a block get a dedicated allocation.
+// Every device memory allocation and every resource gets reported to the memory budget.
+class DeviceAllocator final
+{
+public:
+	DeviceAllocator(VkPhysicalDevice physicalDevice, VkDevice device, MemoryBudget& memoryBudget, VkDeviceSize blockSize = g_DeviceMemoryBlockSize);
+	~DeviceAllocator();
+
+	DeviceAllocator(const DeviceAllocator&) = delete;
+	DeviceAllocator& operator=(const DeviceAllocator&) = delete;
+	DeviceAllocator(DeviceAllocator&&) = delete;
+	DeviceAllocator& operator=(DeviceAllocator&&) = delete;
+
+	// Allocates memory with the given properties and binds it to the buffer
+	DeviceAllocation AllocateBufferMemory(VkBuffer buffer, VkMemoryPropertyFlags properties, MemoryCategory category);
+	// Allocates memory with the given properties and binds it to the image, the tiling decides which pool it comes from
+	DeviceAllocation AllocateImageMemory(VkImage image, VkImageTiling tiling, VkMemoryPropertyFlags properties, MemoryCategory category);
+	// Allocates memory without binding it, for resources that share one allocation
+	DeviceAllocation AllocateMemory(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, MemoryCategory category, bool optimal);
+	void Free(const DeviceAllocation& allocation);
+
+	// Totals of every memory type
+	DeviceMemoryStatistics GetStatistics() const;
+	// Statistics of the memory types in use, fragmentation is the part of the free bytes outside the largest free region
+	void PrintStatistics() const;
+
+	// True when one of the memory types in typeBits has all the properties
+	bool HasMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const;
+	uint32_t GetMemoryType(const DeviceAllocation& allocation) const;
+	// Heap the memory of the allocation comes from
+	uint32_t GetHeap(const DeviceAllocation& allocation) const;
+
+	// True when the block of the allocation is used less than the threshold and a fuller block of its pool can take its resources
+	bool IsDefragmentationCandidate(const DeviceAllocation& allocation, double threshold) const;
+	// New allocations skip the block of the allocation until the defragmentation ends, so moving out of it empties it
+	void ExcludeFromAllocation(const DeviceAllocation& allocation);
+	void EndDefragmentation();
+	VkPhysicalDevice GetPhysicalDevice() const;
+	VkDevice GetDevice() const;
+
+private:
+	VkPhysicalDevice m_PhysicalDevice;
+	VkDevice m_Device;
+	MemoryBudget& m_MemoryBudget;
+	VkPhysicalDeviceMemoryProperties m_MemoryProperties;
+	VkDeviceSize m_BufferImageGranularity;
+	uint32_t m_MaxAllocationCount;
+	uint32_t m_DeviceMemoryCount;											// Live vkAllocateMemory allocations, blocks and dedicated
+	std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_BlockSizes;
+	std::vector<DeviceMemoryPool> m_Pools;									// Two per memory type, linear and optimal
+	std::array<uint32_t, VK_MAX_MEMORY_TYPES> m_DedicatedCounts;
+	std::array<VkDeviceSize, VK_MAX_MEMORY_TYPES> m_DedicatedBytes;
+
+	DeviceAllocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, MemoryCategory category, bool optimal, bool dedicated, VkBuffer buffer, VkImage image);
+	DeviceAllocation AllocateDedicated(uint32_t memoryType, VkDeviceSize size, MemoryCategory category, VkBuffer buffer, VkImage image);
+	VkDeviceMemory AllocateDeviceMemory(uint32_t memoryType, VkDeviceSize size, const void* next, void*& map);
+	DeviceMemoryStatistics GetStatistics(uint32_t memoryType) const;
+};
+
+#endif
@@ -0,0 +1,190 @@
+#if defined(__AVX__) or defined(__SSE2__) or defined(_M_X64) or (defined(_M_IX86_FP) and _M_IX86_FP >= 2)
+	#include <immintrin.h>
+#endif
+
+#include <bit>
+#include <array>
+#include <cmath>
+
+#include "FrustumCulling.h"
+#include "Mesh.h"
+
+namespace
+{
+	// Signed distance of the box its furthest corner along the plane normal, negative means fully outside
+	bool IsBoxInside(const Frustum& frustum, const ObjectBounds& bounds, size_t object)
+	{
+		for (const glm::vec4& plane : frustum.Planes)
+		{
+			// Same order of additions as the batches, so both give the same answer on the plane
+			const float distance
+			{
+				plane.x * bounds.CenterX[object] + plane.w + plane.y * bounds.CenterY[object] + plane.z * bounds.CenterZ[object] +
+				std::abs(plane.x) * bounds.ExtentX[object] + std::abs(plane.y) * bounds.ExtentY[object] + std::abs(plane.z) * bounds.ExtentZ[object]
+			};
+
+			if (distance < 0.0f) return false;
+		}
+
+		return true;
+	}
+}
+
+void AddObjectBounds
+(
+	ObjectBounds& bounds,
+	const BoundingBox& boundingBox,
+	const glm::mat4& modelMatrix
+)
+{
+	const glm::vec3 center{ modelMatrix * glm::vec4{ (boundingBox.Minimum + boundingBox.Maximum) * 0.5f, 1.0f } };
+	const glm::vec3 extent{ (boundingBox.Maximum - boundingBox.Minimum) * 0.5f };
+
+	// Every world axis picks up the absolute contribution of every mesh axis
+	const glm::mat3 absolute{ glm::abs(glm::vec3{ modelMatrix[0] }), glm::abs(glm::vec3{ modelMatrix[1] }), glm::abs(glm::vec3{ modelMatrix[2] }) };
+	const glm::vec3 worldExtent{ absolute * extent };
+
+	bounds.CenterX.push_back(center.x);
+	bounds.CenterY.push_back(center.y);
+	bounds.CenterZ.push_back(center.z);
+	bounds.ExtentX.push_back(worldExtent.x);
+	bounds.ExtentY.push_back(worldExtent.y);
+	bounds.ExtentZ.push_back(worldExtent.z);
+}
+
+void ClearObjectBounds
+(
+	ObjectBounds& bounds
+)
+{
+	bounds.CenterX.clear();
+	bounds.CenterY.clear();
+	bounds.CenterZ.clear();
+	bounds.ExtentX.clear();
+	bounds.ExtentY.clear();
+	bounds.ExtentZ.clear();
+}
+
+void CullObjects
+(
+	const Frustum& frustum,
+	const ObjectBounds& bounds,
+	std::vector<uint32_t>& visibleObjects
+)
+{
+	const size_t objectCount{ bounds.CenterX.size() };
+
+	// Sized for the worst case up front, the batches write their visible objects without checking capacity
+	visibleObjects.resize(objectCount);
+	uint32_t* output{ visibleObjects.data() };
+	size_t object{};
+
+#if defined(__AVX__)
+	__m256 planeX[6]{}, planeY[6]{}, planeZ[6]{}, planeW[6]{}, absoluteX[6]{}, absoluteY[6]{}, absoluteZ[6]{};
+	for (size_t i{}; i < frustum.Planes.size(); ++i)
+	{
+		const glm::vec4& plane{ frustum.Planes[i] };
+		planeX[i] = _mm256_set1_ps(plane.x);
+		planeY[i] = _mm256_set1_ps(plane.y);
+		planeZ[i] = _mm256_set1_ps(plane.z);
+		planeW[i] = _mm256_set1_ps(plane.w);
+		absoluteX[i] = _mm256_set1_ps(std::abs(plane.x));
+		absoluteY[i] = _mm256_set1_ps(std::abs(plane.y));
+		absoluteZ[i] = _mm256_set1_ps(std::abs(plane.z));
+	}
+
+	const __m256 zero{ _mm256_setzero_ps() };
+	for (; object + g_CullingBatchSize <= objectCount; object += g_CullingBatchSize)
+	{
+		const __m256 centerX{ _mm256_loadu_ps(bounds.CenterX.data() + object) };
+		const __m256 centerY{ _mm256_loadu_ps(bounds.CenterY.data() + object) };
+		const __m256 centerZ{ _mm256_loadu_ps(bounds.CenterZ.data() + object) };
+		const __m256 extentX{ _mm256_loadu_ps(bounds.ExtentX.data() + object) };
+		const __m256 extentY{ _mm256_loadu_ps(bounds.ExtentY.data() + object) };
+		const __m256 extentZ{ _mm256_loadu_ps(bounds.ExtentZ.data() + object) };
+
+		__m256 inside{ _mm256_castsi256_ps(_mm256_set1_epi32(-1)) };
+		for (size_t i{}; i < frustum.Planes.size(); ++i)
+		{
+			__m256 distance{ _mm256_add_ps(_mm256_mul_ps(planeX[i], centerX), planeW[i]) };
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(planeY[i], centerY));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(planeZ[i], centerZ));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(absoluteX[i], extentX));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(absoluteY[i], extentY));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(absoluteZ[i], extentZ));
+
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+		}
+
+		for (uint32_t mask{ static_cast<uint32_t>(_mm256_movemask_ps(inside)) }; mask != 0; mask &= mask - 1)
+		{
+			*output++ = static_cast<uint32_t>(object) + static_cast<uint32_t>(std::countr_zero(mask));
+		}
+	}
+#elif defined(__SSE2__) or defined(_M_X64) or (defined(_M_IX86_FP) and _M_IX86_FP >= 2)
+	__m128 planeX[6]{}, planeY[6]{}, planeZ[6]{}, planeW[6]{}, absoluteX[6]{}, absoluteY[6]{}, absoluteZ[6]{};
+	for (size_t i{}; i < frustum.Planes.size(); ++i)
+	{
+		const glm::vec4& plane{ frustum.Planes[i] };
+		planeX[i] = _mm_set1_ps(plane.x);
+		planeY[i] = _mm_set1_ps(plane.y);
+		planeZ[i] = _mm_set1_ps(plane.z);
+		planeW[i] = _mm_set1_ps(plane.w);
+		absoluteX[i] = _mm_set1_ps(std::abs(plane.x));
+		absoluteY[i] = _mm_set1_ps(std::abs(plane.y));
+		absoluteZ[i] = _mm_set1_ps(std::abs(plane.z));
+	}
+
+	const __m128 zero{ _mm_setzero_ps() };
+	for (; object + g_CullingBatchSize <= objectCount; object += g_CullingBatchSize)
+	{
+		const __m128 centerX{ _mm_loadu_ps(bounds.CenterX.data() + object) };
+		const __m128 centerY{ _mm_loadu_ps(bounds.CenterY.data() + object) };
+		const __m128 centerZ{ _mm_loadu_ps(bounds.CenterZ.data() + object) };
+		const __m128 extentX{ _mm_loadu_ps(bounds.ExtentX.data() + object) };
+		const __m128 extentY{ _mm_loadu_ps(bounds.ExtentY.data() + object) };
+		const __m128 extentZ{ _mm_loadu_ps(bounds.ExtentZ.data() + object) };
+
+		__m128 inside{ _mm_castsi128_ps(_mm_set1_epi32(-1)) };
+		for (size_t i{}; i < frustum.Planes.size(); ++i)
+		{
+			__m128 distance{ _mm_add_ps(_mm_mul_ps(planeX[i], centerX), planeW[i]) };
+			distance = _mm_add_ps(distance, _mm_mul_ps(planeY[i], centerY));
+			distance = _mm_add_ps(distance, _mm_mul_ps(planeZ[i], centerZ));
+			distance = _mm_add_ps(distance, _mm_mul_ps(absoluteX[i], extentX));
+			distance = _mm_add_ps(distance, _mm_mul_ps(absoluteY[i], extentY));
+			distance = _mm_add_ps(distance, _mm_mul_ps(absoluteZ[i], extentZ));
+
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+		}
+
+		for (uint32_t mask{ static_cast<uint32_t>(_mm_movemask_ps(inside)) }; mask != 0; mask &= mask - 1)
+		{
+			*output++ = static_cast<uint32_t>(object) + static_cast<uint32_t>(std::countr_zero(mask));
+		}
+	}
+#endif
+
+	// Objects that don't fill a whole batch
+	for (; object < objectCount; ++object)
+	{
+		if (IsBoxInside(frustum, bounds, object)) *output++ = static_cast<uint32_t>(object);
+	}
+
+	visibleObjects.resize(static_cast<size_t>(output - visibleObjects.data()));
+}
+
+void CullObjectsScalar
+(
+	const Frustum& frustum,
+	const ObjectBounds& bounds,
+	std::vector<uint32_t>& visibleObjects
+)
+{
+	visibleObjects.clear();
+
+	for (size_t object{}; object < bounds.CenterX.size(); ++object)
+	{
+		if (IsBoxInside(frustum, bounds, object)) visibleObjects.push_back(static_cast<uint32_t>(object));
+	}
+}
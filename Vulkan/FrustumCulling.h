@@ -0,0 +1,62 @@
+#ifndef FRUSTUM_CULLING
+#define FRUSTUM_CULLING
+
+#include <glm.hpp>
+#include <vector>
+#include <cstdint>
+
+#include "Meshlet.h"
+
+struct BoundingBox;
+
+// Objects the frustum test handles per instruction, eight with AVX and four with SSE.
+// Msvc only defines __AVX__ under /arch:AVX or higher, Vulkan.vcxproj builds with /arch:AVX2 so the eight wide path is the one that ships
+#if defined(__AVX__)
+constexpr size_t g_CullingBatchSize{ 8 };
+#elif defined(__SSE2__) or defined(_M_X64) or (defined(_M_IX86_FP) and _M_IX86_FP >= 2)
+constexpr size_t g_CullingBatchSize{ 4 };
+#else
+constexpr size_t g_CullingBatchSize{ 1 };
+#endif
+
+// World space boxes of many objects as a structure of arrays, so a batch of objects is one load per component
+struct ObjectBounds final
+{
+	std::vector<float> CenterX;
+	std::vector<float> CenterY;
+	std::vector<float> CenterZ;
+	std::vector<float> ExtentX;
+	std::vector<float> ExtentY;
+	std::vector<float> ExtentZ;
+};
+
+// Moves the mesh space box into world space and appends it, the world box encloses the rotated box (Arvo)
+void AddObjectBounds
+(
+	ObjectBounds& bounds,
+	const BoundingBox& boundingBox,
+	const glm::mat4& modelMatrix
+);
+
+void ClearObjectBounds
+(
+	ObjectBounds& bounds
+);
+
+// Writes the index of every object intersecting the frustum to visibleObjects in ascending order, the planes must be in world space
+void CullObjects
+(
+	const Frustum& frustum,
+	const ObjectBounds& bounds,
+	std::vector<uint32_t>& visibleObjects
+);
+
+// One object at a time, the reference the batched version gets compared against
+void CullObjectsScalar
+(
+	const Frustum& frustum,
+	const ObjectBounds& bounds,
+	std::vector<uint32_t>& visibleObjects
+);
+
+#endif
@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+#include "GeometryArena.h"
+#include "Mesh.h"
+#include "VertexLayout.h"
+#include "HelperFunctions.h"
+#include "Defragmenter.h"
+
+namespace
+{
+	// Transfer source too, the defragmenter copies the buffers when it moves them
+	constexpr VkBufferUsageFlags g_VertexBufferUsage{ VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT };
+	constexpr VkBufferUsageFlags g_IndexBufferUsage{ VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT };
+
+	// Slot of the index type in the index buffer arrays
+	size_t GetIndexSlot(VkIndexType indexType)
+	{
+		return (indexType == VK_INDEX_TYPE_UINT16) ? 0 : 1;
+	}
+
+	size_t GetIndexSize(VkIndexType indexType)
+	{
+		return (indexType == VK_INDEX_TYPE_UINT16) ? sizeof(uint16_t) : sizeof(uint32_t);
+	}
+}
+
+RangeAllocator::RangeAllocator(uint32_t capacity) :
+	m_FreeRanges{ GeometryAllocation{ 0, capacity } },
+	m_Capacity{ capacity },
+	m_UsedCount{}
+{
+
+}
+
+bool RangeAllocator::Allocate(uint32_t count, GeometryAllocation& allocation)
+{
+	if (count == 0)
+	{
+		allocation = GeometryAllocation{ 0, 0 };
+		return true;
+	}
+
+	for (auto it{ m_FreeRanges.begin() }; it != m_FreeRanges.end(); ++it)
+	{
+		if (it->Count < count) continue;
+
+		allocation = GeometryAllocation{ it->Offset, count };
+		it->Offset += count;
+		it->Count -= count;
+		if (it->Count == 0) m_FreeRanges.erase(it);
+
+		m_UsedCount += count;
+		return true;
+	}
+
+	return false;
+}
+
+void RangeAllocator::Free(const GeometryAllocation& allocation)
+{
+	if (allocation.Count == 0) return;
+
+	auto next{ std::lower_bound(m_FreeRanges.begin(), m_FreeRanges.end(), allocation.Offset, [](const GeometryAllocation& range, uint32_t offset) { return range.Offset < offset; }) };
+	auto range{ m_FreeRanges.insert(next, allocation) };
+
+	// Merge with the following range first, the iterator of the previous range stays valid
+	auto following{ range + 1 };
+	if (following != m_FreeRanges.end() and range->Offset + range->Count == following->Offset)
+	{
+		range->Count += following->Count;
+		m_FreeRanges.erase(following);
+	}
+
+	if (range != m_FreeRanges.begin())
+	{
+		auto previous{ range - 1 };
+		if (previous->Offset + previous->Count == range->Offset)
+		{
+			previous->Count += range->Count;
+			m_FreeRanges.erase(range);
+		}
+	}
+
+	m_UsedCount -= allocation.Count;
+}
+
+uint32_t RangeAllocator::GetCapacity() const
+{
+	return m_Capacity;
+}
+
+uint32_t RangeAllocator::GetUsedCount() const
+{
+	return m_UsedCount;
+}
+
+GeometryArena::GeometryArena(DeviceAllocator& deviceAllocator, VkDevice device, StagingRing& stagingRing, uint32_t vertexCapacity, uint32_t indexCapacity) :
+	m_DeviceAllocator{ deviceAllocator },
+	m_Device{ device },
+	m_StagingRing{ stagingRing },
+	m_VertexBuffer{},
+	m_VertexBufferMemory{},
+	m_VertexRanges{ vertexCapacity },
+	m_IndexBuffers{},
+	m_IndexBufferMemories{},
+	m_IndexRanges{ RangeAllocator{ indexCapacity }, RangeAllocator{ indexCapacity } },
+	m_Defragmenter{},
+	m_MovableResources{}
+{
+	CreateBuffer
+	(
+		m_DeviceAllocator,
+		sizeof(VertexFormat<g_VertexLayout>::Type) * VkDeviceSize(vertexCapacity),
+		g_VertexBufferUsage,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		MemoryCategory::Geometry,
+		m_VertexBuffer,
+		m_VertexBufferMemory
+	);
+
+	for (VkIndexType indexType : { VK_INDEX_TYPE_UINT16, VK_INDEX_TYPE_UINT32 })
+	{
+		CreateBuffer
+		(
+			m_DeviceAllocator,
+			GetIndexSize(indexType) * VkDeviceSize(indexCapacity),
+			g_IndexBufferUsage,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			MemoryCategory::Geometry,
+			m_IndexBuffers.at(GetIndexSlot(indexType)),
+			m_IndexBufferMemories.at(GetIndexSlot(indexType))
+		);
+	}
+}
+
+GeometryArena::~GeometryArena()
+{
+	if (m_Defragmenter != nullptr)
+	{
+		for (uint32_t resource : m_MovableResources) m_Defragmenter->Unregister(resource);
+	}
+
+	vkDestroyBuffer(m_Device, m_VertexBuffer, nullptr);
+	m_DeviceAllocator.Free(m_VertexBufferMemory);
+
+	for (size_t i{}; i < m_IndexBuffers.size(); ++i)
+	{
+		vkDestroyBuffer(m_Device, m_IndexBuffers.at(i), nullptr);
+		m_DeviceAllocator.Free(m_IndexBufferMemories.at(i));
+	}
+}
+
+bool GeometryArena::AddVertices(const Vertex* vertices, uint32_t vertexCount, GeometryAllocation& allocation)
+{
+	if (!m_VertexRanges.Allocate(vertexCount, allocation)) return false;
+	if (vertexCount == 0) return true;
+
+	// A copy in flight would miss the new vertices
+	if (m_Defragmenter != nullptr) m_Defragmenter->CancelMove(m_MovableResources.at(0));
+
+	// The gpu copy uses the compile time vertex layout, the cpu copy stays full precision
+	const VkDeviceSize vertexSize{ sizeof(VertexFormat<g_VertexLayout>::Type) };
+	const VkDeviceSize bufferSize{ vertexSize * vertexCount };
+
+	// Packed straight into the staging ring, chunks never split a vertex
+	m_StagingRing.UploadBuffer(m_VertexBuffer, vertexSize * allocation.Offset, bufferSize, vertexSize, [vertices, vertexSize](void* destination, VkDeviceSize offset, VkDeviceSize size)
+	{
+		PackVertices<g_VertexLayout>(vertices + offset / vertexSize, static_cast<size_t>(size / vertexSize), destination);
+	});
+
+	return true;
+}
+
+bool GeometryArena::AddIndices(const uint32_t* indices, uint32_t indexCount, VkIndexType indexType, GeometryAllocation& allocation)
+{
+	if (!m_IndexRanges.at(GetIndexSlot(indexType)).Allocate(indexCount, allocation)) return false;
+	if (indexCount == 0) return true;
+
+	if (m_Defragmenter != nullptr) m_Defragmenter->CancelMove(m_MovableResources.at(1 + GetIndexSlot(indexType)));
+
+	const VkDeviceSize indexSize{ GetIndexSize(indexType) };
+	const VkDeviceSize bufferSize{ indexSize * indexCount };
+
+	m_StagingRing.UploadBuffer(m_IndexBuffers.at(GetIndexSlot(indexType)), indexSize * allocation.Offset, bufferSize, indexSize, [indices, indexSize, indexType](void* destination, VkDeviceSize offset, VkDeviceSize size)
+	{
+		const uint32_t* input{ indices + offset / indexSize };
+
+		if (indexType == VK_INDEX_TYPE_UINT16)
+		{
+			uint16_t* output{ static_cast<uint16_t*>(destination) };
+			for (VkDeviceSize i{}; i < size / indexSize; ++i) output[i] = static_cast<uint16_t>(input[i]);
+		}
+		else
+		{
+			memcpy(destination, input, static_cast<size_t>(size));
+		}
+	});
+
+	return true;
+}
+
+void GeometryArena::RemoveVertices(const GeometryAllocation& allocation)
+{
+	m_VertexRanges.Free(allocation);
+}
+
+void GeometryArena::RemoveIndices(const GeometryAllocation& allocation, VkIndexType indexType)
+{
+	m_IndexRanges.at(GetIndexSlot(indexType)).Free(allocation);
+}
+
+void GeometryArena::RegisterMovable(Defragmenter& defragmenter)
+{
+	m_Defragmenter = &defragmenter;
+
+	const VkDeviceSize vertexBufferSize{ sizeof(VertexFormat<g_VertexLayout>::Type) * VkDeviceSize(m_VertexRanges.GetCapacity()) };
+	m_MovableResources.at(0) = m_Defragmenter->RegisterBuffer(m_VertexBuffer, m_VertexBufferMemory, vertexBufferSize, g_VertexBufferUsage);
+
+	for (VkIndexType indexType : { VK_INDEX_TYPE_UINT16, VK_INDEX_TYPE_UINT32 })
+	{
+		const size_t slot{ GetIndexSlot(indexType) };
+		const VkDeviceSize indexBufferSize{ GetIndexSize(indexType) * VkDeviceSize(m_IndexRanges.at(slot).GetCapacity()) };
+		m_MovableResources.at(1 + slot) = m_Defragmenter->RegisterBuffer(m_IndexBuffers.at(slot), m_IndexBufferMemories.at(slot), indexBufferSize, g_IndexBufferUsage);
+	}
+}
+
+VkBuffer GeometryArena::GetVertexBuffer() const
+{
+	return m_VertexBuffer;
+}
+
+VkBuffer GeometryArena::GetIndexBuffer(VkIndexType indexType) const
+{
+	return m_IndexBuffers.at(GetIndexSlot(indexType));
+}
+
+uint32_t GeometryArena::GetVertexCount() const
+{
+	return m_VertexRanges.GetUsedCount();
+}
+
+uint32_t GeometryArena::GetIndexCount(VkIndexType indexType) const
+{
+	return m_IndexRanges.at(GetIndexSlot(indexType)).GetUsedCount();
+}
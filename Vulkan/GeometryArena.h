@@ -0,0 +1,90 @@
+#ifndef GEOMETRY_ARENA
+#define GEOMETRY_ARENA
+
+#include <vulkan.hpp>
+#include <vector>
+#include <array>
+
+#include "DeviceAllocator.h"
+#include "StagingRing.h"
+
+struct Vertex;
+class Defragmenter;
+
+// Vertices and indices per index type the arena has room for, every mesh gets suballocated out of these
+constexpr uint32_t g_GeometryArenaVertexCapacity{ 1u << 19 };
+constexpr uint32_t g_GeometryArenaIndexCapacity{ 1u << 21 };
+
+// Range of elements inside one of the arena buffers, offset and count are in vertices or indices
+struct GeometryAllocation final
+{
+	uint32_t Offset;
+	uint32_t Count;
+};
+
+// First fit allocator over a range of elements, freed ranges get merged with their neighbours
+class RangeAllocator final
+{
+public:
+	RangeAllocator(uint32_t capacity);
+
+	bool Allocate(uint32_t count, GeometryAllocation& allocation);
+	void Free(const GeometryAllocation& allocation);
+	uint32_t GetCapacity() const;
+	uint32_t GetUsedCount() const;
+
+private:
+	std::vector<GeometryAllocation> m_FreeRanges;		// Sorted on offset, never touching each other
+	uint32_t m_Capacity;
+	uint32_t m_UsedCount;
+};
+
+// One device local vertex buffer and one index buffer per index type shared by every mesh,
+// meshes draw with firstIndex and vertexOffset so the buffers only get bound once per frame
+class GeometryArena final
+{
+public:
+	GeometryArena
+	(
+		DeviceAllocator& deviceAllocator,
+		VkDevice device,
+		StagingRing& stagingRing,
+		uint32_t vertexCapacity = g_GeometryArenaVertexCapacity,
+		uint32_t indexCapacity = g_GeometryArenaIndexCapacity
+	);
+	~GeometryArena();
+
+	GeometryArena(const GeometryArena&) = delete;
+	GeometryArena& operator=(const GeometryArena&) = delete;
+	GeometryArena(GeometryArena&&) = delete;
+	GeometryArena& operator=(GeometryArena&&) = delete;
+
+	// Packs the vertices into the compile time vertex layout, returns false if the arena is full
+	bool AddVertices(const Vertex* vertices, uint32_t vertexCount, GeometryAllocation& allocation);
+	// Indices stay relative to the vertex allocation of the mesh, returns false if the arena is full
+	bool AddIndices(const uint32_t* indices, uint32_t indexCount, VkIndexType indexType, GeometryAllocation& allocation);
+	void RemoveVertices(const GeometryAllocation& allocation);
+	void RemoveIndices(const GeometryAllocation& allocation, VkIndexType indexType);
+	// Lets the defragmenter move the buffers, meshes fetch them from the arena every frame so nothing else needs patching
+	void RegisterMovable(Defragmenter& defragmenter);
+
+	VkBuffer GetVertexBuffer() const;
+	VkBuffer GetIndexBuffer(VkIndexType indexType) const;
+	uint32_t GetVertexCount() const;
+	uint32_t GetIndexCount(VkIndexType indexType) const;
+
+private:
+	DeviceAllocator& m_DeviceAllocator;
+	VkDevice m_Device;
+	StagingRing& m_StagingRing;
+	VkBuffer m_VertexBuffer;
+	DeviceAllocation m_VertexBufferMemory;
+	RangeAllocator m_VertexRanges;
+	std::array<VkBuffer, 2> m_IndexBuffers;					// 16 bit and 32 bit
+	std::array<DeviceAllocation, 2> m_IndexBufferMemories;
+	std::array<RangeAllocator, 2> m_IndexRanges;
+	Defragmenter* m_Defragmenter;
+	std::array<uint32_t, 3> m_MovableResources;			// Vertex buffer, then the index buffers
+};
+
+#endif
@@ -0,0 +1,335 @@
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+#include "GpuCulling.h"
+#include "HelperFunctions.h"
+
+GpuCulling::GpuCulling(VkPhysicalDevice physicalDevice, VkDevice device, DeviceAllocator& deviceAllocator, uint32_t frameCount, uint32_t drawGroupCount, uint32_t maxObjects) :
+	m_PhysicalDevice{ physicalDevice },
+	m_Device{ device },
+	m_DeviceAllocator{ deviceAllocator },
+	m_DrawGroupCount{ drawGroupCount },
+	m_MaxObjects{ maxObjects },
+	m_MaxDrawsPerGroup{},
+	m_Objects{},
+	m_DescriptorSetLayout{},
+	m_DescriptorPool{},
+	m_ComputeShader{},
+	m_PipelineLayout{},
+	m_Pipeline{},
+	m_Frames{}
+{
+	// Every object of a group could be visible, but one indirect draw can't go over the device limit
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(m_PhysicalDevice, &properties);
+	m_MaxDrawsPerGroup = std::min(m_MaxObjects, properties.limits.maxDrawIndirectCount);
+
+	if (CreateDescriptorSetLayout() != VK_SUCCESS) throw std::runtime_error("Failed to create gpu culling descriptor set layout!");
+	if (CreateDescriptorPool(frameCount) != VK_SUCCESS) throw std::runtime_error("Failed to create gpu culling descriptor pool!");
+	if (CreatePipeline() != VK_SUCCESS) throw std::runtime_error("Failed to create gpu culling pipeline!");
+
+	m_Frames.resize(frameCount);
+	for (GpuCullingFrame& frame : m_Frames) CreateFrame(frame);
+}
+
+GpuCulling::~GpuCulling()
+{
+	for (GpuCullingFrame& frame : m_Frames)
+	{
+		vkDestroyBuffer(m_Device, frame.ObjectBuffer, nullptr);
+		m_DeviceAllocator.Free(frame.ObjectMemory);
+		vkDestroyBuffer(m_Device, frame.DrawBuffer, nullptr);
+		m_DeviceAllocator.Free(frame.DrawMemory);
+		vkDestroyBuffer(m_Device, frame.CountBuffer, nullptr);
+		m_DeviceAllocator.Free(frame.CountMemory);
+	}
+
+	vkDestroyPipeline(m_Device, m_Pipeline, nullptr);
+	vkDestroyPipelineLayout(m_Device, m_PipelineLayout, nullptr);
+	vkDestroyShaderModule(m_Device, m_ComputeShader, nullptr);
+	vkDestroyDescriptorPool(m_Device, m_DescriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(m_Device, m_DescriptorSetLayout, nullptr);
+}
+
+void GpuCulling::SetObject(uint32_t object, const GpuObject& gpuObject)
+{
+	if (object >= m_MaxObjects) throw std::runtime_error("Too many objects for gpu culling!");
+
+	if (object >= m_Objects.size()) m_Objects.resize(object + 1);
+	m_Objects.at(object) = gpuObject;
+
+	// The other frames in flight might still read their buffer, so they only get the object once they record again
+	for (GpuCullingFrame& frame : m_Frames)
+	{
+		frame.DirtyBegin = std::min(frame.DirtyBegin, object);
+		frame.DirtyEnd = std::max(frame.DirtyEnd, object + 1);
+	}
+}
+
+void GpuCulling::RecordCulling(VkCommandBuffer commandBuffer, uint32_t frame, const Frustum& frustum)
+{
+	GpuCullingFrame& cullingFrame{ m_Frames.at(frame) };
+
+	if (cullingFrame.DirtyBegin < cullingFrame.DirtyEnd)
+	{
+		GpuObject* objects{ static_cast<GpuObject*>(cullingFrame.ObjectMemory.Map) };
+		std::copy(m_Objects.begin() + cullingFrame.DirtyBegin, m_Objects.begin() + cullingFrame.DirtyEnd, objects + cullingFrame.DirtyBegin);
+		cullingFrame.DirtyBegin = m_MaxObjects;
+		cullingFrame.DirtyEnd = 0;
+	}
+	cullingFrame.ObjectCount = static_cast<uint32_t>(m_Objects.size());
+
+	// Counts start at zero every frame, the compute shader bumps them with atomics
+	vkCmdFillBuffer(commandBuffer, cullingFrame.CountBuffer, 0, VK_WHOLE_SIZE, 0);
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkMemoryBarrier.html
+	const VkMemoryBarrier fillBarrier
+	{
+		VK_STRUCTURE_TYPE_MEMORY_BARRIER,								// sType
+		nullptr,														// pNext
+		VK_ACCESS_TRANSFER_WRITE_BIT,									// srcAccessMask
+		VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT			// dstAccessMask
+	};
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &fillBarrier, 0, nullptr, 0, nullptr);
+
+	CullingPushConstants pushConstants{};
+	for (size_t i{}; i < frustum.Planes.size(); ++i) pushConstants.Planes[i] = frustum.Planes[i];
+	pushConstants.ObjectCount = cullingFrame.ObjectCount;
+	pushConstants.MaxDrawsPerGroup = m_MaxDrawsPerGroup;
+	pushConstants.DrawGroupCount = m_DrawGroupCount;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &cullingFrame.DescriptorSet, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullingPushConstants), &pushConstants);
+	vkCmdDispatch(commandBuffer, (cullingFrame.ObjectCount + g_GpuCullingWorkgroupSize - 1) / g_GpuCullingWorkgroupSize, 1, 1);
+
+	// The draws get read as indirect commands, the counts also by the host once the frame its fence signals
+	const VkMemoryBarrier cullBarrier
+	{
+		VK_STRUCTURE_TYPE_MEMORY_BARRIER,								// sType
+		nullptr,														// pNext
+		VK_ACCESS_SHADER_WRITE_BIT,										// srcAccessMask
+		VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT	// dstAccessMask
+	};
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+}
+
+void GpuCulling::RecordDraws(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t drawGroup) const
+{
+	const GpuCullingFrame& cullingFrame{ m_Frames.at(frame) };
+
+	vkCmdDrawIndexedIndirectCount
+	(
+		commandBuffer,
+		cullingFrame.DrawBuffer,
+		VkDeviceSize(drawGroup) * m_MaxDrawsPerGroup * sizeof(VkDrawIndexedIndirectCommand),
+		cullingFrame.CountBuffer,
+		VkDeviceSize(drawGroup) * sizeof(uint32_t),
+		m_MaxDrawsPerGroup,
+		sizeof(VkDrawIndexedIndirectCommand)
+	);
+}
+
+uint32_t GpuCulling::GetSubmittedIndexCount(uint32_t frame) const
+{
+	const uint32_t* counts{ static_cast<const uint32_t*>(m_Frames.at(frame).CountMemory.Map) };
+	return counts[m_DrawGroupCount];
+}
+
+VkDescriptorSetLayout GpuCulling::GetDescriptorSetLayout() const
+{
+	return m_DescriptorSetLayout;
+}
+
+VkDescriptorSet GpuCulling::GetDescriptorSet(uint32_t frame) const
+{
+	return m_Frames.at(frame).DescriptorSet;
+}
+
+VkResult GpuCulling::CreateDescriptorSetLayout()
+{
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDescriptorSetLayoutBinding.html
+	const std::array<VkDescriptorSetLayoutBinding, 3> descriptorSetLayoutBindings
+	{
+		// Objects
+		VkDescriptorSetLayoutBinding
+		{
+			0,													// binding
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,					// descriptorType
+			1,													// descriptorCount
+			VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT,	// stageFlags
+			nullptr												// pImmutableSamplers
+		},
+		// Draw commands
+		VkDescriptorSetLayoutBinding
+		{
+			1,
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			1,
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			nullptr
+		},
+		// Draw counts
+		VkDescriptorSetLayoutBinding
+		{
+			2,
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			1,
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			nullptr
+		}
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDescriptorSetLayoutCreateInfo.html
+	const VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo
+	{
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,		// sType
+		nullptr,													// pNext
+		0,															// flags
+		uint32_t(descriptorSetLayoutBindings.size()),				// bindingCount
+		descriptorSetLayoutBindings.data()							// pBindings
+	};
+
+	return vkCreateDescriptorSetLayout(m_Device, &descriptorSetLayoutCreateInfo, nullptr, &m_DescriptorSetLayout);
+}
+
+VkResult GpuCulling::CreateDescriptorPool(uint32_t frameCount)
+{
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDescriptorPoolSize.html
+	const VkDescriptorPoolSize descriptorPoolSize
+	{
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,			// type
+		frameCount * 3								// descriptorCount
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDescriptorPoolCreateInfo.html
+	const VkDescriptorPoolCreateInfo descriptorPoolCreateInfo
+	{
+		VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,		// sType
+		nullptr,											// pNext
+		0,													// flags
+		frameCount,											// maxSets
+		1,													// poolSizeCount
+		&descriptorPoolSize									// pPoolSizes
+	};
+
+	return vkCreateDescriptorPool(m_Device, &descriptorPoolCreateInfo, nullptr, &m_DescriptorPool);
+}
+
+VkResult GpuCulling::CreatePipeline()
+{
+	m_ComputeShader = CreateShaderModule(LoadSPIRV("shaders/cull_comp.spv"), m_Device);
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPushConstantRange.html
+	const VkPushConstantRange pushConstantRange
+	{
+		VK_SHADER_STAGE_COMPUTE_BIT,		// stageFlags
+		0,									// offset
+		sizeof(CullingPushConstants)		// size
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineLayoutCreateInfo.html
+	const VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,		// sType
+		nullptr,											// pNext
+		0,													// flags
+		1,													// setLayoutCount
+		&m_DescriptorSetLayout,								// pSetLayouts
+		1,													// pushConstantRangeCount
+		&pushConstantRange									// pPushConstantRanges
+	};
+
+	const VkResult result{ vkCreatePipelineLayout(m_Device, &pipelineLayoutCreateInfo, nullptr, &m_PipelineLayout) };
+	if (result != VK_SUCCESS) return result;
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkComputePipelineCreateInfo.html
+	const VkComputePipelineCreateInfo computePipelineCreateInfo
+	{
+		VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,			// sType
+		nullptr,												// pNext
+		0,														// flags
+		// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineShaderStageCreateInfo.html
+		VkPipelineShaderStageCreateInfo							// stage
+		{
+			VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,	// sType
+			nullptr,												// pNext
+			0,														// flags
+			VK_SHADER_STAGE_COMPUTE_BIT,							// stage
+			m_ComputeShader,										// module
+			"main",													// pName
+			nullptr													// pSpecializationInfo
+		},
+		m_PipelineLayout,										// layout
+		VK_NULL_HANDLE,											// basePipelineHandle
+		0														// basePipelineIndex
+	};
+
+	return vkCreateComputePipelines(m_Device, VK_NULL_HANDLE, 1, &computePipelineCreateInfo, nullptr, &m_Pipeline);
+}
+
+void GpuCulling::CreateFrame(GpuCullingFrame& frame)
+{
+	const VkDeviceSize objectsSize{ VkDeviceSize(m_MaxObjects) * sizeof(GpuObject) };
+	const VkDeviceSize drawsSize{ VkDeviceSize(m_DrawGroupCount) * m_MaxDrawsPerGroup * sizeof(VkDrawIndexedIndirectCommand) };
+	const VkDeviceSize countsSize{ (VkDeviceSize(m_DrawGroupCount) + 1) * sizeof(uint32_t) };
+
+	// The host only writes the objects that changed, so they stay mapped
+	CreateBuffer(m_DeviceAllocator, objectsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::Uniforms, frame.ObjectBuffer, frame.ObjectMemory);
+
+	CreateBuffer(m_DeviceAllocator, drawsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Geometry, frame.DrawBuffer, frame.DrawMemory);
+
+	// Only a handful of counts, host visible so the submitted index count can be read back without a copy
+	CreateBuffer(m_DeviceAllocator, countsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryCategory::Geometry, frame.CountBuffer, frame.CountMemory);
+	memset(frame.CountMemory.Map, 0, countsSize);
+
+	frame.ObjectCount = 0;
+	frame.DirtyBegin = m_MaxObjects;
+	frame.DirtyEnd = 0;
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDescriptorSetAllocateInfo.html
+	const VkDescriptorSetAllocateInfo descriptorSetAllocateInfo
+	{
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,			// sType
+		nullptr,												// pNext
+		m_DescriptorPool,										// descriptorPool
+		1,														// descriptorSetCount
+		&m_DescriptorSetLayout									// pSetLayouts
+	};
+
+	if (vkAllocateDescriptorSets(m_Device, &descriptorSetAllocateInfo, &frame.DescriptorSet) != VK_SUCCESS) throw std::runtime_error("Failed to allocate gpu culling descriptor set!");
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDescriptorBufferInfo.html
+	const std::array<VkDescriptorBufferInfo, 3> descriptorBufferInfos
+	{
+		VkDescriptorBufferInfo{ frame.ObjectBuffer, 0, VK_WHOLE_SIZE },
+		VkDescriptorBufferInfo{ frame.DrawBuffer, 0, VK_WHOLE_SIZE },
+		VkDescriptorBufferInfo{ frame.CountBuffer, 0, VK_WHOLE_SIZE }
+	};
+
+	std::array<VkWriteDescriptorSet, 3> writeDescriptorSets{};
+	for (uint32_t binding{}; binding < writeDescriptorSets.size(); ++binding)
+	{
+		// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkWriteDescriptorSet.html
+		writeDescriptorSets.at(binding) = VkWriteDescriptorSet
+		{
+			VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,			// sType
+			nullptr,										// pNext
+			frame.DescriptorSet,							// dstSet
+			binding,										// dstBinding
+			0,												// dstArrayElement
+			1,												// descriptorCount
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,				// descriptorType
+			nullptr,										// pImageInfo
+			&descriptorBufferInfos.at(binding),				// pBufferInfo
+			nullptr											// pTexelBufferView
+		};
+	}
+
+	vkUpdateDescriptorSets(m_Device, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
+}
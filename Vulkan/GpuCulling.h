@@ -0,0 +1,88 @@
+#ifndef GPU_CULLING
+#define GPU_CULLING
+
+#include <vulkan.hpp>
+#include <vector>
+
+#include "HelperStructs.h"
+#include "DeviceAllocator.h"
+#include "Meshlet.h"
+
+// Objects the gpu culling buffers have room for
+constexpr uint32_t g_GpuCullingMaxObjects{ 4096 };
+
+// Objects one compute workgroup culls, matches local_size_x of cull.comp
+constexpr uint32_t g_GpuCullingWorkgroupSize{ 64 };
+
+// Buffers of one frame in flight, the compute pass of a frame writes the draws its graphics pass reads
+struct GpuCullingFrame final
+{
+	VkBuffer ObjectBuffer;
+	DeviceAllocation ObjectMemory;				// Host visible, Map points at the objects
+	uint32_t DirtyBegin;						// Objects changed since the frame last culled, copied in before its dispatch
+	uint32_t DirtyEnd;
+	VkBuffer DrawBuffer;						// VkDrawIndexedIndirectCommands, MaxDrawsPerGroup for every draw group
+	DeviceAllocation DrawMemory;
+	VkBuffer CountBuffer;						// Draw count per draw group followed by the submitted index count
+	DeviceAllocation CountMemory;				// Host visible, Map points at the counts
+	VkDescriptorSet DescriptorSet;
+	uint32_t ObjectCount;
+};
+
+// Frustum culls objects in a compute pass that writes indirect draws and their counts, the graphics pass
+// draws them with vkCmdDrawIndexedIndirectCount so recording costs the same no matter how many objects there are
+class GpuCulling final
+{
+public:
+	GpuCulling
+	(
+		VkPhysicalDevice physicalDevice,
+		VkDevice device,
+		DeviceAllocator& deviceAllocator,
+		uint32_t frameCount,
+		uint32_t drawGroupCount,
+		uint32_t maxObjects = g_GpuCullingMaxObjects
+	);
+	~GpuCulling();
+
+	GpuCulling(const GpuCulling&) = delete;
+	GpuCulling& operator=(const GpuCulling&) = delete;
+	GpuCulling(GpuCulling&&) = delete;
+	GpuCulling& operator=(GpuCulling&&) = delete;
+
+	// Stores the object and marks it dirty in every frame, objects that don't change cost nothing per frame
+	void SetObject(uint32_t object, const GpuObject& gpuObject);
+	// Copies the objects changed since the frame last ran into its buffer, resets the counts and culls,
+	// has to be recorded outside of a render pass once the previous submission of the frame finished
+	void RecordCulling(VkCommandBuffer commandBuffer, uint32_t frame, const Frustum& frustum);
+	// Draws the visible objects of one draw group, the index buffer of the group has to be bound
+	void RecordDraws(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t drawGroup) const;
+	// Indices the culling of the frame let through the last time it ran, only valid after waiting on the frame its fence
+	uint32_t GetSubmittedIndexCount(uint32_t frame) const;
+
+	// Binding 0 holds the objects, the gpu driven vertex shaders read their model matrix from it
+	VkDescriptorSetLayout GetDescriptorSetLayout() const;
+	VkDescriptorSet GetDescriptorSet(uint32_t frame) const;
+
+private:
+	VkPhysicalDevice m_PhysicalDevice;
+	VkDevice m_Device;
+	DeviceAllocator& m_DeviceAllocator;
+	uint32_t m_DrawGroupCount;
+	uint32_t m_MaxObjects;
+	uint32_t m_MaxDrawsPerGroup;
+	std::vector<GpuObject> m_Objects;
+	VkDescriptorSetLayout m_DescriptorSetLayout;
+	VkDescriptorPool m_DescriptorPool;
+	VkShaderModule m_ComputeShader;
+	VkPipelineLayout m_PipelineLayout;
+	VkPipeline m_Pipeline;
+	std::vector<GpuCullingFrame> m_Frames;
+
+	VkResult CreateDescriptorSetLayout();
+	VkResult CreateDescriptorPool(uint32_t frameCount);
+	VkResult CreatePipeline();
+	void CreateFrame(GpuCullingFrame& frame);
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include <fstream>
 
 #include "HelperFunctions.h"
+#include "DeviceAllocator.h"
 
 VkResult CreateDebugUtilsMessengerEXT
 (
@@ -40,6 +41,43 @@ void DestroyDebugUtilsMessengerEXT
     }
 }
 
+VkResult CopyMemoryToImageEXT
+(
+    VkDevice device,
+    const VkCopyMemoryToImageInfoEXT* pCopyMemoryToImageInfo
+)
+{
+    auto func = (PFN_vkCopyMemoryToImageEXT)vkGetDeviceProcAddr(device, "vkCopyMemoryToImageEXT");
+
+    if (func != nullptr) 
+    {
+        return func(device, pCopyMemoryToImageInfo);
+    }
+    else 
+    {
+        return VK_ERROR_EXTENSION_NOT_PRESENT;
+    }
+}
+
+VkResult TransitionImageLayoutEXT
+(
+    VkDevice device,
+    uint32_t transitionCount,
+    const VkHostImageLayoutTransitionInfoEXT* pTransitions
+)
+{
+    auto func = (PFN_vkTransitionImageLayoutEXT)vkGetDeviceProcAddr(device, "vkTransitionImageLayoutEXT");
+
+    if (func != nullptr) 
+    {
+        return func(device, transitionCount, pTransitions);
+    }
+    else 
+    {
+        return VK_ERROR_EXTENSION_NOT_PRESENT;
+    }
+}
+
 VKAPI_ATTR VkBool32 VKAPI_CALL MessageCallback
 (
     VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
@@ -138,6 +176,21 @@ QueueFamilyIndices FindQueueFamilies
         ++i;
     }
 
+    // A family without graphics and compute is the dedicated copy engine, it runs uploads next to the rendering.
+    // Only whole texel granularity, the uploads copy images in rows
+    for (uint32_t j{}; j < queueFamilyCount; ++j)
+    {
+        const VkQueueFamilyProperties& queueFamilyProperty{ queueFamilyProperties.at(j) };
+        const VkExtent3D& granularity{ queueFamilyProperty.minImageTransferGranularity };
+
+        const bool transferOnly{ (queueFamilyProperty.queueFlags & VK_QUEUE_TRANSFER_BIT) and not (queueFamilyProperty.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) };
+        if (transferOnly and granularity.width == 1 and granularity.height == 1 and granularity.depth == 1)
+        {
+            indices.TransferFamily = j;
+            break;
+        }
+    }
+
     return indices;
 }
 
@@ -182,6 +235,84 @@ bool DeviceExtenstionsPresent
     return extensionsPresent;
 }
 
+bool DeviceExtensionSupported
+(
+    VkPhysicalDevice device,
+    const char* extensionName
+)
+{
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+
+    return std::ranges::find_if(extensions,
+        [extensionName](const auto& extension) -> bool
+        {
+            return strcmp(extensionName, extension.extensionName) == 0;
+        }
+    ) != extensions.end();
+}
+
+bool HostImageCopySupported
+(
+    VkPhysicalDevice device
+)
+{
+    // The copy commands 2 and format feature flags 2 it depends on are core since vulkan 1.3
+    VkPhysicalDeviceProperties physicalDeviceProperties{};
+    vkGetPhysicalDeviceProperties(device, &physicalDeviceProperties);
+    if (physicalDeviceProperties.apiVersion < VK_API_VERSION_1_3) return false;
+    if (!DeviceExtensionSupported(device, VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME)) return false;
+
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPhysicalDeviceHostImageCopyFeaturesEXT.html
+    VkPhysicalDeviceHostImageCopyFeaturesEXT hostImageCopyFeatures{};
+    hostImageCopyFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT;
+
+    VkPhysicalDeviceFeatures2 physicalDeviceFeatures{};
+    physicalDeviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    physicalDeviceFeatures.pNext = &hostImageCopyFeatures;
+    vkGetPhysicalDeviceFeatures2(device, &physicalDeviceFeatures);
+    if (!hostImageCopyFeatures.hostImageCopy) return false;
+
+    // First call for the layout counts, second one for the layouts themselves
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPhysicalDeviceHostImageCopyPropertiesEXT.html
+    VkPhysicalDeviceHostImageCopyPropertiesEXT hostImageCopyProperties{};
+    hostImageCopyProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_PROPERTIES_EXT;
+
+    VkPhysicalDeviceProperties2 physicalDeviceProperties2{};
+    physicalDeviceProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    physicalDeviceProperties2.pNext = &hostImageCopyProperties;
+    vkGetPhysicalDeviceProperties2(device, &physicalDeviceProperties2);
+
+    std::vector<VkImageLayout> copySrcLayouts(hostImageCopyProperties.copySrcLayoutCount);
+    std::vector<VkImageLayout> copyDstLayouts(hostImageCopyProperties.copyDstLayoutCount);
+    hostImageCopyProperties.pCopySrcLayouts = copySrcLayouts.data();
+    hostImageCopyProperties.pCopyDstLayouts = copyDstLayouts.data();
+    vkGetPhysicalDeviceProperties2(device, &physicalDeviceProperties2);
+
+    // Textures get sampled in this layout, copying straight into it saves a transition after the copy
+    return std::ranges::find(copyDstLayouts, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) != copyDstLayouts.end();
+}
+
+bool FormatSupportsHostImageCopy
+(
+    VkPhysicalDevice device,
+    VkFormat format
+)
+{
+    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkFormatProperties3.html
+    VkFormatProperties3 formatProperties3{};
+    formatProperties3.sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_3;
+
+    VkFormatProperties2 formatProperties{};
+    formatProperties.sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_2;
+    formatProperties.pNext = &formatProperties3;
+    vkGetPhysicalDeviceFormatProperties2(device, format, &formatProperties);
+
+    return (formatProperties3.optimalTilingFeatures & VK_FORMAT_FEATURE_2_HOST_IMAGE_TRANSFER_BIT_EXT) != 0;
+}
+
 SwapChainSupportDetails QuerySwapChainSupportDetails
 (
     VkPhysicalDevice device, 
@@ -341,15 +472,18 @@ uint32_t FindMemoryTypeIndex
 
 void CreateBuffer
 (
-    VkPhysicalDevice physicalDevice, 
-    VkDevice device, 
+    DeviceAllocator& deviceAllocator, 
     VkDeviceSize size, 
     VkBufferUsageFlags usage, 
     VkMemoryPropertyFlags properties, 
+    MemoryCategory category,
     VkBuffer& buffer, 
-    VkDeviceMemory& bufferMemory
+    DeviceAllocation& bufferMemory
 ) 
 {
+    const VkDevice device{ deviceAllocator.GetDevice() };
+
+
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkBufferCreateInfo.html
     const VkBufferCreateInfo bufferCreateInfo
     {
@@ -368,30 +502,7 @@ void CreateBuffer
         throw std::runtime_error("failed to create buffer!");
     }
 
-    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkMemoryRequirements.html
-    VkMemoryRequirements memoryRequirements{};
-    vkGetBufferMemoryRequirements(device, buffer, &memoryRequirements);
-
-    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkMemoryAllocateInfo.html
-    const VkMemoryAllocateInfo memoryAllocateInfo
-    {
-        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,												// sType
-        nullptr,																			// pNext
-        memoryRequirements.size,															// allocationSize
-        FindMemoryTypeIndex																	// memoryTypeIndex
-        (
-            physicalDevice,
-            memoryRequirements.memoryTypeBits,
-            properties
-        )
-    };
-
-    if (vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &bufferMemory) != VK_SUCCESS) 
-    {
-        throw std::runtime_error("failed to allocate buffer memory!");
-    }
-
-    vkBindBufferMemory(device, buffer, bufferMemory, 0);
+    bufferMemory = deviceAllocator.AllocateBufferMemory(buffer, properties, category);
 }
 
 void CopyBuffer
@@ -401,34 +512,42 @@ void CopyBuffer
     VkBuffer dstBuffer, 
     VkDeviceSize size,
     VkCommandPool commandPool, 
-    VkQueue queue
+    VkQueue queue,
+    VkDeviceSize dstOffset
 ) 
 {
     VkCommandBuffer commandBuffer{ BeginSingleTimeCommands(device, commandPool) };
+    CopyBuffer(commandBuffer, srcBuffer, dstBuffer, size, dstOffset);
+    EndSingleTimeCommands(device, commandPool, queue, commandBuffer);
+}
 
+void CopyBuffer
+(
+    VkCommandBuffer commandBuffer,
+    VkBuffer srcBuffer, 
+    VkBuffer dstBuffer, 
+    VkDeviceSize size,
+    VkDeviceSize dstOffset
+)
+{
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkBufferCopy.html
     const VkBufferCopy bufferCopy
     {
         0,          // srcOffset
-        0,          // dstOffset
+        dstOffset,  // dstOffset
         size        // size
     };
     vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &bufferCopy);
-
-    EndSingleTimeCommands(device, commandPool, queue, commandBuffer);
 }
 
 void CreateImage
 (
-    VkPhysicalDevice physicalDevice,
     VkDevice device,
     VkExtent2D size,
     VkFormat format,
     VkImageTiling tiling,
     VkImageUsageFlags usage,
-    VkMemoryPropertyFlags properties,
     VkImage& image,
-    VkDeviceMemory& memory, 
     uint32_t mipLevels,
     VkSampleCountFlagBits sampleCount
 )
@@ -457,30 +576,26 @@ void CreateImage
     {
         throw std::runtime_error("Failed to create image!");
     }
+}
 
-    VkMemoryRequirements memoryRequirements{};
-    vkGetImageMemoryRequirements(device, image, &memoryRequirements);
-
-    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkMemoryAllocateInfo.html
-    const VkMemoryAllocateInfo memoryAllocateInfo
-    {
-        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,             // sType                                       
-        nullptr,                                            // pNext
-        memoryRequirements.size,                            // allocationSize
-        FindMemoryTypeIndex                                 // memoryTypeIndex
-        (
-            physicalDevice,
-            memoryRequirements.memoryTypeBits,
-            properties  
-        )
-    };
-
-    if (vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &memory) != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to allocate image memory!");
-    }
+void CreateImage
+(
+    DeviceAllocator& deviceAllocator,
+    VkExtent2D size,
+    VkFormat format,
+    VkImageTiling tiling,
+    VkImageUsageFlags usage,
+    VkMemoryPropertyFlags properties,
+    MemoryCategory category,
+    VkImage& image,
+    DeviceAllocation& memory, 
+    uint32_t mipLevels,
+    VkSampleCountFlagBits sampleCount
+)
+{
+    CreateImage(deviceAllocator.GetDevice(), size, format, tiling, usage, image, mipLevels, sampleCount);
 
-    vkBindImageMemory(device, image, memory, 0);
+    memory = deviceAllocator.AllocateImageMemory(image, tiling, properties, category);
 }
 
 VkCommandBuffer BeginSingleTimeCommands
@@ -559,7 +674,20 @@ void TransitionImageLayout
 )
 {
     VkCommandBuffer commandBuffer{ BeginSingleTimeCommands(device, commandpool) };
+    TransitionImageLayout(commandBuffer, image, format, oldLayout, newLayout, mipLevels);
+    EndSingleTimeCommands(device, commandpool, queue, commandBuffer);
+}
 
+void TransitionImageLayout
+(
+    VkCommandBuffer commandBuffer,
+    VkImage image, 
+    VkFormat format, 
+    VkImageLayout oldLayout, 
+    VkImageLayout newLayout, 
+    uint32_t mipLevels
+)
+{
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkImageMemoryBarrier.html
     VkImageMemoryBarrier imageMemoryBarrier
     {
@@ -639,8 +767,6 @@ void TransitionImageLayout
         1, &imageMemoryBarrier
     );
 
-    EndSingleTimeCommands(device, commandpool, queue, commandBuffer);
-
     format;
 }
 
@@ -656,7 +782,19 @@ void CopyBufferToImage
 ) 
 {
     VkCommandBuffer commandBuffer{ BeginSingleTimeCommands(device, commandpool ) };
+    CopyBufferToImage(commandBuffer, buffer, image, width, height);
+    EndSingleTimeCommands(device, commandpool, queue, commandBuffer);
+}
 
+void CopyBufferToImage
+(
+    VkCommandBuffer commandBuffer,
+    VkBuffer buffer, 
+    VkImage image, 
+    uint32_t width, 
+    uint32_t height
+)
+{
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkBufferImageCopy.html
     const VkBufferImageCopy bufferImageCopy
     {
@@ -696,8 +834,6 @@ void CopyBufferToImage
         1,
         &bufferImageCopy
     );
-
-    EndSingleTimeCommands(device, commandpool, queue, commandBuffer);
 }
 
 VkImageView CreateImageView
@@ -806,6 +942,22 @@ void GenerateMipmaps
     int32_t texHeight,
     uint32_t mipLevels
 )
+{
+    VkCommandBuffer commandBuffer = BeginSingleTimeCommands(device, commandPool);
+    GenerateMipmaps(physicalDevice, commandBuffer, image, imageFormat, texWidth, texHeight, mipLevels);
+    EndSingleTimeCommands(device, commandPool, queue, commandBuffer);
+}
+
+void GenerateMipmaps
+(
+    VkPhysicalDevice physicalDevice,
+    VkCommandBuffer commandBuffer,
+    VkImage image,
+    VkFormat imageFormat,
+    int32_t texWidth,
+    int32_t texHeight,
+    uint32_t mipLevels
+)
 {
     VkFormatProperties formatProperties{};
     vkGetPhysicalDeviceFormatProperties(physicalDevice, imageFormat, &formatProperties);
@@ -814,8 +966,6 @@ void GenerateMipmaps
         throw std::runtime_error("texture image format does not support linear blitting!"); 
     }
 
-    VkCommandBuffer commandBuffer = BeginSingleTimeCommands(device, commandPool);
-
     // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkImageMemoryBarrier.html
     VkImageMemoryBarrier imageMemoryBarrier
     {
@@ -945,8 +1095,6 @@ void GenerateMipmaps
         0, nullptr,
         1, &imageMemoryBarrier  
     );
-
-    EndSingleTimeCommands(device, commandPool, queue, commandBuffer);
 }
 
 VkSampleCountFlagBits GetMaxUsableSampleCount
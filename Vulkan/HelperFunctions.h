@@ -7,6 +7,9 @@
 #include "HelperStructs.h"
 
 struct GLFWwindow;
+class DeviceAllocator;
+enum class MemoryCategory;
+struct DeviceAllocation;
 
 //Function to load and call the vkCreateDebugUtilsMessengerEXT function since it's not loaded automatically
 VkResult CreateDebugUtilsMessengerEXT
@@ -25,6 +28,21 @@ void DestroyDebugUtilsMessengerEXT
     const VkAllocationCallbacks* pAllocator
 );
 
+//Function to load and call the vkCopyMemoryToImageEXT function since it's not loaded automatically
+VkResult CopyMemoryToImageEXT
+(
+    VkDevice device,
+    const VkCopyMemoryToImageInfoEXT* pCopyMemoryToImageInfo
+);
+
+//Function to load and call the vkTransitionImageLayoutEXT function since it's not loaded automatically
+VkResult TransitionImageLayoutEXT
+(
+    VkDevice device,
+    uint32_t transitionCount,
+    const VkHostImageLayoutTransitionInfoEXT* pTransitions
+);
+
 // Function that will handle messages coming from our validation layer
 VKAPI_ATTR VkBool32 VKAPI_CALL MessageCallback
 (
@@ -62,6 +80,26 @@ bool DeviceExtenstionsPresent
     std::vector<const char*>& physicalExtensionNames
 );
 
+// Check if one optional device extension is available, without printing the extension table
+bool DeviceExtensionSupported
+(
+    VkPhysicalDevice device, 
+    const char* extensionName
+);
+
+// Check if textures can be written from the host, the extension and feature are there and images can be copied to in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+bool HostImageCopySupported
+(
+    VkPhysicalDevice device
+);
+
+// Check if optimal tiling images of the format can be written from the host
+bool FormatSupportsHostImageCopy
+(
+    VkPhysicalDevice device,
+    VkFormat format
+);
+
 // Function that fills our VkDebugUtilsMessengerCreateInfoEXT struct
 SwapChainSupportDetails QuerySwapChainSupportDetails
 (
@@ -106,18 +144,20 @@ uint32_t FindMemoryTypeIndex
     VkMemoryPropertyFlags properties
 );
 
+// The memory gets suballocated by the device allocator, host visible memory comes back mapped
 void CreateBuffer
 (
-    VkPhysicalDevice physicalDevice, 
-    VkDevice device, 
+    DeviceAllocator& deviceAllocator, 
     VkDeviceSize size, 
     VkBufferUsageFlags usage, 
     VkMemoryPropertyFlags properties,
+    MemoryCategory category,
     VkBuffer& buffer, 
-    VkDeviceMemory& bufferMemory
+    DeviceAllocation& bufferMemory
 );
 
 
+// Copies size bytes from the start of srcBuffer to dstOffset in dstBuffer
 void CopyBuffer
 (
     VkDevice device, 
@@ -125,20 +165,45 @@ void CopyBuffer
     VkBuffer dstBuffer, 
     VkDeviceSize size, 
     VkCommandPool commandPool, 
-    VkQueue queue
+    VkQueue queue,
+    VkDeviceSize dstOffset = 0
 );
 
+// Records the copy instead of submitting it, so it can share a command buffer with other uploads
+void CopyBuffer
+(
+    VkCommandBuffer commandBuffer,
+    VkBuffer srcBuffer, 
+    VkBuffer dstBuffer, 
+    VkDeviceSize size,
+    VkDeviceSize dstOffset = 0
+);
+
+// Creates the image without memory, for images that get bound into memory the caller manages
 void CreateImage
 (
-    VkPhysicalDevice physicalDevice,
     VkDevice device,
     VkExtent2D size,
     VkFormat format,
     VkImageTiling tiling, 
     VkImageUsageFlags usage,
+    VkImage& image,
+    uint32_t mipLevels,
+    VkSampleCountFlagBits sampleCount
+);
+
+// The memory gets suballocated by the device allocator, large images get a dedicated allocation
+void CreateImage
+(
+    DeviceAllocator& deviceAllocator,
+    VkExtent2D size,
+    VkFormat format,
+    VkImageTiling tiling, 
+    VkImageUsageFlags usage,
     VkMemoryPropertyFlags properties,
+    MemoryCategory category,
     VkImage& image,
-    VkDeviceMemory& memory, 
+    DeviceAllocation& memory, 
     uint32_t mipLevels,
     VkSampleCountFlagBits sampleCount
 );
@@ -169,6 +234,17 @@ void TransitionImageLayout
     uint32_t mipLevels
 );
 
+// Records the barrier instead of submitting it
+void TransitionImageLayout
+(
+    VkCommandBuffer commandBuffer,
+    VkImage image, 
+    VkFormat format, 
+    VkImageLayout oldLayout, 
+    VkImageLayout newLayout, 
+    uint32_t mipLevels
+);
+
 void CopyBufferToImage
 (
     VkDevice device, 
@@ -180,6 +256,16 @@ void CopyBufferToImage
     uint32_t height
 );
 
+// Records the copy instead of submitting it
+void CopyBufferToImage
+(
+    VkCommandBuffer commandBuffer,
+    VkBuffer buffer, 
+    VkImage image, 
+    uint32_t width, 
+    uint32_t height
+);
+
 VkImageView CreateImageView
 (
     VkDevice device,
@@ -220,6 +306,18 @@ void GenerateMipmaps
     uint32_t mipLevels
 );
 
+// Records the blits instead of submitting them, the image ends up in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+void GenerateMipmaps
+(
+    VkPhysicalDevice physicalDevice,
+    VkCommandBuffer commandBuffer,
+    VkImage image,
+    VkFormat imageFormat,
+    int32_t texWidth,
+    int32_t texHeight,
+    uint32_t mipLevels
+);
+
 VkSampleCountFlagBits GetMaxUsableSampleCount
 (
     VkPhysicalDevice device
@@ -10,6 +10,7 @@ struct QueueFamilyIndices final
 {
 	std::optional<uint32_t> GraphicsFamily;
 	std::optional<uint32_t> PresentFamily;
+	std::optional<uint32_t> TransferFamily;		// Transfer only family for uploads, optional, graphics takes over without one
 
 	bool IsComplete();
 };
@@ -43,4 +44,32 @@ struct PushConstants
 	int RenderType;
 };
 
+struct ImpostorPushConstants
+{
+	glm::vec4 BoundingSphere;		// Mesh space center and radius
+	int FrameCount;					// Frames along one side of the atlas
+	int RenderType;
+};
+
+// One object of the gpu driven path, matches the std430 Object struct of cull.comp and the gpu driven vertex shaders
+struct GpuObject final
+{
+	glm::mat4 ModelMatrix;
+	glm::vec4 BoundingSphere;		// Mesh space center and radius
+	uint32_t IndexCount;
+	uint32_t FirstIndex;			// Into the arena index buffer
+	int32_t VertexOffset;
+	uint32_t DrawGroup;				// Objects sharing an index type, all of them get drawn with one indirect draw
+	uint32_t MaterialIndex;			// First of its four textures in the texture table is MaterialIndex * 4
+	uint32_t Padding[3];			// std430 rounds the struct up to the alignment of the matrix
+};
+
+struct CullingPushConstants
+{
+	glm::vec4 Planes[6];			// World space frustum planes pointing inwards
+	uint32_t ObjectCount;
+	uint32_t MaxDrawsPerGroup;		// Every draw group owns this many commands in the draw buffer
+	uint32_t DrawGroupCount;
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,299 @@
+#include <bit>
+#include <algorithm>
+#include <new>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+
+#include "HostAllocator.h"
+
+namespace
+{
+	const char* GetScopeName(uint32_t scope)
+	{
+		switch (scope)
+		{
+		case VK_SYSTEM_ALLOCATION_SCOPE_COMMAND: return "Command";
+		case VK_SYSTEM_ALLOCATION_SCOPE_OBJECT: return "Object";
+		case VK_SYSTEM_ALLOCATION_SCOPE_CACHE: return "Cache";
+		case VK_SYSTEM_ALLOCATION_SCOPE_DEVICE: return "Device";
+		case VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE: return "Instance";
+		}
+
+		return "Unknown";
+	}
+
+	// Arena of the scope, the other scopes are rare or live long and go straight to the heap
+	uint32_t GetArena(VkSystemAllocationScope scope)
+	{
+		switch (scope)
+		{
+		case VK_SYSTEM_ALLOCATION_SCOPE_OBJECT: return 0;
+		case VK_SYSTEM_ALLOCATION_SCOPE_COMMAND: return 1;
+		default: return UINT32_MAX;
+		}
+	}
+}
+
+HostAllocator::HostAllocator() :
+	m_Callbacks{},
+	m_Mutex{},
+	m_Statistics{},
+	m_CurrentFrameAllocationCounts{},
+	m_FrameCount{},
+	m_FreeChunks{},
+	m_Slabs{},
+	m_SlabAddresses{}
+{
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkAllocationCallbacks.html
+	m_Callbacks = VkAllocationCallbacks
+	{
+		this,										// pUserData
+		AllocationCallback,							// pfnAllocation
+		ReallocationCallback,						// pfnReallocation
+		FreeCallback,								// pfnFree
+		InternalAllocationCallback,					// pfnInternalAllocation
+		InternalFreeCallback						// pfnInternalFree
+	};
+}
+
+HostAllocator::~HostAllocator()
+{
+	for (void* slab : m_Slabs)
+	{
+		::operator delete(slab, std::align_val_t{ g_HostSlabSize });
+	}
+}
+
+const VkAllocationCallbacks* HostAllocator::GetCallbacks() const
+{
+	return &m_Callbacks;
+}
+
+void HostAllocator::EndFrame()
+{
+	const std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	for (size_t i{}; i < g_HostAllocationScopeCount; ++i)
+	{
+		m_Statistics.at(i).LastFrameAllocationCount = m_CurrentFrameAllocationCounts.at(i);
+		m_Statistics.at(i).FrameAllocationCount += m_CurrentFrameAllocationCounts.at(i);
+		m_CurrentFrameAllocationCounts.at(i) = 0;
+	}
+
+	++m_FrameCount;
+}
+
+HostAllocationStatistics HostAllocator::GetStatistics(VkSystemAllocationScope scope) const
+{
+	const std::lock_guard<std::mutex> lock{ m_Mutex };
+	return m_Statistics.at(scope);
+}
+
+void HostAllocator::PrintStatistics() const
+{
+	const std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	std::cout << "-----Host Allocations-----" << std::endl;
+	std::cout << std::fixed << std::setprecision(1);
+
+	for (uint32_t i{}; i < g_HostAllocationScopeCount; ++i)
+	{
+		const HostAllocationStatistics& statistics{ m_Statistics.at(i) };
+		const double allocationsPerFrame{ (m_FrameCount == 0) ? 0.0 : double(statistics.FrameAllocationCount) / double(m_FrameCount) };
+
+		std::cout << std::setw(16) << std::left << GetScopeName(i)
+			<< statistics.AllocationCount << " allocations (" << statistics.PooledCount << " pooled), " << statistics.FreeCount << " frees, "
+			<< statistics.InternalAllocationCount << " internal, live " << double(statistics.LiveBytes) / 1024.0 << " KiB, peak " << double(statistics.PeakBytes) / 1024.0 << " KiB, "
+			<< statistics.LastFrameAllocationCount << " last frame, " << allocationsPerFrame << " per frame" << std::endl;
+	}
+
+	std::cout << std::defaultfloat;
+	std::cout << m_Slabs.size() << " arena slabs of " << g_HostSlabSize / 1024 << " KiB over " << m_FrameCount << " frames" << std::endl << std::endl;
+}
+
+void* HostAllocator::Allocate(size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	if (size == 0) return nullptr;
+
+	HostAllocationStatistics& statistics{ m_Statistics.at(scope) };
+	++statistics.AllocationCount;
+	++m_CurrentFrameAllocationCounts.at(scope);
+
+	// Chunks sit on multiples of their size inside a slab aligned to the slab size, a chunk at least as big as the alignment is aligned
+	const uint32_t arena{ GetArena(scope) };
+	const size_t chunkSize{ std::bit_ceil(std::max({ size, alignment, g_HostMinimumChunkSize })) };
+	if (arena != UINT32_MAX and chunkSize <= g_HostMaximumChunkSize)
+	{
+		const size_t chunkClass{ static_cast<size_t>(std::countr_zero(chunkSize) - std::countr_zero(g_HostMinimumChunkSize)) };
+
+		void* chunk{ AllocateChunk(chunkClass, arena) };
+		if (chunk == nullptr) return nullptr;
+
+		++statistics.PooledCount;
+		statistics.LiveBytes += chunkSize;
+		statistics.PeakBytes = std::max(statistics.PeakBytes, statistics.LiveBytes);
+		return chunk;
+	}
+
+	// The header goes right in front of the user pointer, padding it to the alignment keeps the pointer aligned
+	alignment = std::max(alignment, alignof(AllocationHeader));
+	const size_t offset{ (sizeof(AllocationHeader) + alignment - 1) / alignment * alignment };
+
+	char* base{ static_cast<char*>(::operator new(offset + size, std::align_val_t{ alignment }, std::nothrow)) };
+	if (base == nullptr) return nullptr;
+
+	char* memory{ base + offset };
+	const AllocationHeader header{ size, alignment, offset, static_cast<uint32_t>(scope) };
+	memcpy(memory - sizeof(AllocationHeader), &header, sizeof(AllocationHeader));
+
+	statistics.LiveBytes += size;
+	statistics.PeakBytes = std::max(statistics.PeakBytes, statistics.LiveBytes);
+	return memory;
+}
+
+void* HostAllocator::Reallocate(void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	if (original == nullptr) return Allocate(size, alignment, scope);
+
+	if (size == 0)
+	{
+		Free(original);
+		return nullptr;
+	}
+
+	size_t originalSize{};
+	uint32_t originalScope{};
+	GetAllocationInfo(original, originalSize, originalScope);
+
+	// The original stays valid when the new allocation fails
+	void* memory{ Allocate(size, alignment, scope) };
+	if (memory == nullptr) return nullptr;
+
+	memcpy(memory, original, std::min(size, originalSize));
+	Free(original);
+	return memory;
+}
+
+void HostAllocator::Free(void* memory)
+{
+	if (memory == nullptr) return;
+
+	size_t size{};
+	uint32_t scope{};
+	GetAllocationInfo(memory, size, scope);
+
+	HostAllocationStatistics& statistics{ m_Statistics.at(scope) };
+	++statistics.FreeCount;
+	statistics.LiveBytes -= size;
+
+	const uintptr_t slabAddress{ reinterpret_cast<uintptr_t>(memory) & ~uintptr_t(g_HostSlabSize - 1) };
+	if (m_SlabAddresses.contains(slabAddress))
+	{
+		const SlabHeader* slabHeader{ reinterpret_cast<const SlabHeader*>(slabAddress) };
+		const size_t chunkClass{ static_cast<size_t>(std::countr_zero(size_t(slabHeader->ChunkSize)) - std::countr_zero(g_HostMinimumChunkSize)) };
+		void*& freeChunks{ m_FreeChunks.at(GetArena(static_cast<VkSystemAllocationScope>(scope))).at(chunkClass) };
+
+		// The first bytes of a free chunk point to the next free chunk
+		memcpy(memory, &freeChunks, sizeof(void*));
+		freeChunks = memory;
+		return;
+	}
+
+	AllocationHeader header{};
+	memcpy(&header, static_cast<char*>(memory) - sizeof(AllocationHeader), sizeof(AllocationHeader));
+	::operator delete(static_cast<char*>(memory) - header.Offset, std::align_val_t{ header.Alignment });
+}
+
+void HostAllocator::GetAllocationInfo(void* memory, size_t& size, uint32_t& scope) const
+{
+	const uintptr_t slabAddress{ reinterpret_cast<uintptr_t>(memory) & ~uintptr_t(g_HostSlabSize - 1) };
+	if (m_SlabAddresses.contains(slabAddress))
+	{
+		const SlabHeader* slabHeader{ reinterpret_cast<const SlabHeader*>(slabAddress) };
+		size = slabHeader->ChunkSize;
+		scope = slabHeader->Scope;
+		return;
+	}
+
+	AllocationHeader header{};
+	memcpy(&header, static_cast<char*>(memory) - sizeof(AllocationHeader), sizeof(AllocationHeader));
+	size = header.Size;
+	scope = header.Scope;
+}
+
+void* HostAllocator::AllocateChunk(size_t chunkClass, uint32_t arena)
+{
+	void*& freeChunks{ m_FreeChunks.at(arena).at(chunkClass) };
+	if (freeChunks == nullptr and !AddSlab(chunkClass, arena, (arena == 0) ? VK_SYSTEM_ALLOCATION_SCOPE_OBJECT : VK_SYSTEM_ALLOCATION_SCOPE_COMMAND)) return nullptr;
+
+	void* chunk{ freeChunks };
+	memcpy(&freeChunks, chunk, sizeof(void*));
+	return chunk;
+}
+
+bool HostAllocator::AddSlab(size_t chunkClass, uint32_t arena, uint32_t scope)
+{
+	const size_t chunkSize{ g_HostMinimumChunkSize << chunkClass };
+
+	// The driver expects a null pointer when the host runs out of memory, not an exception
+	char* slab{ static_cast<char*>(::operator new(g_HostSlabSize, std::align_val_t{ g_HostSlabSize }, std::nothrow)) };
+	if (slab == nullptr) return false;
+
+	m_Slabs.push_back(slab);
+	m_SlabAddresses.insert(reinterpret_cast<uintptr_t>(slab));
+
+	const SlabHeader header{ static_cast<uint32_t>(chunkSize), scope };
+	memcpy(slab, &header, sizeof(SlabHeader));
+
+	// The chunks overlapping the header are never handed out, the rest goes on the free list in address order
+	void*& freeChunks{ m_FreeChunks.at(arena).at(chunkClass) };
+	const size_t firstChunk{ (sizeof(SlabHeader) + chunkSize - 1) / chunkSize };
+	for (size_t i{ g_HostSlabSize / chunkSize }; i-- > firstChunk;)
+	{
+		void* chunk{ slab + i * chunkSize };
+		memcpy(chunk, &freeChunks, sizeof(void*));
+		freeChunks = chunk;
+	}
+
+	return true;
+}
+
+void* VKAPI_PTR HostAllocator::AllocationCallback(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	HostAllocator* hostAllocator{ static_cast<HostAllocator*>(userData) };
+	const std::lock_guard<std::mutex> lock{ hostAllocator->m_Mutex };
+	return hostAllocator->Allocate(size, alignment, scope);
+}
+
+void* VKAPI_PTR HostAllocator::ReallocationCallback(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	HostAllocator* hostAllocator{ static_cast<HostAllocator*>(userData) };
+	const std::lock_guard<std::mutex> lock{ hostAllocator->m_Mutex };
+	return hostAllocator->Reallocate(original, size, alignment, scope);
+}
+
+void VKAPI_PTR HostAllocator::FreeCallback(void* userData, void* memory)
+{
+	HostAllocator* hostAllocator{ static_cast<HostAllocator*>(userData) };
+	const std::lock_guard<std::mutex> lock{ hostAllocator->m_Mutex };
+	hostAllocator->Free(memory);
+}
+
+void VKAPI_PTR HostAllocator::InternalAllocationCallback(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope)
+{
+	size;
+	type;
+
+	HostAllocator* hostAllocator{ static_cast<HostAllocator*>(userData) };
+	const std::lock_guard<std::mutex> lock{ hostAllocator->m_Mutex };
+	++hostAllocator->m_Statistics.at(scope).InternalAllocationCount;
+}
+
+void VKAPI_PTR HostAllocator::InternalFreeCallback(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope)
+{
+	userData;
+	size;
+	type;
+	scope;
+}
@@ -0,0 +1,96 @@
+#ifndef HOST_ALLOCATOR
+#define HOST_ALLOCATOR
+
+#include <vulkan.hpp>
+#include <array>
+#include <vector>
+#include <unordered_set>
+#include <mutex>
+#include <cstdint>
+
+// Bytes of one arena slab, slabs are aligned to their size so a chunk finds its slab by masking its address
+constexpr size_t g_HostSlabSize{ size_t(64) << 10 };
+
+// Chunk sizes of the arenas, powers of two from the smallest to the largest
+constexpr size_t g_HostMinimumChunkSize{ 16 };
+constexpr size_t g_HostMaximumChunkSize{ 2048 };
+constexpr size_t g_HostChunkClassCount{ 8 };
+
+// VK_SYSTEM_ALLOCATION_SCOPE_COMMAND up to VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE
+constexpr size_t g_HostAllocationScopeCount{ 5 };
+
+struct HostAllocationStatistics final
+{
+	uint64_t AllocationCount;				// Reallocations included
+	uint64_t FreeCount;
+	uint64_t PooledCount;					// Allocations served out of an arena
+	uint64_t InternalAllocationCount;		// Allocations the driver made itself and only reported
+	uint64_t FrameAllocationCount;			// Allocations inside frames, for the average per frame
+	uint64_t LastFrameAllocationCount;
+	size_t LiveBytes;
+	size_t PeakBytes;
+};
+
+// Host memory callbacks handed to the driver, they count allocations and bytes per allocation scope.
+// Object and command scope allocations, the small and frequent ones, come out of chunk arenas instead of the heap.
+class HostAllocator final
+{
+public:
+	HostAllocator();
+	~HostAllocator();
+
+	HostAllocator(const HostAllocator&) = delete;
+	HostAllocator& operator=(const HostAllocator&) = delete;
+	HostAllocator(HostAllocator&&) = delete;
+	HostAllocator& operator=(HostAllocator&&) = delete;
+
+	// Has to be passed to the destroy call of every object created with it
+	const VkAllocationCallbacks* GetCallbacks() const;
+
+	// Closes the allocation counts of the current frame
+	void EndFrame();
+
+	HostAllocationStatistics GetStatistics(VkSystemAllocationScope scope) const;
+	void PrintStatistics() const;
+
+private:
+	struct SlabHeader final
+	{
+		uint32_t ChunkSize;
+		uint32_t Scope;
+	};
+
+	// Stored right in front of allocations that don't come out of an arena
+	struct AllocationHeader final
+	{
+		size_t Size;
+		size_t Alignment;
+		size_t Offset;						// From the start of the heap allocation to the user pointer
+		uint32_t Scope;
+	};
+
+	VkAllocationCallbacks m_Callbacks;
+	mutable std::mutex m_Mutex;
+	std::array<HostAllocationStatistics, g_HostAllocationScopeCount> m_Statistics;
+	std::array<uint64_t, g_HostAllocationScopeCount> m_CurrentFrameAllocationCounts;
+	uint64_t m_FrameCount;
+	std::array<std::array<void*, g_HostChunkClassCount>, 2> m_FreeChunks;	// Intrusive free lists, object and command scope
+	std::vector<void*> m_Slabs;
+	std::unordered_set<uintptr_t> m_SlabAddresses;
+
+	void* Allocate(size_t size, size_t alignment, VkSystemAllocationScope scope);
+	void* Reallocate(void* original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+	void Free(void* memory);
+	// Size usable behind the pointer and the scope it got allocated for
+	void GetAllocationInfo(void* memory, size_t& size, uint32_t& scope) const;
+	void* AllocateChunk(size_t chunkClass, uint32_t arena);
+	bool AddSlab(size_t chunkClass, uint32_t arena, uint32_t scope);
+
+	static void* VKAPI_PTR AllocationCallback(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope);
+	static void* VKAPI_PTR ReallocationCallback(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+	static void VKAPI_PTR FreeCallback(void* userData, void* memory);
+	static void VKAPI_PTR InternalAllocationCallback(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+	static void VKAPI_PTR InternalFreeCallback(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+};
+
+#endif
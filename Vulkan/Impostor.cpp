@@ -0,0 +1,673 @@
+#include <gtc/matrix_transform.hpp>
+#include <stdexcept>
+#include <array>
+#include <cmath>
+
+#include "Impostor.h"
+#include "HelperFunctions.h"
+#include "VertexLayout.h"
+
+namespace
+{
+	constexpr VkFormat g_ImpostorBaseColorFormat{ VK_FORMAT_R8G8B8A8_SRGB };
+	constexpr VkFormat g_ImpostorSurfaceFormat{ VK_FORMAT_R8G8B8A8_UNORM };
+}
+
+Impostor::Impostor
+(
+	VkDevice device,
+	DeviceAllocator& deviceAllocator,
+	ImpostorBaker& baker,
+	const Mesh& mesh,
+	VkDescriptorSet texturesDescriptorSet
+) :
+	m_Device{ device },
+	m_DeviceAllocator{ deviceAllocator },
+	m_BaseColorImage{},
+	m_BaseColorMemory{},
+	m_BaseColorImageView{},
+	m_SurfaceImage{},
+	m_SurfaceMemory{},
+	m_SurfaceImageView{},
+	m_BoundingSphere{ mesh.GetBoundingSphere() },
+	m_Baked{ false }
+{
+	CreateAtlas();
+	Bake(baker, mesh, texturesDescriptorSet);
+}
+
+Impostor::~Impostor()
+{
+	Evict();
+}
+
+void Impostor::Evict()
+{
+	vkDestroyImageView(m_Device, m_BaseColorImageView, nullptr);
+	vkDestroyImage(m_Device, m_BaseColorImage, nullptr);
+	m_DeviceAllocator.Free(m_BaseColorMemory);
+
+	vkDestroyImageView(m_Device, m_SurfaceImageView, nullptr);
+	vkDestroyImage(m_Device, m_SurfaceImage, nullptr);
+	m_DeviceAllocator.Free(m_SurfaceMemory);
+
+	m_BaseColorImage = VK_NULL_HANDLE;
+	m_BaseColorMemory = DeviceAllocation{};
+	m_BaseColorImageView = VK_NULL_HANDLE;
+	m_SurfaceImage = VK_NULL_HANDLE;
+	m_SurfaceMemory = DeviceAllocation{};
+	m_SurfaceImageView = VK_NULL_HANDLE;
+
+	m_Baked = false;
+}
+
+void Impostor::Restore()
+{
+	if (!IsResident()) CreateAtlas();
+}
+
+void Impostor::Bake(ImpostorBaker& baker, const Mesh& mesh, VkDescriptorSet texturesDescriptorSet)
+{
+	baker.Record(m_BaseColorImageView, m_SurfaceImageView, mesh, texturesDescriptorSet);
+	m_Baked = true;
+}
+
+bool Impostor::IsResident() const
+{
+	return m_BaseColorImage != VK_NULL_HANDLE;
+}
+
+bool Impostor::IsBaked() const
+{
+	return m_Baked;
+}
+
+uint32_t Impostor::GetHeap() const
+{
+	return m_DeviceAllocator.GetHeap(m_BaseColorMemory);
+}
+
+VkDeviceSize Impostor::GetSize() const
+{
+	return m_BaseColorMemory.Size + m_SurfaceMemory.Size;
+}
+
+VkImageView Impostor::GetBaseColorImageView() const
+{
+	return m_BaseColorImageView;
+}
+
+VkImageView Impostor::GetSurfaceImageView() const
+{
+	return m_SurfaceImageView;
+}
+
+const BoundingSphere& Impostor::GetBoundingSphere() const
+{
+	return m_BoundingSphere;
+}
+
+void Impostor::CreateAtlas()
+{
+	const VkExtent2D atlasExtent{ g_ImpostorFrameCount * g_ImpostorFrameSize, g_ImpostorFrameCount * g_ImpostorFrameSize };
+
+	CreateImage
+	(
+		m_DeviceAllocator,
+		atlasExtent,
+		g_ImpostorBaseColorFormat,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		MemoryCategory::Textures,
+		m_BaseColorImage,
+		m_BaseColorMemory,
+		1,
+		VK_SAMPLE_COUNT_1_BIT
+	);
+	m_BaseColorImageView = CreateImageView(m_Device, m_BaseColorImage, g_ImpostorBaseColorFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+
+	CreateImage
+	(
+		m_DeviceAllocator,
+		atlasExtent,
+		g_ImpostorSurfaceFormat,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		MemoryCategory::Textures,
+		m_SurfaceImage,
+		m_SurfaceMemory,
+		1,
+		VK_SAMPLE_COUNT_1_BIT
+	);
+	m_SurfaceImageView = CreateImageView(m_Device, m_SurfaceImage, g_ImpostorSurfaceFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+}
+
+ImpostorBaker::ImpostorBaker
+(
+	VkPhysicalDevice physicalDevice,
+	VkDevice device,
+	DeviceAllocator& deviceAllocator,
+	VkCommandPool commandPool,
+	VkQueue queue,
+	VkDescriptorSetLayout texturesDescriptorSetLayout
+) :
+	m_Device{ device },
+	m_DeviceAllocator{ deviceAllocator },
+	m_CommandPool{ commandPool },
+	m_Queue{ queue },
+	m_DepthFormat{ FindDepthFormat(physicalDevice) },
+	m_DepthImage{},
+	m_DepthMemory{},
+	m_DepthImageView{},
+	m_RenderPass{},
+	m_PipelineLayout{},
+	m_Pipeline{},
+	m_CommandBuffer{},
+	m_FrameBuffers{}
+{
+	m_RenderPass = CreateRenderPass();
+	if (m_RenderPass == VK_NULL_HANDLE) throw std::runtime_error("Failed to create impostor bake render pass!");
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPushConstantRange.html
+	const VkPushConstantRange pushConstantRange
+	{
+		VK_SHADER_STAGE_VERTEX_BIT,		// stageFlags
+		0,								// offset
+		sizeof(glm::mat4)				// size
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineLayoutCreateInfo.html
+	const VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,				// sType
+		nullptr,													// pNext
+		0,															// flags
+		1,															// setLayoutCount
+		&texturesDescriptorSetLayout,								// pSetLayouts
+		1,															// pushConstantRangeCount
+		&pushConstantRange											// pPushConstantRanges
+	};
+
+	if (vkCreatePipelineLayout(m_Device, &pipelineLayoutCreateInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS) throw std::runtime_error("Failed to create impostor bake pipeline layout!");
+
+	// The modules are only needed while the pipeline gets created
+	const VkShaderModule vertexShader{ CreateShaderModule(LoadSPIRV(VertexFormat<g_VertexLayout>::ImpostorBakeShaderPath), m_Device) };
+	const VkShaderModule fragmentShader{ CreateShaderModule(LoadSPIRV("shaders/impostor_bake_frag.spv"), m_Device) };
+
+	m_Pipeline = CreatePipeline(vertexShader, fragmentShader);
+
+	vkDestroyShaderModule(m_Device, vertexShader, nullptr);
+	vkDestroyShaderModule(m_Device, fragmentShader, nullptr);
+
+	if (m_Pipeline == VK_NULL_HANDLE) throw std::runtime_error("Failed to create impostor bake pipeline!");
+}
+
+ImpostorBaker::~ImpostorBaker()
+{
+	// Bakes that never got submitted still have to finish before their frame buffers go
+	Submit();
+
+	vkDestroyPipeline(m_Device, m_Pipeline, nullptr);
+	vkDestroyPipelineLayout(m_Device, m_PipelineLayout, nullptr);
+	vkDestroyRenderPass(m_Device, m_RenderPass, nullptr);
+}
+
+void ImpostorBaker::Record(VkImageView baseColorImageView, VkImageView surfaceImageView, const Mesh& mesh, VkDescriptorSet texturesDescriptorSet)
+{
+	const VkExtent2D atlasExtent{ g_ImpostorFrameCount * g_ImpostorFrameSize, g_ImpostorFrameCount * g_ImpostorFrameSize };
+
+	if (m_CommandBuffer == VK_NULL_HANDLE)
+	{
+		CreateDepthBuffer();
+		m_CommandBuffer = BeginSingleTimeCommands(m_Device, m_CommandPool);
+	}
+
+	const std::array<VkImageView, 3> attachments{ baseColorImageView, surfaceImageView, m_DepthImageView };
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkFramebufferCreateInfo.html
+	const VkFramebufferCreateInfo frameBufferCreateInfo
+	{
+		VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,				// sType
+		nullptr,												// pNext
+		0,														// flags
+		m_RenderPass,											// renderPass
+		uint32_t(attachments.size()),							// AttachmentCount
+		attachments.data(),										// pAttachments
+		atlasExtent.width,										// width
+		atlasExtent.height,										// height
+		1														// layers
+	};
+
+	VkFramebuffer frameBuffer{};
+	if (vkCreateFramebuffer(m_Device, &frameBufferCreateInfo, nullptr, &frameBuffer) != VK_SUCCESS) throw std::runtime_error("Failed to create impostor bake frame buffer!");
+	m_FrameBuffers.push_back(frameBuffer);
+
+	// Zero alpha marks the texels no frame covers
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkClearValue.html
+	const std::array<VkClearValue, 3> clearValues
+	{
+		VkClearValue{ 0.0f, 0.0f, 0.0f, 0.0f },
+		VkClearValue{ 0.5f, 0.5f, 0.0f, 0.0f },
+		VkClearValue{ 1.0f, 0 }
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkRenderPassBeginInfo.html
+	const VkRenderPassBeginInfo renderPassBeginInfo
+	{
+		VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,		// sType
+		nullptr,										// pNext
+		m_RenderPass,									// renderPass
+		frameBuffer,									// framebuffer
+		VkRect2D{ VkOffset2D{ 0, 0 }, atlasExtent },	// renderArea
+		uint32_t(clearValues.size()),					// clearValueCount
+		clearValues.data()								// pClearValues
+	};
+
+	vkCmdBeginRenderPass(m_CommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBindPipeline(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
+
+	// The mesh lives in the shared geometry arena, its ranges come from the draw offsets
+	const VkBuffer vertexBuffers[]{ mesh.GetVertexBuffer() };
+	const VkDeviceSize offsets[]{ 0 };
+	vkCmdBindVertexBuffers(m_CommandBuffer, 0, 1, vertexBuffers, offsets);
+	vkCmdBindIndexBuffer(m_CommandBuffer, mesh.GetIndexBuffer(), 0, mesh.GetIndexType());
+	vkCmdBindDescriptorSets(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &texturesDescriptorSet, 0, nullptr);
+
+	// Every frame gets the full detail level, the frames never overlap so one clear covers them all
+	const MeshLod& lod{ mesh.GetLods().front() };
+	for (uint32_t y{}; y < g_ImpostorFrameCount; ++y)
+	{
+		for (uint32_t x{}; x < g_ImpostorFrameCount; ++x)
+		{
+			const VkViewport viewport
+			{
+				float(x * g_ImpostorFrameSize),		// x
+				float(y * g_ImpostorFrameSize),		// y
+				float(g_ImpostorFrameSize),			// width
+				float(g_ImpostorFrameSize),			// height
+				0.0f,								// minDepth
+				1.0f								// maxDepth
+			};
+			vkCmdSetViewport(m_CommandBuffer, 0, 1, &viewport);
+
+			const VkRect2D scissor{ VkOffset2D{ int32_t(x * g_ImpostorFrameSize), int32_t(y * g_ImpostorFrameSize) }, VkExtent2D{ g_ImpostorFrameSize, g_ImpostorFrameSize } };
+			vkCmdSetScissor(m_CommandBuffer, 0, 1, &scissor);
+
+			const glm::mat4 frameMatrix{ GetImpostorFrameMatrix(mesh.GetBoundingSphere(), x, y) };
+			vkCmdPushConstants(m_CommandBuffer, m_PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &frameMatrix);
+
+			vkCmdDrawIndexed(m_CommandBuffer, lod.IndexCount, 1, mesh.GetFirstIndex() + lod.FirstIndex, mesh.GetVertexOffset(), 0);
+		}
+	}
+
+	vkCmdEndRenderPass(m_CommandBuffer);
+}
+
+uint32_t ImpostorBaker::Submit()
+{
+	if (m_CommandBuffer == VK_NULL_HANDLE) return 0;
+
+	EndSingleTimeCommands(m_Device, m_CommandPool, m_Queue, m_CommandBuffer);
+	m_CommandBuffer = VK_NULL_HANDLE;
+
+	const uint32_t bakeCount{ static_cast<uint32_t>(m_FrameBuffers.size()) };
+	for (VkFramebuffer frameBuffer : m_FrameBuffers) vkDestroyFramebuffer(m_Device, frameBuffer, nullptr);
+	m_FrameBuffers.clear();
+
+	DestroyDepthBuffer();
+
+	return bakeCount;
+}
+
+void ImpostorBaker::CreateDepthBuffer()
+{
+	const VkExtent2D atlasExtent{ g_ImpostorFrameCount * g_ImpostorFrameSize, g_ImpostorFrameCount * g_ImpostorFrameSize };
+
+	CreateImage
+	(
+		m_DeviceAllocator,
+		atlasExtent,
+		m_DepthFormat,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		MemoryCategory::Attachments,
+		m_DepthImage,
+		m_DepthMemory,
+		1,
+		VK_SAMPLE_COUNT_1_BIT
+	);
+	m_DepthImageView = CreateImageView(m_Device, m_DepthImage, m_DepthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
+}
+
+void ImpostorBaker::DestroyDepthBuffer()
+{
+	vkDestroyImageView(m_Device, m_DepthImageView, nullptr);
+	vkDestroyImage(m_Device, m_DepthImage, nullptr);
+	m_DeviceAllocator.Free(m_DepthMemory);
+
+	m_DepthImage = VK_NULL_HANDLE;
+	m_DepthMemory = DeviceAllocation{};
+	m_DepthImageView = VK_NULL_HANDLE;
+}
+
+VkRenderPass ImpostorBaker::CreateRenderPass() const
+{
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkAttachmentDescription.html
+	const std::array<VkAttachmentDescription, 3> attachmentDescriptions
+	{
+		// base color attachment, sampled by the impostor pipeline afterwards
+		VkAttachmentDescription
+		{
+			0,													// flags
+			g_ImpostorBaseColorFormat,							// format
+			VK_SAMPLE_COUNT_1_BIT,								// samples
+			VK_ATTACHMENT_LOAD_OP_CLEAR,						// loadOp
+			VK_ATTACHMENT_STORE_OP_STORE,						// storeOp
+			VK_ATTACHMENT_LOAD_OP_DONT_CARE,					// stencilLoadOp
+			VK_ATTACHMENT_STORE_OP_DONT_CARE,					// stencilStoreOp
+			VK_IMAGE_LAYOUT_UNDEFINED,							// initialLayout
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL			// finalLayout
+		},
+		// surface attachment
+		VkAttachmentDescription
+		{
+			0,
+			g_ImpostorSurfaceFormat,
+			VK_SAMPLE_COUNT_1_BIT,
+			VK_ATTACHMENT_LOAD_OP_CLEAR,
+			VK_ATTACHMENT_STORE_OP_STORE,
+			VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+			VK_ATTACHMENT_STORE_OP_DONT_CARE,
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+		},
+		// depth buffering attachment, shared by every bake
+		VkAttachmentDescription
+		{
+			0,
+			m_DepthFormat,
+			VK_SAMPLE_COUNT_1_BIT,
+			VK_ATTACHMENT_LOAD_OP_CLEAR,
+			VK_ATTACHMENT_STORE_OP_DONT_CARE,
+			VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+			VK_ATTACHMENT_STORE_OP_DONT_CARE,
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+		}
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkAttachmentReference.html
+	const std::array<VkAttachmentReference, 2> colorAttachmentReferences
+	{
+		VkAttachmentReference{ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL },
+		VkAttachmentReference{ 1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL }
+	};
+
+	const VkAttachmentReference depthAttachmentReference
+	{
+		2,													// attachment
+		VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL	// layout
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkSubpassDescription.html
+	const VkSubpassDescription subpassDescription
+	{
+		0,												// flags
+		VK_PIPELINE_BIND_POINT_GRAPHICS,				// pipelineBindPoint
+		0,												// inputAttachmentCount
+		nullptr,										// pInputAttachments
+		uint32_t(colorAttachmentReferences.size()),		// colorAttachmentCount
+		colorAttachmentReferences.data(),				// pColorAttachments
+		nullptr,										// pResolveAttachments
+		&depthAttachmentReference,						// pDepthStencilAttachment
+		0,												// preserveAttachmentCount
+		nullptr											// pPreserveAttachments
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkSubpassDependency.html
+	const std::array<VkSubpassDependency, 2> subpassDependencies
+	{
+		// The bake recorded before this one has to be done with the shared depth buffer
+		VkSubpassDependency
+		{
+			VK_SUBPASS_EXTERNAL,																	// srcSubpass
+			0,																						// dstSubpass
+			VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,												// srcStageMask
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,												// dstStageMask
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,											// srcAccessMask
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,	// dstAccessMask
+			0																						// dependencyFlags
+		},
+		VkSubpassDependency
+		{
+			0,
+			VK_SUBPASS_EXTERNAL,
+			VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			VK_ACCESS_SHADER_READ_BIT,
+			0
+		}
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkRenderPassCreateInfo.html
+	const VkRenderPassCreateInfo renderPassCreateInfo
+	{
+		VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,			// sType
+		nullptr,											// pNext
+		0,													// flags
+		uint32_t(attachmentDescriptions.size()),			// attachmentCount
+		attachmentDescriptions.data(),						// pAttachments
+		1,													// subpassCount
+		&subpassDescription,								// pSubpasses
+		uint32_t(subpassDependencies.size()),				// dependencyCount
+		subpassDependencies.data()							// pDependencies
+	};
+
+	VkRenderPass renderPass{};
+	if (vkCreateRenderPass(m_Device, &renderPassCreateInfo, nullptr, &renderPass) != VK_SUCCESS) return VK_NULL_HANDLE;
+
+	return renderPass;
+}
+
+VkPipeline ImpostorBaker::CreatePipeline(VkShaderModule vertexShader, VkShaderModule fragmentShader) const
+{
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineShaderStageCreateInfo.html
+	const std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages
+	{
+		VkPipelineShaderStageCreateInfo
+		{
+			VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,	// sType
+			nullptr,												// pNext
+			0,														// flags
+			VK_SHADER_STAGE_VERTEX_BIT,								// stage
+			vertexShader,											// module
+			"main",													// pName
+			nullptr													// pSpecializationInfo
+		},
+		VkPipelineShaderStageCreateInfo
+		{
+			VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+			nullptr,
+			0,
+			VK_SHADER_STAGE_FRAGMENT_BIT,
+			fragmentShader,
+			"main",
+			nullptr
+		}
+	};
+
+	const auto vertexBindingDescription{ VertexFormat<g_VertexLayout>::GetBindingDescription() };
+	const auto vertexAttributeDescriptions{ VertexFormat<g_VertexLayout>::GetAttributeDescriptions() };
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineVertexInputStateCreateInfo.html
+	const VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,		// sType
+		nullptr,														// pNext
+		0,																// flags
+		1,																// vertexBindingDescriptionCount
+		&vertexBindingDescription,										// pVertexBindingDescriptions
+		static_cast<uint32_t>(vertexAttributeDescriptions.size()),		// vertexAttributeDescriptionCount
+		vertexAttributeDescriptions.data()								// pVertexAttributeDescriptions
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineInputAssemblyStateCreateInfo.html
+	const VkPipelineInputAssemblyStateCreateInfo inputAssemblyStateCreateInfo
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,	// sType
+		nullptr,														// pNext
+		0,																// flags
+		VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,							// topology
+		VK_FALSE														// primitiveRestartEnable
+	};
+
+	// Every frame sets its own viewport
+	const std::array<VkDynamicState, 2> dynamicStates{ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineDynamicStateCreateInfo.html
+	const VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,		// sType
+		nullptr,													// pNext
+		0,															// flags
+		uint32_t(dynamicStates.size()),								// dynamicStateCount
+		dynamicStates.data()										// pDynamicStates
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineViewportStateCreateInfo.html
+	const VkPipelineViewportStateCreateInfo viewportStateCreateInfo
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,		// sType
+		nullptr,													// pNext
+		0,															// flags
+		1,															// viewportCount
+		nullptr,													// pViewports
+		1,															// scissorCount
+		nullptr														// pScissors
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineRasterizationStateCreateInfo.html
+	const VkPipelineRasterizationStateCreateInfo rasterizationStateCreateInfo
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,		// sType
+		nullptr,														// pNext
+		0,																// flags
+		VK_FALSE,														// depthClampEnable
+		VK_FALSE,														// rasterizerDiscardEnable
+		VK_POLYGON_MODE_FILL,											// polygonMode
+		VK_CULL_MODE_BACK_BIT,											// cullMode
+		VK_FRONT_FACE_COUNTER_CLOCKWISE,								// frontFace
+		VK_FALSE,														// depthBiasEnable
+		0.0f,															// depthBiasConstantFactor
+		0.0f,															// depthBiasClamp
+		0.0f,															// depthBiasSlopeFactor
+		1.0f															// lineWidth
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineMultisampleStateCreateInfo.html
+	const VkPipelineMultisampleStateCreateInfo multisampleStateCreateInfo
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,		// sType
+		nullptr,														// pNext
+		0,																// flags
+		VK_SAMPLE_COUNT_1_BIT,											// rasterizationSamples
+		VK_FALSE,														// sampleShadingEnable
+		0.0f,															// minSampleShading
+		nullptr,														// pSampleMask
+		VK_FALSE,														// alphaToCoverageEnable
+		VK_FALSE														// alphaToOneEnable
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineDepthStencilStateCreateInfo.html
+	const VkPipelineDepthStencilStateCreateInfo depthStencilStateCreateInfo
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,				// sType
+		nullptr,																// pNext
+		0,																		// flags
+		VK_TRUE,																// depthTestEnable
+		VK_TRUE,																// depthWriteEnable
+		VK_COMPARE_OP_LESS,														// depthCompareOp
+		VK_FALSE,																// depthBoundsTestEnable
+		VK_FALSE,																// stencilTestEnable
+		VkStencilOpState{},														// front
+		VkStencilOpState{},														// back
+		0.0f,																	// minDepthBounds
+		1.0f																	// maxDepthBounds
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineColorBlendAttachmentState.html
+	VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	colorBlendAttachment.blendEnable = VK_FALSE;
+
+	const std::array<VkPipelineColorBlendAttachmentState, 2> colorBlendAttachments{ colorBlendAttachment, colorBlendAttachment };
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPipelineColorBlendStateCreateInfo.html
+	const VkPipelineColorBlendStateCreateInfo colorBlendStateCreateInfo
+	{
+		VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,		// sType
+		nullptr,														// pNext
+		0,																// flags
+		VK_FALSE,														// logicOpEnable
+		VK_LOGIC_OP_COPY,												// logicOp
+		uint32_t(colorBlendAttachments.size()),							// attachmentCount
+		colorBlendAttachments.data(),									// pAttachments
+		{ 0.0f, 0.0f, 0.0f, 0.0f }										// blendConstants
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkGraphicsPipelineCreateInfo.html
+	const VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo
+	{
+		VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,		// sType
+		nullptr,												// pNext
+		0,														// flags
+		uint32_t(shaderStages.size()),							// stageCount
+		shaderStages.data(),									// pStages
+		&vertexInputStateCreateInfo,							// pVertexInputState
+		&inputAssemblyStateCreateInfo,							// pInputAssemblyState
+		nullptr,												// pTessellationState
+		&viewportStateCreateInfo,								// pViewportState
+		&rasterizationStateCreateInfo,							// pRasterizationState
+		&multisampleStateCreateInfo,							// pMultisampleState
+		&depthStencilStateCreateInfo,							// pDepthStencilState
+		&colorBlendStateCreateInfo,								// pColorBlendState
+		&dynamicStateCreateInfo,								// pDynamicState
+		m_PipelineLayout,										// layout
+		m_RenderPass,											// renderPass
+		0,														// subpass
+		nullptr,												// basePipelineHandle
+		0														// basePipelineIndex
+	};
+
+	VkPipeline pipeline{};
+	if (vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &graphicsPipelineCreateInfo, nullptr, &pipeline) != VK_SUCCESS) return VK_NULL_HANDLE;
+
+	return pipeline;
+}
+
+glm::mat4 GetImpostorFrameMatrix
+(
+	const BoundingSphere& boundingSphere,
+	uint32_t frameX,
+	uint32_t frameY
+)
+{
+	// Frame centers spread evenly over the octahedron, impostor.vert rounds the view direction to the same grid
+	const glm::vec2 encoded{ (glm::vec2{ float(frameX), float(frameY) } + 0.5f) / float(g_ImpostorFrameCount) * 2.0f - 1.0f };
+	const glm::vec3 direction{ DecodeOctahedral(encoded) };
+	const glm::vec3 up{ (std::abs(direction.y) < 0.999f) ? glm::vec3{ 0.0f, 1.0f, 0.0f } : glm::vec3{ 0.0f, 0.0f, 1.0f } };
+
+	const float radius{ boundingSphere.Radius };
+	const glm::vec3 eye{ boundingSphere.Center + direction * radius * 2.0f };
+	const glm::mat4 viewMatrix{ glm::lookAt(eye, boundingSphere.Center, up) };
+
+	// The sphere fills the frame exactly, y is flipped like the main camera so the top row of a frame is up
+	glm::mat4 projectionMatrix{ glm::orthoRH_ZO(-radius, radius, -radius, radius, 0.0f, radius * 4.0f) };
+	projectionMatrix[1][1] *= -1;
+
+	return projectionMatrix * viewMatrix;
+}
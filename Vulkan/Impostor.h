@@ -0,0 +1,124 @@
+#ifndef IMPOSTOR
+#define IMPOSTOR
+
+#include <vulkan.hpp>
+#include <vector>
+
+#include "Mesh.h"
+
+// Frames along one side of the atlas and the resolution of a single frame
+constexpr uint32_t g_ImpostorFrameCount{ 8 };
+constexpr uint32_t g_ImpostorFrameSize{ 128 };
+
+class ImpostorBaker;
+
+// Octahedral impostor of a mesh, the atlas holds one orthographic frame per view direction on the octahedron,
+// baked once at load so far away copies of the mesh can be drawn as a single quad
+class Impostor
+{
+public:
+	// The bake gets recorded in the baker, the atlas is only valid once the baker submitted it
+	Impostor
+	(
+		VkDevice device,
+		DeviceAllocator& deviceAllocator,
+		ImpostorBaker& baker,
+		const Mesh& mesh,
+		VkDescriptorSet texturesDescriptorSet
+	);
+	~Impostor();
+
+	Impostor(const Impostor&) = delete;
+	Impostor& operator=(const Impostor&) = delete;
+	Impostor(Impostor&&) = delete;
+	Impostor& operator=(Impostor&&) = delete;
+
+	// Releases the atlas, the mesh has to be drawn in full detail until it gets restored and baked again
+	void Evict();
+	// Allocates the atlas again, it only holds the impostor again once a bake got recorded and the baker submitted it
+	void Restore();
+	// Records drawing the mesh into the atlas, the textures descriptor set has to stay valid until the baker submits
+	void Bake(ImpostorBaker& baker, const Mesh& mesh, VkDescriptorSet texturesDescriptorSet);
+	bool IsResident() const;
+	// False from Evict until a bake got recorded into the restored atlas, only then can it be drawn
+	bool IsBaked() const;
+	// Heap the atlas lives on
+	uint32_t GetHeap() const;
+	// Bytes of both atlases
+	VkDeviceSize GetSize() const;
+
+	VkImageView GetBaseColorImageView() const;
+	VkImageView GetSurfaceImageView() const;
+	const BoundingSphere& GetBoundingSphere() const;
+
+private:
+	VkDevice m_Device;
+	DeviceAllocator& m_DeviceAllocator;
+	VkImage m_BaseColorImage;				// Base color, alpha is coverage
+	DeviceAllocation m_BaseColorMemory;
+	VkImageView m_BaseColorImageView;
+	VkImage m_SurfaceImage;					// Octahedral mesh space normal in rg, specular in b and glossiness in a
+	DeviceAllocation m_SurfaceMemory;
+	VkImageView m_SurfaceImageView;
+	BoundingSphere m_BoundingSphere;
+	bool m_Baked;
+
+	void CreateAtlas();
+};
+
+// Render pass, pipeline and depth buffer every impostor bake shares, created once instead of per impostor.
+// Bakes get recorded into one command buffer and go to the queue together on Submit
+class ImpostorBaker final
+{
+public:
+	ImpostorBaker
+	(
+		VkPhysicalDevice physicalDevice,
+		VkDevice device,
+		DeviceAllocator& deviceAllocator,
+		VkCommandPool commandPool,
+		VkQueue queue,
+		VkDescriptorSetLayout texturesDescriptorSetLayout
+	);
+	~ImpostorBaker();
+
+	ImpostorBaker(const ImpostorBaker&) = delete;
+	ImpostorBaker& operator=(const ImpostorBaker&) = delete;
+	ImpostorBaker(ImpostorBaker&&) = delete;
+	ImpostorBaker& operator=(ImpostorBaker&&) = delete;
+
+	// Records drawing every frame of the mesh into the atlas, the textures descriptor set has to stay valid until Submit
+	void Record(VkImageView baseColorImageView, VkImageView surfaceImageView, const Mesh& mesh, VkDescriptorSet texturesDescriptorSet);
+	// Submits every bake recorded since the last call in one go and waits on it, returns how many there were
+	uint32_t Submit();
+
+private:
+	VkDevice m_Device;
+	DeviceAllocator& m_DeviceAllocator;
+	VkCommandPool m_CommandPool;
+	VkQueue m_Queue;
+	VkFormat m_DepthFormat;
+	VkImage m_DepthImage;					// Only allocated while bakes are recorded, every bake clears it
+	DeviceAllocation m_DepthMemory;
+	VkImageView m_DepthImageView;
+	VkRenderPass m_RenderPass;
+	VkPipelineLayout m_PipelineLayout;
+	VkPipeline m_Pipeline;
+	VkCommandBuffer m_CommandBuffer;		// VK_NULL_HANDLE while nothing is recorded
+	std::vector<VkFramebuffer> m_FrameBuffers;	// Of the recorded bakes, destroyed once they ran
+
+	VkRenderPass CreateRenderPass() const;
+	VkPipeline CreatePipeline(VkShaderModule vertexShader, VkShaderModule fragmentShader) const;
+	void CreateDepthBuffer();
+	void DestroyDepthBuffer();
+};
+
+// View projection matrix of one atlas frame, looking at the bounding sphere from the frame its octahedral direction
+glm::mat4 GetImpostorFrameMatrix
+(
+	const BoundingSphere& boundingSphere,
+	uint32_t frameX,
+	uint32_t frameY
+);
+
+#endif
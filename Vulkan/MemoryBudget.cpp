@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+#include "MemoryBudget.h"
+
+MemoryBudget::MemoryBudget(VkPhysicalDevice physicalDevice, bool budgetExtension) :
+	m_PhysicalDevice{ physicalDevice },
+	m_BudgetExtension{ budgetExtension },
+	m_HeapCount{},
+	m_HeapSizes{},
+	m_Budgets{},
+	m_ProcessUsages{},
+	m_DeviceMemoryBytes{},
+	m_UpdateDeviceMemoryBytes{},
+	m_AllocatedBytes{},
+	m_CategoryBytes{},
+	m_Evictables{},
+	m_UnusedEvictables{},
+	m_UseCount{},
+	m_EvictionCount{},
+	m_RestoreCount{}
+{
+	VkPhysicalDeviceMemoryProperties memoryProperties{};
+	vkGetPhysicalDeviceMemoryProperties(m_PhysicalDevice, &memoryProperties);
+
+	m_HeapCount = memoryProperties.memoryHeapCount;
+	for (uint32_t i{}; i < m_HeapCount; ++i)
+	{
+		m_HeapSizes.at(i) = memoryProperties.memoryHeaps[i].size;
+		m_Budgets.at(i) = static_cast<VkDeviceSize>(double(m_HeapSizes.at(i)) * g_MemoryHeapBudgetFallback);
+	}
+
+	Update();
+}
+
+void MemoryBudget::AddDeviceMemory(uint32_t heap, VkDeviceSize size)
+{
+	m_DeviceMemoryBytes.at(heap) += size;
+}
+
+void MemoryBudget::RemoveDeviceMemory(uint32_t heap, VkDeviceSize size)
+{
+	m_DeviceMemoryBytes.at(heap) -= size;
+}
+
+void MemoryBudget::AddAllocation(MemoryCategory category, uint32_t heap, VkDeviceSize size)
+{
+	m_AllocatedBytes.at(heap) += size;
+	m_CategoryBytes.at(static_cast<size_t>(category)) += size;
+}
+
+void MemoryBudget::RemoveAllocation(MemoryCategory category, uint32_t heap, VkDeviceSize size)
+{
+	m_AllocatedBytes.at(heap) -= size;
+	m_CategoryBytes.at(static_cast<size_t>(category)) -= size;
+}
+
+void MemoryBudget::Update()
+{
+	if (!m_BudgetExtension) return;
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPhysicalDeviceMemoryBudgetPropertiesEXT.html
+	VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+	budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPhysicalDeviceMemoryProperties2.html
+	VkPhysicalDeviceMemoryProperties2 memoryProperties{};
+	memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+	memoryProperties.pNext = &budgetProperties;
+
+	vkGetPhysicalDeviceMemoryProperties2(m_PhysicalDevice, &memoryProperties);
+
+	for (uint32_t i{}; i < m_HeapCount; ++i)
+	{
+		// Some drivers leave the budget of heaps they don't manage at zero, those keep the fallback
+		if (budgetProperties.heapBudget[i] != 0) m_Budgets.at(i) = std::min(budgetProperties.heapBudget[i], m_HeapSizes.at(i));
+		m_ProcessUsages.at(i) = budgetProperties.heapUsage[i];
+		m_UpdateDeviceMemoryBytes.at(i) = m_DeviceMemoryBytes.at(i);
+	}
+}
+
+uint32_t MemoryBudget::RegisterEvictable(uint32_t heap, VkDeviceSize size, EvictionCallback callback, RestoreCallback restore)
+{
+	const Evictable evictable{ heap, size, std::move(callback), std::move(restore), ++m_UseCount, true };
+
+	if (m_UnusedEvictables.empty())
+	{
+		m_Evictables.push_back(evictable);
+		return static_cast<uint32_t>(m_Evictables.size() - 1);
+	}
+
+	const uint32_t slot{ m_UnusedEvictables.back() };
+	m_UnusedEvictables.pop_back();
+	m_Evictables.at(slot) = evictable;
+	return slot;
+}
+
+void MemoryBudget::UnregisterEvictable(uint32_t evictable)
+{
+	m_Evictables.at(evictable).Callback = nullptr;
+	m_Evictables.at(evictable).Restore = nullptr;
+	m_UnusedEvictables.push_back(evictable);
+}
+
+void MemoryBudget::Touch(uint32_t evictable)
+{
+	m_Evictables.at(evictable).LastUse = ++m_UseCount;
+}
+
+bool MemoryBudget::CanEvict() const
+{
+	return std::any_of(m_Evictables.begin(), m_Evictables.end(), [this](const Evictable& evictable) { return evictable.Resident and evictable.Callback and IsNearBudget(evictable.Heap); });
+}
+
+uint32_t MemoryBudget::Evict()
+{
+	uint32_t evictedCount{};
+
+	while (true)
+	{
+		// A handful of resources at most, a linear search for the oldest beats keeping a list sorted on every touch
+		auto oldest{ m_Evictables.end() };
+		for (auto it{ m_Evictables.begin() }; it != m_Evictables.end(); ++it)
+		{
+			if (!it->Resident or !it->Callback or !IsNearBudget(it->Heap)) continue;
+			if (oldest == m_Evictables.end() or it->LastUse < oldest->LastUse) oldest = it;
+		}
+		if (oldest == m_Evictables.end()) break;
+
+		// The slot stays registered until its owner unregisters it, the callback is free to touch the budget
+		oldest->Resident = false;
+		const EvictionCallback callback{ oldest->Callback };
+		callback();
+
+		++evictedCount;
+	}
+
+	m_EvictionCount += evictedCount;
+	return evictedCount;
+}
+
+bool MemoryBudget::CanRestore() const
+{
+	return std::any_of(m_Evictables.begin(), m_Evictables.end(), [this](const Evictable& evictable) { return !evictable.Resident and evictable.Restore and HasRoom(evictable); });
+}
+
+uint32_t MemoryBudget::Restore()
+{
+	uint32_t restoredCount{};
+
+	while (true)
+	{
+		// The ones used last before they got evicted are the likeliest to be needed again
+		auto newest{ m_Evictables.end() };
+		for (auto it{ m_Evictables.begin() }; it != m_Evictables.end(); ++it)
+		{
+			if (it->Resident or !it->Restore or !HasRoom(*it)) continue;
+			if (newest == m_Evictables.end() or it->LastUse > newest->LastUse) newest = it;
+		}
+		if (newest == m_Evictables.end()) break;
+
+		// Counts as used so it isn't the first to go at the next eviction
+		newest->Resident = true;
+		newest->LastUse = ++m_UseCount;
+		const RestoreCallback restore{ newest->Restore };
+		restore();
+
+		++restoredCount;
+	}
+
+	m_RestoreCount += restoredCount;
+	return restoredCount;
+}
+
+bool MemoryBudget::IsNearBudget(uint32_t heap) const
+{
+	return double(GetUsage(heap)) >= double(GetBudget(heap)) * g_MemoryEvictionThreshold;
+}
+
+VkDeviceSize MemoryBudget::GetBudget(uint32_t heap) const
+{
+	return m_Budgets.at(heap);
+}
+
+VkDeviceSize MemoryBudget::GetUsage(uint32_t heap) const
+{
+	// Between updates our own allocations get added on top of what the driver reported last
+	VkDeviceSize usage{ m_DeviceMemoryBytes.at(heap) };
+	if (m_BudgetExtension) usage = std::max(m_ProcessUsages.at(heap) + m_DeviceMemoryBytes.at(heap), m_UpdateDeviceMemoryBytes.at(heap)) - m_UpdateDeviceMemoryBytes.at(heap);
+
+	// Free space inside the blocks is ours to reuse, evicting to make room for it would gain nothing
+	const VkDeviceSize reusableBytes{ m_DeviceMemoryBytes.at(heap) - m_AllocatedBytes.at(heap) };
+	return (usage > reusableBytes) ? usage - reusableBytes : 0;
+}
+
+VkDeviceSize MemoryBudget::GetCategoryUsage(MemoryCategory category) const
+{
+	return m_CategoryBytes.at(static_cast<size_t>(category));
+}
+
+void MemoryBudget::PrintStatistics() const
+{
+	std::cout << "-----Memory Budget-----" << std::endl;
+	std::cout << "Budgets from " << ((m_BudgetExtension) ? "VK_EXT_memory_budget" : "the heap sizes") << std::endl;
+
+	std::cout << std::fixed << std::setprecision(1);
+	for (uint32_t i{}; i < m_HeapCount; ++i)
+	{
+		const std::string name{ "Heap " + std::to_string(i) };
+		std::cout << std::setw(16) << std::left << name << double(GetUsage(i)) / 1048576.0 << " of " << double(GetBudget(i)) / 1048576.0 << " MiB budget, heap "
+			<< double(m_HeapSizes.at(i)) / 1048576.0 << " MiB" << ((IsNearBudget(i)) ? ", near budget" : "") << std::endl;
+	}
+
+	for (size_t i{}; i < g_MemoryCategoryCount; ++i)
+	{
+		std::cout << std::setw(16) << std::left << GetMemoryCategoryName(static_cast<MemoryCategory>(i)) << double(m_CategoryBytes.at(i)) / 1048576.0 << " MiB" << std::endl;
+	}
+	std::cout << std::defaultfloat;
+
+	std::cout << m_EvictionCount << " resources evicted, " << m_RestoreCount << " restored" << std::endl << std::endl;
+}
+
+bool MemoryBudget::HasRoom(const Evictable& evictable) const
+{
+	return double(GetUsage(evictable.Heap) + evictable.Size) < double(GetBudget(evictable.Heap)) * g_MemoryRestoreThreshold;
+}
+
+const char* GetMemoryCategoryName
+(
+	MemoryCategory category
+)
+{
+	switch (category)
+	{
+	case MemoryCategory::Geometry: return "Geometry";
+	case MemoryCategory::Textures: return "Textures";
+	case MemoryCategory::Attachments: return "Attachments";
+	case MemoryCategory::Uniforms: return "Uniforms";
+	case MemoryCategory::Staging: return "Staging";
+	}
+
+	return "Unknown";
+}
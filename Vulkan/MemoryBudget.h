@@ -0,0 +1,118 @@
+#ifndef MEMORY_BUDGET
+#define MEMORY_BUDGET
+
+#include <vulkan.hpp>
+#include <functional>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+// What a resource is used for, every device allocation is tracked under one of these
+enum class MemoryCategory
+{
+	Geometry,
+	Textures,
+	Attachments,
+	Uniforms,
+	Staging
+};
+
+constexpr size_t g_MemoryCategoryCount{ 5 };
+
+// Part of the budget a heap can use before the least recently used resources on it get evicted
+constexpr double g_MemoryEvictionThreshold{ 0.9 };
+
+// Part of the budget a heap has to stay below with an evicted resource restored, lower than the eviction threshold so
+// a restored resource doesn't get evicted again right away
+constexpr double g_MemoryRestoreThreshold{ 0.75 };
+
+// Part of the heap size used as budget when the driver doesn't report one through VK_EXT_memory_budget
+constexpr double g_MemoryHeapBudgetFallback{ 0.8 };
+
+// Releases the memory of one resource, only gets called while the device is idle
+using EvictionCallback = std::function<void()>;
+// Brings an evicted resource back, only gets called while the device is idle
+using RestoreCallback = std::function<void()>;
+
+// Resource that can give up its memory when the heap it lives on runs out of budget
+struct Evictable final
+{
+	uint32_t Heap;
+	VkDeviceSize Size;					// Bytes restoring it takes
+	EvictionCallback Callback;			// Empty once unregistered, its slot gets reused
+	RestoreCallback Restore;			// Empty when an evicted resource doesn't come back
+	uint64_t LastUse;
+	bool Resident;
+};
+
+// Keeps track of how much memory every heap and category uses against the budget of the heap.
+// The budget comes from VK_EXT_memory_budget when the device has it, otherwise it is a part of the heap size.
+class MemoryBudget final
+{
+public:
+	MemoryBudget(VkPhysicalDevice physicalDevice, bool budgetExtension);
+
+	MemoryBudget(const MemoryBudget&) = delete;
+	MemoryBudget& operator=(const MemoryBudget&) = delete;
+	MemoryBudget(MemoryBudget&&) = delete;
+	MemoryBudget& operator=(MemoryBudget&&) = delete;
+
+	// Reported by the device allocator for every vkAllocateMemory and vkFreeMemory
+	void AddDeviceMemory(uint32_t heap, VkDeviceSize size);
+	void RemoveDeviceMemory(uint32_t heap, VkDeviceSize size);
+	// Reported by the device allocator for every resource, blocks and dedicated allocations alike
+	void AddAllocation(MemoryCategory category, uint32_t heap, VkDeviceSize size);
+	void RemoveAllocation(MemoryCategory category, uint32_t heap, VkDeviceSize size);
+
+	// Fetches the budgets and the usage of the whole process from the driver, once per frame is plenty
+	void Update();
+
+	// Returns the handle Touch and UnregisterEvictable take, without a restore callback an evicted resource stays evicted
+	uint32_t RegisterEvictable(uint32_t heap, VkDeviceSize size, EvictionCallback callback, RestoreCallback restore = nullptr);
+	void UnregisterEvictable(uint32_t evictable);
+	// Marks the resource as used, the ones untouched the longest get evicted first
+	void Touch(uint32_t evictable);
+
+	// True when a heap near its budget has resources left to evict
+	bool CanEvict() const;
+	// Calls the eviction callbacks in least recently used order until every heap is below the threshold, returns how many got evicted
+	uint32_t Evict();
+	// True when an evicted resource fits on its heap again
+	bool CanRestore() const;
+	// Calls the restore callbacks in most recently used order as long as they fit below the restore threshold, returns how many got restored
+	uint32_t Restore();
+
+	bool IsNearBudget(uint32_t heap) const;
+	VkDeviceSize GetBudget(uint32_t heap) const;
+	// Memory of the heap in use, free space inside the blocks of the device allocator not included
+	VkDeviceSize GetUsage(uint32_t heap) const;
+	VkDeviceSize GetCategoryUsage(MemoryCategory category) const;
+	void PrintStatistics() const;
+
+private:
+	VkPhysicalDevice m_PhysicalDevice;
+	bool m_BudgetExtension;
+	uint32_t m_HeapCount;
+	std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_HeapSizes;
+	std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_Budgets;
+	std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_ProcessUsages;				// Reported by the driver at the last update
+	std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_DeviceMemoryBytes;			// Ours, blocks and dedicated allocations
+	std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_UpdateDeviceMemoryBytes;	// Ours at the last update
+	std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_AllocatedBytes;				// Handed out to resources
+	std::array<VkDeviceSize, g_MemoryCategoryCount> m_CategoryBytes;
+	std::vector<Evictable> m_Evictables;
+	std::vector<uint32_t> m_UnusedEvictables;
+	uint64_t m_UseCount;
+	uint32_t m_EvictionCount;
+	uint32_t m_RestoreCount;
+
+	bool HasRoom(const Evictable& evictable) const;
+};
+
+// Name of the category for the statistics
+const char* GetMemoryCategoryName
+(
+	MemoryCategory category
+);
+
+#endif
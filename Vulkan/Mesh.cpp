@@ -1,19 +1,84 @@
 #define TINYOBJLOADER_IMPLEMENTATION
 
 #include <tiny_obj_loader.h>
-#include <unordered_map>
+#include <thread>
+#include <algorithm>
 #include <glm.hpp>
 #include <gtc/matrix_transform.hpp>
 #include <iostream>
+#include <chrono>
+#include <cmath>
+#include <limits>
 
 #include "Mesh.h"
+#include "MeshCache.h"
+#include "VertexWeldTable.h"
+#include "MeshOptimizer.h"
 #include "HelperFunctions.h"
 #include "Camera.h"
 
+namespace
+{
+	glm::vec3 CalculateFaceTangent(const Vertex& vertex0, const Vertex& vertex1, const Vertex& vertex2)
+	{
+		// Calculate edges of the triangle
+		const glm::vec3 edge1{ vertex1.Position - vertex0.Position };
+		const glm::vec3 edge2{ vertex2.Position - vertex0.Position };
+
+		// Calculate the difference in UV coordinates
+		const glm::vec2 deltaUV1{ vertex1.TextureCoordinates - vertex0.TextureCoordinates };
+		const glm::vec2 deltaUV2{ vertex2.TextureCoordinates - vertex0.TextureCoordinates };
+
+		const float f{ 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y) };
+
+		glm::vec3 tangent{};
+		tangent.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
+		tangent.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
+		tangent.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
+
+		return tangent;
+	}
+
+	// Gives the level its own copies of the vertices it uses, their tangents are the sum of the level its triangles around them.
+	// Collapsed and uv degenerate triangles add nothing, a vertex left without any keeps the tangent it was copied from
+	void AppendLodVertices(std::vector<uint32_t>& indices, std::vector<Vertex>& vertices)
+	{
+		constexpr uint32_t unused{ std::numeric_limits<uint32_t>::max() };
+		std::vector<uint32_t> remap(vertices.size(), unused);
+		const size_t firstVertex{ vertices.size() };
+
+		for (uint32_t& index : indices)
+		{
+			if (remap[index] == unused)
+			{
+				remap[index] = static_cast<uint32_t>(vertices.size());
+				vertices.push_back(vertices[index]);
+			}
+
+			index = remap[index];
+		}
+
+		std::vector<glm::vec3> tangents(vertices.size() - firstVertex, glm::vec3{ 0.0f });
+		for (size_t i{}; i + 2 < indices.size(); i += 3)
+		{
+			const glm::vec3 tangent{ CalculateFaceTangent(vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]]) };
+			if (not std::isfinite(tangent.x) or not std::isfinite(tangent.y) or not std::isfinite(tangent.z)) continue;
+
+			for (size_t j{}; j < 3; ++j) tangents[indices[i + j] - firstVertex] += tangent;
+		}
+
+		for (size_t i{}; i < tangents.size(); ++i)
+		{
+			const float length{ glm::length(tangents[i]) };
+			if (length > 0.0f) vertices[firstVertex + i].Tangent = tangents[i] / length;
+		}
+	}
+}
+
 bool Vertex::operator==(const Vertex& other) const
 {
 	return (Position == other.Position) and (Color == other.Color) and (TextureCoordinates == other.TextureCoordinates)
-		and (Tangent == other.Tangent);
+		and (Normal == other.Normal) and (Tangent == other.Tangent);
 }
 
 VkVertexInputBindingDescription Vertex::GetBindingDescription()
@@ -111,56 +176,93 @@ size_t std::hash<Vertex>::operator()(const Vertex& vertex) const
 	return hashValue;
 }
 
-Mesh::Mesh(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool copyCommandPool, VkQueue copyQueue, const std::filesystem::path& path) :
-	m_PhysicalDevice{ physicalDevice },
-	m_Device{ device },
-	m_CopyCommandPool{ copyCommandPool },
-	m_CopyQueue{ copyQueue },
+uint64_t MeshLoadSettings::GetProcessingKey() const
+{
+	// Every setting goes in at full precision, settings a disabled step would use count as zero so changing them doesn't rebuild the cache
+	const std::array<uint8_t, 4> flags{ OptimizeVertexCache, OptimizeOverdraw, OptimizeVertexFetch, BuildMeshlets };
+	const float overdrawThreshold{ (OptimizeOverdraw) ? OverdrawThreshold : 0.0f };
+	const float lodReduction{ (LodCount > 1) ? LodReduction : 0.0f };
+	const float lodMaxError{ (LodCount > 1) ? LodMaxError : 0.0f };
+
+	uint64_t key{ HashBytes(flags.data(), flags.size()) };
+	key = HashBytes(&overdrawThreshold, sizeof(float), key);
+	key = HashBytes(&LodCount, sizeof(uint32_t), key);
+	key = HashBytes(&lodReduction, sizeof(float), key);
+	key = HashBytes(&lodMaxError, sizeof(float), key);
+
+	return key;
+}
+
+Mesh::Mesh(GeometryArena& geometryArena, const std::filesystem::path& path, const MeshLoadSettings& settings) :
+	m_GeometryArena{ geometryArena },
 	m_Vertices{},
-	m_VertexBuffer{},
-	m_VertexBufferMemory{},
+	m_VertexAllocation{},
 	m_Indices{},
-	m_IndexBuffer{},
-	m_IndexBufferMemory{},
+	m_IndexAllocation{},
+	m_IndexType{ VK_INDEX_TYPE_UINT32 },
+	m_Meshlets{},
+	m_Lods{},
+	m_BoundingSphere{},
+	m_BoundingBox{},
 	m_ModelMatrix{ 1.0f },
 	m_Rotate{ true }
 {
-	LoadMesh(path);
-	if (CreateVertexBuffer() != VK_SUCCESS) throw std::runtime_error("Failed to create vertex buffer!");
-	if (CreateIndexBuffer() != VK_SUCCESS) throw std::runtime_error("Failed to create index buffer!");
+	const auto startTime{ std::chrono::high_resolution_clock::now() };
+
+	MeshCacheView cache{};
+	const bool cacheHit{ OpenMeshCache(path, settings.GetProcessingKey(), cache) and DecodeMeshCache(cache, m_Vertices, m_Indices) };
+
+	if (cacheHit)
+	{
+		// Warm cache, the streams got decoded straight from the mapped file
+		m_Meshlets.assign(cache.Meshlets, cache.Meshlets + cache.MeshletCount);
+		m_Lods.assign(cache.Lods, cache.Lods + cache.LodCount);
+	}
+	else
+	{
+		m_Vertices.clear();
+		m_Indices.clear();
+
+		LoadMesh(path, settings);
+		if (!WriteMeshCache(path, settings.GetProcessingKey(), m_Vertices, m_Indices, m_Meshlets, m_Lods)) std::cerr << "Failed to write mesh cache for " << path.string() << std::endl;
+	}
+
+	if (AddToGeometryArena() != VK_SUCCESS) throw std::runtime_error("Failed to add mesh to the geometry arena!");
+
+	CalculateBounds();
+
+	const std::chrono::duration<float, std::milli> loadTime{ std::chrono::high_resolution_clock::now() - startTime };
+	std::cout << "Loaded " << path.string() << ((cacheHit) ? " from cache" : " from source") << " in " << loadTime.count() << " ms" << std::endl;
 }
 
-Mesh::Mesh(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool copyCommandPool, VkQueue copyQueue, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) :
-	m_PhysicalDevice{ physicalDevice },
-	m_Device{ device },
-	m_CopyCommandPool{ copyCommandPool },
-	m_CopyQueue{ copyQueue },
+Mesh::Mesh(GeometryArena& geometryArena, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) :
+	m_GeometryArena{ geometryArena },
 	m_Vertices{ vertices },
-	m_VertexBuffer{},
-	m_VertexBufferMemory{},
+	m_VertexAllocation{},
 	m_Indices{ indices },
-	m_IndexBuffer{},
-	m_IndexBufferMemory{},
+	m_IndexAllocation{},
+	m_IndexType{ VK_INDEX_TYPE_UINT32 },
+	m_Meshlets{},
+	m_Lods{ MeshLod{ 0, static_cast<uint32_t>(indices.size()), 0.0f } },
+	m_BoundingSphere{},
+	m_BoundingBox{},
 	m_ModelMatrix{ 1.0f }
 {
-	if (CreateVertexBuffer() != VK_SUCCESS) throw std::runtime_error("Failed to create vertex buffer!");
-	if (CreateIndexBuffer() != VK_SUCCESS) throw std::runtime_error("Failed to create index buffer!");
+	CalculateBounds();
+
+	if (AddToGeometryArena() != VK_SUCCESS) throw std::runtime_error("Failed to add mesh to the geometry arena!");
 }
 
 Mesh::~Mesh()
 {
-	// Vertex buffer
-	vkDestroyBuffer(m_Device, m_VertexBuffer, nullptr);
-	vkFreeMemory(m_Device, m_VertexBufferMemory, nullptr);
-
-	// Index buffer
-	vkDestroyBuffer(m_Device, m_IndexBuffer, nullptr);
-	vkFreeMemory(m_Device, m_IndexBufferMemory, nullptr);
+	// The arena buffers outlive the mesh, only its ranges get handed back
+	m_GeometryArena.RemoveVertices(m_VertexAllocation);
+	m_GeometryArena.RemoveIndices(m_IndexAllocation, m_IndexType);
 }
 
-void Mesh::Update(std::chrono::duration<float> elapsedSeconds)
+bool Mesh::Update(std::chrono::duration<float> elapsedSeconds)
 {
-	if (!m_Rotate) return;
+	if (!m_Rotate) return false;
 
 	// Calculate total rotation angle for 2 seconds
 	constexpr float totalRotationDegrees = 360.0f; // Rotate fully in 2 seconds
@@ -171,6 +273,8 @@ void Mesh::Update(std::chrono::duration<float> elapsedSeconds)
 
 	// Apply rotation to the model matrix
 	m_ModelMatrix = glm::rotate(m_ModelMatrix, glm::radians(rotationAngle), g_WorldRight);
+
+	return true;
 }
 
 
@@ -181,17 +285,57 @@ const std::vector<Vertex>& Mesh::GetVertices() const
 
 VkBuffer Mesh::GetVertexBuffer() const
 {
-	return m_VertexBuffer;
+	return m_GeometryArena.GetVertexBuffer();
 }
 
-const std::vector<uint32_t> Mesh::GetIndices() const
+int32_t Mesh::GetVertexOffset() const
+{
+	return static_cast<int32_t>(m_VertexAllocation.Offset);
+}
+
+const std::vector<uint32_t>& Mesh::GetIndices() const
 {
 	return m_Indices;
 }
 
+uint32_t Mesh::GetIndexCount() const
+{
+	return static_cast<uint32_t>(m_Indices.size());
+}
+
 VkBuffer Mesh::GetIndexBuffer() const
 {
-	return m_IndexBuffer;
+	return m_GeometryArena.GetIndexBuffer(m_IndexType);
+}
+
+uint32_t Mesh::GetFirstIndex() const
+{
+	return m_IndexAllocation.Offset;
+}
+
+VkIndexType Mesh::GetIndexType() const
+{
+	return m_IndexType;
+}
+
+const std::vector<Meshlet>& Mesh::GetMeshlets() const
+{
+	return m_Meshlets;
+}
+
+const std::vector<MeshLod>& Mesh::GetLods() const
+{
+	return m_Lods;
+}
+
+const BoundingSphere& Mesh::GetBoundingSphere() const
+{
+	return m_BoundingSphere;
+}
+
+const BoundingBox& Mesh::GetBoundingBox() const
+{
+	return m_BoundingBox;
 }
 
 glm::mat4 Mesh::GetModelMatrix() const
@@ -209,206 +353,354 @@ void Mesh::SwitchRotate()
 	m_Rotate = !m_Rotate;
 }
 
-VkResult Mesh::CreateVertexBuffer()
+VkResult Mesh::AddToGeometryArena()
 {
-	VkResult result{};
+	// Small meshes get 16 bit indices, half the memory and index fetch bandwidth, they stay relative to the vertex offset
+	m_IndexType = (m_Vertices.size() <= g_MaxUInt16IndexedVertices) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
 
-	VkBuffer vertexStagingBuffer{};
-	VkDeviceMemory vertexStagingBufferMemory{};
+	if (!m_GeometryArena.AddVertices(m_Vertices.data(), static_cast<uint32_t>(m_Vertices.size()), m_VertexAllocation)) return VK_ERROR_OUT_OF_DEVICE_MEMORY;
 
-	CreateBuffer
-	(
-		m_PhysicalDevice, 
-		m_Device, 
-		sizeof(Vertex) * m_Vertices.size(),
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
-		vertexStagingBuffer, 
-		vertexStagingBufferMemory
-	);
-
-	void* data{};
-	result = vkMapMemory(m_Device, vertexStagingBufferMemory, 0, sizeof(Vertex) * m_Vertices.size(), 0, &data);
-	memcpy(data, m_Vertices.data(), sizeof(Vertex) * m_Vertices.size());
-	vkUnmapMemory(m_Device, vertexStagingBufferMemory);
-
-	CreateBuffer
-	(
-		m_PhysicalDevice,
-		m_Device,
-		sizeof(Vertex) * m_Vertices.size(),
-		VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		m_VertexBuffer,
-		m_VertexBufferMemory
-	);
-
-	CopyBuffer(m_Device, vertexStagingBuffer, m_VertexBuffer, sizeof(Vertex) * m_Vertices.size(), m_CopyCommandPool, m_CopyQueue);
+	if (!m_GeometryArena.AddIndices(m_Indices.data(), static_cast<uint32_t>(m_Indices.size()), m_IndexType, m_IndexAllocation))
+	{
+		m_GeometryArena.RemoveVertices(m_VertexAllocation);
+		m_VertexAllocation = GeometryAllocation{};
 
-	vkDestroyBuffer(m_Device, vertexStagingBuffer, nullptr);
-	vkFreeMemory(m_Device, vertexStagingBufferMemory, nullptr);
+		return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+	}
 
-	return result;
+	return VK_SUCCESS;
 }
 
-VkResult Mesh::CreateIndexBuffer()
+void Mesh::LoadMesh(const std::filesystem::path& path, const MeshLoadSettings& settings)
 {
-	VkResult result{};
+	LoadObj(path, settings.ThreadCount, m_Vertices, m_Indices);
 
-	const size_t bufferSize{ sizeof(uint32_t) * m_Indices.size() };
+	if (settings.OptimizeVertexCache)
+	{
+		const float acmrBefore{ CalculateACMR(m_Indices, m_Vertices.size()) };
+		OptimizeVertexCache(m_Indices, m_Vertices.size());
+		const float acmrAfter{ CalculateACMR(m_Indices, m_Vertices.size()) };
 
-	VkBuffer indexStagingBuffer{};
-	VkDeviceMemory indexStagingBufferMemory{};
+		std::cout << path.string() << " vertex cache ACMR " << acmrBefore << " -> " << acmrAfter << std::endl;
+	}
 
-	CreateBuffer
-	(
-		m_PhysicalDevice,
-		m_Device,
-		bufferSize,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		indexStagingBuffer,
-		indexStagingBufferMemory
-	);
-
-	void* data{};
-	result = vkMapMemory(m_Device, indexStagingBufferMemory, 0, bufferSize, 0, &data);
-	memcpy(data, m_Indices.data(), bufferSize);
-	vkUnmapMemory(m_Device, indexStagingBufferMemory);
-
-	CreateBuffer
-	(
-		m_PhysicalDevice,
-		m_Device,
-		bufferSize,
-		VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		m_IndexBuffer,
-		m_IndexBufferMemory
-	);
+	if (settings.OptimizeOverdraw)
+	{
+		const float overdrawBefore{ CalculateOverdraw(m_Indices, m_Vertices) };
+		OptimizeOverdraw(m_Indices, m_Vertices, settings.OverdrawThreshold);
+		const float overdrawAfter{ CalculateOverdraw(m_Indices, m_Vertices) };
+
+		std::cout << path.string() << " overdraw " << overdrawBefore << " -> " << overdrawAfter << ", ACMR " << CalculateACMR(m_Indices, m_Vertices.size()) << std::endl;
+	}
+
+	if (settings.BuildMeshlets)
+	{
+		m_Meshlets = ::BuildMeshlets(m_Indices, m_Vertices);
 
-	CopyBuffer(m_Device, indexStagingBuffer, m_IndexBuffer, bufferSize, m_CopyCommandPool, m_CopyQueue);
+		std::cout << path.string() << " " << m_Meshlets.size() << " meshlets, ACMR " << CalculateACMR(m_Indices, m_Vertices.size()) << std::endl;
+	}
+
+	// Every level gets appended behind the full mesh, so the meshlet ranges stay valid
+	m_Lods.assign(1, MeshLod{ 0, static_cast<uint32_t>(m_Indices.size()), 0.0f });
+	if (settings.LodCount > 1) GenerateLods(path, settings);
 
-	vkDestroyBuffer(m_Device, indexStagingBuffer, nullptr);
-	vkFreeMemory(m_Device, indexStagingBufferMemory, nullptr);
+	if (settings.OptimizeVertexFetch)
+	{
+		const float strideBefore{ CalculateFetchStride(m_Indices, m_Vertices.size(), sizeof(Vertex)) };
+		OptimizeVertexFetch(m_Indices, m_Vertices);
+		const float strideAfter{ CalculateFetchStride(m_Indices, m_Vertices.size(), sizeof(Vertex)) };
 
-	return result;
+		std::cout << path.string() << " average vertex fetch stride " << strideBefore << " -> " << strideAfter << " bytes" << std::endl;
+	}
 }
 
-void Mesh::LoadMesh(const std::filesystem::path& path) {
-	if (!std::filesystem::exists(path)) throw std::runtime_error("Invalid texture file path given!");
+void Mesh::GenerateLods(const std::filesystem::path& path, const MeshLoadSettings& settings)
+{
+	CalculateBounds();
+
+	// Every level gets simplified from the full mesh, so the errors don't stack up over the chain.
+	// The vertices levels append are never used by the full mesh, the simplifier skips them
+	const std::vector<uint32_t> fullIndices{ m_Indices };
+	const float maxError{ settings.LodMaxError * m_BoundingSphere.Radius };
 
-	tinyobj::attrib_t attributes{};
-	std::vector<tinyobj::shape_t> shapes{};
-	std::vector<tinyobj::material_t> materials{};
-	std::string error{};
+	for (uint32_t level{ 1 }; level < settings.LodCount; ++level)
+	{
+		const size_t previousIndexCount{ m_Lods.back().IndexCount };
+		const size_t targetIndexCount{ size_t(double(fullIndices.size()) * std::pow(double(settings.LodReduction), double(level))) / 3 * 3 };
+
+		float error{};
+		std::vector<uint32_t> lodIndices{ SimplifyMesh(fullIndices, m_Vertices, targetIndexCount, maxError, error) };
+
+		// A level that barely removes anything is not worth switching to
+		if (lodIndices.empty() or float(lodIndices.size()) > float(previousIndexCount) * 0.9f) break;
 
-	if (!tinyobj::LoadObj(&attributes, &shapes, &materials, &error, path.string().c_str())) {
-		throw std::runtime_error(error);
+		AppendLodVertices(lodIndices, m_Vertices);
+		if (settings.OptimizeVertexCache) OptimizeVertexCache(lodIndices, m_Vertices.size());
+
+		m_Lods.push_back(MeshLod{ static_cast<uint32_t>(m_Indices.size()), static_cast<uint32_t>(lodIndices.size()), error });
+		m_Indices.insert(m_Indices.end(), lodIndices.begin(), lodIndices.end());
+
+		std::cout << path.string() << " lod " << level << " " << lodIndices.size() / 3 << " triangles, error " << error << std::endl;
 	}
+}
 
-	std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+void Mesh::CalculateBounds()
+{
+	if (m_Vertices.empty()) return;
 
-	for (const auto& shape : shapes) {
-		for (size_t i = 0; i < shape.mesh.indices.size(); i += 3) {
-			// Indices for the triangle
-			tinyobj::index_t idx0 = shape.mesh.indices[i];
-			tinyobj::index_t idx1 = shape.mesh.indices[i + 1];
-			tinyobj::index_t idx2 = shape.mesh.indices[i + 2];
+	glm::vec3 minimum{ m_Vertices.front().Position };
+	glm::vec3 maximum{ minimum };
+	for (const Vertex& vertex : m_Vertices)
+	{
+		minimum = glm::min(minimum, vertex.Position);
+		maximum = glm::max(maximum, vertex.Position);
+	}
 
-			// Vertices of the triangle
-			Vertex vertex0 = {};
-			Vertex vertex1 = {};
-			Vertex vertex2 = {};
+	m_BoundingBox = BoundingBox{ minimum, maximum };
 
-			vertex0.Position = glm::vec3(
-				attributes.vertices[3 * idx0.vertex_index + 0],
-				attributes.vertices[3 * idx0.vertex_index + 1],
-				attributes.vertices[3 * idx0.vertex_index + 2]
-			);
-			vertex1.Position = glm::vec3(
-				attributes.vertices[3 * idx1.vertex_index + 0],
-				attributes.vertices[3 * idx1.vertex_index + 1],
-				attributes.vertices[3 * idx1.vertex_index + 2]
-			);
-			vertex2.Position = glm::vec3(
-				attributes.vertices[3 * idx2.vertex_index + 0],
-				attributes.vertices[3 * idx2.vertex_index + 1],
-				attributes.vertices[3 * idx2.vertex_index + 2]
-			);
+	m_BoundingSphere.Center = (minimum + maximum) * 0.5f;
+	m_BoundingSphere.Radius = 0.0f;
+	for (const Vertex& vertex : m_Vertices) m_BoundingSphere.Radius = std::max(m_BoundingSphere.Radius, glm::length(vertex.Position - m_BoundingSphere.Center));
+}
 
-			vertex0.TextureCoordinates = glm::vec2(
-				attributes.texcoords[2 * idx0.texcoord_index + 0],
-				1.0f - attributes.texcoords[2 * idx0.texcoord_index + 1]
-			);
-			vertex1.TextureCoordinates = glm::vec2(
-				attributes.texcoords[2 * idx1.texcoord_index + 0],
-				1.0f - attributes.texcoords[2 * idx1.texcoord_index + 1]
-			);
-			vertex2.TextureCoordinates = glm::vec2(
-				attributes.texcoords[2 * idx2.texcoord_index + 0],
-				1.0f - attributes.texcoords[2 * idx2.texcoord_index + 1]
-			);
+namespace
+{
+	// Vertices and indices of a range of triangles welded on their own, indices are local to the range
+	struct WeldedTriangles final
+	{
+		std::vector<Vertex> Vertices;
+		std::vector<uint32_t> Indices;
+	};
 
-			vertex0.Normal = glm::vec3(
-				attributes.normals[3 * idx0.normal_index + 0],
-				attributes.normals[3 * idx0.normal_index + 1],
-				attributes.normals[3 * idx0.normal_index + 2]
+	void ExpandTriangle(const tinyobj::attrib_t& attributes, const tinyobj::index_t* indices, std::array<Vertex, 3>& vertices)
+	{
+		for (size_t i{}; i < 3; ++i)
+		{
+			const tinyobj::index_t index{ indices[i] };
+			Vertex& vertex{ vertices.at(i) };
+
+			vertex = Vertex{};
+			vertex.Position = glm::vec3(
+				attributes.vertices[3 * index.vertex_index + 0],
+				attributes.vertices[3 * index.vertex_index + 1],
+				attributes.vertices[3 * index.vertex_index + 2]
 			);
-			vertex1.Normal = glm::vec3(
-				attributes.normals[3 * idx1.normal_index + 0],
-				attributes.normals[3 * idx1.normal_index + 1],
-				attributes.normals[3 * idx1.normal_index + 2]
+			vertex.TextureCoordinates = glm::vec2(
+				attributes.texcoords[2 * index.texcoord_index + 0],
+				1.0f - attributes.texcoords[2 * index.texcoord_index + 1]
 			);
-			vertex2.Normal = glm::vec3(
-				attributes.normals[3 * idx2.normal_index + 0],
-				attributes.normals[3 * idx2.normal_index + 1],
-				attributes.normals[3 * idx2.normal_index + 2]
+			vertex.Normal = glm::vec3(
+				attributes.normals[3 * index.normal_index + 0],
+				attributes.normals[3 * index.normal_index + 1],
+				attributes.normals[3 * index.normal_index + 2]
 			);
+		}
 
-			// Calculate edges of the triangle
-			glm::vec3 edge1 = vertex1.Position - vertex0.Position;
-			glm::vec3 edge2 = vertex2.Position - vertex0.Position;
-
-			// Calculate the difference in UV coordinates
-			glm::vec2 deltaUV1 = vertex1.TextureCoordinates - vertex0.TextureCoordinates;
-			glm::vec2 deltaUV2 = vertex2.TextureCoordinates - vertex0.TextureCoordinates;
+		const glm::vec3 tangent{ CalculateFaceTangent(vertices.at(0), vertices.at(1), vertices.at(2)) };
+		for (Vertex& vertex : vertices) vertex.Tangent += tangent;
+	}
 
-			float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
+	void ParseObj
+	(
+		const std::filesystem::path& path,
+		tinyobj::attrib_t& attributes,
+		std::vector<tinyobj::shape_t>& shapes,
+		std::vector<const tinyobj::index_t*>& triangles
+	)
+	{
+		if (!std::filesystem::exists(path)) throw std::runtime_error("Invalid mesh file path given!");
 
-			glm::vec3 tangent;
-			tangent.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
-			tangent.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
-			tangent.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
+		std::vector<tinyobj::material_t> materials{};
+		std::string error{};
 
-			vertex0.Tangent += tangent;
-			vertex1.Tangent += tangent;
-			vertex2.Tangent += tangent;
+		if (!tinyobj::LoadObj(&attributes, &shapes, &materials, &error, path.string().c_str()))
+		{
+			throw std::runtime_error(error);
+		}
 
-			// Insert vertices into the uniqueVertices map and m_Vertices vector
-			if (uniqueVertices.count(vertex0) == 0) {
-				uniqueVertices[vertex0] = static_cast<uint32_t>(m_Vertices.size());
-				m_Vertices.push_back(vertex0);
+		// Flatten the triangles of all shapes so they can be split in ranges independent of shape boundaries
+		for (const auto& shape : shapes)
+		{
+			for (size_t i{}; i + 2 < shape.mesh.indices.size(); i += 3)
+			{
+				triangles.push_back(&shape.mesh.indices[i]);
 			}
+		}
+	}
+
+	// Runs task(i) for every i in [0, count) on its own thread, the calling thread takes the first one
+	template <typename Task>
+	void RunOnWorkers(size_t count, const Task& task)
+	{
+		std::vector<std::thread> workers{};
+		for (size_t i{ 1 }; i < count; ++i) workers.emplace_back(std::cref(task), i);
+		if (count > 0) task(0);
+		for (auto& worker : workers) worker.join();
+	}
 
-			if (uniqueVertices.count(vertex1) == 0) {
-				uniqueVertices[vertex1] = static_cast<uint32_t>(m_Vertices.size());
-				m_Vertices.push_back(vertex1);
+	// Expands and welds triangles [begin, end), unique vertices are stored in order of first use
+	void WeldTriangles
+	(
+		const tinyobj::attrib_t& attributes,
+		const std::vector<const tinyobj::index_t*>& triangles,
+		size_t begin,
+		size_t end,
+		WeldedTriangles& output
+	)
+	{
+		VertexWeldTable uniqueVertices{ (end - begin) * 3 };
+		std::array<Vertex, 3> vertices{};
+
+		output.Indices.reserve((end - begin) * 3);
+
+		for (size_t i{ begin }; i < end; ++i)
+		{
+			ExpandTriangle(attributes, triangles.at(i), vertices);
+
+			for (const Vertex& vertex : vertices)
+			{
+				output.Indices.push_back(uniqueVertices.Insert(vertex, output.Vertices));
 			}
+		}
+	}
+}
+
+void LoadObj
+(
+	const std::filesystem::path& path,
+	uint32_t threadCount,
+	std::vector<Vertex>& vertices,
+	std::vector<uint32_t>& indices
+)
+{
+	tinyobj::attrib_t attributes{};
+	std::vector<tinyobj::shape_t> shapes{};
+	std::vector<const tinyobj::index_t*> triangles{};
+	ParseObj(path, attributes, shapes, triangles);
+
+	// Small meshes are not worth the thread overhead, unless the caller asked for a thread count
+	constexpr size_t minimumTrianglesPerRange{ 4096 };
+	const size_t rangeCount
+	{
+		(threadCount == 0) ?
+		std::clamp<size_t>((triangles.size() + minimumTrianglesPerRange - 1) / minimumTrianglesPerRange, 1, std::max(std::thread::hardware_concurrency(), 1u)) :
+		std::clamp<size_t>(triangles.size(), 1, threadCount)
+	};
+	const size_t trianglesPerRange{ (triangles.size() + rangeCount - 1) / rangeCount };
+
+	std::vector<WeldedTriangles> ranges(rangeCount);
+	RunOnWorkers(rangeCount, [&](size_t i)
+	{
+		WeldTriangles(attributes, triangles, std::min(i * trianglesPerRange, triangles.size()), std::min((i + 1) * trianglesPerRange, triangles.size()), ranges.at(i));
+	});
+
+	// Every range vertex gets a position in the concatenation of all ranges, a serial merge would keep the first position of every vertex in order
+	std::vector<size_t> rangeOffsets(rangeCount + 1);
+	for (size_t i{}; i < rangeCount; ++i) rangeOffsets.at(i + 1) = rangeOffsets.at(i) + ranges.at(i).Vertices.size();
+	const size_t rangeVertexCount{ rangeOffsets.back() };
+
+	// Equal vertices hash the same, so every shard finds the first position of its vertices on its own by going through the ranges in order
+	const size_t shardCount{ rangeCount };
+	std::vector<std::vector<std::vector<uint32_t>>> shardVertices(rangeCount, std::vector<std::vector<uint32_t>>(shardCount));
+	RunOnWorkers(rangeCount, [&](size_t i)
+	{
+		const std::vector<Vertex>& rangeVertices{ ranges.at(i).Vertices };
+		for (size_t j{}; j < rangeVertices.size(); ++j)
+		{
+			// The top bits pick the shard, the weld table probes with the bottom ones
+			const uint64_t hash{ HashVertexBytes(rangeVertices[j]) };
+			shardVertices[i][static_cast<size_t>(((hash >> 32) * shardCount) >> 32)].push_back(static_cast<uint32_t>(j));
+		}
+	});
+
+	std::vector<uint32_t> firstPositions(rangeVertexCount);
+	RunOnWorkers(shardCount, [&](size_t shard)
+	{
+		size_t shardVertexCount{};
+		for (size_t i{}; i < rangeCount; ++i) shardVertexCount += shardVertices[i][shard].size();
+
+		VertexWeldTable uniqueVertices{ shardVertexCount };
+		std::vector<Vertex> shardUniqueVertices{};
+		std::vector<uint32_t> shardFirstPositions{};
+		shardUniqueVertices.reserve(shardVertexCount);
+
+		for (size_t i{}; i < rangeCount; ++i)
+		{
+			for (const uint32_t j : shardVertices[i][shard])
+			{
+				const uint32_t position{ static_cast<uint32_t>(rangeOffsets[i] + j) };
+				const uint32_t unique{ uniqueVertices.Insert(ranges[i].Vertices[j], shardUniqueVertices) };
+				if (unique == shardFirstPositions.size()) shardFirstPositions.push_back(position);
 
-			if (uniqueVertices.count(vertex2) == 0) {
-				uniqueVertices[vertex2] = static_cast<uint32_t>(m_Vertices.size());
-				m_Vertices.push_back(vertex2);
+				firstPositions[position] = shardFirstPositions[unique];
 			}
+		}
+	});
+
+	// Vertices at their first position get numbered in order, every range starts behind the new vertices of the ranges before it
+	std::vector<size_t> vertexOffsets(rangeCount + 1);
+	RunOnWorkers(rangeCount, [&](size_t i)
+	{
+		size_t count{};
+		for (size_t position{ rangeOffsets[i] }; position < rangeOffsets[i + 1]; ++position) count += (firstPositions[position] == position) ? 1 : 0;
+		vertexOffsets[i + 1] = count;
+	});
+	for (size_t i{}; i < rangeCount; ++i) vertexOffsets.at(i + 1) += vertexOffsets.at(i);
+
+	std::vector<uint32_t> positionIndices(rangeVertexCount);
+	vertices.resize(vertexOffsets.back());
+	RunOnWorkers(rangeCount, [&](size_t i)
+	{
+		uint32_t index{ static_cast<uint32_t>(vertexOffsets[i]) };
+		for (size_t j{}; j < ranges[i].Vertices.size(); ++j)
+		{
+			const size_t position{ rangeOffsets[i] + j };
+			if (firstPositions[position] != position) continue;
 
-			m_Indices.push_back(uniqueVertices[vertex0]);
-			m_Indices.push_back(uniqueVertices[vertex1]);
-			m_Indices.push_back(uniqueVertices[vertex2]);
+			positionIndices[position] = index;
+			vertices[index++] = ranges[i].Vertices[j];
 		}
-	}
+	});
+
+	// Every first position got its index above, the local indices of a range can now point at vertices another range added
+	std::vector<size_t> indexOffsets(rangeCount + 1);
+	for (size_t i{}; i < rangeCount; ++i) indexOffsets.at(i + 1) = indexOffsets.at(i) + ranges.at(i).Indices.size();
+
+	indices.resize(indexOffsets.back());
+	RunOnWorkers(rangeCount, [&](size_t i)
+	{
+		const WeldedTriangles& range{ ranges[i] };
+		const size_t rangeOffset{ rangeOffsets[i] };
+		uint32_t* output{ indices.data() + indexOffsets[i] };
+
+		for (size_t j{}; j < range.Indices.size(); ++j) output[j] = positionIndices[firstPositions[rangeOffset + range.Indices[j]]];
+	});
 
 	// Normalize the tangents
-	for (auto& vertex : m_Vertices) {
+	for (auto& vertex : vertices)
+	{
 		vertex.Tangent = glm::normalize(vertex.Tangent);
 	}
 }
+
+void ExpandObj
+(
+	const std::filesystem::path& path,
+	std::vector<Vertex>& corners
+)
+{
+	tinyobj::attrib_t attributes{};
+	std::vector<tinyobj::shape_t> shapes{};
+	std::vector<const tinyobj::index_t*> triangles{};
+	ParseObj(path, attributes, shapes, triangles);
+
+	std::array<Vertex, 3> vertices{};
+
+	corners.clear();
+	corners.reserve(triangles.size() * 3);
+	for (const tinyobj::index_t* triangle : triangles)
+	{
+		ExpandTriangle(attributes, triangle, vertices);
+		corners.insert(corners.end(), vertices.begin(), vertices.end());
+	}
+}
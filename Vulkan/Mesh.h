@@ -7,6 +7,9 @@
 #include <array>
 #include <filesystem>
 
+#include "Meshlet.h"
+#include "GeometryArena.h"
+
 struct Vertex final
 {
 	glm::vec3 Position;
@@ -38,23 +41,75 @@ namespace std
 	};
 }
 
+// Settings for loading and processing a mesh from a file
+struct MeshLoadSettings final
+{
+	uint32_t ThreadCount{ 0 };		// Threads used to ingest the source file, 0 picks up to every hardware thread by file size and 1 is the serial path
+	bool OptimizeVertexCache{ true };	// Reorder triangles for the post transform vertex cache
+	bool OptimizeOverdraw{ true };		// Draw outward facing triangle clusters first, only for opaque meshes
+	float OverdrawThreshold{ 1.05f };	// Vertex cache degradation the overdraw pass may cost, 1.05 allows 5% more misses
+	bool BuildMeshlets{ true };		// Split the mesh into meshlets for culling, reorders the triangles so every meshlet is contiguous
+	bool OptimizeVertexFetch{ true };	// Renumber vertices in the order the indices use them, runs after any index reordering
+	uint32_t LodCount{ 4 };				// Levels of detail including the full mesh, the chain stops early when simplifying stops paying off
+	float LodReduction{ 0.5f };			// Fraction of the triangles every level keeps from the one before
+	float LodMaxError{ 0.05f };			// Largest simplification error a level may have, relative to the mesh its bounding radius
+
+	// Hash of the settings that change the processed vertices or indices, caches built with another key are rebuilt
+	uint64_t GetProcessingKey() const;
+};
+
+// Range of the index buffer drawing one level of detail, every level uses the same vertex buffer
+struct MeshLod final
+{
+	uint32_t FirstIndex;
+	uint32_t IndexCount;
+	float Error;					// Largest distance the simplification moved the surface, in mesh units
+};
+
+struct BoundingSphere final
+{
+	glm::vec3 Center;
+	float Radius;
+};
+
+// Axis aligned box around the mesh, in mesh space
+struct BoundingBox final
+{
+	glm::vec3 Minimum;
+	glm::vec3 Maximum;
+};
+
+// Parses an obj file into welded vertices and indices, the result does not depend on the thread count
+void LoadObj
+(
+	const std::filesystem::path& path,
+	uint32_t threadCount,
+	std::vector<Vertex>& vertices,
+	std::vector<uint32_t>& indices
+);
+
+// Parses an obj file into one vertex per triangle corner without any welding
+void ExpandObj
+(
+	const std::filesystem::path& path,
+	std::vector<Vertex>& corners
+);
+
+// Meshes with at most this many vertices get 16 bit indices, primitive restart is off so 0xFFFF is a normal index
+constexpr size_t g_MaxUInt16IndexedVertices{ 65536 };
+
 class Mesh final
 {
 public:
 	Mesh
 	(
-		VkPhysicalDevice physicalDevice, 
-		VkDevice device, 
-		VkCommandPool copyCommandPool, 
-		VkQueue copyQueue, 
-		const std::filesystem::path& path
+		GeometryArena& geometryArena,
+		const std::filesystem::path& path,
+		const MeshLoadSettings& settings = MeshLoadSettings{}
 	);
 	Mesh
 	(
-		VkPhysicalDevice physicalDevice,
-		VkDevice device,
-		VkCommandPool copyCommandPool,
-		VkQueue copyQueue,
+		GeometryArena& geometryArena,
 		const std::vector<Vertex>& vertices,
 		const std::vector<uint32_t>& indices
 	);
@@ -65,32 +120,42 @@ public:
 	Mesh(Mesh&&) = delete;
 	Mesh& operator=(Mesh&&) = delete;
 
-	void Update(std::chrono::duration<float> seconds);
+	// Returns whether the model matrix changed
+	bool Update(std::chrono::duration<float> seconds);
 	const std::vector<Vertex>& GetVertices() const;
 	VkBuffer GetVertexBuffer() const;
-	const std::vector<uint32_t> GetIndices() const;
+	int32_t GetVertexOffset() const;
+	const std::vector<uint32_t>& GetIndices() const;
+	uint32_t GetIndexCount() const;
 	VkBuffer GetIndexBuffer() const;
+	uint32_t GetFirstIndex() const;
+	VkIndexType GetIndexType() const;
+	const std::vector<Meshlet>& GetMeshlets() const;
+	const std::vector<MeshLod>& GetLods() const;
+	const BoundingSphere& GetBoundingSphere() const;
+	const BoundingBox& GetBoundingBox() const;
 	glm::mat4 GetModelMatrix() const;
 	void SetModelMatrix(const glm::mat4& matrix);
 	void SwitchRotate();
 
 private:
-	VkPhysicalDevice m_PhysicalDevice;
-	VkDevice m_Device;
-	VkCommandPool m_CopyCommandPool;
-	VkQueue m_CopyQueue;
+	GeometryArena& m_GeometryArena;
 	std::vector<Vertex> m_Vertices;
-	VkBuffer m_VertexBuffer;
-	VkDeviceMemory m_VertexBufferMemory;
+	GeometryAllocation m_VertexAllocation;		// Where the vertices live in the arena vertex buffer
 	std::vector<uint32_t> m_Indices;
-	VkBuffer m_IndexBuffer;
-	VkDeviceMemory m_IndexBufferMemory;
+	GeometryAllocation m_IndexAllocation;		// Where the indices live in the arena index buffer of m_IndexType
+	VkIndexType m_IndexType;
+	std::vector<Meshlet> m_Meshlets;
+	std::vector<MeshLod> m_Lods;
+	BoundingSphere m_BoundingSphere;
+	BoundingBox m_BoundingBox;
 	glm::mat4 m_ModelMatrix;
 	bool m_Rotate;
 
-	void LoadMesh(const std::filesystem::path& path);
-	VkResult CreateVertexBuffer();
-	VkResult CreateIndexBuffer();
+	void LoadMesh(const std::filesystem::path& path, const MeshLoadSettings& settings);
+	void GenerateLods(const std::filesystem::path& path, const MeshLoadSettings& settings);
+	void CalculateBounds();
+	VkResult AddToGeometryArena();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,295 @@
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#include <fstream>
+#include <array>
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+#include "MeshCache.h"
+#include "MeshCodec.h"
+#include "Mesh.h"
+#include "Meshlet.h"
+
+namespace
+{
+	// Meshlets and lods follow the encoded streams, they start on a 4 byte boundary so they can be read in place
+	size_t GetStreamPadding(size_t streamsSize)
+	{
+		return (4 - streamsSize % 4) % 4;
+	}
+
+	// Draws of the range may only read indices the cache holds, in whole triangles
+	bool IsIndexRangeValid(uint32_t firstIndex, uint32_t indexCount, uint32_t totalIndexCount)
+	{
+		return uint64_t(firstIndex) + uint64_t(indexCount) <= uint64_t(totalIndexCount) and indexCount % 3 == 0;
+	}
+}
+
+MappedFile::MappedFile(const std::filesystem::path& path) :
+#ifdef _WIN32
+	m_File{ INVALID_HANDLE_VALUE },
+	m_Mapping{ nullptr },
+#else
+	m_File{ -1 },
+#endif
+	m_Data{ nullptr },
+	m_Size{}
+{
+	m_Size = static_cast<size_t>(std::filesystem::file_size(path));
+
+#ifdef _WIN32
+	m_File = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_File == INVALID_HANDLE_VALUE) throw std::runtime_error("Failed to open file for mapping!");
+
+	// Mapping an empty file is not allowed, an empty view is still valid for us
+	if (m_Size == 0) return;
+
+	m_Mapping = CreateFileMappingW(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_Mapping == nullptr)
+	{
+		CloseHandle(m_File);
+		throw std::runtime_error("Failed to create file mapping!");
+	}
+
+	m_Data = static_cast<const std::byte*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_Data == nullptr)
+	{
+		CloseHandle(m_Mapping);
+		CloseHandle(m_File);
+		throw std::runtime_error("Failed to map view of file!");
+	}
+#else
+	m_File = open(path.c_str(), O_RDONLY);
+	if (m_File == -1) throw std::runtime_error("Failed to open file for mapping!");
+
+	if (m_Size == 0) return;
+
+	void* data{ mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_File, 0) };
+	if (data == MAP_FAILED)
+	{
+		close(m_File);
+		throw std::runtime_error("Failed to map file!");
+	}
+
+	madvise(data, m_Size, MADV_SEQUENTIAL);
+	m_Data = static_cast<const std::byte*>(data);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+	if (m_Data != nullptr) UnmapViewOfFile(m_Data);
+	if (m_Mapping != nullptr) CloseHandle(m_Mapping);
+	CloseHandle(m_File);
+#else
+	if (m_Data != nullptr) munmap(const_cast<std::byte*>(m_Data), m_Size);
+	close(m_File);
+#endif
+}
+
+const std::byte* MappedFile::GetData() const
+{
+	return m_Data;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return m_Size;
+}
+
+uint64_t HashBytes
+(
+	const void* data,
+	size_t size,
+	uint64_t hash
+)
+{
+	const uint8_t* bytes{ static_cast<const uint8_t*>(data) };
+	for (size_t i{}; i < size; ++i)
+	{
+		hash ^= static_cast<uint64_t>(bytes[i]);
+		hash *= 0x100000001b3;
+	}
+
+	return hash;
+}
+
+uint64_t HashFile
+(
+	const std::filesystem::path& path
+)
+{
+	const MappedFile file{ path };
+
+	return HashBytes(file.GetData(), file.GetSize());
+}
+
+std::filesystem::path GetMeshCachePath
+(
+	const std::filesystem::path& sourcePath
+)
+{
+	std::filesystem::path cachePath{ sourcePath };
+	cachePath += ".meshcache";
+
+	return cachePath;
+}
+
+bool OpenMeshCache
+(
+	const std::filesystem::path& sourcePath,
+	uint64_t processingKey,
+	MeshCacheView& view
+)
+{
+	const std::filesystem::path cachePath{ GetMeshCachePath(sourcePath) };
+	if (!std::filesystem::exists(cachePath)) return false;
+
+	auto file{ std::make_unique<MappedFile>(cachePath) };
+	if (file->GetSize() < sizeof(MeshCacheHeader)) return false;
+
+	MeshCacheHeader header{};
+	memcpy(&header, file->GetData(), sizeof(MeshCacheHeader));
+
+	if (header.Magic != g_MeshCacheMagic) return false;
+	if (header.Version != g_MeshCacheVersion) return false;
+	if (header.VertexStride != sizeof(Vertex)) return false;
+	if (header.ProcessingKey != processingKey) return false;
+
+	const size_t streamsSize{ size_t(header.VertexDataSize) + size_t(header.IndexDataSize) };
+	const size_t meshletsSize{ size_t(header.MeshletCount) * sizeof(Meshlet) };
+	const size_t lodsSize{ size_t(header.LodCount) * sizeof(MeshLod) };
+	if (file->GetSize() != sizeof(MeshCacheHeader) + streamsSize + GetStreamPadding(streamsSize) + meshletsSize + lodsSize) return false;
+
+	// The cheap checks passed, only now pay for hashing the payload and the source
+	if (header.PayloadHash != HashBytes(file->GetData() + sizeof(MeshCacheHeader), file->GetSize() - sizeof(MeshCacheHeader))) return false;
+
+	if (std::filesystem::exists(sourcePath))
+	{
+		if (header.SourceSize != std::filesystem::file_size(sourcePath)) return false;
+		if (header.SourceHash != HashFile(sourcePath)) return false;
+	}
+
+	const uint8_t* vertexData{ reinterpret_cast<const uint8_t*>(file->GetData() + sizeof(MeshCacheHeader)) };
+	const uint8_t* meshlets{ vertexData + streamsSize + GetStreamPadding(streamsSize) };
+
+	view.VertexData = vertexData;
+	view.VertexDataSize = header.VertexDataSize;
+	view.VertexCount = header.VertexCount;
+	view.IndexData = vertexData + header.VertexDataSize;
+	view.IndexDataSize = header.IndexDataSize;
+	view.IndexCount = header.IndexCount;
+	view.Meshlets = reinterpret_cast<const Meshlet*>(meshlets);
+	view.MeshletCount = header.MeshletCount;
+	view.Lods = reinterpret_cast<const MeshLod*>(meshlets + meshletsSize);
+	view.LodCount = header.LodCount;
+
+	// A matching hash only says the file is what got written, the ranges still have to fit the streams before anything draws them
+	if (view.LodCount == 0) return false;
+	for (uint32_t i{}; i < view.MeshletCount; ++i)
+	{
+		if (!IsIndexRangeValid(view.Meshlets[i].FirstIndex, view.Meshlets[i].IndexCount, view.IndexCount)) return false;
+	}
+	for (uint32_t i{}; i < view.LodCount; ++i)
+	{
+		if (!IsIndexRangeValid(view.Lods[i].FirstIndex, view.Lods[i].IndexCount, view.IndexCount)) return false;
+	}
+
+	view.File = std::move(file);
+
+	return true;
+}
+
+bool DecodeMeshCache
+(
+	const MeshCacheView& view,
+	std::vector<Vertex>& vertices,
+	std::vector<uint32_t>& indices
+)
+{
+	vertices.resize(view.VertexCount);
+	indices.resize(view.IndexCount);
+
+	if (!DecodeVertexBuffer(vertices.data(), vertices.size(), sizeof(Vertex), view.VertexData, view.VertexDataSize)) return false;
+	if (!DecodeIndexBuffer(indices.data(), indices.size(), view.IndexData, view.IndexDataSize)) return false;
+
+	const uint32_t vertexCount{ view.VertexCount };
+	if (std::any_of(indices.begin(), indices.end(), [vertexCount](uint32_t index) { return index >= vertexCount; })) return false;
+
+	return true;
+}
+
+bool WriteMeshCache
+(
+	const std::filesystem::path& sourcePath,
+	uint64_t processingKey,
+	const std::vector<Vertex>& vertices,
+	const std::vector<uint32_t>& indices,
+	const std::vector<Meshlet>& meshlets,
+	const std::vector<MeshLod>& lods
+)
+{
+	const std::vector<uint8_t> vertexData{ EncodeVertexBuffer(vertices.data(), vertices.size(), sizeof(Vertex)) };
+	const std::vector<uint8_t> indexData{ EncodeIndexBuffer(indices.data(), indices.size()) };
+	const std::array<uint8_t, 4> padding{};
+	const size_t paddingSize{ GetStreamPadding(vertexData.size() + indexData.size()) };
+
+	// Same order as the file
+	uint64_t payloadHash{ HashBytes(vertexData.data(), vertexData.size()) };
+	payloadHash = HashBytes(indexData.data(), indexData.size(), payloadHash);
+	payloadHash = HashBytes(padding.data(), paddingSize, payloadHash);
+	payloadHash = HashBytes(meshlets.data(), meshlets.size() * sizeof(Meshlet), payloadHash);
+	payloadHash = HashBytes(lods.data(), lods.size() * sizeof(MeshLod), payloadHash);
+
+	const MeshCacheHeader header
+	{
+		g_MeshCacheMagic,											// Magic
+		g_MeshCacheVersion,											// Version
+		HashFile(sourcePath),										// SourceHash
+		static_cast<uint64_t>(std::filesystem::file_size(sourcePath)),	// SourceSize
+		processingKey,												// ProcessingKey
+		payloadHash,												// PayloadHash
+		static_cast<uint32_t>(sizeof(Vertex)),						// VertexStride
+		static_cast<uint32_t>(vertices.size()),						// VertexCount
+		static_cast<uint32_t>(indices.size()),						// IndexCount
+		static_cast<uint32_t>(meshlets.size()),						// MeshletCount
+		static_cast<uint32_t>(lods.size()),							// LodCount
+		static_cast<uint32_t>(vertexData.size()),					// VertexDataSize
+		static_cast<uint32_t>(indexData.size())						// IndexDataSize
+	};
+
+	// Write to a temporary file first so a crash never leaves a half written cache behind
+	const std::filesystem::path cachePath{ GetMeshCachePath(sourcePath) };
+	std::filesystem::path temporaryPath{ cachePath };
+	temporaryPath += ".tmp";
+
+	{
+		std::ofstream file{ temporaryPath, std::ios::binary | std::ios::trunc };
+		if (!file.is_open()) return false;
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(MeshCacheHeader));
+		file.write(reinterpret_cast<const char*>(vertexData.data()), std::streamsize(vertexData.size()));
+		file.write(reinterpret_cast<const char*>(indexData.data()), std::streamsize(indexData.size()));
+		file.write(reinterpret_cast<const char*>(padding.data()), std::streamsize(paddingSize));
+		file.write(reinterpret_cast<const char*>(meshlets.data()), std::streamsize(meshlets.size() * sizeof(Meshlet)));
+		file.write(reinterpret_cast<const char*>(lods.data()), std::streamsize(lods.size() * sizeof(MeshLod)));
+
+		if (!file.good()) return false;
+	}
+
+	std::error_code error{};
+	std::filesystem::rename(temporaryPath, cachePath, error);
+
+	return !error;
+}
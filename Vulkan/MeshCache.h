@@ -0,0 +1,127 @@
+#ifndef MESH_CACHE
+#define MESH_CACHE
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct Vertex;
+struct Meshlet;
+struct MeshLod;
+
+// Read only view of a whole file mapped into our address space
+class MappedFile final
+{
+public:
+	MappedFile(const std::filesystem::path& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&&) = delete;
+	MappedFile& operator=(MappedFile&&) = delete;
+
+	const std::byte* GetData() const;
+	size_t GetSize() const;
+
+private:
+#ifdef _WIN32
+	void* m_File;
+	void* m_Mapping;
+#else
+	int m_File;
+#endif
+	const std::byte* m_Data;
+	size_t m_Size;
+};
+
+// Layout of a mesh cache file: header, encoded vertices, encoded indices, padding to 4 bytes, meshlets, lods
+struct MeshCacheHeader final
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint64_t SourceHash;			// Hash of the source file the cache was built from
+	uint64_t SourceSize;
+	uint64_t ProcessingKey;			// Hash of the processing settings the streams were built with
+	uint64_t PayloadHash;			// Hash of everything behind the header, catches truncated and corrupt caches
+	uint32_t VertexStride;
+	uint32_t VertexCount;
+	uint32_t IndexCount;
+	uint32_t MeshletCount;
+	uint32_t LodCount;
+	uint32_t VertexDataSize;		// Bytes of the vertex stream after EncodeVertexBuffer
+	uint32_t IndexDataSize;			// Bytes of the index stream after EncodeIndexBuffer
+};
+
+// Streams of a valid cache file, they point straight into the mapped file
+struct MeshCacheView final
+{
+	std::unique_ptr<MappedFile> File;
+	const uint8_t* VertexData;
+	uint32_t VertexDataSize;
+	uint32_t VertexCount;
+	const uint8_t* IndexData;
+	uint32_t IndexDataSize;
+	uint32_t IndexCount;
+	const Meshlet* Meshlets;
+	uint32_t MeshletCount;
+	const MeshLod* Lods;
+	uint32_t LodCount;
+};
+
+constexpr uint32_t g_MeshCacheMagic{ 0x4348534D };		// "MSHC"
+constexpr uint32_t g_MeshCacheVersion{ 12 };
+
+constexpr uint64_t g_FnvOffsetBasis{ 0xcbf29ce484222325 };
+
+// Continues a 64 bit FNV-1a hash over size bytes, a new hash starts from g_FnvOffsetBasis
+uint64_t HashBytes
+(
+	const void* data,
+	size_t size,
+	uint64_t hash = g_FnvOffsetBasis
+);
+
+// 64 bit FNV-1a hash of the file contents
+uint64_t HashFile
+(
+	const std::filesystem::path& path
+);
+
+// The cache lives next to the source file, "vehicle.obj" -> "vehicle.obj.meshcache"
+std::filesystem::path GetMeshCachePath
+(
+	const std::filesystem::path& sourcePath
+);
+
+// Maps the cache belonging to the source file, returns false if it is missing, stale or corrupt.
+// Without the source file only the payload hash and the meshlet and lod ranges vouch for it, so it can be shipped on its own
+bool OpenMeshCache
+(
+	const std::filesystem::path& sourcePath,
+	uint64_t processingKey,
+	MeshCacheView& view
+);
+
+// Decodes the vertex and index streams of an opened cache, returns false if they are corrupt or an index points past the vertices
+bool DecodeMeshCache
+(
+	const MeshCacheView& view,
+	std::vector<Vertex>& vertices,
+	std::vector<uint32_t>& indices
+);
+
+// Writes the final vertex, index, meshlet and lod streams of a mesh, returns false if the file could not be written
+bool WriteMeshCache
+(
+	const std::filesystem::path& sourcePath,
+	uint64_t processingKey,
+	const std::vector<Vertex>& vertices,
+	const std::vector<uint32_t>& indices,
+	const std::vector<Meshlet>& meshlets,
+	const std::vector<MeshLod>& lods
+);
+
+#endif
@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <cstring>
+
+#include "MeshCodec.h"
+
+namespace
+{
+	// First byte of every stream, so a stream of the wrong kind or an older format gets rejected
+	constexpr uint8_t g_VertexCodecHeader{ 0xA1 };
+	constexpr uint8_t g_IndexCodecHeader{ 0xB1 };
+
+	constexpr size_t g_GroupSize{ 16 };
+
+	// Group modes, the bits every delta of the group takes
+	constexpr uint8_t g_GroupZero{ 0 };
+	constexpr uint8_t g_GroupBits2{ 1 };
+	constexpr uint8_t g_GroupBits4{ 2 };
+	constexpr uint8_t g_GroupBits8{ 3 };
+
+	uint8_t ZigzagEncode(uint8_t delta)
+	{
+		return static_cast<uint8_t>((delta << 1) ^ ((delta & 0x80) ? 0xFF : 0x00));
+	}
+
+	uint8_t ZigzagDecode(uint8_t value)
+	{
+		return static_cast<uint8_t>((value >> 1) ^ (0 - (value & 1)));
+	}
+
+	uint8_t ChooseGroupMode(const uint8_t* group)
+	{
+		uint8_t maximum{};
+		for (size_t i{}; i < g_GroupSize; ++i) maximum |= group[i];
+
+		if (maximum == 0) return g_GroupZero;
+		if (maximum < 4) return g_GroupBits2;
+		if (maximum < 16) return g_GroupBits4;
+		return g_GroupBits8;
+	}
+
+	void EncodeGroup(const uint8_t* group, uint8_t mode, std::vector<uint8_t>& output)
+	{
+		switch (mode)
+		{
+		case g_GroupBits2:
+			for (size_t i{}; i < g_GroupSize; i += 4)
+			{
+				output.push_back(static_cast<uint8_t>(group[i] | (group[i + 1] << 2) | (group[i + 2] << 4) | (group[i + 3] << 6)));
+			}
+			break;
+		case g_GroupBits4:
+			for (size_t i{}; i < g_GroupSize; i += 2)
+			{
+				output.push_back(static_cast<uint8_t>(group[i] | (group[i + 1] << 4)));
+			}
+			break;
+		case g_GroupBits8:
+			output.insert(output.end(), group, group + g_GroupSize);
+			break;
+		default:
+			break;
+		}
+	}
+
+	// Returns the position after the group or nullptr when the data runs out
+	const uint8_t* DecodeGroup(const uint8_t* data, const uint8_t* end, uint8_t mode, uint8_t* group)
+	{
+		switch (mode)
+		{
+		case g_GroupZero:
+			memset(group, 0, g_GroupSize);
+			return data;
+		case g_GroupBits2:
+			if (end - data < 4) return nullptr;
+			for (size_t i{}; i < g_GroupSize; i += 4)
+			{
+				const uint8_t byte{ *data++ };
+				group[i] = byte & 3;
+				group[i + 1] = (byte >> 2) & 3;
+				group[i + 2] = (byte >> 4) & 3;
+				group[i + 3] = byte >> 6;
+			}
+			return data;
+		case g_GroupBits4:
+			if (end - data < 8) return nullptr;
+			for (size_t i{}; i < g_GroupSize; i += 2)
+			{
+				const uint8_t byte{ *data++ };
+				group[i] = byte & 15;
+				group[i + 1] = byte >> 4;
+			}
+			return data;
+		default:
+			if (end - data < 16) return nullptr;
+			memcpy(group, data, g_GroupSize);
+			return data + g_GroupSize;
+		}
+	}
+}
+
+std::vector<uint8_t> EncodeVertexBuffer
+(
+	const void* vertices,
+	size_t vertexCount,
+	size_t vertexStride
+)
+{
+	const uint8_t* input{ static_cast<const uint8_t*>(vertices) };
+
+	std::vector<uint8_t> output{};
+	output.reserve(1 + vertexCount * vertexStride / 2);
+	output.push_back(g_VertexCodecHeader);
+
+	// Deltas carry over block borders, every plane starts at zero
+	std::vector<uint8_t> previous(vertexStride, 0);
+	uint8_t plane[g_VertexCodecBlockSize]{};
+
+	for (size_t blockStart{}; blockStart < vertexCount; blockStart += g_VertexCodecBlockSize)
+	{
+		const size_t blockSize{ std::min(g_VertexCodecBlockSize, vertexCount - blockStart) };
+		const size_t groupCount{ (blockSize + g_GroupSize - 1) / g_GroupSize };
+
+		for (size_t k{}; k < vertexStride; ++k)
+		{
+			// The tail of the last group stays zero, which the decoder never writes out
+			memset(plane, 0, sizeof(plane));
+			for (size_t i{}; i < blockSize; ++i)
+			{
+				const uint8_t value{ input[(blockStart + i) * vertexStride + k] };
+				plane[i] = ZigzagEncode(static_cast<uint8_t>(value - previous[k]));
+				previous[k] = value;
+			}
+
+			// Two bits of mode per group, four groups per header byte
+			const size_t headerStart{ output.size() };
+			output.resize(output.size() + (groupCount + 3) / 4, 0);
+
+			for (size_t group{}; group < groupCount; ++group)
+			{
+				const uint8_t mode{ ChooseGroupMode(plane + group * g_GroupSize) };
+				output[headerStart + group / 4] |= static_cast<uint8_t>(mode << ((group % 4) * 2));
+
+				EncodeGroup(plane + group * g_GroupSize, mode, output);
+			}
+		}
+	}
+
+	return output;
+}
+
+bool DecodeVertexBuffer
+(
+	void* destination,
+	size_t vertexCount,
+	size_t vertexStride,
+	const uint8_t* data,
+	size_t dataSize
+)
+{
+	const uint8_t* end{ data + dataSize };
+	if (dataSize == 0 or *data++ != g_VertexCodecHeader) return false;
+
+	uint8_t* output{ static_cast<uint8_t*>(destination) };
+
+	// Every plane of a block gets unpacked first, so the deltas can be undone four planes at a time
+	std::vector<uint8_t> planes(vertexStride * g_VertexCodecBlockSize);
+	std::vector<uint8_t> previous(vertexStride, 0);
+
+	for (size_t blockStart{}; blockStart < vertexCount; blockStart += g_VertexCodecBlockSize)
+	{
+		const size_t blockSize{ std::min(g_VertexCodecBlockSize, vertexCount - blockStart) };
+		const size_t groupCount{ (blockSize + g_GroupSize - 1) / g_GroupSize };
+		const size_t headerSize{ (groupCount + 3) / 4 };
+
+		for (size_t k{}; k < vertexStride; ++k)
+		{
+			if (size_t(end - data) < headerSize) return false;
+			const uint8_t* header{ data };
+			data += headerSize;
+
+			uint8_t* plane{ planes.data() + k * g_VertexCodecBlockSize };
+			for (size_t group{}; group < groupCount; ++group)
+			{
+				const uint8_t mode{ static_cast<uint8_t>((header[group / 4] >> ((group % 4) * 2)) & 3) };
+
+				data = DecodeGroup(data, end, mode, plane + group * g_GroupSize);
+				if (data == nullptr) return false;
+			}
+		}
+
+		uint8_t* blockOutput{ output + blockStart * vertexStride };
+		size_t k{};
+
+		// Four bytes per step, the zigzag and the additions stay inside their byte
+		for (; k + 4 <= vertexStride; k += 4)
+		{
+			const uint8_t* plane0{ planes.data() + k * g_VertexCodecBlockSize };
+			const uint8_t* plane1{ plane0 + g_VertexCodecBlockSize };
+			const uint8_t* plane2{ plane1 + g_VertexCodecBlockSize };
+			const uint8_t* plane3{ plane2 + g_VertexCodecBlockSize };
+
+			uint32_t value{};
+			memcpy(&value, previous.data() + k, 4);
+
+			for (size_t i{}; i < blockSize; ++i)
+			{
+				const uint32_t zigzag{ uint32_t(plane0[i]) | (uint32_t(plane1[i]) << 8) | (uint32_t(plane2[i]) << 16) | (uint32_t(plane3[i]) << 24) };
+				const uint32_t delta{ ((zigzag >> 1) & 0x7F7F7F7F) ^ ((zigzag & 0x01010101) * 0xFF) };
+
+				value = ((value & 0x7F7F7F7F) + (delta & 0x7F7F7F7F)) ^ ((value ^ delta) & 0x80808080);
+				memcpy(blockOutput + i * vertexStride + k, &value, 4);
+			}
+
+			memcpy(previous.data() + k, &value, 4);
+		}
+
+		for (; k < vertexStride; ++k)
+		{
+			const uint8_t* plane{ planes.data() + k * g_VertexCodecBlockSize };
+
+			uint8_t value{ previous[k] };
+			for (size_t i{}; i < blockSize; ++i)
+			{
+				value = static_cast<uint8_t>(value + ZigzagDecode(plane[i]));
+				blockOutput[i * vertexStride + k] = value;
+			}
+			previous[k] = value;
+		}
+	}
+
+	return data == end;
+}
+
+std::vector<uint8_t> EncodeIndexBuffer
+(
+	const uint32_t* indices,
+	size_t indexCount
+)
+{
+	std::vector<uint8_t> output{};
+	output.reserve(1 + indexCount * 2);
+	output.push_back(g_IndexCodecHeader);
+
+	uint32_t previous{};
+	for (size_t i{}; i < indexCount; ++i)
+	{
+		const int32_t delta{ static_cast<int32_t>(indices[i] - previous) };
+		uint32_t value{ (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31) };
+		previous = indices[i];
+
+		// Seven bits per byte, the high bit says another byte follows
+		while (value >= 0x80)
+		{
+			output.push_back(static_cast<uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+		output.push_back(static_cast<uint8_t>(value));
+	}
+
+	return output;
+}
+
+bool DecodeIndexBuffer
+(
+	uint32_t* destination,
+	size_t indexCount,
+	const uint8_t* data,
+	size_t dataSize
+)
+{
+	const uint8_t* end{ data + dataSize };
+	if (dataSize == 0 or *data++ != g_IndexCodecHeader) return false;
+
+	uint32_t previous{};
+	for (size_t i{}; i < indexCount; ++i)
+	{
+		if (data == end) return false;
+
+		// Almost every index fits in the first byte
+		uint32_t value{ *data++ };
+		if (value >= 0x80)
+		{
+			value &= 0x7F;
+			for (uint32_t shift{ 7 }; ; shift += 7)
+			{
+				if (data == end or shift > 28) return false;
+
+				const uint32_t byte{ *data++ };
+				value |= (byte & 0x7F) << shift;
+				if (byte < 0x80) break;
+			}
+		}
+
+		previous += (value >> 1) ^ (0u - (value & 1));
+		destination[i] = previous;
+	}
+
+	return data == end;
+}
@@ -0,0 +1,46 @@
+#ifndef MESH_CODEC
+#define MESH_CODEC
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Vertices get encoded in blocks, every byte of the vertex is a plane of deltas inside a block
+constexpr size_t g_VertexCodecBlockSize{ 256 };
+
+// Transposes the vertices into byte planes, delta encodes every plane against the previous vertex
+// and packs groups of 16 deltas into 0, 2, 4 or 8 bits each
+std::vector<uint8_t> EncodeVertexBuffer
+(
+	const void* vertices,
+	size_t vertexCount,
+	size_t vertexStride
+);
+
+// Writes vertexCount * vertexStride bytes to destination, returns false if the data is corrupt or does not match the counts
+bool DecodeVertexBuffer
+(
+	void* destination,
+	size_t vertexCount,
+	size_t vertexStride,
+	const uint8_t* data,
+	size_t dataSize
+);
+
+// Zigzag encodes the difference with the previous index as a variable length integer, one byte for most indices after OptimizeVertexFetch
+std::vector<uint8_t> EncodeIndexBuffer
+(
+	const uint32_t* indices,
+	size_t indexCount
+);
+
+// Writes indexCount indices to destination, returns false if the data is corrupt or does not match the count
+bool DecodeIndexBuffer
+(
+	uint32_t* destination,
+	size_t indexCount,
+	const uint8_t* data,
+	size_t dataSize
+);
+
+#endif
@@ -0,0 +1,832 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+#include "MeshOptimizer.h"
+#include "Mesh.h"
+#include "VertexWeldTable.h"
+
+namespace
+{
+	// Size of the lru cache Forsyth's algorithm models, larger than any real fifo cache on purpose
+	constexpr int g_ForsythCacheSize{ 32 };
+
+	constexpr size_t g_NoTriangle{ std::numeric_limits<size_t>::max() };
+
+	// Fifo post transform cache, a vertex is in the cache as long as less than Size misses happened after it got loaded
+	class FifoCache final
+	{
+	public:
+		FifoCache(size_t vertexCount, uint32_t size) :
+			m_LoadTimes(vertexCount, 0),
+			m_Misses{},
+			m_Size{ size }
+		{
+
+		}
+
+		// Returns 1 when the vertex had to be fetched from memory
+		uint32_t Load(uint32_t vertex)
+		{
+			uint64_t& loadTime{ m_LoadTimes.at(vertex) };
+			if (loadTime != 0 and m_Misses - loadTime + 1 <= m_Size) return 0;
+
+			++m_Misses;
+			loadTime = m_Misses;
+
+			return 1;
+		}
+
+		uint32_t LoadTriangle(const uint32_t* triangle)
+		{
+			return Load(triangle[0]) + Load(triangle[1]) + Load(triangle[2]);
+		}
+
+		// Pretends enough misses happened to push every vertex out
+		void Flush()
+		{
+			m_Misses += m_Size;
+		}
+
+		uint64_t GetMisses() const
+		{
+			return m_Misses;
+		}
+
+	private:
+		std::vector<uint64_t> m_LoadTimes;
+		uint64_t m_Misses;
+		uint32_t m_Size;
+	};
+
+	// Depth buffer of one overdraw view, pixels store the nearest depth so far
+	struct OverdrawView final
+	{
+		std::vector<float> Depths;
+		uint64_t ShadedFragments;
+	};
+
+	// Rasterizes a triangle given in pixel coordinates with a less depth test, clockwise triangles are culled
+	void RasterizeTriangle(const glm::vec3& vertex0, const glm::vec3& vertex1, const glm::vec3& vertex2, OverdrawView& view)
+	{
+		const auto edge{ [](const glm::vec3& a, const glm::vec3& b, float x, float y) { return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x); } };
+
+		const float area{ edge(vertex0, vertex1, vertex2.x, vertex2.y) };
+		if (area <= 0.0f) return;
+
+		const float maximum{ float(g_OverdrawViewportSize - 1) };
+		const int minimumX{ int(std::clamp(std::floor(std::min({ vertex0.x, vertex1.x, vertex2.x })), 0.0f, maximum)) };
+		const int maximumX{ int(std::clamp(std::ceil(std::max({ vertex0.x, vertex1.x, vertex2.x })), 0.0f, maximum)) };
+		const int minimumY{ int(std::clamp(std::floor(std::min({ vertex0.y, vertex1.y, vertex2.y })), 0.0f, maximum)) };
+		const int maximumY{ int(std::clamp(std::ceil(std::max({ vertex0.y, vertex1.y, vertex2.y })), 0.0f, maximum)) };
+
+		for (int y{ minimumY }; y <= maximumY; ++y)
+		{
+			for (int x{ minimumX }; x <= maximumX; ++x)
+			{
+				// Sample at the pixel center
+				const float sampleX{ float(x) + 0.5f };
+				const float sampleY{ float(y) + 0.5f };
+
+				const float weight0{ edge(vertex1, vertex2, sampleX, sampleY) };
+				const float weight1{ edge(vertex2, vertex0, sampleX, sampleY) };
+				const float weight2{ edge(vertex0, vertex1, sampleX, sampleY) };
+				if (weight0 < 0.0f or weight1 < 0.0f or weight2 < 0.0f) continue;
+
+				const float depth{ (weight0 * vertex0.z + weight1 * vertex1.z + weight2 * vertex2.z) / area };
+
+				float& storedDepth{ view.Depths[size_t(y) * g_OverdrawViewportSize + size_t(x)] };
+				if (depth < storedDepth)
+				{
+					storedDepth = depth;
+					++view.ShadedFragments;
+				}
+			}
+		}
+	}
+
+	float ForsythVertexScore(int cachePosition, uint32_t liveTriangleCount)
+	{
+		// Vertices without triangles left will never be used again
+		if (liveTriangleCount == 0) return -1.0f;
+
+		float score{};
+		if (cachePosition >= 0)
+		{
+			// The last triangle's vertices get a fixed score so we don't keep using the same edge
+			if (cachePosition < 3)
+			{
+				score = 0.75f;
+			}
+			else
+			{
+				const float scaler{ 1.0f / float(g_ForsythCacheSize - 3) };
+				score = std::pow(1.0f - float(cachePosition - 3) * scaler, 1.5f);
+			}
+		}
+
+		// Prefer vertices with few triangles left so lone triangles don't get stranded
+		score += 2.0f / std::sqrt(float(liveTriangleCount));
+
+		return score;
+	}
+
+	// Sum of squared distances to a set of planes, the upper triangle of a symmetric 4x4 matrix
+	struct Quadric final
+	{
+		double A00, A01, A02, A03, A11, A12, A13, A22, A23, A33;
+
+		static Quadric FromPlane(const glm::dvec3& normal, double distance)
+		{
+			return Quadric
+			{
+				normal.x * normal.x, normal.x * normal.y, normal.x * normal.z, normal.x * distance,
+				normal.y * normal.y, normal.y * normal.z, normal.y * distance,
+				normal.z * normal.z, normal.z * distance,
+				distance * distance
+			};
+		}
+
+		Quadric& operator+=(const Quadric& other)
+		{
+			A00 += other.A00; A01 += other.A01; A02 += other.A02; A03 += other.A03;
+			A11 += other.A11; A12 += other.A12; A13 += other.A13;
+			A22 += other.A22; A23 += other.A23;
+			A33 += other.A33;
+
+			return *this;
+		}
+
+		double Evaluate(const glm::dvec3& p) const
+		{
+			const double error
+			{
+				A00 * p.x * p.x + 2.0 * A01 * p.x * p.y + 2.0 * A02 * p.x * p.z + 2.0 * A03 * p.x
+				+ A11 * p.y * p.y + 2.0 * A12 * p.y * p.z + 2.0 * A13 * p.y
+				+ A22 * p.z * p.z + 2.0 * A23 * p.z
+				+ A33
+			};
+
+			// Rounding can push a perfect fit slightly under zero
+			return std::max(error, 0.0);
+		}
+	};
+
+	struct PositionHash final
+	{
+		size_t operator()(const glm::vec3& position) const
+		{
+			size_t hash{};
+			for (int i{}; i < 3; ++i) hash = hash * 31 + std::hash<float>{}(position[i]);
+
+			return hash;
+		}
+	};
+
+	struct Collapse final
+	{
+		uint32_t Source;
+		uint32_t Target;
+		double Cost;
+	};
+}
+
+float CalculateACMR
+(
+	const std::vector<uint32_t>& indices,
+	size_t vertexCount,
+	uint32_t cacheSize
+)
+{
+	if (indices.size() < 3) return 0.0f;
+
+	FifoCache cache{ vertexCount, cacheSize };
+	for (const uint32_t index : indices) cache.Load(index);
+
+	return float(cache.GetMisses()) / float(indices.size() / 3);
+}
+
+void OptimizeVertexCache
+(
+	std::vector<uint32_t>& indices,
+	size_t vertexCount
+)
+{
+	const size_t triangleCount{ indices.size() / 3 };
+	if (triangleCount == 0) return;
+
+	// Triangles that still have to be emitted for each vertex, stored back to back
+	std::vector<uint32_t> liveTriangleCounts(vertexCount, 0);
+	for (size_t i{}; i < triangleCount * 3; ++i) ++liveTriangleCounts.at(indices[i]);
+
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t i{}; i < vertexCount; ++i) adjacencyOffsets[i + 1] = adjacencyOffsets[i] + liveTriangleCounts[i];
+
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	{
+		std::vector<uint32_t> cursors{ adjacencyOffsets.begin(), adjacencyOffsets.end() - 1 };
+		for (size_t i{}; i < triangleCount * 3; ++i) adjacency[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t i{}; i < vertexCount; ++i) vertexScores[i] = ForsythVertexScore(-1, liveTriangleCounts[i]);
+
+	std::vector<float> triangleScores(triangleCount);
+	for (size_t i{}; i < triangleCount; ++i)
+	{
+		triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> output{};
+	output.reserve(triangleCount * 3);
+
+	std::vector<uint32_t> cache{};
+	std::vector<uint32_t> newCache{};
+	cache.reserve(g_ForsythCacheSize + 3);
+	newCache.reserve(g_ForsythCacheSize + 3);
+
+	size_t bestTriangle{ size_t(std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin()) };
+	size_t nextUnemitted{};
+
+	for (size_t emittedCount{}; emittedCount < triangleCount; ++emittedCount)
+	{
+		// Nothing in the cache has triangles left, continue with the next triangle in the original order
+		if (bestTriangle == g_NoTriangle)
+		{
+			while (emitted[nextUnemitted]) ++nextUnemitted;
+			bestTriangle = nextUnemitted;
+		}
+
+		emitted[bestTriangle] = true;
+
+		newCache.clear();
+		for (size_t i{}; i < 3; ++i)
+		{
+			const uint32_t vertex{ indices[bestTriangle * 3 + i] };
+			output.push_back(vertex);
+
+			// Remove the triangle from the vertex its live triangles
+			const auto begin{ adjacency.begin() + adjacencyOffsets[vertex] };
+			const auto end{ begin + liveTriangleCounts[vertex] };
+			const auto position{ std::find(begin, end, static_cast<uint32_t>(bestTriangle)) };
+			std::iter_swap(position, end - 1);
+			--liveTriangleCounts[vertex];
+
+			if (std::find(newCache.begin(), newCache.end(), vertex) == newCache.end()) newCache.push_back(vertex);
+		}
+
+		// The emitted vertices move to the front of the lru cache
+		for (const uint32_t vertex : cache)
+		{
+			if (std::find(newCache.begin(), newCache.end(), vertex) == newCache.end()) newCache.push_back(vertex);
+		}
+
+		for (size_t i{}; i < newCache.size(); ++i)
+		{
+			const uint32_t vertex{ newCache[i] };
+			cachePositions[vertex] = (i < size_t(g_ForsythCacheSize)) ? int(i) : -1;
+
+			const float score{ ForsythVertexScore(cachePositions[vertex], liveTriangleCounts[vertex]) };
+			const float difference{ score - vertexScores[vertex] };
+			vertexScores[vertex] = score;
+
+			for (uint32_t j{ adjacencyOffsets[vertex] }; j < adjacencyOffsets[vertex] + liveTriangleCounts[vertex]; ++j)
+			{
+				triangleScores[adjacency[j]] += difference;
+			}
+		}
+
+		if (newCache.size() > size_t(g_ForsythCacheSize)) newCache.resize(g_ForsythCacheSize);
+		std::swap(cache, newCache);
+
+		// Only triangles touching the cache are worth looking at
+		bestTriangle = g_NoTriangle;
+		float bestScore{ -1.0f };
+		for (const uint32_t vertex : cache)
+		{
+			for (uint32_t j{ adjacencyOffsets[vertex] }; j < adjacencyOffsets[vertex] + liveTriangleCounts[vertex]; ++j)
+			{
+				const uint32_t triangle{ adjacency[j] };
+				if (triangleScores[triangle] > bestScore)
+				{
+					bestScore = triangleScores[triangle];
+					bestTriangle = triangle;
+				}
+			}
+		}
+	}
+
+	std::copy(output.begin(), output.end(), indices.begin());
+}
+
+float CalculateOverdraw
+(
+	const std::vector<uint32_t>& indices,
+	const std::vector<Vertex>& vertices
+)
+{
+	if (indices.size() < 3 or vertices.empty()) return 0.0f;
+
+	glm::vec3 minimum{ vertices.front().Position };
+	glm::vec3 maximum{ vertices.front().Position };
+	for (const Vertex& vertex : vertices)
+	{
+		minimum = glm::min(minimum, vertex.Position);
+		maximum = glm::max(maximum, vertex.Position);
+	}
+
+	const glm::vec3 extent{ maximum - minimum };
+	const float largestExtent{ std::max({ extent.x, extent.y, extent.z }) };
+	if (largestExtent <= 0.0f) return 0.0f;
+
+	// Positions in [0, 1] with the aspect ratio of the mesh kept
+	std::vector<glm::vec3> positions(vertices.size());
+	for (size_t i{}; i < vertices.size(); ++i) positions[i] = (vertices[i].Position - minimum) / largestExtent;
+
+	uint64_t shadedFragments{};
+	uint64_t coveredPixels{};
+
+	OverdrawView view{};
+	for (int axis{}; axis < 3; ++axis)
+	{
+		// Looking down the axis from both sides, the screen axes are picked so front faces stay counter clockwise
+		const int screenX{ (axis + 1) % 3 };
+		const int screenY{ (axis + 2) % 3 };
+
+		for (const float side : { 1.0f, -1.0f })
+		{
+			view.Depths.assign(size_t(g_OverdrawViewportSize) * g_OverdrawViewportSize, std::numeric_limits<float>::max());
+			view.ShadedFragments = 0;
+
+			const float scale{ float(g_OverdrawViewportSize) };
+			const auto project{ [&](uint32_t index)
+			{
+				const glm::vec3& position{ positions[index] };
+				const float x{ (side > 0.0f) ? position[screenX] : position[screenY] };
+				const float y{ (side > 0.0f) ? position[screenY] : position[screenX] };
+
+				return glm::vec3{ x * scale, y * scale, -side * position[axis] };
+			} };
+
+			for (size_t i{}; i + 2 < indices.size(); i += 3)
+			{
+				RasterizeTriangle(project(indices[i]), project(indices[i + 1]), project(indices[i + 2]), view);
+			}
+
+			shadedFragments += view.ShadedFragments;
+			coveredPixels += size_t(std::count_if(view.Depths.begin(), view.Depths.end(), [](float depth) { return depth != std::numeric_limits<float>::max(); }));
+		}
+	}
+
+	return (coveredPixels == 0) ? 0.0f : float(shadedFragments) / float(coveredPixels);
+}
+
+void OptimizeOverdraw
+(
+	std::vector<uint32_t>& indices,
+	const std::vector<Vertex>& vertices,
+	float threshold
+)
+{
+	const size_t triangleCount{ indices.size() / 3 };
+	if (triangleCount == 0) return;
+
+	FifoCache cache{ vertices.size(), g_VertexCacheSize };
+
+	// A triangle missing on all three vertices starts a new patch, reordering patches costs no cache hits
+	std::vector<size_t> patchStarts{};
+	for (size_t i{}; i < triangleCount; ++i)
+	{
+		if (cache.LoadTriangle(&indices[i * 3]) == 3 or i == 0) patchStarts.push_back(i);
+	}
+	patchStarts.push_back(triangleCount);
+
+	// Patches get cut into smaller clusters as soon as the cluster so far is within the threshold of the patch its ACMR
+	std::vector<size_t> clusterStarts{};
+	for (size_t patch{}; patch + 1 < patchStarts.size(); ++patch)
+	{
+		const size_t begin{ patchStarts[patch] };
+		const size_t end{ patchStarts[patch + 1] };
+
+		cache.Flush();
+		uint32_t patchMisses{};
+		for (size_t i{ begin }; i < end; ++i) patchMisses += cache.LoadTriangle(&indices[i * 3]);
+
+		const float clusterThreshold{ threshold * float(patchMisses) / float(end - begin) };
+
+		cache.Flush();
+		size_t clusterStart{ begin };
+		uint32_t clusterMisses{};
+		clusterStarts.push_back(begin);
+
+		for (size_t i{ begin }; i < end; ++i)
+		{
+			clusterMisses += cache.LoadTriangle(&indices[i * 3]);
+
+			// The next cluster may be drawn after any other one, so it starts with a cold cache
+			if (i + 1 < end and float(clusterMisses) <= clusterThreshold * float(i + 1 - clusterStart))
+			{
+				clusterStart = i + 1;
+				clusterMisses = 0;
+				clusterStarts.push_back(clusterStart);
+				cache.Flush();
+			}
+		}
+	}
+	clusterStarts.push_back(triangleCount);
+
+	const size_t clusterCount{ clusterStarts.size() - 1 };
+
+	// Area weighted centroid and normal of every cluster, the length of a triangle its cross product is twice its area
+	std::vector<glm::vec3> centroids(clusterCount, glm::vec3{ 0.0f });
+	std::vector<glm::vec3> normals(clusterCount, glm::vec3{ 0.0f });
+	glm::vec3 meshCentroid{ 0.0f };
+	float meshArea{};
+
+	for (size_t cluster{}; cluster < clusterCount; ++cluster)
+	{
+		float clusterArea{};
+		for (size_t i{ clusterStarts[cluster] }; i < clusterStarts[cluster + 1]; ++i)
+		{
+			const glm::vec3& position0{ vertices[indices[i * 3]].Position };
+			const glm::vec3& position1{ vertices[indices[i * 3 + 1]].Position };
+			const glm::vec3& position2{ vertices[indices[i * 3 + 2]].Position };
+
+			const glm::vec3 normal{ glm::cross(position1 - position0, position2 - position0) };
+			const float area{ glm::length(normal) };
+
+			centroids[cluster] += (position0 + position1 + position2) * (area / 3.0f);
+			normals[cluster] += normal;
+			clusterArea += area;
+		}
+
+		meshCentroid += centroids[cluster];
+		meshArea += clusterArea;
+		if (clusterArea > 0.0f) centroids[cluster] /= clusterArea;
+	}
+
+	if (meshArea <= 0.0f) return;
+	meshCentroid /= meshArea;
+
+	// Clusters far out along their own normal are unlikely to be hidden by the rest of the mesh, they go first
+	std::vector<float> sortKeys(clusterCount, 0.0f);
+	for (size_t cluster{}; cluster < clusterCount; ++cluster)
+	{
+		const float normalLength{ glm::length(normals[cluster]) };
+		if (normalLength > 0.0f) sortKeys[cluster] = glm::dot(centroids[cluster] - meshCentroid, normals[cluster] / normalLength);
+	}
+
+	std::vector<size_t> order(clusterCount);
+	for (size_t i{}; i < clusterCount; ++i) order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<uint32_t> output{};
+	output.reserve(indices.size());
+	for (const size_t cluster : order)
+	{
+		output.insert(output.end(), indices.begin() + clusterStarts[cluster] * 3, indices.begin() + clusterStarts[cluster + 1] * 3);
+	}
+
+	std::copy(output.begin(), output.end(), indices.begin());
+}
+
+float CalculateFetchStride
+(
+	const std::vector<uint32_t>& indices,
+	size_t vertexCount,
+	size_t vertexStride
+)
+{
+	FifoCache cache{ vertexCount, g_VertexCacheSize };
+
+	uint64_t distance{};
+	uint64_t fetches{};
+	uint32_t previousVertex{};
+
+	for (const uint32_t index : indices)
+	{
+		if (cache.Load(index) == 0) continue;
+
+		if (fetches != 0) distance += (index > previousVertex) ? index - previousVertex : previousVertex - index;
+		previousVertex = index;
+		++fetches;
+	}
+
+	return (fetches < 2) ? 0.0f : float(distance * vertexStride) / float(fetches - 1);
+}
+
+void OptimizeVertexFetch
+(
+	std::vector<uint32_t>& indices,
+	std::vector<Vertex>& vertices
+)
+{
+	constexpr uint32_t unused{ std::numeric_limits<uint32_t>::max() };
+
+	std::vector<uint32_t> remap(vertices.size(), unused);
+	std::vector<Vertex> output{};
+	output.reserve(vertices.size());
+
+	for (uint32_t& index : indices)
+	{
+		uint32_t& newIndex{ remap.at(index) };
+		if (newIndex == unused)
+		{
+			newIndex = static_cast<uint32_t>(output.size());
+			output.push_back(vertices[index]);
+		}
+
+		index = newIndex;
+	}
+
+	vertices = std::move(output);
+}
+
+std::vector<uint32_t> GeneratePositionRemap
+(
+	const std::vector<Vertex>& vertices,
+	size_t& positionCount
+)
+{
+	std::unordered_map<glm::vec3, uint32_t, PositionHash> uniquePositions{};
+	uniquePositions.reserve(vertices.size());
+
+	std::vector<uint32_t> positionIds(vertices.size());
+	for (size_t i{}; i < vertices.size(); ++i)
+	{
+		positionIds[i] = uniquePositions.try_emplace(vertices[i].Position, static_cast<uint32_t>(uniquePositions.size())).first->second;
+	}
+
+	positionCount = uniquePositions.size();
+
+	return positionIds;
+}
+
+std::vector<uint32_t> SimplifyMesh
+(
+	const std::vector<uint32_t>& indices,
+	const std::vector<Vertex>& vertices,
+	size_t targetIndexCount,
+	float maxError,
+	float& error
+)
+{
+	const double maxCost{ double(maxError) * double(maxError) };
+	error = 0.0f;
+
+	// Per face tangents keep nearly every corner its own vertex, as seams they would lock the whole mesh. The caller rebuilds the tangents
+	// of the level, so vertices that only differ in their tangent are one vertex here and only uv, normal and color seams are left
+	std::vector<uint32_t> result(indices.size());
+	{
+		VertexWeldTable uniqueVertices{ vertices.size() };
+		std::vector<Vertex> uniqueAttributes{};
+		std::vector<uint32_t> firstVertices{};
+		std::vector<uint32_t> mergedVertices(vertices.size());
+
+		for (uint32_t i{}; i < static_cast<uint32_t>(vertices.size()); ++i)
+		{
+			Vertex vertex{ vertices[i] };
+			vertex.Tangent = glm::vec3{ 0.0f };
+
+			const uint32_t unique{ uniqueVertices.Insert(vertex, uniqueAttributes) };
+			if (unique == firstVertices.size()) firstVertices.push_back(i);
+			mergedVertices[i] = firstVertices[unique];
+		}
+
+		for (size_t i{}; i < indices.size(); ++i) result[i] = mergedVertices[indices[i]];
+	}
+
+	// Collapses work on positions, the vertices sharing a position (wedges) follow along
+	size_t positionCount{};
+	const std::vector<uint32_t> positionIds{ GeneratePositionRemap(vertices, positionCount) };
+
+	std::vector<uint32_t> wedgeOffsets(positionCount + 1, 0);
+	for (const uint32_t position : positionIds) ++wedgeOffsets[position + 1];
+	for (size_t i{}; i < positionCount; ++i) wedgeOffsets[i + 1] += wedgeOffsets[i];
+
+	std::vector<uint32_t> wedges(vertices.size());
+	{
+		std::vector<uint32_t> cursors{ wedgeOffsets.begin(), wedgeOffsets.end() - 1 };
+		for (uint32_t i{}; i < static_cast<uint32_t>(vertices.size()); ++i) wedges[cursors[positionIds[i]]++] = i;
+	}
+
+	// Every position starts with the planes of the triangles around it
+	std::vector<Quadric> quadrics(positionCount, Quadric{});
+	for (size_t i{}; i + 2 < result.size(); i += 3)
+	{
+		const glm::dvec3 position0{ vertices[result[i]].Position };
+		const glm::dvec3 position1{ vertices[result[i + 1]].Position };
+		const glm::dvec3 position2{ vertices[result[i + 2]].Position };
+
+		const glm::dvec3 normal{ glm::cross(position1 - position0, position2 - position0) };
+		const double length{ glm::length(normal) };
+		if (length <= 0.0) continue;
+
+		const Quadric quadric{ Quadric::FromPlane(normal / length, -glm::dot(normal / length, position0)) };
+		for (size_t j{}; j < 3; ++j) quadrics[positionIds[result[i + j]]] += quadric;
+	}
+
+	const auto edgeKey{ [](uint32_t a, uint32_t b) { return (uint64_t(std::min(a, b)) << 32) | std::max(a, b); } };
+
+	std::vector<uint32_t> remap(vertices.size());
+	std::vector<bool> locked(positionCount);
+	std::vector<bool> touched(positionCount);
+	std::vector<uint32_t> seamEdgeCounts(positionCount);
+	std::vector<uint32_t> adjacencyOffsets(vertices.size() + 1);
+	std::vector<uint32_t> adjacency{};
+	std::vector<Collapse> collapses{};
+	std::vector<uint32_t> targets{};
+	std::unordered_map<uint64_t, uint32_t> positionEdgeCounts{};
+	std::unordered_map<uint64_t, uint32_t> vertexEdgeCounts{};
+
+	while (result.size() > targetIndexCount)
+	{
+		// Triangles around every vertex
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (const uint32_t index : result) ++adjacencyOffsets[index + 1];
+		for (size_t i{}; i < vertices.size(); ++i) adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+
+		adjacency.resize(result.size());
+		{
+			std::vector<uint32_t> cursors{ adjacencyOffsets.begin(), adjacencyOffsets.end() - 1 };
+			for (size_t i{}; i < result.size(); ++i) adjacency[cursors[result[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		positionEdgeCounts.clear();
+		vertexEdgeCounts.clear();
+		for (size_t i{}; i + 2 < result.size(); i += 3)
+		{
+			for (size_t j{}; j < 3; ++j)
+			{
+				const uint32_t a{ result[i + j] };
+				const uint32_t b{ result[i + (j + 1) % 3] };
+				++positionEdgeCounts[edgeKey(positionIds[a], positionIds[b])];
+				++vertexEdgeCounts[edgeKey(a, b)];
+			}
+		}
+
+		// Open and non manifold edges never move, a seam edge is a closed edge whose two triangles don't share the vertices
+		std::fill(locked.begin(), locked.end(), false);
+		std::fill(seamEdgeCounts.begin(), seamEdgeCounts.end(), 0);
+		for (const auto& [key, count] : positionEdgeCounts)
+		{
+			const uint32_t a{ uint32_t(key >> 32) };
+			const uint32_t b{ uint32_t(key & 0xffffffff) };
+
+			if (count != 2)
+			{
+				locked[a] = true;
+				locked[b] = true;
+			}
+		}
+		for (const auto& [key, count] : vertexEdgeCounts)
+		{
+			const uint32_t a{ positionIds[uint32_t(key >> 32)] };
+			const uint32_t b{ positionIds[uint32_t(key & 0xffffffff)] };
+			if (count == 1 and positionEdgeCounts[edgeKey(a, b)] == 2)
+			{
+				++seamEdgeCounts[a];
+				++seamEdgeCounts[b];
+			}
+		}
+
+		// A seam position can only slide along its seam, where a seam turns or splits it stays put
+		const auto isSeamEdge{ [&](uint32_t a, uint32_t b) { return seamEdgeCounts[a] != 0 and seamEdgeCounts[b] != 0 and positionEdgeCounts[edgeKey(a, b)] == 2; } };
+		for (size_t i{}; i < positionCount; ++i)
+		{
+			// Every seam edge got counted once on each side
+			if (seamEdgeCounts[i] != 0 and seamEdgeCounts[i] != 4) locked[i] = true;
+		}
+
+		collapses.clear();
+		for (size_t i{}; i + 2 < result.size(); i += 3)
+		{
+			for (size_t j{}; j < 3; ++j)
+			{
+				const uint32_t a{ positionIds[result[i + j]] };
+				const uint32_t b{ positionIds[result[i + (j + 1) % 3]] };
+
+				for (const auto& [from, to] : { std::pair{ a, b }, std::pair{ b, a } })
+				{
+					if (locked[from]) continue;
+					if (seamEdgeCounts[from] != 0 and !isSeamEdge(from, to)) continue;
+
+					Quadric quadric{ quadrics[from] };
+					quadric += quadrics[to];
+					collapses.push_back(Collapse{ from, to, quadric.Evaluate(glm::dvec3{ vertices[wedges[wedgeOffsets[to]]].Position }) });
+				}
+			}
+		}
+
+		if (collapses.empty()) break;
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.Cost < b.Cost; });
+
+		for (uint32_t i{}; i < static_cast<uint32_t>(vertices.size()); ++i) remap[i] = i;
+		std::fill(touched.begin(), touched.end(), false);
+
+		// Every collapse removes about two triangles, stop once this pass removed enough
+		const size_t trianglesToRemove{ (result.size() - targetIndexCount) / 3 };
+		size_t removedTriangles{};
+
+		for (const Collapse& collapse : collapses)
+		{
+			if (removedTriangles >= trianglesToRemove or collapse.Cost > maxCost) break;
+			if (touched[collapse.Source] or touched[collapse.Target]) continue;
+
+			const glm::vec3 targetPosition{ vertices[wedges[wedgeOffsets[collapse.Target]]].Position };
+
+			// Every wedge needs exactly one neighbour at the target to move onto, otherwise the attributes can't follow
+			bool valid{ true };
+			uint32_t sharedTriangles{};
+			targets.clear();
+
+			for (uint32_t w{ wedgeOffsets[collapse.Source] }; w < wedgeOffsets[collapse.Source + 1] and valid; ++w)
+			{
+				const uint32_t wedge{ wedges[w] };
+				if (adjacencyOffsets[wedge] == adjacencyOffsets[wedge + 1]) continue;
+
+				uint32_t target{ std::numeric_limits<uint32_t>::max() };
+				for (uint32_t j{ adjacencyOffsets[wedge] }; j < adjacencyOffsets[wedge + 1] and valid; ++j)
+				{
+					const uint32_t* triangle{ &result[size_t(adjacency[j]) * 3] };
+
+					bool shared{ false };
+					for (size_t k{}; k < 3; ++k)
+					{
+						if (positionIds[triangle[k]] != collapse.Target) continue;
+
+						shared = true;
+						if (target != std::numeric_limits<uint32_t>::max() and target != triangle[k]) valid = false;
+						target = triangle[k];
+					}
+
+					if (shared)
+					{
+						++sharedTriangles;
+						continue;
+					}
+
+					// Moving the vertex may not flip any triangle that stays
+					glm::vec3 before[3]{};
+					glm::vec3 after[3]{};
+					for (size_t k{}; k < 3; ++k)
+					{
+						before[k] = vertices[triangle[k]].Position;
+						after[k] = (triangle[k] == wedge) ? targetPosition : before[k];
+					}
+
+					const glm::vec3 normalBefore{ glm::cross(before[1] - before[0], before[2] - before[0]) };
+					const glm::vec3 normalAfter{ glm::cross(after[1] - after[0], after[2] - after[0]) };
+					if (glm::dot(normalBefore, normalAfter) <= 0.0f) valid = false;
+				}
+
+				if (target == std::numeric_limits<uint32_t>::max()) valid = false;
+				targets.push_back(target);
+			}
+
+			if (!valid or targets.empty()) continue;
+
+			size_t targetIndex{};
+			for (uint32_t w{ wedgeOffsets[collapse.Source] }; w < wedgeOffsets[collapse.Source + 1]; ++w)
+			{
+				const uint32_t wedge{ wedges[w] };
+				if (adjacencyOffsets[wedge] == adjacencyOffsets[wedge + 1]) continue;
+
+				remap[wedge] = targets[targetIndex++];
+
+				// Everything around the collapse changed, leave it for the next pass
+				for (uint32_t j{ adjacencyOffsets[wedge] }; j < adjacencyOffsets[wedge + 1]; ++j)
+				{
+					const uint32_t* triangle{ &result[size_t(adjacency[j]) * 3] };
+					for (size_t k{}; k < 3; ++k) touched[positionIds[triangle[k]]] = true;
+				}
+			}
+
+			quadrics[collapse.Target] += quadrics[collapse.Source];
+			error = std::max(error, static_cast<float>(std::sqrt(collapse.Cost)));
+			removedTriangles += sharedTriangles;
+		}
+
+		if (removedTriangles == 0) break;
+
+		// Apply the collapses and drop the triangles that became degenerate
+		size_t writeIndex{};
+		for (size_t i{}; i + 2 < result.size(); i += 3)
+		{
+			const uint32_t a{ remap[result[i]] };
+			const uint32_t b{ remap[result[i + 1]] };
+			const uint32_t c{ remap[result[i + 2]] };
+			if (a == b or b == c or a == c) continue;
+
+			result[writeIndex++] = a;
+			result[writeIndex++] = b;
+			result[writeIndex++] = c;
+		}
+		result.resize(writeIndex);
+	}
+
+	return result;
+}
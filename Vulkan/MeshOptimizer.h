@@ -0,0 +1,82 @@
+#ifndef MESH_OPTIMIZER
+#define MESH_OPTIMIZER
+
+#include <vector>
+#include <cstdint>
+
+struct Vertex;
+
+// Size of the fifo post transform cache we simulate when measuring index buffers
+constexpr uint32_t g_VertexCacheSize{ 16 };
+
+// Average cache miss ratio, the number of vertex shader invocations per triangle (0.5 is ideal, 3 is the worst)
+float CalculateACMR
+(
+	const std::vector<uint32_t>& indices,
+	size_t vertexCount,
+	uint32_t cacheSize = g_VertexCacheSize
+);
+
+// Reorders the triangles for the post transform vertex cache (Tom Forsyth's linear speed algorithm)
+void OptimizeVertexCache
+(
+	std::vector<uint32_t>& indices,
+	size_t vertexCount
+);
+
+// Cache degradation allowed when splitting the index buffer into clusters for overdraw sorting, 1.05 allows 5% more misses
+constexpr float g_OverdrawThreshold{ 1.05f };
+
+// Resolution of the views the overdraw of a mesh is measured from
+constexpr uint32_t g_OverdrawViewportSize{ 256 };
+
+// Average number of fragments shaded per covered pixel with early depth testing, measured on the cpu from the six axis views (1.0 is ideal)
+float CalculateOverdraw
+(
+	const std::vector<uint32_t>& indices,
+	const std::vector<Vertex>& vertices
+);
+
+// Splits the vertex cache optimized indices into clusters and draws the outward facing ones first (Sander et al. fast triangle reordering)
+void OptimizeOverdraw
+(
+	std::vector<uint32_t>& indices,
+	const std::vector<Vertex>& vertices,
+	float threshold = g_OverdrawThreshold
+);
+
+// Average distance in bytes between consecutive vertex fetches, only cache misses fetch from memory
+float CalculateFetchStride
+(
+	const std::vector<uint32_t>& indices,
+	size_t vertexCount,
+	size_t vertexStride
+);
+
+// Renumbers the vertices in the order the index buffer first uses them, unused vertices are dropped
+void OptimizeVertexFetch
+(
+	std::vector<uint32_t>& indices,
+	std::vector<Vertex>& vertices
+);
+
+// Gives every vertex the id of its position, vertices that only differ in other attributes share an id
+std::vector<uint32_t> GeneratePositionRemap
+(
+	const std::vector<Vertex>& vertices,
+	size_t& positionCount
+);
+
+// Collapses edges by quadric error until the target index count is reached or the next collapse would cost more than maxError,
+// error is the largest collapse distance in mesh units. Tangents are ignored, vertices that only differ in theirs get merged,
+// so the level has to get its tangents rebuilt
+std::vector<uint32_t> SimplifyMesh
+(
+	const std::vector<uint32_t>& indices,
+	const std::vector<Vertex>& vertices,
+	size_t targetIndexCount,
+	float maxError,
+	float& error
+);
+
+#endif
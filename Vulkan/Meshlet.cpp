@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+#include "Meshlet.h"
+#include "Mesh.h"
+
+namespace
+{
+	struct PositionHash final
+	{
+		size_t operator()(const glm::vec3& position) const
+		{
+			size_t hash{};
+			for (int i{}; i < 3; ++i) hash = hash * 31 + std::hash<float>{}(position[i]);
+
+			return hash;
+		}
+	};
+
+	// How much a triangle facing away from the meshlet its cone counts against it, in new vertices
+	constexpr float g_MeshletConeWeight{ 2.0f };
+
+	// Triangles more than about 45 degrees away from the meshlet its average facing don't get added
+	constexpr float g_MeshletMinimumConeDot{ 0.7f };
+
+	// Which way along which axis the meshlet its cone points, meshlets that can never be back facing come last
+	uint32_t GetFacingBucket(const Meshlet& meshlet)
+	{
+		if (meshlet.ConeCutoff >= 1.0f) return 6;
+
+		const glm::vec3 axis{ glm::abs(meshlet.ConeAxis) };
+		const int major{ (axis.x >= axis.y and axis.x >= axis.z) ? 0 : ((axis.y >= axis.z) ? 1 : 2) };
+		return uint32_t(major) * 2 + ((meshlet.ConeAxis[major] < 0.0f) ? 1 : 0);
+	}
+
+	void CalculateMeshletBounds(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, Meshlet& meshlet)
+	{
+		glm::vec3 minimum{ vertices[indices[meshlet.FirstIndex]].Position };
+		glm::vec3 maximum{ minimum };
+		for (uint32_t i{ meshlet.FirstIndex }; i < meshlet.FirstIndex + meshlet.IndexCount; ++i)
+		{
+			minimum = glm::min(minimum, vertices[indices[i]].Position);
+			maximum = glm::max(maximum, vertices[indices[i]].Position);
+		}
+
+		meshlet.Center = (minimum + maximum) * 0.5f;
+		meshlet.Radius = 0.0f;
+		for (uint32_t i{ meshlet.FirstIndex }; i < meshlet.FirstIndex + meshlet.IndexCount; ++i)
+		{
+			meshlet.Radius = std::max(meshlet.Radius, glm::length(vertices[indices[i]].Position - meshlet.Center));
+		}
+
+		// The cone axis is the average of the face normals, the cutoff comes from the normal furthest away from it
+		std::vector<glm::vec3> normals{};
+		normals.reserve(meshlet.IndexCount / 3);
+
+		glm::vec3 axis{ 0.0f };
+		for (uint32_t i{ meshlet.FirstIndex }; i + 2 < meshlet.FirstIndex + meshlet.IndexCount; i += 3)
+		{
+			const glm::vec3& position0{ vertices[indices[i]].Position };
+			const glm::vec3& position1{ vertices[indices[i + 1]].Position };
+			const glm::vec3& position2{ vertices[indices[i + 2]].Position };
+
+			const glm::vec3 normal{ glm::cross(position1 - position0, position2 - position0) };
+			const float length{ glm::length(normal) };
+			if (length <= 0.0f) continue;
+
+			normals.push_back(normal / length);
+			axis += normals.back();
+		}
+
+		meshlet.ConeAxis = glm::vec3{ 0.0f, 0.0f, 1.0f };
+		meshlet.ConeCutoff = 1.0f;
+
+		const float axisLength{ glm::length(axis) };
+		if (normals.empty() or axisLength <= 0.0f) return;
+		meshlet.ConeAxis = axis / axisLength;
+
+		float minimumDot{ 1.0f };
+		for (const glm::vec3& normal : normals) minimumDot = std::min(minimumDot, glm::dot(normal, meshlet.ConeAxis));
+
+		// A spread of 90 degrees or more always has a triangle facing the camera
+		if (minimumDot <= 0.0f) return;
+		meshlet.ConeCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+	}
+}
+
+std::vector<Meshlet> BuildMeshlets
+(
+	std::vector<uint32_t>& indices,
+	const std::vector<Vertex>& vertices,
+	uint32_t maxVertices,
+	uint32_t maxTriangles
+)
+{
+	const size_t triangleCount{ indices.size() / 3 };
+	std::vector<Meshlet> meshlets{};
+	if (triangleCount == 0) return meshlets;
+
+	// Vertices split on a hard edge or uv seam still share a position, meshlets should grow across those
+	std::vector<uint32_t> positionIds(vertices.size());
+	{
+		std::unordered_map<glm::vec3, uint32_t, PositionHash> uniquePositions{};
+		uniquePositions.reserve(vertices.size());
+
+		for (size_t i{}; i < vertices.size(); ++i)
+		{
+			positionIds[i] = uniquePositions.try_emplace(vertices[i].Position, static_cast<uint32_t>(uniquePositions.size())).first->second;
+		}
+	}
+	const size_t positionCount{ *std::max_element(positionIds.begin(), positionIds.end()) + size_t(1) };
+
+	// Triangles touching each position, stored back to back
+	std::vector<uint32_t> adjacencyOffsets(positionCount + 1, 0);
+	for (size_t i{}; i < triangleCount * 3; ++i) ++adjacencyOffsets.at(positionIds.at(indices[i]) + 1);
+	for (size_t i{}; i < positionCount; ++i) adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	{
+		std::vector<uint32_t> cursors{ adjacencyOffsets.begin(), adjacencyOffsets.end() - 1 };
+		for (size_t i{}; i < triangleCount * 3; ++i) adjacency[cursors[positionIds[indices[i]]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<glm::vec3> normals(triangleCount);
+	for (size_t i{}; i < triangleCount; ++i)
+	{
+		const glm::vec3& position0{ vertices[indices[i * 3]].Position };
+		const glm::vec3& position1{ vertices[indices[i * 3 + 1]].Position };
+		const glm::vec3& position2{ vertices[indices[i * 3 + 2]].Position };
+
+		const glm::vec3 normal{ glm::cross(position1 - position0, position2 - position0) };
+		const float length{ glm::length(normal) };
+		normals[i] = (length > 0.0f) ? normal / length : glm::vec3{ 0.0f };
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> output{};
+	output.reserve(indices.size());
+
+	// Meshlet a vertex or position was last added to, plus one so zero means never
+	std::vector<uint32_t> vertexMeshlets(vertices.size(), 0);
+	std::vector<uint32_t> positionMeshlets(positionCount, 0);
+	std::vector<uint32_t> meshletVertices{};
+	meshletVertices.reserve(maxVertices);
+
+	const auto countNewVertices{ [&](size_t triangle, uint32_t meshletId)
+	{
+		uint32_t newVertices{};
+		for (size_t j{}; j < 3; ++j)
+		{
+			// A degenerate triangle can use the same vertex twice
+			const uint32_t vertex{ indices[triangle * 3 + j] };
+			if (vertexMeshlets[vertex] != meshletId and (j == 0 or vertex != indices[triangle * 3]) and (j != 2 or vertex != indices[triangle * 3 + 1])) ++newVertices;
+		}
+
+		return newVertices;
+	} };
+
+	// Vertices split by a seam or by their tangent all cost about the same, new positions tell which neighbour keeps the meshlet compact
+	const auto countNewPositions{ [&](size_t triangle, uint32_t meshletId)
+	{
+		uint32_t newPositions{};
+		for (size_t j{}; j < 3; ++j)
+		{
+			const uint32_t position{ positionIds[indices[triangle * 3 + j]] };
+			if (positionMeshlets[position] != meshletId and (j == 0 or position != positionIds[indices[triangle * 3]]) and (j != 2 or position != positionIds[indices[triangle * 3 + 1]])) ++newPositions;
+		}
+
+		return newPositions;
+	} };
+
+	size_t nextSeed{};
+	while (true)
+	{
+		// Every meshlet starts at the first triangle left in the current order, so earlier reordering mostly survives
+		while (nextSeed < triangleCount and emitted[nextSeed]) ++nextSeed;
+		if (nextSeed == triangleCount) break;
+
+		const uint32_t meshletId{ static_cast<uint32_t>(meshlets.size()) + 1 };
+		Meshlet meshlet{};
+		meshlet.FirstIndex = static_cast<uint32_t>(output.size());
+		meshletVertices.clear();
+
+		glm::vec3 axis{ 0.0f };
+		size_t triangle{ nextSeed };
+
+		while (triangle != triangleCount)
+		{
+			emitted[triangle] = true;
+			for (size_t j{}; j < 3; ++j)
+			{
+				const uint32_t vertex{ indices[triangle * 3 + j] };
+				output.push_back(vertex);
+				positionMeshlets[positionIds[vertex]] = meshletId;
+
+				if (vertexMeshlets[vertex] != meshletId)
+				{
+					vertexMeshlets[vertex] = meshletId;
+					meshletVertices.push_back(vertex);
+				}
+			}
+			meshlet.IndexCount += 3;
+			axis += normals[triangle];
+
+			if (meshlet.IndexCount / 3 == maxTriangles) break;
+
+			// Grow into the neighbour that adds the fewest positions and bends the normal cone the least, the vertex limit counts real vertices
+			const float axisLength{ glm::length(axis) };
+			const glm::vec3 direction{ (axisLength > 0.0f) ? axis / axisLength : glm::vec3{ 0.0f } };
+
+			triangle = triangleCount;
+			float bestScore{ std::numeric_limits<float>::max() };
+			for (const uint32_t vertex : meshletVertices)
+			{
+				const uint32_t position{ positionIds[vertex] };
+				for (uint32_t j{ adjacencyOffsets[position] }; j < adjacencyOffsets[position + 1]; ++j)
+				{
+					const uint32_t candidate{ adjacency[j] };
+					if (emitted[candidate]) continue;
+
+					const uint32_t newVertices{ countNewVertices(candidate, meshletId) };
+					if (meshletVertices.size() + newVertices > maxVertices) continue;
+
+					// A wide cone can never be culled, rather start a new meshlet, degenerate triangles fit anywhere
+					const bool hasFacing{ glm::dot(normals[candidate], normals[candidate]) > 0.0f and glm::dot(direction, direction) > 0.0f };
+					const float facing{ (hasFacing) ? glm::dot(normals[candidate], direction) : 1.0f };
+					if (facing < g_MeshletMinimumConeDot) continue;
+
+					const float score{ float(countNewPositions(candidate, meshletId)) + (1.0f - facing) * g_MeshletConeWeight };
+					if (score < bestScore)
+					{
+						bestScore = score;
+						triangle = candidate;
+					}
+				}
+			}
+		}
+
+		CalculateMeshletBounds(output, vertices, meshlet);
+		meshlets.push_back(meshlet);
+	}
+
+	// Meshlets facing the same way go next to each other, the ones culled from a view then form long runs that drawing can skip over.
+	// The overdraw order stays within every facing
+	std::stable_sort(meshlets.begin(), meshlets.end(), [](const Meshlet& a, const Meshlet& b) { return GetFacingBucket(a) < GetFacingBucket(b); });
+
+	indices.clear();
+	for (Meshlet& meshlet : meshlets)
+	{
+		const uint32_t firstIndex{ static_cast<uint32_t>(indices.size()) };
+		indices.insert(indices.end(), output.begin() + meshlet.FirstIndex, output.begin() + meshlet.FirstIndex + meshlet.IndexCount);
+		meshlet.FirstIndex = firstIndex;
+	}
+
+	return meshlets;
+}
+
+Frustum ExtractFrustum
+(
+	const glm::mat4& matrix
+)
+{
+	// Gribb and Hartmann, glm is column major so row i is (matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i])
+	const auto row{ [&matrix](int i) { return glm::vec4{ matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i] }; } };
+
+	Frustum frustum
+	{
+		std::array<glm::vec4, 6>
+		{
+			row(3) + row(0),		// Left
+			row(3) - row(0),		// Right
+			row(3) + row(1),		// Bottom
+			row(3) - row(1),		// Top
+			row(2),					// Near
+			row(3) - row(2)			// Far
+		}
+	};
+
+	for (glm::vec4& plane : frustum.Planes) plane /= glm::length(glm::vec3{ plane });
+
+	return frustum;
+}
+
+bool IsMeshletVisible
+(
+	const Meshlet& meshlet,
+	const Frustum& frustum,
+	const glm::vec3& cameraPosition
+)
+{
+	for (const glm::vec4& plane : frustum.Planes)
+	{
+		if (glm::dot(glm::vec3{ plane }, meshlet.Center) + plane.w < -meshlet.Radius) return false;
+	}
+
+	// Back facing when every direction from the camera into the bounding sphere lies within the back facing side of the normal cone
+	const glm::vec3 direction{ meshlet.Center - cameraPosition };
+	return glm::dot(direction, meshlet.ConeAxis) < meshlet.ConeCutoff * glm::length(direction) + meshlet.Radius;
+}
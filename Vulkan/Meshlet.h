@@ -0,0 +1,56 @@
+#ifndef MESHLET
+#define MESHLET
+
+#include <glm.hpp>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+struct Vertex;
+
+// Limits of a single meshlet, the same limits mesh shading hardware likes
+constexpr uint32_t g_MeshletMaxVertices{ 64 };
+constexpr uint32_t g_MeshletMaxTriangles{ 124 };
+
+// Contiguous range of the index buffer with bounds for culling, everything is in mesh space
+struct Meshlet final
+{
+	uint32_t FirstIndex;
+	uint32_t IndexCount;
+	glm::vec3 Center;
+	float Radius;
+	glm::vec3 ConeAxis;				// Average facing of the triangles
+	float ConeCutoff;				// Sine of the cone its spread, 1 when the meshlet can never be back facing
+};
+
+// Planes pointing inwards, xyz is the normal and w the distance
+struct Frustum final
+{
+	std::array<glm::vec4, 6> Planes;
+};
+
+// Grows meshlets over neighbouring triangles with similar facing and reorders the indices so every meshlet is one contiguous range,
+// meshlets facing the same way end up next to each other
+std::vector<Meshlet> BuildMeshlets
+(
+	std::vector<uint32_t>& indices,
+	const std::vector<Vertex>& vertices,
+	uint32_t maxVertices = g_MeshletMaxVertices,
+	uint32_t maxTriangles = g_MeshletMaxTriangles
+);
+
+// Frustum of a (projection * view * model) matrix with a zero to one depth range, the planes end up in model space
+Frustum ExtractFrustum
+(
+	const glm::mat4& matrix
+);
+
+// False when the meshlet is outside the frustum or all its triangles face away from the camera
+bool IsMeshletVisible
+(
+	const Meshlet& meshlet,
+	const Frustum& frustum,
+	const glm::vec3& cameraPosition
+);
+
+#endif
@@ -0,0 +1,713 @@
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+
+#include "PngDecoder.h"
+
+namespace
+{
+	constexpr std::array<uint8_t, 8> g_PngSignature{ 137, 80, 78, 71, 13, 10, 26, 10 };
+
+	constexpr uint32_t ChunkType(const char (&name)[5])
+	{
+		return (uint32_t(uint8_t(name[0])) << 24) | (uint32_t(uint8_t(name[1])) << 16) | (uint32_t(uint8_t(name[2])) << 8) | uint32_t(uint8_t(name[3]));
+	}
+
+	constexpr uint32_t g_WindowSize{ 32768 };
+
+	// The window gets filled up to its capacity, wide back reference copies may write a few bytes past that
+	constexpr size_t g_WindowCapacity{ size_t(g_WindowSize) * 4 };
+	constexpr size_t g_WindowOverrun{ 8 };
+
+	// https://www.rfc-editor.org/rfc/rfc1951#section-3.2.5
+	constexpr std::array<uint16_t, 29> g_LengthBases{ 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	constexpr std::array<uint8_t, 29> g_LengthExtraBits{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	constexpr std::array<uint16_t, 30> g_DistanceBases
+	{
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+	};
+	constexpr std::array<uint8_t, 30> g_DistanceExtraBits{ 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	// https://www.rfc-editor.org/rfc/rfc1951#section-3.2.7
+	constexpr std::array<uint8_t, 19> g_CodeLengthOrder{ 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	// Picks whichever of left, above and upper left is closest to left + above - upper left, ties in that order, without the three distances
+	uint8_t Paeth(int left, int above, int upperLeft)
+	{
+		const int threshold{ upperLeft * 3 - (left + above) };
+		const int low{ std::min(left, above) };
+		const int high{ std::max(left, above) };
+		const int candidate{ (high <= threshold) ? low : upperLeft };
+		return static_cast<uint8_t>((threshold <= low) ? high : candidate);
+	}
+
+	// Copies a back reference, may write up to g_WindowOverrun bytes past its end.
+	// A distance shorter than the length repeats the bytes the copy just wrote, from 8 on a word never overlaps what it reads
+	void CopyMatch(uint8_t* target, size_t distance, size_t length)
+	{
+		const uint8_t* source{ target - distance };
+		if (distance >= 8)
+		{
+			for (size_t i{}; i < length; i += 8)
+			{
+				uint64_t word{};
+				std::memcpy(&word, source + i, 8);
+				std::memcpy(target + i, &word, 8);
+			}
+		}
+		else if (distance == 1) std::memset(target, *source, length);
+		else
+		{
+			for (size_t i{}; i < length; ++i) target[i] = source[i];
+		}
+	}
+}
+
+PngDecoder::PngDecoder(const std::filesystem::path& path) :
+	m_File{ path, std::ios::binary },
+	m_Input(g_PngInputBufferSize),
+	m_InputPosition{},
+	m_InputSize{},
+	m_PastEnd{},
+	m_ChunkRemaining{},
+	m_DataEnded{ false },
+	m_Supported{ false },
+	m_Width{},
+	m_Height{},
+	m_ColorType{},
+	m_Channels{},
+	m_Palette{},
+	m_HasTransparentKey{ false },
+	m_TransparentKey{},
+	m_Bits{},
+	m_BitCount{},
+	m_State{ InflateState::BlockHeader },
+	m_FinalBlock{ false },
+	m_StoredRemaining{},
+	m_CopyLength{},
+	m_CopyDistance{},
+	m_Window(g_WindowCapacity + g_WindowOverrun),
+	m_WindowEnd{},
+	m_FixedLiterals{},
+	m_FixedDistances{},
+	m_DynamicLiterals{},
+	m_DynamicDistances{},
+	m_Literals{},
+	m_Distances{},
+	m_NextRow{},
+	m_PreviousRow{},
+	m_CurrentRow{}
+{
+	if (!m_File) throw std::runtime_error("Failed to open png file!");
+
+	ReadHeader();
+	if (!m_Supported) return;
+
+	// https://www.rfc-editor.org/rfc/rfc1951#section-3.2.6
+	std::array<uint8_t, 288> fixedLengths{};
+	std::fill(fixedLengths.begin(), fixedLengths.begin() + 144, uint8_t(8));
+	std::fill(fixedLengths.begin() + 144, fixedLengths.begin() + 256, uint8_t(9));
+	std::fill(fixedLengths.begin() + 256, fixedLengths.begin() + 280, uint8_t(7));
+	std::fill(fixedLengths.begin() + 280, fixedLengths.end(), uint8_t(8));
+	BuildTable(fixedLengths.data(), 288, m_FixedLiterals);
+
+	std::array<uint8_t, 30> fixedDistanceLengths{};
+	fixedDistanceLengths.fill(5);
+	BuildTable(fixedDistanceLengths.data(), 30, m_FixedDistances);
+
+	// https://www.rfc-editor.org/rfc/rfc1950#section-2.2
+	const uint32_t compressionMethod{ ReadCompressedByte() };
+	const uint32_t flags{ ReadCompressedByte() };
+	if ((compressionMethod * 256 + flags) % 31 != 0 or (compressionMethod & 15) != 8 or (flags & 32) != 0) throw std::runtime_error("Invalid png zlib header!");
+
+	m_PreviousRow.resize(size_t(m_Width) * m_Channels);
+	m_CurrentRow.resize(size_t(m_Width) * m_Channels);
+}
+
+bool PngDecoder::IsSupported() const
+{
+	return m_Supported;
+}
+
+uint32_t PngDecoder::GetWidth() const
+{
+	return m_Width;
+}
+
+uint32_t PngDecoder::GetHeight() const
+{
+	return m_Height;
+}
+
+void PngDecoder::DecodeRows(uint32_t rowCount, uint8_t* destination)
+{
+	if (!m_Supported) throw std::runtime_error("Png format not supported by the row decoder!");
+	if (rowCount > m_Height - m_NextRow) throw std::runtime_error("Decoding past the last png row!");
+
+	for (uint32_t row{}; row < rowCount; ++row)
+	{
+		uint8_t filter{};
+		Inflate(&filter, 1);
+		Inflate(m_CurrentRow.data(), m_CurrentRow.size());
+		Unfilter(filter);
+		ConvertRow(destination + size_t(row) * m_Width * 4);
+
+		std::swap(m_PreviousRow, m_CurrentRow);
+		++m_NextRow;
+	}
+}
+
+uint8_t PngDecoder::ReadFileByte()
+{
+	if (m_InputPosition == m_InputSize)
+	{
+		m_File.read(reinterpret_cast<char*>(m_Input.data()), static_cast<std::streamsize>(m_Input.size()));
+		m_InputSize = static_cast<size_t>(m_File.gcount());
+		m_InputPosition = 0;
+
+		// The bit buffer reads a couple of bytes ahead, past that the file was cut short
+		if (m_InputSize == 0)
+		{
+			if (++m_PastEnd > 16) throw std::runtime_error("Png file ended early!");
+			return 0;
+		}
+	}
+
+	return m_Input[m_InputPosition++];
+}
+
+uint32_t PngDecoder::ReadFileUint32()
+{
+	uint32_t value{};
+	for (int i{}; i < 4; ++i) value = (value << 8) | ReadFileByte();
+	return value;
+}
+
+uint8_t PngDecoder::ReadCompressedByte()
+{
+	// The zlib stream may be split over any number of IDAT chunks
+	while (m_ChunkRemaining == 0)
+	{
+		if (m_DataEnded)
+		{
+			if (++m_PastEnd > 16) throw std::runtime_error("Png image data ended early!");
+			return 0;
+		}
+
+		for (int i{}; i < 4; ++i) ReadFileByte();
+		m_ChunkRemaining = ReadFileUint32();
+		m_DataEnded = ReadFileUint32() != ChunkType("IDAT");
+		if (m_DataEnded) m_ChunkRemaining = 0;
+	}
+
+	--m_ChunkRemaining;
+	return ReadFileByte();
+}
+
+void PngDecoder::ReadHeader()
+{
+	// https://www.w3.org/TR/png/#5PNG-file-signature
+	for (uint8_t signatureByte : g_PngSignature)
+	{
+		if (ReadFileByte() != signatureByte) return;
+	}
+
+	for (std::array<uint8_t, 4>& entry : m_Palette) entry = std::array<uint8_t, 4>{ 0, 0, 0, 255 };
+
+	uint8_t bitDepth{};
+	uint8_t interlace{};
+	bool compressionSupported{ false };
+	uint32_t paletteSize{};
+
+	while (true)
+	{
+		const uint32_t length{ ReadFileUint32() };
+		const uint32_t type{ ReadFileUint32() };
+		if (m_PastEnd > 0) return;
+
+		// The first IDAT chunk stays open, the decoder reads its data from here on
+		if (type == ChunkType("IDAT"))
+		{
+			m_ChunkRemaining = length;
+			break;
+		}
+		if (type == ChunkType("IEND")) return;
+
+		uint32_t remaining{ length };
+		if (type == ChunkType("IHDR") and length == 13)
+		{
+			m_Width = ReadFileUint32();
+			m_Height = ReadFileUint32();
+			bitDepth = ReadFileByte();
+			m_ColorType = ReadFileByte();
+			const uint8_t compression{ ReadFileByte() };
+			const uint8_t filter{ ReadFileByte() };
+			compressionSupported = compression == 0 and filter == 0;
+			interlace = ReadFileByte();
+			remaining = 0;
+		}
+		else if (type == ChunkType("PLTE") and length % 3 == 0 and length <= 768)
+		{
+			paletteSize = length / 3;
+			for (uint32_t i{}; i < paletteSize; ++i)
+			{
+				for (int channel{}; channel < 3; ++channel) m_Palette[i][channel] = ReadFileByte();
+			}
+			remaining = 0;
+		}
+		else if (type == ChunkType("tRNS"))
+		{
+			// Palette alphas, or one 16 bit sample per channel of the color that is fully transparent
+			if (m_ColorType == 3 and length <= 256)
+			{
+				for (uint32_t i{}; i < length; ++i) m_Palette[i][3] = ReadFileByte();
+				remaining = 0;
+			}
+			else if ((m_ColorType == 0 and length == 2) or (m_ColorType == 2 and length == 6))
+			{
+				for (uint32_t i{}; i < length / 2; ++i)
+				{
+					ReadFileByte();
+					m_TransparentKey[i] = ReadFileByte();
+				}
+				m_HasTransparentKey = true;
+				remaining = 0;
+			}
+		}
+
+		for (uint32_t i{}; i < remaining; ++i) ReadFileByte();
+		for (int i{}; i < 4; ++i) ReadFileByte();
+	}
+
+	switch (m_ColorType)
+	{
+	case 0: m_Channels = 1; break;
+	case 2: m_Channels = 3; break;
+	case 3: m_Channels = 1; break;
+	case 4: m_Channels = 2; break;
+	case 6: m_Channels = 4; break;
+	default: return;
+	}
+
+	m_Supported = m_Width > 0 and m_Height > 0 and bitDepth == 8 and interlace == 0 and compressionSupported and (m_ColorType != 3 or paletteSize > 0);
+}
+
+void PngDecoder::Refill()
+{
+	// Eight bytes at once while the chunk and the input buffer have them, the bytes that don't fit get loaded again next time.
+	// Assumes a little endian host
+	if (m_ChunkRemaining >= 8 and m_InputSize - m_InputPosition >= 8)
+	{
+		uint64_t word{};
+		std::memcpy(&word, m_Input.data() + m_InputPosition, 8);
+		m_Bits |= word << m_BitCount;
+
+		const uint32_t consumed{ (63 - m_BitCount) >> 3 };
+		m_InputPosition += consumed;
+		m_ChunkRemaining -= consumed;
+		m_BitCount += consumed * 8;
+		return;
+	}
+
+	while (m_BitCount <= 56)
+	{
+		// Straight out of the input buffer, only the end of a chunk or of the buffer takes the slow path
+		if (m_ChunkRemaining > 0 and m_InputPosition < m_InputSize)
+		{
+			m_Bits |= uint64_t(m_Input[m_InputPosition++]) << m_BitCount;
+			--m_ChunkRemaining;
+		}
+		else m_Bits |= uint64_t(ReadCompressedByte()) << m_BitCount;
+
+		m_BitCount += 8;
+	}
+}
+
+uint32_t PngDecoder::GetBits(uint32_t count)
+{
+	if (m_BitCount < count) Refill();
+
+	const uint32_t value{ static_cast<uint32_t>(m_Bits & ((uint64_t(1) << count) - 1)) };
+	m_Bits >>= count;
+	m_BitCount -= count;
+	return value;
+}
+
+uint32_t PngDecoder::DecodeSymbol(const PngHuffmanTable& table)
+{
+	if (m_BitCount < 15) Refill();
+
+	const uint16_t entry{ table.Fast[m_Bits & ((uint64_t(1) << g_PngFastHuffmanBits) - 1)] };
+	if (entry != 0)
+	{
+		const uint32_t length{ uint32_t(entry) >> g_PngFastHuffmanBits };
+		m_Bits >>= length;
+		m_BitCount -= length;
+		return entry & ((1u << g_PngFastHuffmanBits) - 1);
+	}
+
+	// Walks the canonical code one bit at a time, every length's codes follow right after the previous length's
+	// https://github.com/madler/zlib/blob/master/contrib/puff/puff.c
+	int code{};
+	int first{};
+	int index{};
+	for (uint32_t length{ 1 }; length < table.Counts.size(); ++length)
+	{
+		code |= static_cast<int>(m_Bits & 1);
+		m_Bits >>= 1;
+		--m_BitCount;
+
+		const int count{ table.Counts[length] };
+		if (code - count < first) return table.Symbols[index + (code - first)];
+
+		index += count;
+		first = (first + count) << 1;
+		code <<= 1;
+	}
+
+	throw std::runtime_error("Invalid png huffman code!");
+}
+
+void PngDecoder::ReadDynamicTables()
+{
+	const uint32_t literalCount{ GetBits(5) + 257 };
+	const uint32_t distanceCount{ GetBits(5) + 1 };
+	const uint32_t codeLengthCount{ GetBits(4) + 4 };
+	if (literalCount > 286 or distanceCount > 30) throw std::runtime_error("Invalid png huffman table sizes!");
+
+	std::array<uint8_t, 19> codeLengthLengths{};
+	for (uint32_t i{}; i < codeLengthCount; ++i) codeLengthLengths[g_CodeLengthOrder[i]] = static_cast<uint8_t>(GetBits(3));
+
+	PngHuffmanTable codeLengths{};
+	BuildTable(codeLengthLengths.data(), 19, codeLengths);
+
+	// Both alphabets come as one run of lengths, repeats may cross from one into the other
+	std::array<uint8_t, 286 + 30> lengths{};
+	for (uint32_t i{}; i < literalCount + distanceCount;)
+	{
+		const uint32_t symbol{ DecodeSymbol(codeLengths) };
+		if (symbol < 16)
+		{
+			lengths[i++] = static_cast<uint8_t>(symbol);
+			continue;
+		}
+
+		uint8_t repeated{};
+		uint32_t repeat{};
+		if (symbol == 16)
+		{
+			if (i == 0) throw std::runtime_error("Png code length repeat without a previous length!");
+			repeated = lengths[i - 1];
+			repeat = 3 + GetBits(2);
+		}
+		else if (symbol == 17) repeat = 3 + GetBits(3);
+		else repeat = 11 + GetBits(7);
+
+		if (i + repeat > literalCount + distanceCount) throw std::runtime_error("Png code lengths overflow!");
+		for (uint32_t j{}; j < repeat; ++j) lengths[i++] = repeated;
+	}
+
+	if (lengths[256] == 0) throw std::runtime_error("Png huffman table without end of block!");
+
+	BuildTable(lengths.data(), literalCount, m_DynamicLiterals);
+	BuildTable(lengths.data() + literalCount, distanceCount, m_DynamicDistances);
+	m_Literals = &m_DynamicLiterals;
+	m_Distances = &m_DynamicDistances;
+}
+
+void PngDecoder::Inflate(uint8_t* destination, size_t size)
+{
+	for (size_t written{}; written < size;)
+	{
+		// Back references reach 32 KiB at most, only those get kept in front once the window runs full
+		if (m_WindowEnd == g_WindowCapacity)
+		{
+			std::memmove(m_Window.data(), m_Window.data() + m_WindowEnd - g_WindowSize, g_WindowSize);
+			m_WindowEnd = g_WindowSize;
+		}
+
+		const size_t start{ m_WindowEnd };
+		const size_t count{ std::min(size - written, g_WindowCapacity - m_WindowEnd) };
+		InflateWindow(start + count);
+
+		std::memcpy(destination + written, m_Window.data() + start, count);
+		written += count;
+	}
+}
+
+void PngDecoder::InflateWindow(size_t end)
+{
+	uint8_t* window{ m_Window.data() };
+
+	while (m_WindowEnd < end)
+	{
+		if (m_CopyLength > 0)
+		{
+			const size_t count{ std::min(end - m_WindowEnd, size_t(m_CopyLength)) };
+			CopyMatch(window + m_WindowEnd, m_CopyDistance, count);
+			m_WindowEnd += count;
+			m_CopyLength -= static_cast<uint32_t>(count);
+			continue;
+		}
+
+		switch (m_State)
+		{
+		case InflateState::BlockHeader:
+		{
+			m_FinalBlock = GetBits(1) == 1;
+
+			// https://www.rfc-editor.org/rfc/rfc1951#section-3.2.3
+			switch (GetBits(2))
+			{
+			case 0:
+			{
+				// Stored blocks start on a byte boundary
+				GetBits(m_BitCount % 8);
+				const uint32_t length{ GetBits(16) };
+				const uint32_t lengthComplement{ GetBits(16) };
+				if ((length ^ 0xFFFF) != lengthComplement) throw std::runtime_error("Invalid png stored block length!");
+
+				m_StoredRemaining = length;
+				m_State = InflateState::Stored;
+				break;
+			}
+			case 1:
+				m_Literals = &m_FixedLiterals;
+				m_Distances = &m_FixedDistances;
+				m_State = InflateState::Huffman;
+				break;
+			case 2:
+				ReadDynamicTables();
+				m_State = InflateState::Huffman;
+				break;
+			default:
+				throw std::runtime_error("Invalid png block type!");
+			}
+			break;
+		}
+		case InflateState::Stored:
+		{
+			for (; m_StoredRemaining > 0 and m_WindowEnd < end; --m_StoredRemaining) window[m_WindowEnd++] = static_cast<uint8_t>(GetBits(8));
+
+			if (m_StoredRemaining == 0) m_State = m_FinalBlock ? InflateState::Done : InflateState::BlockHeader;
+			break;
+		}
+		case InflateState::Huffman:
+			InflateHuffman(end);
+			break;
+		case InflateState::Done:
+			throw std::runtime_error("Png image data ended before the last row!");
+		}
+	}
+}
+
+void PngDecoder::InflateHuffman(size_t end)
+{
+	// Stays in here for as long as the block goes and the window has room, most of the time goes to this loop.
+	// The bit buffer and window position live in locals, the window writes could alias the members and keep them in memory
+	uint8_t* window{ m_Window.data() };
+	const PngHuffmanTable& literals{ *m_Literals };
+	const PngHuffmanTable& distances{ *m_Distances };
+	uint64_t bits{ m_Bits };
+	uint32_t bitCount{ m_BitCount };
+	size_t windowEnd{ m_WindowEnd };
+
+	const auto refill{ [&]()
+	{
+		m_Bits = bits;
+		m_BitCount = bitCount;
+		Refill();
+		bits = m_Bits;
+		bitCount = m_BitCount;
+	} };
+
+	// Codes longer than the lookup take the slow path through DecodeSymbol, it never needs to refill since 15 bits are always there
+	const auto decode{ [&](const PngHuffmanTable& table)
+	{
+		const uint16_t entry{ table.Fast[bits & ((uint64_t(1) << g_PngFastHuffmanBits) - 1)] };
+		if (entry != 0)
+		{
+			const uint32_t length{ uint32_t(entry) >> g_PngFastHuffmanBits };
+			bits >>= length;
+			bitCount -= length;
+			return uint32_t(entry) & ((1u << g_PngFastHuffmanBits) - 1);
+		}
+
+		m_Bits = bits;
+		m_BitCount = bitCount;
+		const uint32_t symbol{ DecodeSymbol(table) };
+		bits = m_Bits;
+		bitCount = m_BitCount;
+		return symbol;
+	} };
+
+	const auto getBits{ [&](uint32_t count)
+	{
+		const uint32_t value{ static_cast<uint32_t>(bits & ((uint64_t(1) << count) - 1)) };
+		bits >>= count;
+		bitCount -= count;
+		return value;
+	} };
+
+	while (windowEnd < end)
+	{
+		// One refill covers a length and a distance with their extra bits, 15 + 5 + 15 + 13, or two literals
+		if (bitCount < 48) refill();
+
+		uint32_t symbol{ decode(literals) };
+		if (symbol < 256)
+		{
+			window[windowEnd++] = static_cast<uint8_t>(symbol);
+			if (windowEnd == end) break;
+
+			symbol = decode(literals);
+			if (symbol < 256)
+			{
+				window[windowEnd++] = static_cast<uint8_t>(symbol);
+				continue;
+			}
+
+			// Two codes may have taken 30 bits, the length and distance need up to 33 more
+			if (bitCount < 33) refill();
+		}
+
+		if (symbol == 256)
+		{
+			m_State = m_FinalBlock ? InflateState::Done : InflateState::BlockHeader;
+			break;
+		}
+
+		const uint32_t lengthCode{ symbol - 257 };
+		if (lengthCode >= g_LengthBases.size()) throw std::runtime_error("Invalid png length code!");
+		const uint32_t length{ g_LengthBases[lengthCode] + getBits(g_LengthExtraBits[lengthCode]) };
+
+		const uint32_t distanceCode{ decode(distances) };
+		if (distanceCode >= g_DistanceBases.size()) throw std::runtime_error("Invalid png distance code!");
+		const uint32_t distance{ g_DistanceBases[distanceCode] + getBits(g_DistanceExtraBits[distanceCode]) };
+		if (distance > windowEnd) throw std::runtime_error("Png distance reaches before the start of the data!");
+
+		// The part past end waits for the next call
+		const size_t count{ std::min(end - windowEnd, size_t(length)) };
+		CopyMatch(window + windowEnd, distance, count);
+		windowEnd += count;
+		m_CopyLength = length - static_cast<uint32_t>(count);
+		m_CopyDistance = distance;
+	}
+
+	m_Bits = bits;
+	m_BitCount = bitCount;
+	m_WindowEnd = windowEnd;
+}
+
+void PngDecoder::Unfilter(uint8_t filter)
+{
+	// https://www.w3.org/TR/png/#9Filter-types
+	uint8_t* row{ m_CurrentRow.data() };
+	const uint8_t* previous{ m_PreviousRow.data() };
+	const size_t size{ m_CurrentRow.size() };
+	const size_t pixelSize{ m_Channels };
+
+	switch (filter)
+	{
+	case 0:
+		break;
+	case 1:
+		for (size_t i{ pixelSize }; i < size; ++i) row[i] = static_cast<uint8_t>(row[i] + row[i - pixelSize]);
+		break;
+	case 2:
+		for (size_t i{}; i < size; ++i) row[i] = static_cast<uint8_t>(row[i] + previous[i]);
+		break;
+	case 3:
+		for (size_t i{}; i < pixelSize; ++i) row[i] = static_cast<uint8_t>(row[i] + previous[i] / 2);
+		for (size_t i{ pixelSize }; i < size; ++i) row[i] = static_cast<uint8_t>(row[i] + (row[i - pixelSize] + previous[i]) / 2);
+		break;
+	case 4:
+		for (size_t i{}; i < pixelSize; ++i) row[i] = static_cast<uint8_t>(row[i] + previous[i]);
+		for (size_t i{ pixelSize }; i < size; ++i) row[i] = static_cast<uint8_t>(row[i] + Paeth(row[i - pixelSize], previous[i], previous[i - pixelSize]));
+		break;
+	default:
+		throw std::runtime_error("Invalid png filter type!");
+	}
+}
+
+void PngDecoder::ConvertRow(uint8_t* destination) const
+{
+	const uint8_t* row{ m_CurrentRow.data() };
+
+	switch (m_ColorType)
+	{
+	case 0:
+		for (uint32_t x{}; x < m_Width; ++x)
+		{
+			uint8_t* texel{ destination + size_t(x) * 4 };
+			texel[0] = texel[1] = texel[2] = row[x];
+			texel[3] = (m_HasTransparentKey and row[x] == m_TransparentKey[0]) ? uint8_t(0) : uint8_t(255);
+		}
+		break;
+	case 2:
+		for (uint32_t x{}; x < m_Width; ++x)
+		{
+			uint8_t* texel{ destination + size_t(x) * 4 };
+			const uint8_t* pixel{ row + size_t(x) * 3 };
+			texel[0] = pixel[0];
+			texel[1] = pixel[1];
+			texel[2] = pixel[2];
+			texel[3] = (m_HasTransparentKey and std::equal(pixel, pixel + 3, m_TransparentKey.begin())) ? uint8_t(0) : uint8_t(255);
+		}
+		break;
+	case 3:
+		for (uint32_t x{}; x < m_Width; ++x) std::memcpy(destination + size_t(x) * 4, m_Palette[row[x]].data(), 4);
+		break;
+	case 4:
+		for (uint32_t x{}; x < m_Width; ++x)
+		{
+			uint8_t* texel{ destination + size_t(x) * 4 };
+			texel[0] = texel[1] = texel[2] = row[size_t(x) * 2];
+			texel[3] = row[size_t(x) * 2 + 1];
+		}
+		break;
+	default:
+		std::memcpy(destination, row, size_t(m_Width) * 4);
+		break;
+	}
+}
+
+void PngDecoder::BuildTable(const uint8_t* lengths, uint32_t count, PngHuffmanTable& table)
+{
+	table.Fast.fill(0);
+	table.Counts.fill(0);
+	for (uint32_t symbol{}; symbol < count; ++symbol) ++table.Counts[lengths[symbol]];
+	table.Counts[0] = 0;
+
+	// More codes of a length than the shorter ones leave room for means the lengths are corrupt, fewer is allowed
+	int left{ 1 };
+	for (size_t length{ 1 }; length < table.Counts.size(); ++length)
+	{
+		left = (left << 1) - table.Counts[length];
+		if (left < 0) throw std::runtime_error("Invalid png huffman code lengths!");
+	}
+
+	std::array<uint16_t, 16> offsets{};
+	for (size_t length{ 1 }; length + 1 < offsets.size(); ++length) offsets[length + 1] = static_cast<uint16_t>(offsets[length] + table.Counts[length]);
+	for (uint32_t symbol{}; symbol < count; ++symbol)
+	{
+		if (lengths[symbol] != 0) table.Symbols[offsets[lengths[symbol]]++] = static_cast<uint16_t>(symbol);
+	}
+
+	// The stream holds codes starting at their most significant bit, the lookup indexes with the bits reversed
+	uint32_t code{};
+	uint32_t index{};
+	for (uint32_t length{ 1 }; length <= g_PngFastHuffmanBits; ++length)
+	{
+		for (uint32_t i{}; i < table.Counts[length]; ++i, ++code, ++index)
+		{
+			uint32_t reversed{};
+			for (uint32_t bit{}; bit < length; ++bit) reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+
+			const uint16_t entry{ static_cast<uint16_t>((length << g_PngFastHuffmanBits) | table.Symbols[index]) };
+			for (uint32_t fill{ reversed }; fill < table.Fast.size(); fill += 1u << length) table.Fast[fill] = entry;
+		}
+		code <<= 1;
+	}
+}
@@ -0,0 +1,111 @@
+#ifndef PNG_DECODER
+#define PNG_DECODER
+
+#include <filesystem>
+#include <fstream>
+#include <array>
+#include <vector>
+#include <cstdint>
+
+// Bytes of the file read at once
+constexpr size_t g_PngInputBufferSize{ size_t(64) << 10 };
+
+// Codes up to this many bits get decoded with one table lookup, longer ones bit by bit
+constexpr uint32_t g_PngFastHuffmanBits{ 9 };
+
+// Canonical huffman code of one deflate alphabet, the fast entries hold the code length above bit 9 and the symbol below it
+struct PngHuffmanTable final
+{
+	std::array<uint16_t, size_t(1) << g_PngFastHuffmanBits> Fast;
+	std::array<uint16_t, 16> Counts;				// Codes per length
+	std::array<uint16_t, 288> Symbols;				// Ordered by code
+};
+
+// Decodes a png a couple of rows at a time into rgba8, the same pixels stbi_load with STBI_rgb_alpha gives.
+// Only the input buffer, the inflate window and two rows are held, the caller decides where the pixels go,
+// so a texture can be decoded straight into mapped staging memory without the whole image ever being resident.
+// Non interlaced 8 bit images only, anything else isn't supported and has to go through stb_image.
+class PngDecoder final
+{
+public:
+	explicit PngDecoder(const std::filesystem::path& path);
+
+	PngDecoder(const PngDecoder&) = delete;
+	PngDecoder& operator=(const PngDecoder&) = delete;
+	PngDecoder(PngDecoder&&) = delete;
+	PngDecoder& operator=(PngDecoder&&) = delete;
+
+	bool IsSupported() const;
+	uint32_t GetWidth() const;
+	uint32_t GetHeight() const;
+
+	// Writes the next rowCount rows to destination, width * 4 bytes each. Throws when the file is corrupt
+	void DecodeRows(uint32_t rowCount, uint8_t* destination);
+
+private:
+	enum class InflateState
+	{
+		BlockHeader,
+		Stored,
+		Huffman,
+		Done
+	};
+
+	std::ifstream m_File;
+	std::vector<uint8_t> m_Input;
+	size_t m_InputPosition;
+	size_t m_InputSize;
+	uint32_t m_PastEnd;							// Zero bytes handed out after the end of the file
+	uint32_t m_ChunkRemaining;					// Bytes left in the current IDAT chunk
+	bool m_DataEnded;							// A chunk other than IDAT followed
+
+	bool m_Supported;
+	uint32_t m_Width;
+	uint32_t m_Height;
+	uint8_t m_ColorType;
+	uint32_t m_Channels;
+	std::array<std::array<uint8_t, 4>, 256> m_Palette;
+	bool m_HasTransparentKey;
+	std::array<uint8_t, 3> m_TransparentKey;
+
+	uint64_t m_Bits;							// Least significant bit is the next one in the stream
+	uint32_t m_BitCount;
+	InflateState m_State;
+	bool m_FinalBlock;
+	uint32_t m_StoredRemaining;
+	uint32_t m_CopyLength;
+	uint32_t m_CopyDistance;
+	std::vector<uint8_t> m_Window;				// Output gets inflated in here, at least the last 32 KiB stay for back references
+	size_t m_WindowEnd;
+	PngHuffmanTable m_FixedLiterals;
+	PngHuffmanTable m_FixedDistances;
+	PngHuffmanTable m_DynamicLiterals;
+	PngHuffmanTable m_DynamicDistances;
+	const PngHuffmanTable* m_Literals;
+	const PngHuffmanTable* m_Distances;
+
+	uint32_t m_NextRow;
+	std::vector<uint8_t> m_PreviousRow;
+	std::vector<uint8_t> m_CurrentRow;
+
+	uint8_t ReadFileByte();
+	uint32_t ReadFileUint32();
+	uint8_t ReadCompressedByte();
+	void ReadHeader();
+
+	void Refill();
+	uint32_t GetBits(uint32_t count);
+	uint32_t DecodeSymbol(const PngHuffmanTable& table);
+	void ReadDynamicTables();
+	void Inflate(uint8_t* destination, size_t size);
+	// Inflates into the window until it reaches end
+	void InflateWindow(size_t end);
+	void InflateHuffman(size_t end);
+
+	void Unfilter(uint8_t filter);
+	void ConvertRow(uint8_t* destination) const;
+
+	static void BuildTable(const uint8_t* lengths, uint32_t count, PngHuffmanTable& table);
+};
+
+#endif
@@ -1,2 +1,12 @@
 glslc.exe pbr.vert -o vert.spv
-glslc.exe pbr.frag -o frag.spv
\ No newline at end of file
+glslc.exe pbr.frag -o frag.spv
+glslc.exe pbr_packed.vert -o vert_packed.spv
+glslc.exe impostor.vert -o impostor_vert.spv
+glslc.exe impostor.frag -o impostor_frag.spv
+glslc.exe impostor_bake.vert -o impostor_bake_vert.spv
+glslc.exe -DPACKED_VERTEX impostor_bake.vert -o impostor_bake_vert_packed.spv
+glslc.exe impostor_bake.frag -o impostor_bake_frag.spv
+glslc.exe -DGPU_DRIVEN pbr.vert -o vert_gpu.spv
+glslc.exe -DGPU_DRIVEN pbr_packed.vert -o vert_packed_gpu.spv
+glslc.exe -DGPU_DRIVEN pbr.frag -o frag_gpu.spv
+glslc.exe cull.comp -o cull_comp.spv
\ No newline at end of file
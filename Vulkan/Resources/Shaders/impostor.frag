@@ -0,0 +1,77 @@
+#version 450
+
+// Define constants for RenderType corresponding to the C++ enum values
+const int RenderTypeCombined = 0;
+const int RenderTypeBaseColor = 1;
+const int RenderTypeNormal = 2;
+const int RenderTypeGlossiness = 3;
+const int RenderTypeSpecular = 4;
+
+layout(push_constant) uniform PushConstants
+{
+    vec4 BoundingSphere;
+    int FrameCount;
+    int RenderType;
+} g_PushConstants;
+
+layout(set = 1, binding = 0) uniform sampler2D g_BaseColorAtlas;
+layout(set = 1, binding = 1) uniform sampler2D g_SurfaceAtlas;
+
+layout(location = 0) in vec2 g_InTextureCoordinates;
+layout(location = 1) in vec3 g_InViewDirection;
+layout(location = 2) in mat3 g_InNormalMatrix;
+
+layout(location = 0) out vec4 g_OutColor;
+
+const vec3 g_LightDirection = vec3(0.577, -0.577, 0.577);
+const vec3 g_AmbientColor = vec3(0.03, 0.03, 0.03);
+const float g_Shininess = 25.0;
+
+vec3 DecodeOctahedral(vec2 encoded)
+{
+    vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-direction.z, 0.0);
+    direction.x += (direction.x >= 0.0) ? -fold : fold;
+    direction.y += (direction.y >= 0.0) ? -fold : fold;
+    return normalize(direction);
+}
+
+float Phong(float ks, float exponent, vec3 lightDirection, vec3 viewDirection, vec3 normal)
+{
+    const vec3 reflection = reflect(lightDirection, normal);
+    const float cosine = clamp(dot(reflection, viewDirection), 0.0, 1.0);
+    const float phong = 1.0 * ks * pow(cosine, exponent);
+    
+    return phong;
+}
+
+void main()
+{
+    const vec4 baseColor = texture(g_BaseColorAtlas, g_InTextureCoordinates);
+    if (baseColor.a < 0.5) discard;
+
+    const vec4 surface = texture(g_SurfaceAtlas, g_InTextureCoordinates);
+    const vec3 normal = normalize(g_InNormalMatrix * DecodeOctahedral(surface.rg * 2.0 - 1.0));
+
+    if(g_PushConstants.RenderType == RenderTypeCombined)
+    {
+        const float phong = Phong(surface.b, surface.a * g_Shininess, g_LightDirection, g_InViewDirection, normal);
+        g_OutColor = vec4(baseColor.rgb + vec3(phong, phong, phong) + g_AmbientColor, 1.0);
+    }
+    else if(g_PushConstants.RenderType == RenderTypeBaseColor)
+    {
+        g_OutColor = vec4(baseColor.rgb, 1.0);
+    }
+    else if(g_PushConstants.RenderType == RenderTypeNormal)
+    {
+        g_OutColor = vec4(normal * 0.5 + 0.5, 1.0);
+    }
+    else if(g_PushConstants.RenderType == RenderTypeGlossiness)
+    {
+        g_OutColor = vec4(surface.aaa, 1.0);
+    }
+    else
+    {
+        g_OutColor = vec4(surface.bbb, 1.0);
+    }
+}
\ No newline at end of file
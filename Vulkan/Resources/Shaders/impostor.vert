@@ -0,0 +1,74 @@
+#version 450
+
+layout(set = 0, binding = 0) uniform UniformBufferObject 
+{
+    mat4 ModelMatrix;
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+    vec3 CameraPosition;
+} g_UBO;
+
+layout(push_constant) uniform PushConstants
+{
+    vec4 BoundingSphere;        // Mesh space center and radius
+    int FrameCount;             // Frames along one side of the atlas
+    int RenderType;
+} g_PushConstants;
+
+layout(location = 0) out vec2 g_OutTextureCoordinates;
+layout(location = 1) out vec3 g_OutViewDirection;
+layout(location = 2) out mat3 g_OutNormalMatrix;
+
+// Two triangles, no vertex buffer needed
+const vec2 g_Corners[6] = vec2[6]
+(
+    vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+    vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0)
+);
+
+vec2 EncodeOctahedral(vec3 direction)
+{
+    const vec3 projected = direction / (abs(direction.x) + abs(direction.y) + abs(direction.z));
+    if (projected.z >= 0.0) return projected.xy;
+
+    return vec2
+    (
+        (1.0 - abs(projected.y)) * ((projected.x >= 0.0) ? 1.0 : -1.0),
+        (1.0 - abs(projected.x)) * ((projected.y >= 0.0) ? 1.0 : -1.0)
+    );
+}
+
+vec3 DecodeOctahedral(vec2 encoded)
+{
+    vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-direction.z, 0.0);
+    direction.x += (direction.x >= 0.0) ? -fold : fold;
+    direction.y += (direction.y >= 0.0) ? -fold : fold;
+    return normalize(direction);
+}
+
+void main()
+{
+    const vec3 center = g_PushConstants.BoundingSphere.xyz;
+    const float radius = g_PushConstants.BoundingSphere.w;
+    const float frameCount = float(g_PushConstants.FrameCount);
+
+    // Pick the frame baked closest to the direction we look at the mesh from
+    const vec3 cameraPosition = (inverse(g_UBO.ModelMatrix) * vec4(g_UBO.CameraPosition, 1.0)).xyz;
+    const vec2 encoded = EncodeOctahedral(normalize(cameraPosition - center));
+    const vec2 frame = clamp(floor((encoded * 0.5 + 0.5) * frameCount), vec2(0.0), vec2(frameCount - 1.0));
+
+    // Same basis the frame was baked with, see Impostor.cpp
+    const vec3 direction = DecodeOctahedral((frame + 0.5) / frameCount * 2.0 - 1.0);
+    const vec3 worldUp = (abs(direction.y) < 0.999) ? vec3(0.0, 1.0, 0.0) : vec3(0.0, 0.0, 1.0);
+    const vec3 right = normalize(cross(worldUp, direction));
+    const vec3 up = cross(direction, right);
+
+    const vec2 corner = g_Corners[gl_VertexIndex];
+    const vec4 worldPosition = g_UBO.ModelMatrix * vec4(center + (right * corner.x + up * corner.y) * radius, 1.0);
+
+    gl_Position = g_UBO.ProjectionMatrix * g_UBO.ViewMatrix * worldPosition;
+    g_OutTextureCoordinates = (frame + vec2(0.5 + corner.x * 0.5, 0.5 - corner.y * 0.5)) / frameCount;
+    g_OutViewDirection = normalize(worldPosition.xyz - g_UBO.CameraPosition);
+    g_OutNormalMatrix = mat3(g_UBO.ModelMatrix);
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#version 450
+
+layout(set = 0, binding = 0) uniform sampler2D g_BaseColorTexture;      
+layout(set = 0, binding = 1) uniform sampler2D g_NormalTexture;         
+layout(set = 0, binding = 2) uniform sampler2D g_GlossTexture;      
+layout(set = 0, binding = 3) uniform sampler2D g_SpecularTexture;               
+
+layout(location = 0) in vec2 g_InTextureCoordinates;
+layout(location = 1) in vec3 g_InNormal;
+layout(location = 2) in vec3 g_InTangent;
+
+// Base color with coverage in alpha, octahedral mesh space normal in rg, specular in b and glossiness in a
+layout(location = 0) out vec4 g_OutBaseColor;
+layout(location = 1) out vec4 g_OutSurface;
+
+// Same normal mapping as pbr.frag, so the impostor shades like the mesh
+vec3 CalculateNormal()
+{
+    const vec3 biNormal = normalize(cross(g_InNormal, g_InTangent));
+    const mat3 tangentSpaceMatrix = mat3(g_InTangent, biNormal, g_InNormal);
+    const vec3 SampledNormal = texture(g_NormalTexture, g_InTextureCoordinates).rgb;    
+    return normalize(SampledNormal * tangentSpaceMatrix);
+}
+
+vec2 EncodeOctahedral(vec3 direction)
+{
+    const vec3 projected = direction / (abs(direction.x) + abs(direction.y) + abs(direction.z));
+    if (projected.z >= 0.0) return projected.xy;
+
+    return vec2
+    (
+        (1.0 - abs(projected.y)) * ((projected.x >= 0.0) ? 1.0 : -1.0),
+        (1.0 - abs(projected.x)) * ((projected.y >= 0.0) ? 1.0 : -1.0)
+    );
+}
+
+void main()
+{
+    g_OutBaseColor = vec4(texture(g_BaseColorTexture, g_InTextureCoordinates).rgb, 1.0);
+    g_OutSurface = vec4
+    (
+        EncodeOctahedral(CalculateNormal()) * 0.5 + 0.5,
+        texture(g_SpecularTexture, g_InTextureCoordinates).r,
+        texture(g_GlossTexture, g_InTextureCoordinates).r
+    );
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#version 450
+
+// Renders one frame of the impostor atlas, everything stays in mesh space
+layout(push_constant) uniform PushConstants
+{
+    mat4 ViewProjectionMatrix;
+} g_PushConstants;
+
+#ifdef PACKED_VERTEX
+// Half and Compact vertex layouts, normal and tangent are octahedral encoded
+layout(location = 0) in vec3 g_InPosition;
+layout(location = 1) in vec2 g_InTextureCoordinates;
+layout(location = 2) in vec2 g_InNormal;
+layout(location = 3) in vec2 g_InTangent;
+#else
+layout(location = 0) in vec3 g_InPosition;
+layout(location = 1) in vec3 g_InColor;
+layout(location = 2) in vec2 g_InTextureCoordinates;
+layout(location = 3) in vec3 g_InNormal;
+layout(location = 4) in vec3 g_InTangent;
+#endif
+
+layout(location = 0) out vec2 g_OutTextureCoordinates;
+layout(location = 1) out vec3 g_OutNormal;
+layout(location = 2) out vec3 g_OutTangent;
+
+#ifdef PACKED_VERTEX
+vec3 DecodeOctahedral(vec2 encoded)
+{
+    vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-direction.z, 0.0);
+    direction.x += (direction.x >= 0.0) ? -fold : fold;
+    direction.y += (direction.y >= 0.0) ? -fold : fold;
+    return normalize(direction);
+}
+#endif
+
+void main()
+{
+    gl_Position = g_PushConstants.ViewProjectionMatrix * vec4(g_InPosition, 1.0);
+    g_OutTextureCoordinates = g_InTextureCoordinates;
+#ifdef PACKED_VERTEX
+    g_OutNormal = DecodeOctahedral(g_InNormal);
+    g_OutTangent = DecodeOctahedral(g_InTangent);
+#else
+    g_OutNormal = normalize(g_InNormal);
+    g_OutTangent = normalize(g_InTangent);
+#endif
+}
\ No newline at end of file
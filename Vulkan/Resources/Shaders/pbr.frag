@@ -11,10 +11,23 @@ layout(push_constant) uniform PushConstants {
     int RenderType;
 } g_PushConstants;
 
+// The gpu driven path draws every mesh with the same descriptor sets, its textures come out of one table
+// holding base color, normal, glossiness and specular for every material
+#ifdef GPU_DRIVEN
+layout(constant_id = 0) const uint g_MaterialCount = 1;
+layout(set = 1, binding = 0) uniform sampler2D g_TextureTable[g_MaterialCount * 4];
+layout(location = 4) flat in uint g_InMaterialIndex;
+
+#define g_BaseColorTexture g_TextureTable[g_InMaterialIndex * 4 + 0]
+#define g_NormalTexture g_TextureTable[g_InMaterialIndex * 4 + 1]
+#define g_GlossTexture g_TextureTable[g_InMaterialIndex * 4 + 2]
+#define g_SpecularTexture g_TextureTable[g_InMaterialIndex * 4 + 3]
+#else
 layout(set = 1, binding = 0) uniform sampler2D g_BaseColorTexture;      
 layout(set = 1, binding = 1) uniform sampler2D g_NormalTexture;         
 layout(set = 1, binding = 2) uniform sampler2D g_GlossTexture;      
 layout(set = 1, binding = 3) uniform sampler2D g_SpecularTexture;               
+#endif
 
 layout(location = 0) in vec2 g_InTextureCoordinates;
 layout(location = 1) in vec3 g_InViewDirection;
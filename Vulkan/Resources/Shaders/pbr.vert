@@ -8,6 +8,25 @@ layout(set = 0, binding = 0) uniform UniformBufferObject
     vec3 CameraPosition;
 } g_UBO;
 
+// The gpu driven path draws every object as an instance, the model matrix comes from the objects buffer
+#ifdef GPU_DRIVEN
+struct Object
+{
+    mat4 ModelMatrix;
+    vec4 BoundingSphere;
+    uint IndexCount;
+    uint FirstIndex;
+    int VertexOffset;
+    uint DrawGroup;
+    uint MaterialIndex;
+};
+
+layout(set = 2, binding = 0) readonly buffer Objects
+{
+    Object g_Objects[];
+};
+#endif
+
 layout(location = 0) in vec3 g_InPosition;
 layout(location = 1) in vec3 g_InColor;
 layout(location = 2) in vec2 g_InTextureCoordinates;
@@ -18,12 +37,22 @@ layout(location = 0) out vec2 g_OutTextureCoordinates;
 layout(location = 1) out vec3 g_OutViewDirection;
 layout(location = 2) out vec3 g_OutNormal;
 layout(location = 3) out vec3 g_OutTangent;
+#ifdef GPU_DRIVEN
+layout(location = 4) flat out uint g_OutMaterialIndex;
+#endif
 
 void main()
 {
-    gl_Position = g_UBO.ProjectionMatrix * g_UBO.ViewMatrix * g_UBO.ModelMatrix * vec4(g_InPosition, 1.0);
+#ifdef GPU_DRIVEN
+    mat4 modelMatrix = g_Objects[gl_InstanceIndex].ModelMatrix;
+    g_OutMaterialIndex = g_Objects[gl_InstanceIndex].MaterialIndex;
+#else
+    mat4 modelMatrix = g_UBO.ModelMatrix;
+#endif
+
+    gl_Position = g_UBO.ProjectionMatrix * g_UBO.ViewMatrix * modelMatrix * vec4(g_InPosition, 1.0);
     g_OutTextureCoordinates = g_InTextureCoordinates;
-    g_OutViewDirection = normalize((g_UBO.ModelMatrix * vec4(g_InPosition,0)).xyz - g_UBO.CameraPosition);
-    g_OutNormal = normalize((g_UBO.ModelMatrix * vec4(g_InNormal,0)).xyz);
-    g_OutTangent = normalize((g_UBO.ModelMatrix * vec4(g_InTangent,0)).xyz);
+    g_OutViewDirection = normalize((modelMatrix * vec4(g_InPosition,0)).xyz - g_UBO.CameraPosition);
+    g_OutNormal = normalize((modelMatrix * vec4(g_InNormal,0)).xyz);
+    g_OutTangent = normalize((modelMatrix * vec4(g_InTangent,0)).xyz);
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+#version 450
+
+layout(set = 0, binding = 0) uniform UniformBufferObject 
+{
+    mat4 ModelMatrix;
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+    vec3 CameraPosition;
+} g_UBO;
+
+// The gpu driven path draws every object as an instance, the model matrix comes from the objects buffer
+#ifdef GPU_DRIVEN
+struct Object
+{
+    mat4 ModelMatrix;
+    vec4 BoundingSphere;
+    uint IndexCount;
+    uint FirstIndex;
+    int VertexOffset;
+    uint DrawGroup;
+    uint MaterialIndex;
+};
+
+layout(set = 2, binding = 0) readonly buffer Objects
+{
+    Object g_Objects[];
+};
+#endif
+
+// Half and Compact vertex layouts, normal and tangent are octahedral encoded
+layout(location = 0) in vec3 g_InPosition;
+layout(location = 1) in vec2 g_InTextureCoordinates;
+layout(location = 2) in vec2 g_InNormal;
+layout(location = 3) in vec2 g_InTangent;
+
+layout(location = 0) out vec2 g_OutTextureCoordinates;
+layout(location = 1) out vec3 g_OutViewDirection;
+layout(location = 2) out vec3 g_OutNormal;
+layout(location = 3) out vec3 g_OutTangent;
+#ifdef GPU_DRIVEN
+layout(location = 4) flat out uint g_OutMaterialIndex;
+#endif
+
+vec3 DecodeOctahedral(vec2 encoded)
+{
+    vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-direction.z, 0.0);
+    direction.x += (direction.x >= 0.0) ? -fold : fold;
+    direction.y += (direction.y >= 0.0) ? -fold : fold;
+    return normalize(direction);
+}
+
+void main()
+{
+#ifdef GPU_DRIVEN
+    mat4 modelMatrix = g_Objects[gl_InstanceIndex].ModelMatrix;
+    g_OutMaterialIndex = g_Objects[gl_InstanceIndex].MaterialIndex;
+#else
+    mat4 modelMatrix = g_UBO.ModelMatrix;
+#endif
+
+    vec3 normal = DecodeOctahedral(g_InNormal);
+    vec3 tangent = DecodeOctahedral(g_InTangent);
+
+    gl_Position = g_UBO.ProjectionMatrix * g_UBO.ViewMatrix * modelMatrix * vec4(g_InPosition, 1.0);
+    g_OutTextureCoordinates = g_InTextureCoordinates;
+    g_OutViewDirection = normalize((modelMatrix * vec4(g_InPosition,0)).xyz - g_UBO.CameraPosition);
+    g_OutNormal = normalize((modelMatrix * vec4(normal,0)).xyz);
+    g_OutTangent = normalize((modelMatrix * vec4(tangent,0)).xyz);
+}
\ No newline at end of file
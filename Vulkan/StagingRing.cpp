@@ -0,0 +1,547 @@
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+#include "StagingRing.h"
+#include "HelperFunctions.h"
+
+namespace
+{
+	VkCommandPool CreateStagingCommandPool(VkDevice device, uint32_t queueFamily)
+	{
+		// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkCommandPoolCreateInfo.html
+		const VkCommandPoolCreateInfo commandPoolCreateInfo
+		{
+			VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,				// sType
+			nullptr,												// pNext
+			VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,		// flags
+			queueFamily												// queueFamilyIndex
+		};
+
+		VkCommandPool commandPool{};
+		if (vkCreateCommandPool(device, &commandPoolCreateInfo, nullptr, &commandPool) != VK_SUCCESS) throw std::runtime_error("Failed to create staging command pool!");
+		return commandPool;
+	}
+
+	VkSemaphore CreateTimelineSemaphore(VkDevice device)
+	{
+		// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkSemaphoreTypeCreateInfo.html
+		const VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo
+		{
+			VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,			// sType
+			nullptr,												// pNext
+			VK_SEMAPHORE_TYPE_TIMELINE,								// semaphoreType
+			0														// initialValue
+		};
+
+		// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkSemaphoreCreateInfo.html
+		const VkSemaphoreCreateInfo semaphoreCreateInfo
+		{
+			VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,				// sType
+			&semaphoreTypeCreateInfo,								// pNext
+			0														// flags
+		};
+
+		VkSemaphore semaphore{};
+		if (vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &semaphore) != VK_SUCCESS) throw std::runtime_error("Failed to create staging timeline semaphore!");
+		return semaphore;
+	}
+
+	VkCommandBuffer AllocateStagingCommandBuffer(VkDevice device, VkCommandPool commandPool)
+	{
+		// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkCommandBufferAllocateInfo.html
+		const VkCommandBufferAllocateInfo commandBufferAllocateInfo
+		{
+			VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,			// sType
+			nullptr,												// pNext
+			commandPool,											// commandPool
+			VK_COMMAND_BUFFER_LEVEL_PRIMARY,						// level
+			1														// commandBufferCount
+		};
+
+		VkCommandBuffer commandBuffer{};
+		if (vkAllocateCommandBuffers(device, &commandBufferAllocateInfo, &commandBuffer) != VK_SUCCESS) throw std::runtime_error("Failed to allocate staging command buffer!");
+		return commandBuffer;
+	}
+}
+
+StagingRing::StagingRing
+(
+	VkDevice device,
+	DeviceAllocator& deviceAllocator,
+	uint32_t graphicsFamily,
+	VkQueue graphicsQueue,
+	uint32_t transferFamily,
+	VkQueue transferQueue,
+	VkDeviceSize size
+) :
+	m_Device{ device },
+	m_DeviceAllocator{ deviceAllocator },
+	m_GraphicsFamily{ graphicsFamily },
+	m_GraphicsQueue{ graphicsQueue },
+	m_TransferFamily{ transferFamily },
+	m_TransferQueue{ transferQueue },
+	m_GraphicsCommandPool{ CreateStagingCommandPool(device, graphicsFamily) },
+	m_TransferCommandPool{ CreateStagingCommandPool(device, transferFamily) },
+	m_TransferTimeline{ CreateTimelineSemaphore(device) },
+	m_GraphicsTimeline{ CreateTimelineSemaphore(device) },
+	m_TransferValue{},
+	m_GraphicsValue{},
+	m_Buffer{},
+	m_Memory{},
+	m_Size{ size },
+	m_Alignment{},
+	m_Head{},
+	m_Tail{},
+	m_Recording{},
+	m_Submissions{},
+	m_RetiredValue{},
+	m_Callbacks{},
+	m_IdleSubmissions{},
+	m_BatchDepth{},
+	m_SubmissionCount{}
+{
+	// Image copies want their buffer offset on a multiple of the texel size, 16 covers every uncompressed format
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(m_DeviceAllocator.GetPhysicalDevice(), &properties);
+	m_Alignment = std::max(VkDeviceSize(16), properties.limits.optimalBufferCopyOffsetAlignment);
+
+	CreateBuffer
+	(
+		m_DeviceAllocator,
+		m_Size,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		MemoryCategory::Staging,
+		m_Buffer,
+		m_Memory
+	);
+}
+
+StagingRing::~StagingRing()
+{
+	WaitIdle();
+
+	// Destroying the pools frees their command buffers
+	vkDestroyCommandPool(m_Device, m_GraphicsCommandPool, nullptr);
+	vkDestroyCommandPool(m_Device, m_TransferCommandPool, nullptr);
+	vkDestroySemaphore(m_Device, m_TransferTimeline, nullptr);
+	vkDestroySemaphore(m_Device, m_GraphicsTimeline, nullptr);
+
+	vkDestroyBuffer(m_Device, m_Buffer, nullptr);
+	m_DeviceAllocator.Free(m_Memory);
+}
+
+void StagingRing::UploadBuffer(VkBuffer buffer, VkDeviceSize dstOffset, VkDeviceSize size, VkDeviceSize elementSize, const StagingWriter& writer)
+{
+	// Half the ring per chunk, so one chunk can be filled while the other one is still being copied
+	const VkDeviceSize maxChunkSize{ (m_Size / 2) / elementSize * elementSize };
+	if (maxChunkSize == 0) throw std::runtime_error("Staging ring is too small for one element!");
+
+	for (VkDeviceSize offset{}; offset < size; offset += maxChunkSize)
+	{
+		const VkDeviceSize chunkSize{ std::min(maxChunkSize, size - offset) };
+		const VkDeviceSize ringOffset{ Allocate(chunkSize) };
+
+		writer(static_cast<char*>(m_Memory.Map) + ringOffset, offset, chunkSize);
+
+		// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkBufferCopy.html
+		const VkBufferCopy bufferCopy
+		{
+			ringOffset,				// srcOffset
+			dstOffset + offset,		// dstOffset
+			chunkSize				// size
+		};
+		vkCmdCopyBuffer(GetCommandBuffer(), m_Buffer, buffer, 1, &bufferCopy);
+	}
+
+	// Only the uploaded range changes hands, the rest of a shared buffer stays with the graphics family
+	TransferOwnership(buffer, dstOffset, size);
+
+	if (m_BatchDepth == 0) Submit();
+}
+
+void StagingRing::UploadBuffer(VkBuffer buffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size)
+{
+	UploadBuffer(buffer, dstOffset, size, 1, [data](void* destination, VkDeviceSize offset, VkDeviceSize chunkSize)
+	{
+		memcpy(destination, static_cast<const char*>(data) + offset, static_cast<size_t>(chunkSize));
+	});
+}
+
+void StagingRing::UploadImage(VkImage image, uint32_t width, uint32_t height, uint32_t pixelSize, const StagingImageWriter& writer)
+{
+	const VkDeviceSize rowSize{ VkDeviceSize(width) * pixelSize };
+	const uint32_t maxChunkRows{ static_cast<uint32_t>(std::min(VkDeviceSize(height), (m_Size / 2) / rowSize)) };
+	if (maxChunkRows == 0) throw std::runtime_error("Staging ring is too small for one image row!");
+
+	for (uint32_t row{}; row < height; row += maxChunkRows)
+	{
+		const uint32_t chunkRows{ std::min(maxChunkRows, height - row) };
+		const VkDeviceSize chunkSize{ rowSize * chunkRows };
+		const VkDeviceSize ringOffset{ Allocate(chunkSize) };
+
+		writer(static_cast<char*>(m_Memory.Map) + ringOffset, row, chunkRows);
+
+		// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkBufferImageCopy.html
+		const VkBufferImageCopy bufferImageCopy
+		{
+			ringOffset,																// bufferOffset
+			0,																		// bufferRowLength
+			0,																		// bufferImageHeight
+			// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkImageSubresourceLayers.html
+			VkImageSubresourceLayers												// imageSubresource
+			{
+				VK_IMAGE_ASPECT_COLOR_BIT,			// aspectMask
+				0,									// mipLevel
+				0,									// baseArrayLayer
+				1									// layerCount
+			},
+			VkOffset3D{ 0, static_cast<int32_t>(row), 0 },							// imageOffset
+			VkExtent3D{ width, chunkRows, 1 }										// imageExtent
+		};
+		vkCmdCopyBufferToImage(GetCommandBuffer(), m_Buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferImageCopy);
+	}
+
+	TransferOwnership(image);
+
+	if (m_BatchDepth == 0) Submit();
+}
+
+void StagingRing::UploadImage(VkImage image, uint32_t width, uint32_t height, uint32_t pixelSize, const void* pixels)
+{
+	const size_t rowSize{ size_t(width) * pixelSize };
+	UploadImage(image, width, height, pixelSize, [pixels, rowSize](void* destination, uint32_t row, uint32_t rowCount)
+	{
+		memcpy(destination, static_cast<const char*>(pixels) + rowSize * row, rowSize * rowCount);
+	});
+}
+
+void StagingRing::Update()
+{
+	uint64_t transferValue{};
+	vkGetSemaphoreCounterValue(m_Device, m_TransferTimeline, &transferValue);
+
+	// In submission order, a graphics part never gets ahead of an older one
+	for (StagingSubmission& submission : m_Submissions)
+	{
+		if (submission.GraphicsValue != 0) continue;
+		if (submission.TransferValue > transferValue) break;
+		SubmitGraphics(submission);
+	}
+
+	uint64_t graphicsValue{};
+	vkGetSemaphoreCounterValue(m_Device, m_GraphicsTimeline, &graphicsValue);
+
+	while (!m_Submissions.empty() and m_Submissions.front().GraphicsValue != 0 and m_Submissions.front().GraphicsValue <= graphicsValue)
+	{
+		RetireOldest();
+	}
+
+	// A callback may record and submit more uploads, those only get waited on by later callbacks
+	while (!m_Callbacks.empty() and m_Callbacks.front().first <= m_RetiredValue)
+	{
+		const StagingCallback callback{ std::move(m_Callbacks.front().second) };
+		m_Callbacks.pop_front();
+		callback();
+	}
+}
+
+void StagingRing::CallWhenFinished(StagingCallback callback)
+{
+	// What is still being recorded goes out with the next submission
+	const uint64_t value{ m_Recording.TransferCommandBuffer != VK_NULL_HANDLE ? m_TransferValue + 1 : m_TransferValue };
+	m_Callbacks.emplace_back(value, std::move(callback));
+}
+
+void StagingRing::Flush()
+{
+	Submit();
+	if (m_Submissions.empty()) return;
+
+	// The copies finish in order on their queue, the newest one having finished covers all of them
+	WaitTimeline(m_TransferTimeline, m_TransferValue);
+
+	for (StagingSubmission& submission : m_Submissions)
+	{
+		if (submission.GraphicsValue == 0) SubmitGraphics(submission);
+	}
+}
+
+void StagingRing::WaitIdle()
+{
+	Flush();
+	while (!m_Submissions.empty()) RetireOldest();
+}
+
+void StagingRing::BeginBatch()
+{
+	++m_BatchDepth;
+}
+
+void StagingRing::EndBatch()
+{
+	if (m_BatchDepth == 0) throw std::runtime_error("Staging batch ended without beginning it!");
+	if (--m_BatchDepth == 0) Submit();
+}
+
+VkCommandBuffer StagingRing::GetCommandBuffer()
+{
+	if (m_Recording.TransferCommandBuffer == VK_NULL_HANDLE) BeginRecording();
+	return m_Recording.TransferCommandBuffer;
+}
+
+VkCommandBuffer StagingRing::GetGraphicsCommandBuffer()
+{
+	if (m_Recording.GraphicsCommandBuffer == VK_NULL_HANDLE) BeginRecording();
+	return m_Recording.GraphicsCommandBuffer;
+}
+
+bool StagingRing::UsesTransferQueue() const
+{
+	return m_TransferFamily != m_GraphicsFamily;
+}
+
+VkDeviceSize StagingRing::GetSize() const
+{
+	return m_Size;
+}
+
+uint32_t StagingRing::GetSubmissionCount() const
+{
+	return m_SubmissionCount;
+}
+
+VkDeviceSize StagingRing::Allocate(VkDeviceSize size)
+{
+	VkDeviceSize head{ (m_Head + m_Alignment - 1) / m_Alignment * m_Alignment };
+
+	// An allocation never wraps, the bytes left at the end of the ring get skipped
+	if (head % m_Size + size > m_Size) head += m_Size - head % m_Size;
+
+	while (head + size - m_Tail > m_Size)
+	{
+		// The copies reading the space we need might not even be submitted yet
+		if (m_Submissions.empty()) Submit();
+		if (m_Submissions.empty()) throw std::runtime_error("Staging allocation larger than the ring!");
+
+		RetireOldest();
+	}
+
+	m_Head = head + size;
+	return head % m_Size;
+}
+
+void StagingRing::BeginRecording()
+{
+	if (m_IdleSubmissions.empty())
+	{
+		StagingSubmission submission{};
+		submission.TransferCommandBuffer = AllocateStagingCommandBuffer(m_Device, m_TransferCommandPool);
+		submission.GraphicsCommandBuffer = AllocateStagingCommandBuffer(m_Device, m_GraphicsCommandPool);
+		m_IdleSubmissions.push_back(submission);
+	}
+
+	m_Recording = m_IdleSubmissions.back();
+	m_IdleSubmissions.pop_back();
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkCommandBufferBeginInfo.html
+	const VkCommandBufferBeginInfo commandBufferBeginInfo
+	{
+		VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,			// sType
+		nullptr,												// pNext
+		VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,			// flags
+		nullptr													// pInheritanceInfo
+	};
+
+	if (vkBeginCommandBuffer(m_Recording.TransferCommandBuffer, &commandBufferBeginInfo) != VK_SUCCESS) throw std::runtime_error("Failed to begin staging command buffer!");
+	if (vkBeginCommandBuffer(m_Recording.GraphicsCommandBuffer, &commandBufferBeginInfo) != VK_SUCCESS) throw std::runtime_error("Failed to begin staging command buffer!");
+}
+
+void StagingRing::TransferOwnership(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size)
+{
+	if (!UsesTransferQueue() or size == 0) return;
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkBufferMemoryBarrier.html
+	VkBufferMemoryBarrier bufferMemoryBarrier
+	{
+		VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,					// sType
+		nullptr,													// pNext
+		VK_ACCESS_TRANSFER_WRITE_BIT,								// srcAccessMask
+		0,															// dstAccessMask
+		m_TransferFamily,											// srcQueueFamilyIndex
+		m_GraphicsFamily,											// dstQueueFamilyIndex
+		buffer,														// buffer
+		offset,														// offset
+		size														// size
+	};
+	vkCmdPipelineBarrier(GetCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &bufferMemoryBarrier, 0, nullptr);
+
+	// The semaphore wait already orders the acquire after the release, it only has to make the bytes visible
+	bufferMemoryBarrier.srcAccessMask = 0;
+	bufferMemoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+	vkCmdPipelineBarrier(GetGraphicsCommandBuffer(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 1, &bufferMemoryBarrier, 0, nullptr);
+}
+
+void StagingRing::TransferOwnership(VkImage image)
+{
+	if (!UsesTransferQueue()) return;
+
+	// Every mip level, the blits filling the others run on the graphics queue. The layout stays the same on both sides
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkImageMemoryBarrier.html
+	VkImageMemoryBarrier imageMemoryBarrier
+	{
+		VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,						// sType
+		nullptr,													// pNext
+		VK_ACCESS_TRANSFER_WRITE_BIT,								// srcAccessMask
+		0,															// dstAccessMask
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,						// oldLayout
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,						// newLayout
+		m_TransferFamily,											// srcQueueFamilyIndex
+		m_GraphicsFamily,											// dstQueueFamilyIndex
+		image,														// image
+		// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkImageSubresourceRange.html
+		VkImageSubresourceRange										// subresourceRange
+		{
+			VK_IMAGE_ASPECT_COLOR_BIT,			// aspectMask
+			0,									// baseMipLevel
+			VK_REMAINING_MIP_LEVELS,			// levelCount
+			0,									// baseArrayLayer
+			1									// layerCount
+		}
+	};
+	vkCmdPipelineBarrier(GetCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+
+	imageMemoryBarrier.srcAccessMask = 0;
+	imageMemoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+	vkCmdPipelineBarrier(GetGraphicsCommandBuffer(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+}
+
+void StagingRing::Submit()
+{
+	if (m_Recording.TransferCommandBuffer == VK_NULL_HANDLE) return;
+
+	// Whatever the graphics queue runs after this, vertex fetch, shaders or more transfers, sees the copied and blitted bytes
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkMemoryBarrier.html
+	const VkMemoryBarrier memoryBarrier
+	{
+		VK_STRUCTURE_TYPE_MEMORY_BARRIER,							// sType
+		nullptr,													// pNext
+		VK_ACCESS_TRANSFER_WRITE_BIT,								// srcAccessMask
+		VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT		// dstAccessMask
+	};
+	vkCmdPipelineBarrier(m_Recording.GraphicsCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+	if (vkEndCommandBuffer(m_Recording.TransferCommandBuffer) != VK_SUCCESS) throw std::runtime_error("Failed to record staging command buffer!");
+	if (vkEndCommandBuffer(m_Recording.GraphicsCommandBuffer) != VK_SUCCESS) throw std::runtime_error("Failed to record staging command buffer!");
+
+	StagingSubmission submission{ m_Recording };
+	submission.TransferValue = ++m_TransferValue;
+	submission.GraphicsValue = 0;
+	submission.End = m_Head;
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkTimelineSemaphoreSubmitInfo.html
+	const VkTimelineSemaphoreSubmitInfo timelineSemaphoreSubmitInfo
+	{
+		VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,		// sType
+		nullptr,												// pNext
+		0,														// waitSemaphoreValueCount
+		nullptr,												// pWaitSemaphoreValues
+		1,														// signalSemaphoreValueCount
+		&submission.TransferValue								// pSignalSemaphoreValues
+	};
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkSubmitInfo.html
+	const VkSubmitInfo submitInfo
+	{
+		VK_STRUCTURE_TYPE_SUBMIT_INFO,			// sType
+		&timelineSemaphoreSubmitInfo,			// pNext
+		0,										// waitSemaphoreCount
+		nullptr,								// pWaitSemaphores
+		nullptr,								// pWaitDstStageMask
+		1,										// commandBufferCount
+		&submission.TransferCommandBuffer,		// pCommandBuffers
+		1,										// signalSemaphoreCount
+		&m_TransferTimeline						// pSignalSemaphores
+	};
+
+	if (vkQueueSubmit(m_TransferQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) throw std::runtime_error("Failed to submit staging copies!");
+
+	m_Submissions.push_back(submission);
+	m_Recording = StagingSubmission{};
+	++m_SubmissionCount;
+
+	// On one queue the graphics part simply queues up behind the copies, there is nothing to wait for
+	if (!UsesTransferQueue()) SubmitGraphics(m_Submissions.back());
+}
+
+void StagingRing::SubmitGraphics(StagingSubmission& submission)
+{
+	submission.GraphicsValue = ++m_GraphicsValue;
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkTimelineSemaphoreSubmitInfo.html
+	const VkTimelineSemaphoreSubmitInfo timelineSemaphoreSubmitInfo
+	{
+		VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,		// sType
+		nullptr,												// pNext
+		1,														// waitSemaphoreValueCount
+		&submission.TransferValue,								// pWaitSemaphoreValues
+		1,														// signalSemaphoreValueCount
+		&submission.GraphicsValue								// pSignalSemaphoreValues
+	};
+
+	const VkPipelineStageFlags waitStage{ VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkSubmitInfo.html
+	const VkSubmitInfo submitInfo
+	{
+		VK_STRUCTURE_TYPE_SUBMIT_INFO,			// sType
+		&timelineSemaphoreSubmitInfo,			// pNext
+		1,										// waitSemaphoreCount
+		&m_TransferTimeline,					// pWaitSemaphores
+		&waitStage,								// pWaitDstStageMask
+		1,										// commandBufferCount
+		&submission.GraphicsCommandBuffer,		// pCommandBuffers
+		1,										// signalSemaphoreCount
+		&m_GraphicsTimeline						// pSignalSemaphores
+	};
+
+	if (vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) throw std::runtime_error("Failed to submit staging acquires!");
+}
+
+void StagingRing::WaitTimeline(VkSemaphore timeline, uint64_t value) const
+{
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkSemaphoreWaitInfo.html
+	const VkSemaphoreWaitInfo semaphoreWaitInfo
+	{
+		VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,		// sType
+		nullptr,									// pNext
+		0,											// flags
+		1,											// semaphoreCount
+		&timeline,									// pSemaphores
+		&value										// pValues
+	};
+
+	if (vkWaitSemaphores(m_Device, &semaphoreWaitInfo, UINT64_MAX) != VK_SUCCESS) throw std::runtime_error("Failed to wait on staging timeline!");
+}
+
+void StagingRing::RetireOldest()
+{
+	StagingSubmission& oldest{ m_Submissions.front() };
+
+	// Older submissions are all retired, so this can't get the graphics parts out of order
+	if (oldest.GraphicsValue == 0)
+	{
+		WaitTimeline(m_TransferTimeline, oldest.TransferValue);
+		SubmitGraphics(oldest);
+	}
+
+	WaitTimeline(m_GraphicsTimeline, oldest.GraphicsValue);
+
+	const StagingSubmission submission{ oldest };
+	m_Submissions.pop_front();
+
+	m_Tail = submission.End;
+	m_RetiredValue = submission.TransferValue;
+	m_IdleSubmissions.push_back(submission);
+}
@@ -0,0 +1,130 @@
+#ifndef STAGING_RING
+#define STAGING_RING
+
+#include <vulkan.hpp>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <utility>
+
+#include "DeviceAllocator.h"
+
+// Bytes of the persistently mapped staging ring every upload goes through
+constexpr VkDeviceSize g_StagingRingSize{ VkDeviceSize(32) << 20 };
+
+// Fills size bytes of an upload starting at offset, destination points into the mapped ring
+using StagingWriter = std::function<void(void* destination, VkDeviceSize offset, VkDeviceSize size)>;
+// Fills rowCount tightly packed rows of an image starting at row, rows get asked for in order from the top
+using StagingImageWriter = std::function<void(void* destination, uint32_t row, uint32_t rowCount)>;
+// Runs once the uploads it waited on are done on both queues
+using StagingCallback = std::function<void()>;
+
+// Copies of one submission. The transfer part runs on the transfer queue, the graphics part takes ownership of what got
+// written and runs whatever needs a graphics queue once the copies finished. The ring space up to End gets reclaimed after both.
+struct StagingSubmission final
+{
+	VkCommandBuffer TransferCommandBuffer;
+	VkCommandBuffer GraphicsCommandBuffer;
+	uint64_t TransferValue;					// Transfer timeline value the copies signal
+	uint64_t GraphicsValue;					// Graphics timeline value, 0 while the graphics part waits to be submitted
+	VkDeviceSize End;
+};
+
+// One host visible buffer that stays mapped, uploads get written into it and copied out on the transfer queue without waiting on the copy.
+// Uploads larger than half the ring get split in chunks, the oldest submissions get waited on when the ring runs full.
+// With a dedicated transfer family the buffers and images get released by it and acquired by the graphics family,
+// the graphics part only gets submitted once the timeline semaphore of the copies got there, so the graphics queue never waits on them.
+class StagingRing final
+{
+public:
+	// Both families the same is fine, the copies then go on the graphics queue and no ownership changes hands
+	StagingRing
+	(
+		VkDevice device,
+		DeviceAllocator& deviceAllocator,
+		uint32_t graphicsFamily,
+		VkQueue graphicsQueue,
+		uint32_t transferFamily,
+		VkQueue transferQueue,
+		VkDeviceSize size = g_StagingRingSize
+	);
+	~StagingRing();
+
+	StagingRing(const StagingRing&) = delete;
+	StagingRing& operator=(const StagingRing&) = delete;
+	StagingRing(StagingRing&&) = delete;
+	StagingRing& operator=(StagingRing&&) = delete;
+
+	// Writes size bytes to dstOffset in the buffer, chunks are a multiple of elementSize so the writer never splits an element
+	void UploadBuffer(VkBuffer buffer, VkDeviceSize dstOffset, VkDeviceSize size, VkDeviceSize elementSize, const StagingWriter& writer);
+	void UploadBuffer(VkBuffer buffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+	// Copies tightly packed pixels to the first mip level of an image in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, chunks are whole rows.
+	// Every mip level ends up owned by the graphics family, still in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+	void UploadImage(VkImage image, uint32_t width, uint32_t height, uint32_t pixelSize, const StagingImageWriter& writer);
+	void UploadImage(VkImage image, uint32_t width, uint32_t height, uint32_t pixelSize, const void* pixels);
+
+	// Submits the graphics parts of the copies that finished, reclaims what both parts are done with and runs the callbacks they waited on.
+	// Never blocks so it can run every frame, graphics work submitted after it sees those uploads
+	void Update();
+	// Calls back from Update once everything recorded so far finished on both queues, the caller never has to wait on the uploads.
+	// Flush and WaitIdle don't run callbacks, the ones still waiting when the ring gets destroyed are dropped
+	void CallWhenFinished(StagingCallback callback);
+	// Submits everything and blocks until the copies finished, the graphics parts are submitted after but not waited on
+	void Flush();
+	// Blocks until every submitted copy and graphics part finished
+	void WaitIdle();
+
+	// Uploads and commands recorded until the matching EndBatch go in one submission, as long as the ring doesn't run full.
+	// Batches nest, the outermost EndBatch submits
+	void BeginBatch();
+	void EndBatch();
+
+	// Transfer command buffer the next uploads get recorded in, transitions recorded here run in order with the copies
+	VkCommandBuffer GetCommandBuffer();
+	// Graphics command buffer of the next uploads, runs after they got acquired, for blits and whatever else a transfer queue can't do
+	VkCommandBuffer GetGraphicsCommandBuffer();
+
+	bool UsesTransferQueue() const;
+	VkDeviceSize GetSize() const;
+	uint32_t GetSubmissionCount() const;
+
+private:
+	VkDevice m_Device;
+	DeviceAllocator& m_DeviceAllocator;
+	uint32_t m_GraphicsFamily;
+	VkQueue m_GraphicsQueue;
+	uint32_t m_TransferFamily;
+	VkQueue m_TransferQueue;
+	VkCommandPool m_GraphicsCommandPool;
+	VkCommandPool m_TransferCommandPool;
+	VkSemaphore m_TransferTimeline;
+	VkSemaphore m_GraphicsTimeline;
+	uint64_t m_TransferValue;						// Last value submitted to signal
+	uint64_t m_GraphicsValue;
+	VkBuffer m_Buffer;
+	DeviceAllocation m_Memory;
+	VkDeviceSize m_Size;
+	VkDeviceSize m_Alignment;
+	VkDeviceSize m_Head;							// Bytes ever handed out, the ring position is this modulo the size
+	VkDeviceSize m_Tail;							// Bytes ever reclaimed
+	StagingSubmission m_Recording;					// Command buffers are VK_NULL_HANDLE when nothing is being recorded
+	std::deque<StagingSubmission> m_Submissions;	// In flight, oldest first
+	uint64_t m_RetiredValue;						// Transfer value of the newest retired submission
+	std::deque<std::pair<uint64_t, StagingCallback>> m_Callbacks;	// Transfer value to wait for, oldest first
+	std::vector<StagingSubmission> m_IdleSubmissions;
+	uint32_t m_BatchDepth;
+	uint32_t m_SubmissionCount;
+
+	// Returns the ring offset of size free bytes, submits and waits on older copies when the ring is full
+	VkDeviceSize Allocate(VkDeviceSize size);
+	void BeginRecording();
+	// Release on the transfer family and acquire on the graphics family, nothing gets recorded when both families are the same
+	void TransferOwnership(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size);
+	void TransferOwnership(VkImage image);
+	void Submit();
+	void SubmitGraphics(StagingSubmission& submission);
+	void WaitTimeline(VkSemaphore timeline, uint64_t value) const;
+	void RetireOldest();
+};
+
+#endif
@@ -1,32 +1,167 @@
 #define STB_IMAGE_IMPLEMENTATION
 
 #include <stb_image.h>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 #include "Texture.h"
 #include "HelperFunctions.h"
+#include "Defragmenter.h"
+#include "PngDecoder.h"
 
-Texture::Texture(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool copyCommandPool, VkQueue copyQueue, const std::filesystem::path& path, VkFormat format) :
+namespace
+{
+	// Transfer source for the mipmap blits and the defragmenter
+	constexpr VkImageUsageFlags g_TextureUsage{ VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT };
+
+	// Rows of every level decoded, filtered and copied from the host at once, even so a band halves into whole rows of the next level
+	constexpr uint32_t g_HostCopyBandRows{ 64 };
+
+	VkImageMemoryBarrier CreateImageBarrier(VkImage image, uint32_t mipLevels, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask)
+	{
+		// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkImageMemoryBarrier.html
+		return VkImageMemoryBarrier
+		{
+			VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,			// sType
+			nullptr,										// pNext
+			srcAccessMask,									// srcAccessMask
+			dstAccessMask,									// dstAccessMask
+			oldLayout,										// oldLayout
+			newLayout,										// newLayout
+			VK_QUEUE_FAMILY_IGNORED,						// srcQueueFamilyIndex
+			VK_QUEUE_FAMILY_IGNORED,						// dstQueueFamilyIndex
+			image,											// image
+			// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkImageSubresourceRange.html
+			VkImageSubresourceRange							// subresourceRange
+			{
+				VK_IMAGE_ASPECT_COLOR_BIT,			// aspectMask
+				0,									// baseMipLevel
+				mipLevels,							// levelCount
+				0,									// baseArrayLayer
+				1									// layerCount
+			}
+		};
+	}
+
+	bool HasMemoryType(VkPhysicalDevice physicalDevice, uint32_t memoryTypeBits, VkMemoryPropertyFlags properties)
+	{
+		VkPhysicalDeviceMemoryProperties memoryProperties{};
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+		for (uint32_t i{}; i < memoryProperties.memoryTypeCount; ++i)
+		{
+			if ((memoryTypeBits & (1u << i)) and (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) return true;
+		}
+
+		return false;
+	}
+
+	float SrgbToLinear(float value)
+	{
+		return (value <= 0.04045f) ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float LinearToSrgb(float value)
+	{
+		return (value <= 0.0031308f) ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	// Halves an rgba8 level like the linear blit does, srgb color channels get averaged in linear space the same way the blit filters them.
+	// Every texel averages its own 2x2 footprint, so an odd last row or column is dropped. A side of one texel stays one texel, the clamp repeats it
+	void DownsampleLevel(const unsigned char* source, uint32_t width, uint32_t height, bool srgb, unsigned char* destination)
+	{
+		static const std::array<float, 256> toLinear{ []()
+		{
+			std::array<float, 256> table{};
+			for (size_t i{}; i < table.size(); ++i) table[i] = SrgbToLinear(float(i) / 255.0f);
+			return table;
+		}() };
+
+		const uint32_t mipWidth{ std::max(width / 2, 1u) };
+		const uint32_t mipHeight{ std::max(height / 2, 1u) };
+
+		for (uint32_t y{}; y < mipHeight; ++y)
+		{
+			const uint32_t y0{ std::min(y * 2, height - 1) };
+			const uint32_t y1{ std::min(y * 2 + 1, height - 1) };
+
+			for (uint32_t x{}; x < mipWidth; ++x)
+			{
+				const uint32_t x0{ std::min(x * 2, width - 1) };
+				const uint32_t x1{ std::min(x * 2 + 1, width - 1) };
+				const std::array<const unsigned char*, 4> texels
+				{
+					source + (size_t(y0) * width + x0) * 4,
+					source + (size_t(y0) * width + x1) * 4,
+					source + (size_t(y1) * width + x0) * 4,
+					source + (size_t(y1) * width + x1) * 4
+				};
+
+				unsigned char* texel{ destination + (size_t(y) * mipWidth + x) * 4 };
+				for (int channel{}; channel < 4; ++channel)
+				{
+					// Alpha is never srgb encoded
+					const bool linearize{ srgb and channel < 3 };
+
+					float sum{};
+					for (const unsigned char* sourceTexel : texels) sum += linearize ? toLinear[sourceTexel[channel]] : float(sourceTexel[channel]) / 255.0f;
+
+					const float average{ linearize ? LinearToSrgb(sum / 4.0f) : sum / 4.0f };
+					texel[channel] = static_cast<unsigned char>(std::clamp(average, 0.0f, 1.0f) * 255.0f + 0.5f);
+				}
+			}
+		}
+	}
+}
+
+Texture::Texture
+(
+	VkPhysicalDevice physicalDevice,
+	VkDevice device,
+	DeviceAllocator& deviceAllocator,
+	StagingRing& stagingRing,
+	const std::filesystem::path& path,
+	VkFormat format,
+	bool hostImageCopy
+) :
 	m_PhysicalDevice{ physicalDevice },
 	m_Device{ device },
-	m_CopyCommandPool{ copyCommandPool },
-	m_CopyQueu{ copyQueue },
+	m_DeviceAllocator{ deviceAllocator },
+	m_StagingRing{ stagingRing },
 	m_Image{},
 	m_ImageMemory{},
-	m_ImageView{}
+	m_ImageView{},
+	m_MipLevels{},
+	m_Extent{},
+	m_Format{ format },
+	m_Defragmenter{},
+	m_MovableResource{},
+	m_RetiredImage{},
+	m_RetiredImageMemory{},
+	m_RetiredImageView{},
+	m_RetiredDefragmenter{},
+	m_HostImageCopy{ hostImageCopy },
+	m_Path{ path },
+	m_ResidentSize{},
+	m_Resident{ true }
 {
 	LoadTexture(path, format);
 }
 
 Texture::~Texture()
 {
-	vkDestroyImageView(m_Device, m_ImageView, nullptr);
-	vkDestroyImage(m_Device, m_Image, nullptr);
-	vkFreeMemory(m_Device, m_ImageMemory, nullptr);
+	// Nothing gets handed to the defragmenter anymore
+	m_RetiredDefragmenter = nullptr;
+	ReleaseRetired();
+	DestroyImage();
 }
 
 VkImageView Texture::GetImageView() const
 {
-	return m_ImageView;
+	return m_RetiredImageView != VK_NULL_HANDLE ? m_RetiredImageView : m_ImageView;
 }
 
 uint32_t Texture::GetMipLevels() const
@@ -34,59 +169,314 @@ uint32_t Texture::GetMipLevels() const
 	return m_MipLevels;
 }
 
+bool Texture::UsesHostImageCopy() const
+{
+	return m_HostImageCopy;
+}
+
+void Texture::Evict()
+{
+	// Nothing worth giving up when only the smallest levels are left
+	if (!m_Resident or m_MipLevels <= g_TextureEvictedLevels) return;
+
+	const uint32_t mipLevels{ m_MipLevels - g_TextureEvictedLevels };
+	const VkExtent2D extent{ std::max(m_Extent.width >> g_TextureEvictedLevels, 1u), std::max(m_Extent.height >> g_TextureEvictedLevels, 1u) };
+
+	VkImage image{};
+	CreateImage(m_Device, extent, m_Format, VK_IMAGE_TILING_OPTIMAL, g_TextureUsage, image, mipLevels, VK_SAMPLE_COUNT_1_BIT);
+	const DeviceAllocation imageMemory{ m_DeviceAllocator.AllocateImageMemory(image, VK_IMAGE_TILING_OPTIMAL, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Textures) };
+
+	// The graphics queue owns the texture, the smaller levels get copied there
+	m_StagingRing.BeginBatch();
+	const VkCommandBuffer commandBuffer{ m_StagingRing.GetGraphicsCommandBuffer() };
+
+	const std::array<VkImageMemoryBarrier, 2> copyBarriers
+	{
+		CreateImageBarrier(m_Image, m_MipLevels, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_READ_BIT),
+		CreateImageBarrier(image, mipLevels, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT)
+	};
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(copyBarriers.size()), copyBarriers.data());
+
+	std::vector<VkImageCopy> imageCopies{};
+	for (uint32_t mipLevel{}; mipLevel < mipLevels; ++mipLevel)
+	{
+		// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkImageCopy.html
+		imageCopies.push_back(VkImageCopy
+		{
+			VkImageSubresourceLayers{ VK_IMAGE_ASPECT_COLOR_BIT, mipLevel + g_TextureEvictedLevels, 0, 1 },				// srcSubresource
+			VkOffset3D{ 0, 0, 0 },																							// srcOffset
+			VkImageSubresourceLayers{ VK_IMAGE_ASPECT_COLOR_BIT, mipLevel, 0, 1 },											// dstSubresource
+			VkOffset3D{ 0, 0, 0 },																							// dstOffset
+			VkExtent3D{ std::max(extent.width >> mipLevel, 1u), std::max(extent.height >> mipLevel, 1u), 1 }				// extent
+		});
+	}
+	vkCmdCopyImage(commandBuffer, m_Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(imageCopies.size()), imageCopies.data());
+
+	// The old image goes back to being sampled, frames keep using it until it gets released
+	const std::array<VkImageMemoryBarrier, 2> readBarriers
+	{
+		CreateImageBarrier(m_Image, m_MipLevels, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT),
+		CreateImageBarrier(image, mipLevels, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT)
+	};
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(readBarriers.size()), readBarriers.data());
+
+	m_StagingRing.EndBatch();
+
+	RetireImage();
+	m_Image = image;
+	m_ImageMemory = imageMemory;
+	m_Extent = extent;
+	m_MipLevels = mipLevels;
+	m_ImageView = CreateImageView(m_Device, m_Image, m_Format, VK_IMAGE_ASPECT_COLOR_BIT, m_MipLevels);
+
+	m_Resident = false;
+}
+
+void Texture::Restore()
+{
+	if (m_Resident) return;
+
+	RetireImage();
+	LoadTexture(m_Path, m_Format);
+
+	m_Resident = true;
+}
+
+void Texture::ReleaseRetired()
+{
+	if (m_RetiredImage == VK_NULL_HANDLE) return;
+
+	vkDestroyImageView(m_Device, m_RetiredImageView, nullptr);
+	vkDestroyImage(m_Device, m_RetiredImage, nullptr);
+	m_DeviceAllocator.Free(m_RetiredImageMemory);
+
+	m_RetiredImage = VK_NULL_HANDLE;
+	m_RetiredImageMemory = DeviceAllocation{};
+	m_RetiredImageView = VK_NULL_HANDLE;
+
+	if (m_RetiredDefragmenter != nullptr) RegisterMovable(*m_RetiredDefragmenter);
+	m_RetiredDefragmenter = nullptr;
+}
+
+bool Texture::IsResident() const
+{
+	return m_Resident;
+}
+
+uint32_t Texture::GetHeap() const
+{
+	return m_DeviceAllocator.GetHeap(m_ImageMemory);
+}
+
+VkDeviceSize Texture::GetResidentSize() const
+{
+	return m_ResidentSize;
+}
+
+void Texture::RegisterMovable(Defragmenter& defragmenter)
+{
+	m_Defragmenter = &defragmenter;
+	m_MovableResource = m_Defragmenter->RegisterImage(m_Image, m_ImageMemory, m_Extent, m_Format, g_TextureUsage, m_MipLevels, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, [this]()
+	{
+		vkDestroyImageView(m_Device, m_ImageView, nullptr);
+		m_ImageView = CreateImageView(m_Device, m_Image, m_Format, VK_IMAGE_ASPECT_COLOR_BIT, m_MipLevels);
+	});
+}
+
 void Texture::LoadTexture(const std::filesystem::path& path, VkFormat format)
 {
 	if (!std::filesystem::exists(path)) throw std::runtime_error("Invalid texture file path given!");
 
-	int textureWidth{}, textureHeight{}, textureChannels{};
-	stbi_uc* pixels{ stbi_load(path.string().c_str(), &textureWidth, &textureHeight, &textureChannels, STBI_rgb_alpha) };
-	m_MipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(textureWidth, textureHeight)))) + 1;
-	const VkDeviceSize imageSize{ VkDeviceSize(textureWidth) * VkDeviceSize(textureHeight) * 4 };
-
-	if (!pixels) throw std::runtime_error("failed to load texture image!");
-
-	VkBuffer stagingPixelBuffer{};
-	VkDeviceMemory stagingPixelBufferMemory{};
-
-	CreateBuffer
-	(
-		m_PhysicalDevice,
-		m_Device,
-		imageSize,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		stagingPixelBuffer,
-		stagingPixelBufferMemory
-	);
-
-	void* data{};
-	vkMapMemory(m_Device, stagingPixelBufferMemory, 0, imageSize, 0, &data);
-	memcpy(data, pixels, static_cast<size_t>(imageSize));
-	vkUnmapMemory(m_Device, stagingPixelBufferMemory);
-	stbi_image_free(pixels);
-
-	CreateImage
-	(
-		m_PhysicalDevice,
-		m_Device,
-		VkExtent2D{ uint32_t(textureWidth), uint32_t(textureHeight) },
-		format,
-		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		m_Image,
-		m_ImageMemory,
-		m_MipLevels,
-		VK_SAMPLE_COUNT_1_BIT
-	);
-
-	TransitionImageLayout(m_Device, m_CopyCommandPool, m_CopyQueu, m_Image, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_MipLevels);
-	CopyBufferToImage(m_Device, m_CopyCommandPool, m_CopyQueu, stagingPixelBuffer, m_Image, static_cast<uint32_t>(textureWidth), static_cast<uint32_t>(textureHeight));
-	
-	GenerateMipmaps(m_PhysicalDevice, m_Device, m_CopyCommandPool, m_CopyQueu, m_Image, format, textureWidth, textureHeight, m_MipLevels);
-
-	vkDestroyBuffer(m_Device, stagingPixelBuffer, nullptr);
-	vkFreeMemory(m_Device, stagingPixelBufferMemory, nullptr);
+	// Pngs get decoded a few rows at a time straight into wherever the upload reads them from, everything else goes through stb_image
+	PngDecoder decoder{ path };
+	stbi_uc* pixels{};
+
+	if (decoder.IsSupported())
+	{
+		m_Extent = VkExtent2D{ decoder.GetWidth(), decoder.GetHeight() };
+	}
+	else
+	{
+		int textureWidth{}, textureHeight{}, textureChannels{};
+		pixels = stbi_load(path.string().c_str(), &textureWidth, &textureHeight, &textureChannels, STBI_rgb_alpha);
+
+		if (!pixels) throw std::runtime_error("failed to load texture image!");
+		m_Extent = VkExtent2D{ uint32_t(textureWidth), uint32_t(textureHeight) };
+	}
+
+	m_MipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(m_Extent.width, m_Extent.height)))) + 1;
+
+	const size_t rowSize{ size_t(m_Extent.width) * 4 };
+	const StagingImageWriter writer{ [&decoder, pixels, rowSize](void* destination, uint32_t row, uint32_t rowCount)
+	{
+		if (pixels) memcpy(destination, pixels + rowSize * row, rowSize * rowCount);
+		else decoder.DecodeRows(rowCount, static_cast<uint8_t*>(destination));
+	} };
+
+	m_HostImageCopy = m_HostImageCopy and FormatSupportsHostImageCopy(m_PhysicalDevice, format);
+
+	VkImageUsageFlags usage{ g_TextureUsage };
+	if (m_HostImageCopy) usage |= VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT;
+	CreateImage(m_Device, m_Extent, format, VK_IMAGE_TILING_OPTIMAL, usage, m_Image, m_MipLevels, VK_SAMPLE_COUNT_1_BIT);
+
+	// Host transfer usage may limit the image to memory types the cpu can reach, without a device local one among them the texture would get sampled out of host memory, it goes through the staging ring then
+	if (m_HostImageCopy)
+	{
+		VkMemoryRequirements memoryRequirements{};
+		vkGetImageMemoryRequirements(m_Device, m_Image, &memoryRequirements);
+
+		if (!HasMemoryType(m_PhysicalDevice, memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+		{
+			vkDestroyImage(m_Device, m_Image, nullptr);
+			m_HostImageCopy = false;
+			CreateImage(m_Device, m_Extent, format, VK_IMAGE_TILING_OPTIMAL, g_TextureUsage, m_Image, m_MipLevels, VK_SAMPLE_COUNT_1_BIT);
+		}
+	}
+
+	m_ImageMemory = m_DeviceAllocator.AllocateImageMemory(m_Image, VK_IMAGE_TILING_OPTIMAL, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryCategory::Textures);
+	m_ResidentSize = m_ImageMemory.Size;
+
+	if (m_HostImageCopy) UploadFromHost(writer);
+	else UploadFromStaging(writer);
+	if (pixels) stbi_image_free(pixels);
 
 	m_ImageView = CreateImageView(m_Device, m_Image, format, VK_IMAGE_ASPECT_COLOR_BIT, m_MipLevels);	
-}
\ No newline at end of file
+}
+
+void Texture::DestroyImage()
+{
+	if (m_Defragmenter != nullptr) m_Defragmenter->Unregister(m_MovableResource);
+	m_Defragmenter = nullptr;
+
+	vkDestroyImageView(m_Device, m_ImageView, nullptr);
+	vkDestroyImage(m_Device, m_Image, nullptr);
+	m_DeviceAllocator.Free(m_ImageMemory);
+
+	m_Image = VK_NULL_HANDLE;
+	m_ImageMemory = DeviceAllocation{};
+	m_ImageView = VK_NULL_HANDLE;
+}
+
+void Texture::RetireImage()
+{
+	if (m_RetiredImage != VK_NULL_HANDLE) throw std::runtime_error("Texture replaced again before its replaced image got released!");
+
+	// The defragmenter must not move what frames are still sampling, nor what the staging ring is still filling
+	if (m_Defragmenter != nullptr) m_Defragmenter->Unregister(m_MovableResource);
+	m_RetiredDefragmenter = m_Defragmenter;
+	m_Defragmenter = nullptr;
+
+	m_RetiredImage = m_Image;
+	m_RetiredImageMemory = m_ImageMemory;
+	m_RetiredImageView = m_ImageView;
+
+	m_Image = VK_NULL_HANDLE;
+	m_ImageMemory = DeviceAllocation{};
+	m_ImageView = VK_NULL_HANDLE;
+}
+void Texture::UploadFromStaging(const StagingImageWriter& writer)
+{
+	// One submission for the transition, the copy and the blits instead of a wait on the queue for each.
+	// Blits need a graphics queue, they run once the graphics queue acquired the uploaded image
+	m_StagingRing.BeginBatch();
+	TransitionImageLayout(m_StagingRing.GetCommandBuffer(), m_Image, m_Format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_MipLevels);
+	m_StagingRing.UploadImage(m_Image, m_Extent.width, m_Extent.height, 4, writer);
+	GenerateMipmaps(m_PhysicalDevice, m_StagingRing.GetGraphicsCommandBuffer(), m_Image, m_Format, int32_t(m_Extent.width), int32_t(m_Extent.height), m_MipLevels);
+	m_StagingRing.EndBatch();
+}
+
+void Texture::UploadFromHost(const StagingImageWriter& writer)
+{
+	// The image never touches a queue before it gets sampled, so it goes straight to the layout it gets sampled in
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkHostImageLayoutTransitionInfoEXT.html
+	const VkHostImageLayoutTransitionInfoEXT hostImageLayoutTransitionInfo
+	{
+		VK_STRUCTURE_TYPE_HOST_IMAGE_LAYOUT_TRANSITION_INFO_EXT,		// sType
+		nullptr,														// pNext
+		m_Image,														// image
+		VK_IMAGE_LAYOUT_UNDEFINED,										// oldLayout
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,						// newLayout
+		// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkImageSubresourceRange.html
+		VkImageSubresourceRange											// subresourceRange
+		{
+			VK_IMAGE_ASPECT_COLOR_BIT,			// aspectMask
+			0,									// baseMipLevel
+			m_MipLevels,						// levelCount
+			0,									// baseArrayLayer
+			1									// layerCount
+		}
+	};
+
+	if (TransitionImageLayoutEXT(m_Device, 1, &hostImageLayoutTransitionInfo) != VK_SUCCESS) throw std::runtime_error("Failed to transition texture on the host!");
+
+	// Every level holds one band of rows instead of the whole chain being resident. The mips get filtered on the cpu since there is no queue to blit on,
+	// a full band and the last one of a level get copied into the image and halved into the next level's band
+	std::vector<std::vector<unsigned char>> bands(m_MipLevels);
+	std::vector<uint32_t> bandFirstRows(m_MipLevels);
+	std::vector<uint32_t> bandRowCounts(m_MipLevels);
+	for (uint32_t level{}; level < m_MipLevels; ++level) bands.at(level).resize(size_t(std::max(m_Extent.width >> level, 1u)) * g_HostCopyBandRows * 4);
+
+	const bool srgb{ m_Format == VK_FORMAT_R8G8B8A8_SRGB };
+	for (uint32_t row{}; row < m_Extent.height; row += g_HostCopyBandRows)
+	{
+		bandRowCounts.at(0) = std::min(g_HostCopyBandRows, m_Extent.height - row);
+		writer(bands.at(0).data(), row, bandRowCounts.at(0));
+
+		for (uint32_t level{}; level < m_MipLevels; ++level)
+		{
+			const uint32_t width{ std::max(m_Extent.width >> level, 1u) };
+			const uint32_t height{ std::max(m_Extent.height >> level, 1u) };
+			const uint32_t firstRow{ bandFirstRows.at(level) };
+			const uint32_t rowCount{ bandRowCounts.at(level) };
+			if (rowCount == 0 or (rowCount < g_HostCopyBandRows and firstRow + rowCount < height)) break;
+
+			// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkMemoryToImageCopyEXT.html
+			const VkMemoryToImageCopyEXT region
+			{
+				VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_EXT,								// sType
+				nullptr,																// pNext
+				bands.at(level).data(),													// pHostPointer
+				0,																		// memoryRowLength
+				0,																		// memoryImageHeight
+				// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkImageSubresourceLayers.html
+				VkImageSubresourceLayers												// imageSubresource
+				{
+					VK_IMAGE_ASPECT_COLOR_BIT,			// aspectMask
+					level,								// mipLevel
+					0,									// baseArrayLayer
+					1									// layerCount
+				},
+				VkOffset3D{ 0, int32_t(firstRow), 0 },									// imageOffset
+				VkExtent3D{ width, rowCount, 1 }										// imageExtent
+			};
+
+			// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkCopyMemoryToImageInfoEXT.html
+			const VkCopyMemoryToImageInfoEXT copyMemoryToImageInfo
+			{
+				VK_STRUCTURE_TYPE_COPY_MEMORY_TO_IMAGE_INFO_EXT,		// sType
+				nullptr,												// pNext
+				0,														// flags
+				m_Image,												// dstImage
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,				// dstImageLayout
+				1,														// regionCount
+				&region													// pRegions
+			};
+
+			if (CopyMemoryToImageEXT(m_Device, &copyMemoryToImageInfo) != VK_SUCCESS) throw std::runtime_error("Failed to copy texture from the host!");
+
+			bandFirstRows.at(level) += rowCount;
+			bandRowCounts.at(level) = 0;
+			if (level + 1 == m_MipLevels) break;
+
+			// Bands start on even rows, so the halved rows continue the next level's band. A last band of one row past an even height has nothing left to add
+			const uint32_t mipHeight{ std::max(height / 2, 1u) };
+			const uint32_t mipRow{ bandFirstRows.at(level + 1) + bandRowCounts.at(level + 1) };
+			const uint32_t mipRowCount{ std::min(std::max(rowCount / 2, 1u), mipHeight - mipRow) };
+			if (mipRowCount == 0) break;
+
+			const size_t mipRowSize{ size_t(std::max(width / 2, 1u)) * 4 };
+			DownsampleLevel(bands.at(level).data(), width, rowCount, srgb, bands.at(level + 1).data() + mipRowSize * bandRowCounts.at(level + 1));
+			bandRowCounts.at(level + 1) += mipRowCount;
+		}
+	}
+}
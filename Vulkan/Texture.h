@@ -4,10 +4,29 @@
 #include <vulkan.hpp>
 #include <filesystem>
 
+#include "DeviceAllocator.h"
+#include "StagingRing.h"
+
+class Defragmenter;
+
+// Largest mip levels an evicted texture gives up, it gets sampled from the smaller ones until it is restored
+constexpr uint32_t g_TextureEvictedLevels{ 2 };
+
 class Texture
 {
 public:
-	Texture(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool copyCommandPool, VkQueue copyQueue, const std::filesystem::path& path, VkFormat format);
+	// The upload, layout transitions and mip blits get recorded in the staging ring, inside a batch they share its submission.
+	// With host image copy the pixels and mips get written into the image by the cpu instead, the staging ring isn't used
+	Texture
+	(
+		VkPhysicalDevice physicalDevice,
+		VkDevice device,
+		DeviceAllocator& deviceAllocator,
+		StagingRing& stagingRing,
+		const std::filesystem::path& path,
+		VkFormat format,
+		bool hostImageCopy
+	);
 	~Texture();
 
 	Texture(const Texture&) = delete;
@@ -15,20 +34,55 @@ public:
 	Texture(Texture&&) = delete;
 	Texture& operator=(Texture&&) = delete;
 
+	// The view to sample, the one of the replaced image until ReleaseRetired
 	VkImageView GetImageView() const;
 	uint32_t GetMipLevels() const;
+	// False when the format or the memory types didn't allow it, even if it was asked for
+	bool UsesHostImageCopy() const;
+	// Lets the defragmenter move the image, the image view gets recreated so descriptor sets using it have to be rewritten after a commit
+	void RegisterMovable(Defragmenter& defragmenter);
+
+	// Replaces the image with one without the largest mip levels, the copy goes out on the graphics queue without waiting on it
+	void Evict();
+	// Replaces the image with the file loaded again the way the constructor did, the upload goes out without waiting on it
+	void Restore();
+	// Once the staging ring finished the copy or upload of Evict or Restore and no frame uses the replaced image anymore,
+	// it gets destroyed and the new one is what gets sampled. Like a move, the descriptor sets have to be rewritten after
+	void ReleaseRetired();
+	bool IsResident() const;
+	uint32_t GetHeap() const;
+	// Bytes the image takes with every mip level
+	VkDeviceSize GetResidentSize() const;
 
 private:
 	VkPhysicalDevice m_PhysicalDevice;
 	VkDevice m_Device;
-	VkCommandPool m_CopyCommandPool;
-	VkQueue m_CopyQueu;
+	DeviceAllocator& m_DeviceAllocator;
+	StagingRing& m_StagingRing;
 	VkImage m_Image;						// VkImage is like a buffer but allows some easy of use for textures like 2D indexing
-	VkDeviceMemory m_ImageMemory;
+	DeviceAllocation m_ImageMemory;
 	VkImageView m_ImageView;
 	uint32_t m_MipLevels;
+	VkExtent2D m_Extent;
+	VkFormat m_Format;
+	Defragmenter* m_Defragmenter;
+	uint32_t m_MovableResource;
+	VkImage m_RetiredImage;					// Replaced by Evict or Restore, still sampled until ReleaseRetired
+	DeviceAllocation m_RetiredImageMemory;
+	VkImageView m_RetiredImageView;
+	Defragmenter* m_RetiredDefragmenter;	// Gets the new image once the old one is released, it can't move while it is being filled
+	bool m_HostImageCopy;
+	std::filesystem::path m_Path;
+	VkDeviceSize m_ResidentSize;
+	bool m_Resident;
 
 	void LoadTexture(const std::filesystem::path& path, VkFormat format);
+	void DestroyImage();
+	// Keeps the image around to be sampled, the defragmenter lets go of it
+	void RetireImage();
+	// The writer hands out the pixels of the first level in rows, either decoded on the spot or copied from what stb_image loaded
+	void UploadFromStaging(const StagingImageWriter& writer);
+	void UploadFromHost(const StagingImageWriter& writer);
 };
 
 #endif
\ No newline at end of file
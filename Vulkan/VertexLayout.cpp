@@ -0,0 +1,217 @@
+#include <gtc/packing.hpp>
+#include <cmath>
+#include <algorithm>
+
+#include "VertexLayout.h"
+
+glm::vec2 EncodeOctahedral
+(
+	const glm::vec3& direction
+)
+{
+	const float length{ std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z) };
+	if (length <= 0.0f) return glm::vec2{ 0.0f };
+
+	const glm::vec3 projected{ direction / length };
+	if (projected.z >= 0.0f) return glm::vec2{ projected.x, projected.y };
+
+	// The lower hemisphere gets folded over the diagonals
+	return glm::vec2
+	{
+		(1.0f - std::abs(projected.y)) * ((projected.x >= 0.0f) ? 1.0f : -1.0f),
+		(1.0f - std::abs(projected.x)) * ((projected.y >= 0.0f) ? 1.0f : -1.0f)
+	};
+}
+
+glm::vec3 DecodeOctahedral
+(
+	const glm::vec2& encoded
+)
+{
+	glm::vec3 direction{ encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y) };
+
+	// Unfold the lower hemisphere again
+	const float fold{ std::max(-direction.z, 0.0f) };
+	direction.x += (direction.x >= 0.0f) ? -fold : fold;
+	direction.y += (direction.y >= 0.0f) ? -fold : fold;
+
+	return glm::normalize(direction);
+}
+
+namespace
+{
+	void PackHalfPosition(const glm::vec3& position, uint16_t* output)
+	{
+		for (int i{}; i < 3; ++i) output[i] = glm::packHalf1x16(position[i]);
+		output[3] = glm::packHalf1x16(1.0f);
+	}
+
+	void PackHalfTextureCoordinates(const glm::vec2& textureCoordinates, uint16_t* output)
+	{
+		output[0] = glm::packHalf1x16(textureCoordinates.x);
+		output[1] = glm::packHalf1x16(textureCoordinates.y);
+	}
+
+	void PackOctahedral16(const glm::vec3& direction, int16_t* output)
+	{
+		const glm::vec2 encoded{ EncodeOctahedral(direction) };
+		output[0] = static_cast<int16_t>(glm::packSnorm1x16(encoded.x));
+		output[1] = static_cast<int16_t>(glm::packSnorm1x16(encoded.y));
+	}
+
+	void PackOctahedral8(const glm::vec3& direction, int8_t* output)
+	{
+		const glm::vec2 encoded{ EncodeOctahedral(direction) };
+		output[0] = static_cast<int8_t>(glm::packSnorm1x8(encoded.x));
+		output[1] = static_cast<int8_t>(glm::packSnorm1x8(encoded.y));
+	}
+}
+
+Vertex VertexFormat<VertexLayout::Float>::Pack(const Vertex& vertex)
+{
+	return vertex;
+}
+
+VkVertexInputBindingDescription VertexFormat<VertexLayout::Float>::GetBindingDescription()
+{
+	return Vertex::GetBindingDescription();
+}
+
+std::vector<VkVertexInputAttributeDescription> VertexFormat<VertexLayout::Float>::GetAttributeDescriptions()
+{
+	const auto attributeDescriptions{ Vertex::GetAttributeDescriptions() };
+
+	return std::vector<VkVertexInputAttributeDescription>{ attributeDescriptions.begin(), attributeDescriptions.end() };
+}
+
+HalfVertex VertexFormat<VertexLayout::Half>::Pack(const Vertex& vertex)
+{
+	HalfVertex packed{};
+	PackHalfPosition(vertex.Position, packed.Position);
+	PackHalfTextureCoordinates(vertex.TextureCoordinates, packed.TextureCoordinates);
+	PackOctahedral16(vertex.Normal, packed.Normal);
+	PackOctahedral16(vertex.Tangent, packed.Tangent);
+
+	return packed;
+}
+
+VkVertexInputBindingDescription VertexFormat<VertexLayout::Half>::GetBindingDescription()
+{
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkVertexInputBindingDescription.html
+	const VkVertexInputBindingDescription bindingDescription
+	{
+		0,									// binding
+		sizeof(HalfVertex),					// stride
+		VK_VERTEX_INPUT_RATE_VERTEX			// inputRate
+	};
+
+	return bindingDescription;
+}
+
+std::vector<VkVertexInputAttributeDescription> VertexFormat<VertexLayout::Half>::GetAttributeDescriptions()
+{
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkVertexInputAttributeDescription.html
+	const std::vector<VkVertexInputAttributeDescription> attributeDescriptions
+	{
+		// Position
+		VkVertexInputAttributeDescription
+		{
+			0,										// location
+			0,										// binding
+			VK_FORMAT_R16G16B16A16_SFLOAT,			// format
+			offsetof(HalfVertex, Position)			// offset
+		},
+		// Texture coordinates
+		VkVertexInputAttributeDescription
+		{
+			1,
+			0,
+			VK_FORMAT_R16G16_SFLOAT,
+			offsetof(HalfVertex, TextureCoordinates)
+		},
+		// Normal
+		VkVertexInputAttributeDescription
+		{
+			2,
+			0,
+			VK_FORMAT_R16G16_SNORM,
+			offsetof(HalfVertex, Normal)
+		},
+		// Tangent
+		VkVertexInputAttributeDescription
+		{
+			3,
+			0,
+			VK_FORMAT_R16G16_SNORM,
+			offsetof(HalfVertex, Tangent)
+		}
+	};
+
+	return attributeDescriptions;
+}
+
+CompactVertex VertexFormat<VertexLayout::Compact>::Pack(const Vertex& vertex)
+{
+	CompactVertex packed{};
+	PackHalfPosition(vertex.Position, packed.Position);
+	PackHalfTextureCoordinates(vertex.TextureCoordinates, packed.TextureCoordinates);
+	PackOctahedral8(vertex.Normal, packed.Normal);
+	PackOctahedral8(vertex.Tangent, packed.Tangent);
+
+	return packed;
+}
+
+VkVertexInputBindingDescription VertexFormat<VertexLayout::Compact>::GetBindingDescription()
+{
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkVertexInputBindingDescription.html
+	const VkVertexInputBindingDescription bindingDescription
+	{
+		0,									// binding
+		sizeof(CompactVertex),				// stride
+		VK_VERTEX_INPUT_RATE_VERTEX			// inputRate
+	};
+
+	return bindingDescription;
+}
+
+std::vector<VkVertexInputAttributeDescription> VertexFormat<VertexLayout::Compact>::GetAttributeDescriptions()
+{
+	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkVertexInputAttributeDescription.html
+	const std::vector<VkVertexInputAttributeDescription> attributeDescriptions
+	{
+		// Position
+		VkVertexInputAttributeDescription
+		{
+			0,										// location
+			0,										// binding
+			VK_FORMAT_R16G16B16A16_SFLOAT,			// format
+			offsetof(CompactVertex, Position)		// offset
+		},
+		// Texture coordinates
+		VkVertexInputAttributeDescription
+		{
+			1,
+			0,
+			VK_FORMAT_R16G16_SFLOAT,
+			offsetof(CompactVertex, TextureCoordinates)
+		},
+		// Normal
+		VkVertexInputAttributeDescription
+		{
+			2,
+			0,
+			VK_FORMAT_R8G8_SNORM,
+			offsetof(CompactVertex, Normal)
+		},
+		// Tangent
+		VkVertexInputAttributeDescription
+		{
+			3,
+			0,
+			VK_FORMAT_R8G8_SNORM,
+			offsetof(CompactVertex, Tangent)
+		}
+	};
+
+	return attributeDescriptions;
+}
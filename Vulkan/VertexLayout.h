@@ -0,0 +1,111 @@
+#ifndef VERTEX_LAYOUT
+#define VERTEX_LAYOUT
+
+#include <vulkan.hpp>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "Mesh.h"
+
+// Layouts a vertex can have in a vertex buffer, the cpu side always works with the full Vertex
+enum class VertexLayout
+{
+	Float,			// Vertex as is, 56 bytes
+	Half,			// Half positions and uvs, 16 bit octahedral normal and tangent, no color, 20 bytes
+	Compact			// Half positions and uvs, 8 bit octahedral normal and tangent, no color, 16 bytes
+};
+
+// Layout the meshes get uploaded in, the pipeline and vertex shader follow it
+constexpr VertexLayout g_VertexLayout{ VertexLayout::Half };
+
+struct HalfVertex final
+{
+	uint16_t Position[4];				// Last component is padding
+	uint16_t TextureCoordinates[2];
+	int16_t Normal[2];
+	int16_t Tangent[2];
+};
+
+struct CompactVertex final
+{
+	uint16_t Position[4];				// Last component is padding
+	uint16_t TextureCoordinates[2];
+	int8_t Normal[2];
+	int8_t Tangent[2];
+};
+
+// Everything the upload and the pipeline need to know about a layout
+template <VertexLayout Layout>
+struct VertexFormat;
+
+template <>
+struct VertexFormat<VertexLayout::Float> final
+{
+	using Type = Vertex;
+	static constexpr const char* ShaderPath{ "shaders/vert.spv" };
+	static constexpr const char* GpuDrivenShaderPath{ "shaders/vert_gpu.spv" };
+	static constexpr const char* ImpostorBakeShaderPath{ "shaders/impostor_bake_vert.spv" };
+
+	static Type Pack(const Vertex& vertex);
+	static VkVertexInputBindingDescription GetBindingDescription();
+	static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions();
+};
+
+template <>
+struct VertexFormat<VertexLayout::Half> final
+{
+	using Type = HalfVertex;
+	static constexpr const char* ShaderPath{ "shaders/vert_packed.spv" };
+	static constexpr const char* GpuDrivenShaderPath{ "shaders/vert_packed_gpu.spv" };
+	static constexpr const char* ImpostorBakeShaderPath{ "shaders/impostor_bake_vert_packed.spv" };
+
+	static Type Pack(const Vertex& vertex);
+	static VkVertexInputBindingDescription GetBindingDescription();
+	static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions();
+};
+
+template <>
+struct VertexFormat<VertexLayout::Compact> final
+{
+	using Type = CompactVertex;
+	static constexpr const char* ShaderPath{ "shaders/vert_packed.spv" };
+	static constexpr const char* GpuDrivenShaderPath{ "shaders/vert_packed_gpu.spv" };
+	static constexpr const char* ImpostorBakeShaderPath{ "shaders/impostor_bake_vert_packed.spv" };
+
+	static Type Pack(const Vertex& vertex);
+	static VkVertexInputBindingDescription GetBindingDescription();
+	static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions();
+};
+
+// Maps a unit vector onto the [-1, 1] square, decoded in pbr_packed.vert
+glm::vec2 EncodeOctahedral
+(
+	const glm::vec3& direction
+);
+
+// Inverse of EncodeOctahedral, returns a unit vector
+glm::vec3 DecodeOctahedral
+(
+	const glm::vec2& encoded
+);
+
+// Writes the vertices in the given layout, destination needs room for vertexCount * sizeof(VertexFormat<Layout>::Type) bytes
+template <VertexLayout Layout>
+void PackVertices(const Vertex* vertices, size_t vertexCount, void* destination)
+{
+	using Type = typename VertexFormat<Layout>::Type;
+
+	if constexpr (std::is_same_v<Type, Vertex>)
+	{
+		memcpy(destination, vertices, vertexCount * sizeof(Vertex));
+	}
+	else
+	{
+		Type* output{ static_cast<Type*>(destination) };
+		for (size_t i{}; i < vertexCount; ++i) output[i] = VertexFormat<Layout>::Pack(vertices[i]);
+	}
+}
+
+#endif
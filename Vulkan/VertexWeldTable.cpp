@@ -0,0 +1,147 @@
+#if defined(_M_X64) || defined(__SSE2__)
+	#include <emmintrin.h>
+	#define VERTEX_WELD_SSE2
+#endif
+// Msvc never defines __SSE4_2__, the project builds with /arch:AVX2 which defines __AVX__ and implies crc32
+#if defined(__SSE4_2__) || defined(__AVX__)
+	#include <nmmintrin.h>
+	#define VERTEX_WELD_CRC32
+#endif
+
+#include <cstring>
+#include <bit>
+#include <algorithm>
+#include <iterator>
+
+#include "VertexWeldTable.h"
+#include "Mesh.h"
+
+static_assert(sizeof(Vertex) == 14 * sizeof(float), "Vertex can't have padding, it gets hashed and compared as raw bytes");
+
+uint64_t HashVertexBytes
+(
+	const Vertex& vertex
+)
+{
+	uint64_t words[sizeof(Vertex) / sizeof(uint64_t)]{};
+	memcpy(words, &vertex, sizeof(Vertex));
+
+#ifdef VERTEX_WELD_CRC32
+	// Two independent crc chains keep both crc units of the core busy
+	uint64_t first{ 0 };
+	uint64_t second{ 0x9e3779b97f4a7c15 };
+	for (size_t i{}; i + 1 < std::size(words); i += 2)
+	{
+		first = _mm_crc32_u64(first, words[i]);
+		second = _mm_crc32_u64(second, words[i + 1]);
+	}
+	first = _mm_crc32_u64(first, words[std::size(words) - 1]);
+
+	// Each chain only saw every other word. The murmur3 finalizer mixes both into every bit, the probe slot takes the low bits and the tag and shard the high ones
+	uint64_t hash{ (first << 32) ^ second };
+	hash = (hash ^ (hash >> 33)) * 0xff51afd7ed558ccd;
+	hash = (hash ^ (hash >> 33)) * 0xc4ceb9fe1a85ec53;
+	return hash ^ (hash >> 33);
+#else
+	// Multiply and fold every word, the same mixing step as wyhash
+	uint64_t hash{ 0x9e3779b97f4a7c15 };
+	for (const uint64_t word : words)
+	{
+		const uint64_t value{ word ^ hash };
+		const uint64_t low{ (value & 0xffffffff) * 0xa0761d65 };
+		const uint64_t high{ (value >> 32) * 0xe7037ed1 };
+		hash = std::rotl(low ^ high, 23) + value * 0x8ebc6af09c88c6e3;
+	}
+
+	return hash ^ (hash >> 32);
+#endif
+}
+
+const char* GetVertexHashName()
+{
+#ifdef VERTEX_WELD_CRC32
+	return "crc32";
+#else
+	return "multiply fold";
+#endif
+}
+
+bool VertexBytesEqual
+(
+	const Vertex& first,
+	const Vertex& second
+)
+{
+#ifdef VERTEX_WELD_SSE2
+	const char* a{ reinterpret_cast<const char*>(&first) };
+	const char* b{ reinterpret_cast<const char*>(&second) };
+
+	// 56 bytes is three full registers and an 8 byte tail
+	__m128i difference{ _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b))) };
+	difference = _mm_or_si128(difference, _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 16)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 16))));
+	difference = _mm_or_si128(difference, _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 32)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 32))));
+	difference = _mm_or_si128(difference, _mm_xor_si128(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + 48)), _mm_loadl_epi64(reinterpret_cast<const __m128i*>(b + 48))));
+
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(difference, _mm_setzero_si128())) == 0xffff;
+#else
+	return memcmp(&first, &second, sizeof(Vertex)) == 0;
+#endif
+}
+
+VertexWeldTable::VertexWeldTable(size_t expectedCount) :
+	m_Slots{},
+	m_Mask{},
+	m_Count{}
+{
+	// Keep the load factor under 50%, linear probing stays short that way
+	const size_t capacity{ std::bit_ceil(std::max<size_t>(expectedCount * 2, 16)) };
+
+	m_Slots.resize(capacity, Slot{ 0, s_EmptyIndex });
+	m_Mask = capacity - 1;
+}
+
+uint32_t VertexWeldTable::Insert(const Vertex& vertex, std::vector<Vertex>& vertices)
+{
+	if ((m_Count + 1) * 2 > m_Slots.size()) Grow(vertices);
+
+	const uint64_t hash{ HashVertexBytes(vertex) };
+	const uint32_t tag{ static_cast<uint32_t>(hash >> 32) };
+
+	for (size_t i{ static_cast<size_t>(hash) & m_Mask }; ; i = (i + 1) & m_Mask)
+	{
+		Slot& slot{ m_Slots[i] };
+
+		if (slot.Index == s_EmptyIndex)
+		{
+			slot.Tag = tag;
+			slot.Index = static_cast<uint32_t>(vertices.size());
+			vertices.push_back(vertex);
+			++m_Count;
+
+			return slot.Index;
+		}
+
+		if (slot.Tag == tag and VertexBytesEqual(vertices[slot.Index], vertex)) return slot.Index;
+	}
+}
+
+void VertexWeldTable::Grow(const std::vector<Vertex>& vertices)
+{
+	std::vector<Slot> slots(m_Slots.size() * 2, Slot{ 0, s_EmptyIndex });
+	const size_t mask{ slots.size() - 1 };
+
+	for (const Slot& slot : m_Slots)
+	{
+		if (slot.Index == s_EmptyIndex) continue;
+
+		const uint64_t hash{ HashVertexBytes(vertices[slot.Index]) };
+
+		size_t i{ static_cast<size_t>(hash) & mask };
+		while (slots[i].Index != s_EmptyIndex) i = (i + 1) & mask;
+
+		slots[i] = slot;
+	}
+
+	m_Slots = std::move(slots);
+	m_Mask = mask;
+}
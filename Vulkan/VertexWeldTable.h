@@ -0,0 +1,59 @@
+#ifndef VERTEX_WELD_TABLE
+#define VERTEX_WELD_TABLE
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct Vertex;
+
+// Hash of the raw bytes of a vertex
+uint64_t HashVertexBytes
+(
+	const Vertex& vertex
+);
+
+// Which of the hashes above got compiled in, so benchmark results say which one they measured
+const char* GetVertexHashName();
+
+// Two vertices are the same when all of their bytes are, so the equality always agrees with the hash
+bool VertexBytesEqual
+(
+	const Vertex& first,
+	const Vertex& second
+);
+
+// Open addressing hash table that welds identical vertices, the vertices themselves live in the output vector
+class VertexWeldTable final
+{
+public:
+	// Expected count is the maximum number of unique vertices, usually the index count
+	VertexWeldTable(size_t expectedCount);
+	~VertexWeldTable() = default;
+
+	VertexWeldTable(const VertexWeldTable&) = delete;
+	VertexWeldTable& operator=(const VertexWeldTable&) = delete;
+	VertexWeldTable(VertexWeldTable&&) = delete;
+	VertexWeldTable& operator=(VertexWeldTable&&) = delete;
+
+	// Returns the index of the vertex in vertices, the vertex is appended if it was not there yet
+	uint32_t Insert(const Vertex& vertex, std::vector<Vertex>& vertices);
+
+private:
+	// Slots store part of the hash so most mismatches never touch the vertex data
+	struct Slot final
+	{
+		uint32_t Tag;
+		uint32_t Index;
+	};
+
+	static constexpr uint32_t s_EmptyIndex{ UINT32_MAX };
+
+	std::vector<Slot> m_Slots;
+	size_t m_Mask;
+	size_t m_Count;
+
+	void Grow(const std::vector<Vertex>& vertices);
+};
+
+#endif
@@ -8,11 +8,14 @@
 #endif // _DEBUG
 
 #include "Application.h"
+#include "Benchmarks.h"
 
 int main() 
 {
     try 
     {
+        if (g_RunBenchmarks) RunBenchmarks();
+
         std::cout << std::format("The application is {} bytes.", sizeof(Application)) << std::endl;
         Application application{ 1600, 900 };
         application.Run();